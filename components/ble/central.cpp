@@ -3,6 +3,9 @@
 #undef min
 #undef max
 
+#include <algorithm>
+
+#include "ble/gap/advertisement.hpp"
 #include "ble/gap/central.hpp"
 
 namespace b2h::ble::gap
@@ -22,6 +25,8 @@ namespace b2h::ble::gap
                 log::debug(central::COMPONENT,
                     "GAP event: BLE_GAP_EVENT_CONNECT.");
 
+                cent->resume_scan();
+
                 if (event->connect.status == 0)
                 {
                     log::info(central::COMPONENT, "Connection established.");
@@ -51,7 +56,12 @@ namespace b2h::ble::gap
 
                 return 0;
             case BLE_GAP_EVENT_NOTIFY_RX:
-                log::debug(central::COMPONENT,
+                // Sent by every sensor on each reading, limit to keep the
+                // UART usable with debug logging on.
+                B2H_LOG_RATE_LIMITED(log::log_level::debug,
+                    central::COMPONENT,
+                    5,
+                    10,
                     "GAP event: BLE_GAP_EVENT_NOTIFY_RX.");
 
                 if (event->notify_rx.indication == 1)
@@ -69,7 +79,10 @@ namespace b2h::ble::gap
                         cent->m_notify_buffer.size(),
                         static_cast<void*>(cent->m_notify_buffer.data()));
 
-                    log::verbose(central::COMPONENT,
+                    B2H_LOG_RATE_LIMITED(log::log_level::verbose,
+                        central::COMPONENT,
+                        5,
+                        10,
                         "Got data: {}.",
                         cent->m_notify_buffer);
 
@@ -84,6 +97,37 @@ namespace b2h::ble::gap
                 }
 
                 return 0;
+            case BLE_GAP_EVENT_DISC:
+                for (std::uint16_t uuid : cent->m_scan_uuids)
+                {
+                    const auto service_data = find_service_data(
+                        { event->disc.data, event->disc.length_data }, uuid);
+
+                    if (!service_data)
+                    {
+                        continue;
+                    }
+
+                    utils::mac::buffer_t addr;
+                    std::copy_n(event->disc.addr.val, addr.size(), addr.data());
+
+                    cent->m_dispatcher.async_dispatch<events::advertisement>(
+                        events::advertisement_args{
+                            utils::mac{ addr },
+                            event->disc.rssi,
+                            uuid,
+                            { service_data->begin(), service_data->end() },
+                        });
+
+                    break;
+                }
+
+                return 0;
+            case BLE_GAP_EVENT_DISC_COMPLETE:
+                log::debug(central::COMPONENT,
+                    "GAP event: BLE_GAP_EVENT_DISC_COMPLETE, reason: {}.",
+                    event->disc_complete.reason);
+                return 0;
             default:
                 log::info(central::COMPONENT, "GAP event: {}.", event->type);
                 return 0;
@@ -94,14 +138,20 @@ namespace b2h::ble::gap
     central::central(event::context& ctx) noexcept :
         m_dispatcher{ ctx },
         m_receiver{ m_dispatcher.make_receiver() },
-        m_notify_buffer{}
+        m_notify_buffer{},
+        m_scan_uuids{},
+        m_scan_mode{ scan_mode::passive },
+        m_scanning{ false }
     {
     }
 
     central::central(central&& other) noexcept :
         m_dispatcher{ std::move(other.m_dispatcher) },
         m_receiver{ m_dispatcher.make_receiver() },
-        m_notify_buffer{ std::move(other.m_notify_buffer) }
+        m_notify_buffer{ std::move(other.m_notify_buffer) },
+        m_scan_uuids{ std::move(other.m_scan_uuids) },
+        m_scan_mode{ other.m_scan_mode },
+        m_scanning{ other.m_scanning.exchange(false) }
     {
     }
 
@@ -115,7 +165,101 @@ namespace b2h::ble::gap
         m_dispatcher    = std::move(other.m_dispatcher);
         m_receiver      = m_dispatcher.make_receiver();
         m_notify_buffer = std::move(other.m_notify_buffer);
+        m_scan_uuids    = std::move(other.m_scan_uuids);
+        m_scan_mode     = other.m_scan_mode;
+        m_scanning      = other.m_scanning.exchange(false);
 
         return *this;
     }
+
+    int central::start_scan(
+        scan_mode mode, std::vector<std::uint16_t> service_uuids) noexcept
+    {
+#if CONFIG_BT_NIMBLE_ROLE_OBSERVER
+        stop_scan();
+
+        m_scan_mode  = mode;
+        m_scan_uuids = std::move(service_uuids);
+        m_scanning   = true;
+
+        const int rc = discover();
+        if (rc != 0)
+        {
+            m_scanning = false;
+        }
+
+        return rc;
+#else
+        log::error(COMPONENT, "Scanning requires the NimBLE observer role.");
+        return BLE_HS_ENOTSUP;
+#endif
+    }
+
+    void central::stop_scan() noexcept
+    {
+        m_scanning = false;
+        pause_scan();
+    }
+
+    int central::discover() noexcept
+    {
+#if CONFIG_BT_NIMBLE_ROLE_OBSERVER
+        std::uint8_t own_addr_type = BLE_OWN_ADDR_PUBLIC;
+        int rc = ble_hs_id_infer_auto(0, &own_addr_type);
+        if (rc != 0)
+        {
+            log::error(COMPONENT,
+                "Failed to infer own address. Error code: [{}]",
+                rc);
+            return rc;
+        }
+
+        // Scan 30 ms out of every 100 ms, leaving the radio to the
+        // connections. Sensors repeat their advertisements, so duplicate
+        // filtering stays off to see each new reading.
+        ::ble_gap_disc_params params{};
+        params.itvl              = 160;
+        params.window            = 48;
+        params.filter_policy     = BLE_HCI_SCAN_FILT_NO_WL;
+        params.limited           = 0;
+        params.passive           = m_scan_mode == scan_mode::passive;
+        params.filter_duplicates = 0;
+
+        rc = ::ble_gap_disc(own_addr_type,
+            BLE_HS_FOREVER,
+            &params,
+            &impl::blecent_gap_event,
+            this);
+        if (rc != 0 && rc != BLE_HS_EALREADY)
+        {
+            log::error(COMPONENT,
+                "Failed to start scanning. Error code: [{}]",
+                rc);
+            return rc;
+        }
+
+        log::debug(COMPONENT, "Scanning started.");
+        return 0;
+#else
+        return BLE_HS_ENOTSUP;
+#endif
+    }
+
+    void central::pause_scan() noexcept
+    {
+#if CONFIG_BT_NIMBLE_ROLE_OBSERVER
+        if (::ble_gap_disc_active())
+        {
+            ::ble_gap_disc_cancel();
+        }
+#endif
+    }
+
+    void central::resume_scan() noexcept
+    {
+        if (m_scanning)
+        {
+            discover();
+        }
+    }
 } // namespace b2h::ble::gap
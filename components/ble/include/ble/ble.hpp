@@ -117,7 +117,7 @@ namespace b2h
         private:
             friend void impl::on_sync() noexcept;
 
-            static constexpr std::string_view COMPONENT{ "ble::context" };
+            static constexpr log::component COMPONENT{ "ble::context" };
 
             dispatcher_type m_dispatcher;
             receiver_type m_receiver;
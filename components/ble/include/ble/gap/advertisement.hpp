@@ -0,0 +1,81 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef B2H_BLE_GAP_ADVERTISEMENT_HPP
+#define B2H_BLE_GAP_ADVERTISEMENT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "tcb/span.hpp"
+
+namespace b2h::ble::gap
+{
+    // Service Data - 16-bit UUID AD type.
+    inline constexpr std::uint8_t AD_TYPE_SERVICE_DATA16{ 0x16 };
+
+    /**
+     * @brief Find the service data of a 16-bit service UUID in advertising
+     * data.
+     *
+     * @param data Advertising data, a sequence of length-type-value AD
+     * structures.
+     * @param uuid Service UUID.
+     * @return Service data following the UUID, std::nullopt if absent or the
+     * advertising data is malformed.
+     */
+    inline std::optional<tcb::span<const std::uint8_t>> find_service_data(
+        tcb::span<const std::uint8_t> data, std::uint16_t uuid) noexcept
+    {
+        std::size_t offset = 0;
+
+        while (offset < data.size())
+        {
+            const std::size_t length = data[offset];
+
+            if (length == 0)
+            {
+                // Early termination of the significant part.
+                break;
+            }
+
+            if (offset + 1 + length > data.size())
+            {
+                return std::nullopt;
+            }
+
+            const auto structure = data.subspan(offset + 1, length);
+
+            if (structure[0] == AD_TYPE_SERVICE_DATA16 &&
+                structure.size() >= 3 &&
+                (structure[1] | (structure[2] << 8)) == uuid)
+            {
+                return structure.subspan(3);
+            }
+
+            offset += 1 + length;
+        }
+
+        return std::nullopt;
+    }
+} // namespace b2h::ble::gap
+
+#endif
@@ -26,8 +26,10 @@
 #undef min
 #undef max
 
+#include <atomic>
 #include <chrono>
 #include <string_view>
+#include <vector>
 
 #include "tl/expected.hpp"
 
@@ -57,6 +59,17 @@ namespace b2h
 
         struct on_disconnect : public event::basic_event<std::uint16_t, int> {
         };
+
+        struct advertisement_args {
+            b2h::utils::mac address;
+            std::int8_t rssi;
+            std::uint16_t service_uuid;
+            std::vector<std::uint8_t> service_data;
+        };
+
+        struct advertisement
+            : public event::basic_event<advertisement_args, int> {
+        };
     } // namespace events::ble::gap
 
     namespace ble::gap
@@ -66,6 +79,12 @@ namespace b2h
             int blecent_gap_event(::ble_gap_event* event, void* arg) noexcept;
         }
 
+        enum class scan_mode
+        {
+            passive, // Listen only.
+            active,  // Also request scan responses.
+        };
+
         class central
         {
         public:
@@ -73,7 +92,8 @@ namespace b2h
             using dispatcher_type = event::dispatcher<
                 events::ble::gap::connect,
                 events::ble::gap::notify_rx,
-                events::ble::gap::on_disconnect
+                events::ble::gap::on_disconnect,
+                events::ble::gap::advertisement
             >;
             // clang-format on
             using receiver_type = dispatcher_type::receiver_type;
@@ -113,7 +133,7 @@ namespace b2h
                     },
                 };
 
-                log::debug(COMPONENT, "Connecting to {}.", addr.to_string());
+                log::debug(COMPONENT, "Connecting to {}.", addr.str());
 
                 m_receiver.async_receive<events::connect>(
                     std::forward<HandlerT>(handler));
@@ -130,6 +150,10 @@ namespace b2h
                     return;
                 }
 
+                // The controller cannot scan and initiate at once, scanning
+                // resumes with the connect event.
+                pause_scan();
+
                 rc = ::ble_gap_connect(own_addr_type,
                     &addr_internal,
                     std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -143,12 +167,44 @@ namespace b2h
                     log::error(COMPONENT,
                         "Failed to connect to device. Error code: [{}]",
                         rc);
+                    resume_scan();
                     m_dispatcher.async_dispatch<events::connect>(
                         tl::make_unexpected(rc));
                     return;
                 }
             }
 
+            /**
+             * @brief Scan for advertisements carrying data of the services,
+             * until stop_scan(). Scanning pauses while a connection is being
+             * established.
+             *
+             * @param mode Passive or active scanning.
+             * @param service_uuids 16-bit service UUIDs, advertisements
+             * without service data of any of them are dropped.
+             * @return int 0 on success, NimBLE error code otherwise.
+             */
+            int start_scan(scan_mode mode,
+                std::vector<std::uint16_t> service_uuids) noexcept;
+
+            void stop_scan() noexcept;
+
+            /**
+             * @brief Receive the next advertisement matching the scan.
+             * Advertisements arriving before the handler is set again are
+             * dropped.
+             *
+             * @param handler
+             */
+            template<typename HandlerT>
+            void async_advertisement(HandlerT&& handler) noexcept
+            {
+                namespace events = events::ble::gap;
+
+                m_receiver.async_receive<events::advertisement>(
+                    std::forward<HandlerT>(handler));
+            }
+
             template<typename HandlerT>
             void async_notify_rx(HandlerT&& handler) noexcept
             {
@@ -177,12 +233,23 @@ namespace b2h
             friend int impl::blecent_gap_event(
                 ::ble_gap_event* event, void* arg) noexcept;
 
-            static constexpr std::string_view COMPONENT{ "gap::central" };
+            static constexpr log::component COMPONENT{ "gap::central" };
 
             dispatcher_type m_dispatcher;
             receiver_type m_receiver;
 
             std::vector<std::uint8_t> m_notify_buffer;
+
+            // Set before scanning starts, read on the NimBLE host task.
+            std::vector<std::uint16_t> m_scan_uuids;
+            scan_mode m_scan_mode;
+            std::atomic<bool> m_scanning; // Requested by the user.
+
+            int discover() noexcept;
+
+            void pause_scan() noexcept;
+
+            void resume_scan() noexcept;
         };
     } // namespace ble::gap
 } // namespace b2h
@@ -78,7 +78,7 @@ namespace b2h
 
     namespace ble::gatt
     {
-        inline constexpr std::string_view COMPONENT{ "gatt::client" };
+        inline constexpr log::component COMPONENT{ "gatt::client" };
 
         class client final
         {
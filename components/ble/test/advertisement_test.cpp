@@ -0,0 +1,62 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "catch2/catch.hpp"
+
+#include <array>
+#include <cstdint>
+
+#include "ble/gap/advertisement.hpp"
+
+TEST_CASE("Find service data of a 16-bit UUID.", "[ble]")
+{
+    const std::array<std::uint8_t, 13> data{
+        0x02, 0x01, 0x06,                   // Flags
+        0x05, 0x16, 0x95, 0xFE, 0x01, 0x02, // Service data, 0xFE95
+        0x03, 0x16, 0x1A, 0x18,             // Service data, 0x181A, empty
+    };
+
+    const auto fe95 = b2h::ble::gap::find_service_data(data, 0xFE95);
+    REQUIRE(fe95.has_value());
+    REQUIRE(fe95->size() == 2);
+    REQUIRE((*fe95)[0] == 0x01);
+    REQUIRE((*fe95)[1] == 0x02);
+
+    const auto env = b2h::ble::gap::find_service_data(data, 0x181A);
+    REQUIRE(env.has_value());
+    REQUIRE(env->empty());
+
+    REQUIRE(!b2h::ble::gap::find_service_data(data, 0x180F).has_value());
+}
+
+TEST_CASE("Reject malformed advertising data.", "[ble]")
+{
+    // Length runs past the end.
+    const std::array<std::uint8_t, 4> truncated{ 0x05, 0x16, 0x1A, 0x18 };
+    REQUIRE(!b2h::ble::gap::find_service_data(truncated, 0x181A));
+
+    // Too short to hold the UUID.
+    const std::array<std::uint8_t, 3> short_uuid{ 0x02, 0x16, 0x1A };
+    REQUIRE(!b2h::ble::gap::find_service_data(short_uuid, 0x181A));
+
+    // Zero length ends the significant part.
+    const std::array<std::uint8_t, 5> padded{ 0x00, 0x03, 0x16, 0x1A, 0x18 };
+    REQUIRE(!b2h::ble::gap::find_service_data(padded, 0x181A));
+}
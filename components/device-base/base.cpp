@@ -38,6 +38,11 @@ namespace b2h::device
     {
     }
 
+    void base::on_advertisement(std::uint16_t service_uuid,
+        tcb::span<const std::uint8_t> service_data) noexcept
+    {
+    }
+
     std::uint16_t base::connection_handle() noexcept
     {
         return m_gatt_client->connection_handle();
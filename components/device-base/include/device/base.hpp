@@ -29,6 +29,7 @@
 #include "ble/gatt/client.hpp"
 #include "hass/device_types.hpp"
 #include "mqtt/client.hpp"
+#include "tcb/span.hpp"
 #include "tl/expected.hpp"
 #include "utils/mac.hpp"
 
@@ -49,6 +50,8 @@ namespace b2h::device
         virtual void on_disconnected() noexcept            = 0;
         virtual void on_notify(std::uint16_t attribute_handle,
             std::vector<std::uint8_t>&& data) noexcept     = 0;
+        virtual void on_advertisement(std::uint16_t service_uuid,
+            tcb::span<const std::uint8_t> service_data) noexcept = 0;
         virtual std::uint16_t connection_handle() noexcept = 0;
     };
 
@@ -70,6 +73,8 @@ namespace b2h::device
         virtual void on_disconnected() noexcept override;
         virtual void on_notify(std::uint16_t attribute_handle,
             std::vector<std::uint8_t>&& data) noexcept override;
+        virtual void on_advertisement(std::uint16_t service_uuid,
+            tcb::span<const std::uint8_t> service_data) noexcept override;
         std::uint16_t connection_handle() noexcept override;
 
         mqtt::client& mqtt_client() noexcept;
@@ -0,0 +1,122 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef B2H_DEVICE_COMMAND_QUEUE_HPP
+#define B2H_DEVICE_COMMAND_QUEUE_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace b2h::device
+{
+    /**
+     * @brief Inbound commands awaiting the device, one per command slot.
+     *
+     * A command pushed to a slot that is already pending replaces its value
+     * and keeps its place in the queue, so a burst of commands on a topic
+     * collapses into its latest value.
+     *
+     * @tparam N Number of command slots, e.g. command topics of the device.
+     */
+    template<std::size_t N>
+    class command_queue final
+    {
+    public:
+        using value_type = std::pair<std::size_t, std::string_view>;
+
+        command_queue() noexcept : m_data{}, m_order{}, m_size{ 0 }
+        {
+        }
+
+        /**
+         * @brief Set the latest command of the slot.
+         *
+         * @param slot Command slot, less than N.
+         * @param data Command payload, copied.
+         */
+        void push(std::size_t slot, std::string_view data)
+        {
+            // The payload may be a view of the slot itself, replayed from
+            // front().
+            if (data.data() != m_data[slot].data())
+            {
+                m_data[slot].assign(data.data(), data.size());
+            }
+
+            const auto end = m_order.begin() + m_size;
+
+            if (std::find(m_order.begin(), end, slot) == end)
+            {
+                m_order[m_size++] = slot;
+            }
+        }
+
+        /**
+         * @brief Oldest pending command.
+         *
+         * @return Slot and payload, valid until the slot is pushed again.
+         */
+        std::optional<value_type> front() const noexcept
+        {
+            if (m_size == 0)
+            {
+                return std::nullopt;
+            }
+
+            const std::size_t slot = m_order.front();
+            return value_type{ slot, m_data[slot] };
+        }
+
+        void pop() noexcept
+        {
+            if (m_size == 0)
+            {
+                return;
+            }
+
+            std::move(m_order.begin() + 1,
+                m_order.begin() + m_size,
+                m_order.begin());
+            --m_size;
+        }
+
+        bool empty() const noexcept
+        {
+            return m_size == 0;
+        }
+
+        std::size_t size() const noexcept
+        {
+            return m_size;
+        }
+
+    private:
+        std::array<std::string, N> m_data;
+        std::array<std::size_t, N> m_order; // Pending slots, oldest first.
+        std::size_t m_size;
+    };
+} // namespace b2h::device
+
+#endif
@@ -0,0 +1,212 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef B2H_DEVICE_DISCOVERY_HPP
+#define B2H_DEVICE_DISCOVERY_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "event/event.hpp"
+#include "hass/discovery_cache.hpp"
+#include "mqtt/client.hpp"
+#include "mqtt/session.hpp"
+#include "utils/logger.hpp"
+
+#if __has_include("sdkconfig.h")
+#include "sdkconfig.h"
+#endif
+
+// Publish all entities of a device in a single device discovery payload
+// instead of one config message per entity. Requires Home Assistant 2024.11 or
+// newer, retained per-entity configs of earlier runs are left on the broker.
+#ifndef B2H_HASS_DEVICE_DISCOVERY
+#ifdef CONFIG_B2H_HASS_DEVICE_DISCOVERY
+#define B2H_HASS_DEVICE_DISCOVERY 1
+#else
+#define B2H_HASS_DEVICE_DISCOVERY 0
+#endif
+#endif
+
+namespace b2h::device
+{
+    inline constexpr bool DEVICE_DISCOVERY{ B2H_HASS_DEVICE_DISCOVERY != 0 };
+
+    inline constexpr std::string_view ORIGIN_NAME{ "ble2hass" };
+
+    /**
+     * @brief Publish retained Home Assistant discovery payload through the
+     * shared discovery cache. The payload is rendered only on a cache miss and
+     * is not published again once the broker acknowledged it.
+     *
+     * @tparam RenderT Callable returning serialized payload.
+     * @tparam HandlerT Publish completion handler.
+     * @param client
+     * @param key
+     * @param topic
+     * @param render
+     * @param handler
+     * @return true Publish started, handler will be called.
+     * @return false Broker already holds the retained payload, handler will
+     * not be called.
+     */
+    template<typename RenderT, typename HandlerT>
+    bool publish_discovery(mqtt::client& client,
+        const hass::discovery_cache::key& key,
+        const char* topic,
+        RenderT&& render,
+        HandlerT&& handler)
+    {
+        auto& cache = hass::discovery_cache::instance();
+
+        std::string storage;
+        const auto cached = cache.find_or_render(key,
+            std::forward<RenderT>(render),
+            storage);
+
+        if (cached.published)
+        {
+            return false;
+        }
+
+        client.async_publish(topic,
+            cached.payload,
+            1,
+            true,
+            [key, handler = std::forward<HandlerT>(handler)](
+                auto&& result) mutable {
+                if (result.has_value())
+                {
+                    hass::discovery_cache::instance().mark_published(key);
+                }
+
+                handler(std::forward<decltype(result)>(result));
+            });
+
+        return true;
+    }
+
+    /**
+     * @brief Whether discovery has to be published again: the broker or Home
+     * Assistant lost it after the device took its generation. Takes the
+     * current generation.
+     *
+     * @param generation Discovery cache generation the device configured at.
+     * @return true Publish the discovery payloads again.
+     * @return false Discovery is up to date.
+     */
+    inline bool rediscover(std::uint32_t& generation) noexcept
+    {
+        const std::uint32_t current =
+            hass::discovery_cache::instance().generation();
+
+        if (current == generation)
+        {
+            return false;
+        }
+
+        generation = current;
+        return true;
+    }
+
+    /**
+     * @brief Mark the discovery payloads unpublished whenever the broker or
+     * Home Assistant may have lost them: the broker started a clean session,
+     * or Home Assistant reported online on its status topic.
+     *
+     * One per session, created before the session starts.
+     *
+     */
+    class discovery_watch final
+    {
+    public:
+        discovery_watch(event::context& ctx, mqtt::session& session) noexcept :
+            m_client{ ctx, session },
+            m_watching{ true }
+        {
+            session.on_connected([](bool session_present) {
+                // Without the old session the broker may have lost the
+                // retained payloads too.
+                if (!session_present)
+                {
+                    hass::discovery_cache::instance().mark_unpublished();
+                }
+            });
+
+            receive();
+
+            // The session subscribes again after a clean session.
+            m_client.async_subscribe(hass::STATUS_TOPIC, 1, [](auto result) {
+                if (!result.has_value())
+                {
+                    log::warning(COMPONENT,
+                        "Failed to subscribe to {}.",
+                        hass::STATUS_TOPIC);
+                }
+            });
+        }
+
+        discovery_watch(const discovery_watch&) = delete;
+        discovery_watch(discovery_watch&&)      = delete;
+
+        discovery_watch& operator=(const discovery_watch&) = delete;
+        discovery_watch& operator=(discovery_watch&&) = delete;
+
+        ~discovery_watch() = default;
+
+        /**
+         * @brief Stop after the next status message, the pending receive
+         * keeps the context running until then.
+         *
+         */
+        void stop() noexcept
+        {
+            m_watching = false;
+        }
+
+    private:
+        static constexpr log::component COMPONENT{ "device::discovery" };
+
+        mqtt::client m_client;
+        bool m_watching;
+
+        void receive() noexcept
+        {
+            m_client.async_receive([this](auto&& result) {
+                // Home Assistant (re)started and asks for discovery again.
+                if (result.has_value() &&
+                    result.value().data == hass::STATUS_ONLINE)
+                {
+                    log::info(COMPONENT, "Home Assistant online.");
+                    hass::discovery_cache::instance().mark_unpublished();
+                }
+
+                if (m_watching)
+                {
+                    receive();
+                }
+            });
+        }
+    };
+} // namespace b2h::device
+
+#endif
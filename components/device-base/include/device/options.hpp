@@ -0,0 +1,122 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef B2H_DEVICE_OPTIONS_HPP
+#define B2H_DEVICE_OPTIONS_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "utils/json.hpp"
+
+namespace b2h::device
+{
+    /**
+     * @brief Publish filter of a single sensor. Values are given in the unit
+     * of the reading, e.g. °C for temperature or mV for battery voltage.
+     *
+     */
+    struct sensor_filter {
+        std::string sensor;
+        float deadband;             // Change needed to publish again.
+        float hysteresis;           // Change needed against the direction of
+                                    // the last published change.
+        std::uint32_t min_interval; // Seconds between publishes.
+
+        static constexpr auto json_fields()
+        {
+            using namespace utils::json;
+
+            return fields(field("sensor", &sensor_filter::sensor),
+                optional_field("deadband", &sensor_filter::deadband),
+                optional_field("hysteresis", &sensor_filter::hysteresis),
+                optional_field("min_interval", &sensor_filter::min_interval));
+        }
+    };
+
+    /**
+     * @brief Per device options read from the configuration file.
+     *
+     */
+    struct options {
+        std::vector<sensor_filter> filters;
+        std::string bindkey; // Key of encrypted advertisements, 32 hex
+                             // digits.
+
+        /**
+         * @brief Find the filter configured for the sensor.
+         *
+         * @param sensor Sensor name, e.g. "temperature".
+         * @return Filter or nullptr if the sensor has none.
+         */
+        const sensor_filter* filter(std::string_view sensor) const noexcept;
+
+        static constexpr auto json_fields()
+        {
+            using namespace utils::json;
+
+            return fields(optional_field("filters", &options::filters),
+                optional_field("bindkey", &options::bindkey));
+        }
+    };
+
+    /**
+     * @brief Decides whether a sensor reading is worth publishing, before any
+     * formatting or MQTT work is done for it.
+     *
+     * Without a configured filter every change of the reading passes.
+     *
+     */
+    class publish_filter
+    {
+    public:
+        using clock_type = std::chrono::steady_clock;
+
+        publish_filter() noexcept;
+
+        explicit publish_filter(const sensor_filter* config) noexcept;
+
+        /**
+         * @brief Check the reading against the last published one.
+         *
+         * @param value Reading in the unit of the filter.
+         * @param now Time of the reading.
+         * @return true if the reading should be published, it becomes the
+         * last published reading then.
+         */
+        bool pass(float value, clock_type::time_point now = clock_type::now())
+            noexcept;
+
+    private:
+        float m_deadband;
+        float m_hysteresis;
+        clock_type::duration m_min_interval;
+
+        std::optional<float> m_last;
+        clock_type::time_point m_last_time;
+        std::int8_t m_direction;
+    };
+} // namespace b2h::device
+
+#endif
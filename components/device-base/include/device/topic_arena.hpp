@@ -0,0 +1,179 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef B2H_DEVICE_TOPIC_ARENA_HPP
+#define B2H_DEVICE_TOPIC_ARENA_HPP
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <type_traits>
+
+#include "fmt/format.h"
+
+namespace b2h::device
+{
+    /**
+     * @brief Size of a topic template rendered with arguments of the given
+     * size, including the terminating null character.
+     *
+     * @param tmpl Topic template, each "{}" is replaced with an argument.
+     * @param arg_size Size of each argument.
+     * @return constexpr std::size_t
+     */
+    constexpr std::size_t topic_size(
+        const std::string_view tmpl, const std::size_t arg_size) noexcept
+    {
+        std::size_t size = tmpl.size() + 1;
+
+        auto pos = tmpl.find("{}");
+
+        while (pos != std::string_view::npos)
+        {
+            size = size - 2 + arg_size;
+            pos  = tmpl.find("{}", pos + 2);
+        }
+
+        return size;
+    }
+
+    /**
+     * @brief Topics of a device, rendered once and packed back to back into a
+     * single buffer.
+     *
+     * Topics are referred to by their id, which is the order they were pushed
+     * in. Each one is null terminated, so it can be handed to the MQTT client
+     * as is.
+     *
+     * @tparam N Number of topics.
+     * @tparam Capacity Buffer size, sum of topic_size() of all the topics.
+     */
+    template<std::size_t N, std::size_t Capacity>
+    class topic_arena final
+    {
+    public:
+        using offset_type = std::conditional_t<
+            (Capacity <= std::numeric_limits<std::uint8_t>::max()),
+            std::uint8_t, std::uint16_t>;
+
+        static_assert(Capacity <= std::numeric_limits<std::uint16_t>::max(),
+            "Topic arena too large.");
+        static_assert(N <= std::numeric_limits<std::uint8_t>::max(),
+            "Too many topics.");
+
+        topic_arena() noexcept : m_data{}, m_offsets{}, m_size{ 0 }
+        {
+        }
+
+        /**
+         * @brief Render the next topic.
+         *
+         * @param tmpl Topic template.
+         * @param args Template arguments.
+         * @return true Topic rendered, its id is the number of topics pushed
+         * before it.
+         * @return false No topic id left or the topic does not fit.
+         */
+        template<typename... ArgsT>
+        bool push(const std::string_view tmpl, const ArgsT&... args) noexcept
+        {
+            if (m_size == N)
+            {
+                return false;
+            }
+
+            const std::size_t begin = m_offsets[m_size];
+            const std::size_t space = Capacity - begin;
+
+            if (space == 0)
+            {
+                return false;
+            }
+
+            const auto [out, size] = fmt::format_to_n(
+                m_data.begin() + begin, space - 1, tmpl, args...);
+
+            if (size >= space)
+            {
+                return false;
+            }
+
+            *out                = '\0';
+            m_offsets[++m_size] = static_cast<offset_type>(begin + size + 1);
+            return true;
+        }
+
+        /**
+         * @brief Null terminated topic.
+         *
+         * @param id Topic id, less than size().
+         * @return const char*
+         */
+        const char* c_str(const std::size_t id) const noexcept
+        {
+            assert(id < m_size);
+            return m_data.data() + m_offsets[id];
+        }
+
+        /**
+         * @brief Topic without the null terminator.
+         *
+         * @param id Topic id, less than size().
+         * @return std::string_view
+         */
+        std::string_view view(const std::size_t id) const noexcept
+        {
+            assert(id < m_size);
+            return { m_data.data() + m_offsets[id],
+                static_cast<std::size_t>(
+                    m_offsets[id + 1] - m_offsets[id] - 1) };
+        }
+
+        /**
+         * @brief Number of topics rendered.
+         *
+         * @return std::size_t
+         */
+        std::size_t size() const noexcept
+        {
+            return m_size;
+        }
+
+        /**
+         * @brief Bytes of the buffer in use.
+         *
+         * @return std::size_t
+         */
+        std::size_t bytes() const noexcept
+        {
+            return m_offsets[m_size];
+        }
+
+    private:
+        std::array<char, Capacity> m_data;
+        std::array<offset_type, N + 1> m_offsets; // Topic starts, then end.
+        std::uint8_t m_size;
+    };
+} // namespace b2h::device
+
+#endif
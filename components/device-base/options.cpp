@@ -0,0 +1,86 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "device/options.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace b2h::device
+{
+    const sensor_filter* options::filter(
+        std::string_view sensor) const noexcept
+    {
+        auto iter = std::find_if(filters.cbegin(),
+            filters.cend(),
+            [sensor](const sensor_filter& filter) {
+                return filter.sensor == sensor;
+            });
+
+        return iter != filters.cend() ? &*iter : nullptr;
+    }
+
+    publish_filter::publish_filter() noexcept : publish_filter{ nullptr }
+    {
+    }
+
+    publish_filter::publish_filter(const sensor_filter* config) noexcept :
+        m_deadband{ config ? config->deadband : 0.0f },
+        m_hysteresis{ config ? config->hysteresis : 0.0f },
+        m_min_interval{ std::chrono::seconds{
+            config ? config->min_interval : 0U } },
+        m_last{},
+        m_last_time{},
+        m_direction{ 0 }
+    {
+    }
+
+    bool publish_filter::pass(float value, clock_type::time_point now) noexcept
+    {
+        if (!m_last)
+        {
+            m_last      = value;
+            m_last_time = now;
+            return true;
+        }
+
+        const float change = value - *m_last;
+
+        if (change == 0.0f || now - m_last_time < m_min_interval)
+        {
+            return false;
+        }
+
+        const std::int8_t direction = change > 0.0f ? 1 : -1;
+        const float threshold       = direction == -m_direction
+                                          ? std::max(m_deadband, m_hysteresis)
+                                          : m_deadband;
+
+        if (std::fabs(change) < threshold)
+        {
+            return false;
+        }
+
+        m_last      = value;
+        m_last_time = now;
+        m_direction = direction;
+        return true;
+    }
+} // namespace b2h::device
@@ -0,0 +1,72 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "catch2/catch.hpp"
+
+#include <string>
+
+#include "device/command_queue.hpp"
+
+TEST_CASE("Keep the latest command per slot.", "[device]")
+{
+    b2h::device::command_queue<3> queue;
+
+    REQUIRE(queue.empty());
+    REQUIRE(!queue.front().has_value());
+
+    queue.push(1, "40");
+    queue.push(2, "on");
+    queue.push(1, "41");
+    queue.push(1, "42");
+
+    REQUIRE(queue.size() == 2);
+
+    auto command = queue.front();
+    REQUIRE(command.has_value());
+    REQUIRE(command->first == 1);
+    REQUIRE(command->second == "42");
+
+    queue.pop();
+    command = queue.front();
+    REQUIRE(command.has_value());
+    REQUIRE(command->first == 2);
+    REQUIRE(command->second == "on");
+
+    queue.pop();
+    REQUIRE(queue.empty());
+
+    // Popping an empty queue does nothing.
+    queue.pop();
+    REQUIRE(queue.empty());
+}
+
+TEST_CASE("Requeue a command from its own slot.", "[device]")
+{
+    b2h::device::command_queue<2> queue;
+
+    queue.push(0, std::string(32, 'x'));
+
+    const auto command = queue.front();
+    queue.pop();
+    queue.push(command->first, command->second);
+
+    REQUIRE(queue.size() == 1);
+    REQUIRE(queue.front()->second == std::string(32, 'x'));
+}
@@ -0,0 +1,173 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "catch2/catch.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "device/discovery.hpp"
+#include "event/event.hpp"
+#include "hass/discovery_cache.hpp"
+#include "mqtt/client.hpp"
+#include "mqtt/session.hpp"
+
+using namespace b2h;
+using namespace b2h::utils::literals;
+
+TEST_CASE("Publish discovery again once the broker lost it.", "[device]")
+{
+    constexpr const char* CONFIG_TOPIC{ "homeassistant/sensor/test/config" };
+
+    event::context context;
+    mqtt::config config{ "mqtt://test:1883" };
+    mqtt::session session{ context };
+    mqtt::client client{ context, session };
+
+    const hass::discovery_cache::key key{ "TEST", "A4:C1:38:01:02:03"_mac, 0 };
+
+    std::uint32_t generation = 0;
+    std::vector<bool> started;
+    std::function<void(int)> step;
+    std::optional<device::discovery_watch> watch;
+
+    test_published_topics.clear();
+
+    // Publish the config the way a device does, then go on with the next
+    // step.
+    const auto publish = [&](int next) {
+        started.push_back(device::publish_discovery(
+            client,
+            key,
+            CONFIG_TOPIC,
+            [] { return std::string{ "{}" }; },
+            [&, next](auto result) {
+                REQUIRE(result.has_value());
+                step(next);
+            }));
+
+        if (!started.back())
+        {
+            step(next);
+        }
+    };
+
+    const auto reconnect = [&](bool session_present, int next) {
+        session.async_disconnect([&, session_present, next](auto) {
+            test_session_present = session_present;
+            session.async_connect([&, next](auto) { step(next); });
+        });
+    };
+
+    step = [&](int i) {
+        switch (i)
+        {
+        case 0:
+            generation = hass::discovery_cache::instance().generation();
+            publish(1);
+            break;
+        case 1:
+            // Acknowledged by the broker, not published again.
+            publish(2);
+            break;
+        case 2:
+            reconnect(true, 3);
+            break;
+        case 3:
+            // The broker resumed the session, the config is still there.
+            REQUIRE_FALSE(device::rediscover(generation));
+            publish(4);
+            break;
+        case 4:
+            reconnect(false, 5);
+            break;
+        case 5:
+            REQUIRE(device::rediscover(generation));
+            publish(6);
+            break;
+        case 6:
+            // The status topic is delivered once more on the clean session,
+            // ending the watch.
+            watch->stop();
+            reconnect(false, 7);
+            break;
+        default:
+            break;
+        }
+    };
+
+    session.config(config);
+    watch.emplace(context, session);
+    session.async_connect([&](auto) { step(0); });
+
+    context.run();
+
+    test_session_present = false;
+
+    REQUIRE(started == std::vector<bool>{ true, false, false, true });
+    REQUIRE(std::count(test_published_topics.cbegin(),
+                test_published_topics.cend(),
+                CONFIG_TOPIC) == 2);
+}
+
+TEST_CASE("Publish discovery again once Home Assistant is online.", "[device]")
+{
+    event::context context;
+    mqtt::config config{ "mqtt://test:1883" };
+    mqtt::session session{ context };
+    mqtt::client client{ context, session };
+
+    std::uint32_t generation = hass::discovery_cache::instance().generation();
+    bool rediscovered        = false;
+
+    // The broker keeps the session, only Home Assistant asks for discovery.
+    test_session_present              = true;
+    test_retained[hass::STATUS_TOPIC] = std::string{ hass::STATUS_ONLINE };
+
+    session.config(config);
+    device::discovery_watch watch{ context, session };
+
+    // Called after the watch handled the same message.
+    client.async_receive([&](auto result) {
+        REQUIRE(result.has_value());
+        rediscovered = device::rediscover(generation);
+
+        // The status topic is delivered once more on the clean session,
+        // ending the watch.
+        watch.stop();
+        session.async_disconnect([&](auto) {
+            test_session_present = false;
+            session.async_connect([](auto) {});
+        });
+    });
+    client.async_subscribe(hass::STATUS_TOPIC, [](auto) {});
+    session.async_connect([](auto) {});
+
+    context.run();
+
+    test_retained.clear();
+    test_session_present = false;
+
+    REQUIRE(rediscovered);
+}
@@ -0,0 +1,118 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "catch2/catch.hpp"
+
+#include <chrono>
+
+#include "device/options.hpp"
+#include "utils/json.hpp"
+
+TEST_CASE("Bind device options.", "[device]")
+{
+    using namespace b2h;
+
+    const auto opts = utils::json::bind<device::options>(R"({
+        "filters": [
+            { "sensor": "temperature", "deadband": 0.1, "hysteresis": 0.2 },
+            { "sensor": "battery", "min_interval": 600 }
+        ],
+        "bindkey": "814aac74c4f17b6c1581e1ab87816b99"
+    })");
+
+    REQUIRE(opts.filters.size() == 2);
+
+    const auto* temperature = opts.filter("temperature");
+    REQUIRE(temperature);
+    REQUIRE(temperature->deadband == Approx(0.1f));
+    REQUIRE(temperature->hysteresis == Approx(0.2f));
+    REQUIRE(temperature->min_interval == 0);
+
+    const auto* battery = opts.filter("battery");
+    REQUIRE(battery);
+    REQUIRE(battery->deadband == 0.0f);
+    REQUIRE(battery->min_interval == 600);
+
+    REQUIRE(opts.filter("humidity") == nullptr);
+    REQUIRE(opts.bindkey == "814aac74c4f17b6c1581e1ab87816b99");
+
+    const auto empty = utils::json::bind<device::options>("{}");
+    REQUIRE(empty.filters.empty());
+    REQUIRE(empty.bindkey.empty());
+}
+
+TEST_CASE("Publish every change without a filter.", "[device]")
+{
+    b2h::device::publish_filter filter;
+
+    REQUIRE(filter.pass(21.0f));
+    REQUIRE(!filter.pass(21.0f));
+    REQUIRE(filter.pass(21.01f));
+    REQUIRE(filter.pass(21.0f));
+}
+
+TEST_CASE("Suppress changes within the deadband.", "[device]")
+{
+    b2h::device::sensor_filter config{ "temperature", 0.1f, 0.0f, 0 };
+    b2h::device::publish_filter filter{ &config };
+
+    REQUIRE(filter.pass(21.0f));
+    REQUIRE(!filter.pass(21.05f));
+    REQUIRE(!filter.pass(20.95f));
+    REQUIRE(filter.pass(21.15f));
+
+    // Measured from the last published value, not the last reading.
+    REQUIRE(!filter.pass(21.2f));
+    REQUIRE(filter.pass(21.3f));
+}
+
+TEST_CASE("Require a larger change to reverse direction.", "[device]")
+{
+    b2h::device::sensor_filter config{ "temperature", 0.1f, 0.3f, 0 };
+    b2h::device::publish_filter filter{ &config };
+
+    REQUIRE(filter.pass(21.0f));
+    REQUIRE(filter.pass(21.1f));
+    REQUIRE(filter.pass(21.2f));
+
+    // Flapping between two readings is suppressed.
+    REQUIRE(!filter.pass(21.1f));
+    REQUIRE(!filter.pass(21.0f));
+    REQUIRE(filter.pass(20.85f));
+
+    // Continuing downwards needs the deadband only.
+    REQUIRE(filter.pass(20.7f));
+}
+
+TEST_CASE("Limit the publish interval.", "[device]")
+{
+    using namespace std::chrono_literals;
+    using clock_type = b2h::device::publish_filter::clock_type;
+
+    b2h::device::sensor_filter config{ "battery", 0.0f, 0.0f, 60 };
+    b2h::device::publish_filter filter{ &config };
+    const clock_type::time_point start{};
+
+    REQUIRE(filter.pass(3000.0f, start));
+    REQUIRE(!filter.pass(2990.0f, start + 30s));
+    REQUIRE(filter.pass(2990.0f, start + 60s));
+    REQUIRE(!filter.pass(2980.0f, start + 119s));
+    REQUIRE(filter.pass(2980.0f, start + 120s));
+}
@@ -0,0 +1,90 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "catch2/catch.hpp"
+
+#include <cstring>
+#include <string_view>
+
+#include "device/topic_arena.hpp"
+
+namespace
+{
+    constexpr std::string_view STATE_TMPL{ "homeassistant/sensor/{}/state" };
+    constexpr std::string_view CONFIG_TMPL{ "homeassistant/sensor/{}/config" };
+} // namespace
+
+TEST_CASE("Pack topics back to back.", "[device]")
+{
+    constexpr std::size_t capacity =
+        b2h::device::topic_size(STATE_TMPL, 4) +
+        b2h::device::topic_size(CONFIG_TMPL, 4);
+
+    static_assert(capacity == 32 + 33);
+
+    b2h::device::topic_arena<2, capacity> arena;
+
+    REQUIRE(arena.push(STATE_TMPL, "abcd"));
+    REQUIRE(arena.push(CONFIG_TMPL, "abcd"));
+
+    REQUIRE(arena.size() == 2);
+    REQUIRE(arena.bytes() == capacity);
+
+    REQUIRE(arena.view(0) == "homeassistant/sensor/abcd/state");
+    REQUIRE(arena.view(1) == "homeassistant/sensor/abcd/config");
+
+    // Null terminated, ready for the MQTT client.
+    REQUIRE(std::strcmp(arena.c_str(0), "homeassistant/sensor/abcd/state") ==
+            0);
+    REQUIRE(arena.c_str(1) == arena.c_str(0) + arena.view(0).size() + 1);
+
+    // No topic id left.
+    REQUIRE(!arena.push(STATE_TMPL, "abcd"));
+}
+
+TEST_CASE("Reject a topic that does not fit.", "[device]")
+{
+    constexpr std::size_t capacity = b2h::device::topic_size(STATE_TMPL, 4);
+
+    b2h::device::topic_arena<2, capacity> arena;
+
+    REQUIRE(!arena.push(STATE_TMPL, "abcde"));
+    REQUIRE(arena.size() == 0);
+
+    REQUIRE(arena.push(STATE_TMPL, "abcd"));
+    REQUIRE(!arena.push(STATE_TMPL, ""));
+    REQUIRE(arena.size() == 1);
+    REQUIRE(arena.view(0) == "homeassistant/sensor/abcd/state");
+}
+
+TEST_CASE("Nest topic templates.", "[device]")
+{
+    constexpr std::string_view unique_id_tmpl{ "lywsd03mmc_{}_humidity" };
+    constexpr std::size_t capacity = b2h::device::topic_size(STATE_TMPL,
+        b2h::device::topic_size(unique_id_tmpl, 12) - 1);
+
+    b2h::device::topic_arena<1, capacity> arena;
+
+    REQUIRE(arena.push("homeassistant/sensor/lywsd03mmc_{}_humidity/state",
+        "a4c138000001"));
+    REQUIRE(arena.bytes() == capacity);
+    REQUIRE(arena.view(0) ==
+            "homeassistant/sensor/lywsd03mmc_a4c138000001_humidity/state");
+}
@@ -35,16 +35,21 @@ namespace b2h::device
         }
 
         std::shared_ptr<interface> device_builder::build(
-            const std::string_view name) && noexcept
+            const std::string_view name, const options& opts) && noexcept
         {
             if (auto iter = g_factory_map.find(name);
                 iter != g_factory_map.end())
             {
                 auto& factory_fun = iter->second;
                 auto device       = factory_fun(std::move(m_mqtt_client),
-                    std::move(m_gatt_client));
+                    std::move(m_gatt_client),
+                    opts);
+
+                if (device->connection_handle() != BLE_HS_CONN_HANDLE_NONE)
+                {
+                    device->on_connected();
+                }
 
-                device->on_connected();
                 return device;
             }
 
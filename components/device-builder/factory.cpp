@@ -31,10 +31,11 @@ namespace b2h::device
     constexpr auto make_factory() noexcept
     {
         return [](std::unique_ptr<mqtt::client>&& mqtt_client,
-                   std::unique_ptr<ble::gatt::client>&& gatt_client)
-                   -> std::shared_ptr<interface> {
+                   std::unique_ptr<ble::gatt::client>&& gatt_client,
+                   const options& opts) -> std::shared_ptr<interface> {
             return std::make_shared<DeviceT>(std::move(mqtt_client),
-                std::move(gatt_client));
+                std::move(gatt_client),
+                opts);
         };
     }
 
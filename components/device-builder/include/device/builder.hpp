@@ -21,8 +21,11 @@
 #ifndef B2H_DEVICE_BUILDER_HPP
 #define B2H_DEVICE_BUILDER_HPP
 
+#include "host/ble_hs.h"
+
 #include "ble/gap/central.hpp"
 #include "device/base.hpp"
+#include "device/options.hpp"
 
 #include <future>
 #include <memory>
@@ -45,8 +48,8 @@ namespace b2h::device
             device_builder& operator=(const device_builder&) = delete;
             device_builder& operator=(device_builder&&) = default;
 
-            std::shared_ptr<interface> build(
-                const std::string_view name) && noexcept;
+            std::shared_ptr<interface> build(const std::string_view name,
+                const options& opts = {}) && noexcept;
 
         private:
             std::unique_ptr<mqtt::client> m_mqtt_client;
@@ -99,6 +102,23 @@ namespace b2h::device
                 };
             }
 
+            /**
+             * @brief Client of a device which is never connected to, its
+             * readings come in advertisements.
+             *
+             * @param mac Device MAC address.
+             * @return device_builder
+             */
+            device_builder gatt_client(const utils::mac& mac) &&
+            {
+                return device_builder{
+                    std::move(m_mqtt_client),
+                    std::make_unique<ble::gatt::client>(m_context,
+                        BLE_HS_CONN_HANDLE_NONE,
+                        mac),
+                };
+            }
+
         private:
             event::context& m_context;
             std::unique_ptr<mqtt::client> m_mqtt_client;
@@ -119,33 +139,11 @@ namespace b2h::device
             mqtt_builder& operator=(const mqtt_builder&) = delete;
             mqtt_builder& operator=(mqtt_builder&&) = default;
 
-            gatt_builder mqtt_client(const mqtt::config& config) &&
+            gatt_builder mqtt_client(mqtt::session& session) &&
             {
-                using connect_arg_t = events::mqtt::connect::expected_type;
-
-                std::unique_ptr<mqtt::client> client =
-                    std::make_unique<mqtt::client>(m_context);
-
-                client->config(config);
-
-                std::packaged_task<connect_arg_t(connect_arg_t &&)>
-                    connection_task{
-                        [](auto&& arg) { return arg; },
-                    };
-
-                auto connection_future = connection_task.get_future();
-                client->async_connect(std::ref(connection_task));
-                auto result = connection_future.get();
-
-                if (!result.has_value())
-                {
-                    throw std::runtime_error(
-                        "Failed to initialize MQTT client.");
-                }
-
                 return gatt_builder{
                     m_context,
-                    std::move(client),
+                    std::make_unique<mqtt::client>(m_context, session),
                 };
             }
 
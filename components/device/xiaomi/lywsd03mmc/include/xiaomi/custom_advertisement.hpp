@@ -0,0 +1,118 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef B2H_DEVICE_XIAOMI_CUSTOM_ADVERTISEMENT_HPP
+#define B2H_DEVICE_XIAOMI_CUSTOM_ADVERTISEMENT_HPP
+
+#include <array>
+#include <cstdint>
+#include <optional>
+
+#include "tcb/span.hpp"
+
+namespace b2h::device::xiaomi
+{
+    // Environmental Sensing service, custom firmware advertises the
+    // readings as its service data.
+    inline constexpr std::uint16_t CUSTOM_ADV_SERVICE_UUID{ 0x181A };
+
+    // atc1441 format: MAC (big endian), temperature in 0.1 °C, humidity and
+    // battery in %, battery in mV and frame counter, multi-byte fields big
+    // endian.
+    inline constexpr std::size_t ATC1441_ADV_SIZE{ 13 };
+
+    // pvvx custom format: MAC, temperature in 0.01 °C, humidity in 0.01 %,
+    // battery in mV and %, frame counter and flags, all little endian.
+    inline constexpr std::size_t PVVX_ADV_SIZE{ 15 };
+
+    struct custom_reading {
+        std::int16_t temperature; // 0.01 °C
+        std::uint16_t humidity;   // 0.01 %
+        std::uint16_t voltage;    // mV
+        std::uint8_t battery;     // %
+        std::uint8_t counter;     // Changes with each new measurement.
+    };
+
+    /**
+     * @brief Decode service data of LYWSD03MMC running atc1441 or pvvx custom
+     * firmware, in either of the unencrypted formats.
+     *
+     * @param data Service data of CUSTOM_ADV_SERVICE_UUID.
+     * @return Reading, std::nullopt for other formats.
+     */
+    inline std::optional<custom_reading> decode_custom_advertisement(
+        tcb::span<const std::uint8_t> data) noexcept
+    {
+        const auto be16 = [&](std::size_t i) {
+            return static_cast<std::uint16_t>((data[i] << 8) | data[i + 1]);
+        };
+
+        const auto le16 = [&](std::size_t i) {
+            return static_cast<std::uint16_t>(data[i] | (data[i + 1] << 8));
+        };
+
+        switch (data.size())
+        {
+        case ATC1441_ADV_SIZE:
+            return custom_reading{
+                static_cast<std::int16_t>(
+                    static_cast<std::int16_t>(be16(6)) * 10),
+                static_cast<std::uint16_t>(data[8] * 100),
+                be16(10),
+                data[9],
+                data[12],
+            };
+        case PVVX_ADV_SIZE:
+            return custom_reading{
+                static_cast<std::int16_t>(le16(6)),
+                le16(8),
+                le16(10),
+                data[12],
+                data[13],
+            };
+        default:
+            return std::nullopt;
+        }
+    }
+
+    /**
+     * @brief Lay out the reading as the DATA characteristic notifies it:
+     * temperature in 0.01 °C, humidity in %, battery in mV, little endian.
+     *
+     * @param reading
+     * @return std::array<std::uint8_t, 5>
+     */
+    inline std::array<std::uint8_t, 5> to_notify_data(
+        const custom_reading& reading) noexcept
+    {
+        const auto temperature =
+            static_cast<std::uint16_t>(reading.temperature);
+
+        return {
+            static_cast<std::uint8_t>(temperature & 0xFF),
+            static_cast<std::uint8_t>(temperature >> 8),
+            static_cast<std::uint8_t>((reading.humidity + 50) / 100),
+            static_cast<std::uint8_t>(reading.voltage & 0xFF),
+            static_cast<std::uint8_t>(reading.voltage >> 8),
+        };
+    }
+} // namespace b2h::device::xiaomi
+
+#endif
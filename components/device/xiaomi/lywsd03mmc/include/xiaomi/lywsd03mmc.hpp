@@ -23,13 +23,18 @@
 
 #include "ble/gatt/client.hpp"
 #include "device/base.hpp"
+#include "device/discovery.hpp"
+#include "device/options.hpp"
+#include "device/topic_arena.hpp"
 #include "hass/device_types.hpp"
+#include "hass/payload_template.hpp"
 #include "mqtt/client.hpp"
 #include "utils/json.hpp"
 #include "utils/logger.hpp"
 
 #include <array>
 #include <functional>
+#include <optional>
 #include <queue>
 #include <thread>
 #include <variant>
@@ -37,8 +42,12 @@
 #include "boost/sml.hpp"
 #include "fmt/format.h"
 
+#include "host/ble_hs.h"
 #include "host/ble_uuid.h"
 
+#include "xiaomi/custom_advertisement.hpp"
+#include "xiaomi/mibeacon.hpp"
+
 namespace b2h::device::xiaomi
 {
     namespace lywsd03mmc_impl
@@ -51,6 +60,10 @@ namespace b2h::device::xiaomi
             struct disconnected {
             };
 
+            // Reading received from an advertisement, not a connection.
+            struct advertised {
+            };
+
             struct notify {
                 std::uint16_t attr_handle;
                 std::vector<std::uint8_t> data;
@@ -71,7 +84,7 @@ namespace b2h::device::xiaomi
             };
         } // namespace events
 
-        static constexpr std::string_view COMPONENT{ "xiaomi::lywsd03mmc" };
+        static constexpr log::component COMPONENT{ "xiaomi::lywsd03mmc" };
 
         static constexpr std::string_view DEVICE_NAME{
             "Mi Temperature & Humidity Monitor 2"
@@ -105,6 +118,16 @@ namespace b2h::device::xiaomi
             "lywsd03mmc_{}_battery"
         };
 
+        // Discovery cache entries of the sensors.
+        static constexpr std::uint8_t TEMPERATURE_SENSOR_INDEX{ 0 };
+        static constexpr std::uint8_t HUMIDITY_SENSOR_INDEX{ 1 };
+        static constexpr std::uint8_t BATTERY_SENSOR_INDEX{ 2 };
+        static constexpr std::uint8_t DEVICE_INDEX{ 3 };
+
+        // Slots of the discovery payload templates.
+        static constexpr std::size_t ID_SLOT{ 0 };
+        static constexpr std::size_t MAC_SLOT{ 1 };
+
         static constexpr std::string_view SENSOR_CONFIG_TOPIC_TMPL{
             "homeassistant/sensor/{}/config"
         };
@@ -112,6 +135,46 @@ namespace b2h::device::xiaomi
             "homeassistant/sensor/{}/state"
         };
 
+        static constexpr std::string_view DEVICE_UNIQUE_ID_TMPL{
+            "lywsd03mmc_{}"
+        };
+        static constexpr std::string_view DEVICE_CONFIG_TOPIC_TMPL{
+            "homeassistant/device/{}/config"
+        };
+
+        // Topics of the device arena, in the order they are rendered. Only
+        // the state topics published on every reading are kept, config topics
+        // are rendered when discovery is published.
+        static constexpr std::size_t TEMPERATURE_STATE_TOPIC{ 0 };
+        static constexpr std::size_t HUMIDITY_STATE_TOPIC{ 1 };
+        static constexpr std::size_t BATTERY_STATE_TOPIC{ 2 };
+
+        static constexpr std::size_t TOPIC_COUNT{ 3 };
+
+        // Size of the topic with the device unique id in its slot.
+        constexpr std::size_t device_topic_size(
+            const std::string_view topic_tmpl,
+            const std::string_view unique_id_tmpl) noexcept
+        {
+            return topic_size(topic_tmpl,
+                topic_size(unique_id_tmpl, utils::mac::MAC_ID_SIZE) - 1);
+        }
+
+        static constexpr std::size_t TOPIC_ARENA_SIZE{
+            device_topic_size(SENSOR_STATE_TOPIC_TMPL,
+                TEMPERATURE_SENSOR_UNIQUE_ID_TMPL) +
+            device_topic_size(SENSOR_STATE_TOPIC_TMPL,
+                HUMIDITY_SENSOR_UNIQUE_ID_TMPL) +
+            device_topic_size(SENSOR_STATE_TOPIC_TMPL,
+                BATTERY_SENSOR_UNIQUE_ID_TMPL)
+        };
+
+        // The MAC id sits at the same place in each sensor state topic.
+        static constexpr std::size_t DEVICE_ID_OFFSET{
+            SENSOR_STATE_TOPIC_TMPL.find("{}") +
+            TEMPERATURE_SENSOR_UNIQUE_ID_TMPL.find("{}")
+        };
+
         static constexpr ble_uuid128_t DATA_SRV{
             BLE_UUID_TYPE_128,
             {
@@ -156,20 +219,58 @@ namespace b2h::device::xiaomi
             },
         };
 
+        // MiBeacon frames carry one or two of the readings each.
+        struct mibeacon_reading {
+            std::optional<float> temperature;
+            std::optional<float> humidity;
+            std::optional<float> battery;
+        };
+
         using topic_buffer_t     = std::array<char, 64>;
         using unique_id_buffer_t = std::array<char, 35>;
-        using id_buffer_t        = std::array<char, 12>;
         using meas_buffer_t      = std::array<char, 5>;
+        using topic_arena_t      = topic_arena<TOPIC_COUNT, TOPIC_ARENA_SIZE>;
+
+        /**
+         * @brief Render the state topics of the device.
+         *
+         * @param mac Device MAC address.
+         * @return topic_arena_t
+         */
+        inline topic_arena_t make_topics(const utils::mac& mac) noexcept
+        {
+            const auto id = mac.to_id();
+
+            topic_arena_t topics;
+
+            const auto push = [&](const std::string_view topic_tmpl,
+                                  const std::string_view unique_id_tmpl) {
+                unique_id_buffer_t unique_id_buf;
+
+                const auto [out, size] =
+                    fmt::format_to_n(unique_id_buf.begin(),
+                        unique_id_buf.size(),
+                        unique_id_tmpl,
+                        std::string_view{ id.data(), id.size() });
+
+                [[maybe_unused]] const bool pushed = topics.push(topic_tmpl,
+                    std::string_view{ unique_id_buf.data(), size });
+
+                assert(pushed);
+            };
+
+            push(SENSOR_STATE_TOPIC_TMPL, TEMPERATURE_SENSOR_UNIQUE_ID_TMPL);
+            push(SENSOR_STATE_TOPIC_TMPL, HUMIDITY_SENSOR_UNIQUE_ID_TMPL);
+            push(SENSOR_STATE_TOPIC_TMPL, BATTERY_SENSOR_UNIQUE_ID_TMPL);
+
+            return topics;
+        }
 
         struct lywsd03mmc_state {
             struct configure {
-                using mac_buffer_t = std::array<char, utils::mac::MAC_STR_SIZE>;
                 using connection_tuple_t =
                     std::pair<std::string_view, std::string_view>;
                 using connections_list_t = std::array<connection_tuple_t, 1>;
-
-                mac_buffer_t mac_buf;
-                connections_list_t conn;
             };
 
             struct operate {
@@ -188,14 +289,19 @@ namespace b2h::device::xiaomi
             ble::gatt::client& gatt_client;
             mqtt::client& mqtt_client;
 
-            topic_buffer_t temp_sens_topic;
-            topic_buffer_t hum_sens_topic;
-            topic_buffer_t batt_sens_topic;
+            topic_arena_t topics;
+
+            publish_filter temp_filter;
+            publish_filter hum_filter;
+            publish_filter batt_filter;
 
             state_variant_t state_var;
 
             std::uint16_t data_attr_handle;
 
+            // Discovery cache generation the configs were published at.
+            std::uint32_t discovery_generation;
+
             std::function<void(external_event_variant_t)>
                 process_external_event;
         };
@@ -217,30 +323,19 @@ namespace b2h::device::xiaomi
                         });
                 };
 
-                const auto mac_to_id = [](const utils::mac& mac,
-                                           id_buffer_t& buf) {
-                    const auto mac_bytes   = mac.as_bytes();
-                    const auto [out, size] = fmt::format_to_n(buf.begin(),
-                        buf.size(),
-                        "{:02x}{:02x}{:02x}{:02x}{:02x}{:02x}",
-                        mac_bytes[5],
-                        mac_bytes[4],
-                        mac_bytes[3],
-                        mac_bytes[2],
-                        mac_bytes[1],
-                        mac_bytes[0]);
-
-                    return std::string_view{ buf.data(), size };
+                // MAC without separators, as rendered into the topics.
+                const auto device_id = [](const lywsd03mmc_state& state) {
+                    return state.topics.view(TEMPERATURE_STATE_TOPIC)
+                        .substr(DEVICE_ID_OFFSET, utils::mac::MAC_ID_SIZE);
                 };
 
-                const auto make_unique_id = [=](const std::string_view tmpl,
-                                                const utils::mac& mac,
+                const auto make_unique_id = [](const std::string_view tmpl,
+                                                const std::string_view id,
                                                 unique_id_buffer_t& buf) {
-                    id_buffer_t id_buf{};
                     const auto [out, size] = fmt::format_to_n(buf.begin(),
                         buf.size(),
                         tmpl,
-                        mac_to_id(mac, id_buf));
+                        id);
 
                     return std::string_view{ buf.data(), size };
                 };
@@ -248,14 +343,14 @@ namespace b2h::device::xiaomi
                 const auto make_topic =
                     [=](const std::string_view topic_tmpl,
                         const std::string_view unique_id_tmpl,
-                        const utils::mac& mac,
+                        const std::string_view id,
                         topic_buffer_t& buf) {
                         unique_id_buffer_t unique_id_buf{};
 
                         const auto [out, size] = fmt::format_to_n(buf.begin(),
                             buf.size() - 1,
                             topic_tmpl,
-                            make_unique_id(unique_id_tmpl, mac, unique_id_buf));
+                            make_unique_id(unique_id_tmpl, id, unique_id_buf));
 
                         assert(size != buf.size());
                         *out = '\0';
@@ -264,32 +359,22 @@ namespace b2h::device::xiaomi
 
                 const auto make_state_topic =
                     [=](const std::string_view unique_id_tmpl,
-                        const utils::mac& mac,
+                        const std::string_view id,
                         topic_buffer_t& buf) {
                         return make_topic(SENSOR_STATE_TOPIC_TMPL,
                             unique_id_tmpl,
-                            mac,
-                            buf);
-                    };
-
-                const auto make_config_topic =
-                    [=](const std::string_view unique_id_tmpl,
-                        const utils::mac& mac,
-                        topic_buffer_t& buf) {
-                        return make_topic(SENSOR_CONFIG_TOPIC_TMPL,
-                            unique_id_tmpl,
-                            mac,
+                            id,
                             buf);
                     };
 
                 const auto make_hass_device =
-                    [](lywsd03mmc_state::configure& state) {
+                    [](lywsd03mmc_state::configure::connections_list_t& conn) {
                         hass::device_type device;
 
                         device.name         = DEVICE_NAME;
                         device.model        = DEVICE_MODEL;
                         device.manufacturer = DEVICE_MANUFACTURER;
-                        device.connections  = tcb::make_span(state.conn);
+                        device.connections  = tcb::make_span(conn);
 
                         return device;
                     };
@@ -308,32 +393,22 @@ namespace b2h::device::xiaomi
                     };
                 };
 
-                auto on_start = [=](lywsd03mmc_state& state) mutable {
-                    using namespace std::literals;
-
-                    const utils::mac& mac = state.gatt_client.mac();
-
-                    auto& state_var =
-                        state.state_var
-                            .template emplace<lywsd03mmc_state::configure>();
-
-                    state_var.conn[0].first = "mac"sv;
-                    state_var.conn[0].second =
-                        mac.to_charbuf(state_var.mac_buf.begin(),
-                               state_var.mac_buf.end())
-                            .value();
-
-                    make_state_topic(TEMPERATURE_SENSOR_UNIQUE_ID_TMPL,
-                        mac,
-                        state.temp_sens_topic);
-
-                    make_state_topic(HUMIDITY_SENSOR_UNIQUE_ID_TMPL,
-                        mac,
-                        state.hum_sens_topic);
+                // Measurement publishes are pipelined by the MQTT client, so
+                // their completion does not gate the state machine.
+                const auto publish_handler = [](auto&& result) {
+                    if (!result.has_value())
+                    {
+                        log::warning(COMPONENT,
+                            "Publish failed: {}.",
+                            esp_err_to_name(result.error()));
+                    }
+                };
 
-                    make_state_topic(BATTERY_SENSOR_UNIQUE_ID_TMPL,
-                        mac,
-                        state.batt_sens_topic);
+                auto on_start = [=](lywsd03mmc_state& state) mutable {
+                    state.state_var
+                        .template emplace<lywsd03mmc_state::configure>();
+                    state.discovery_generation =
+                        hass::discovery_cache::instance().generation();
 
                     state.gatt_client.async_discover_service_by_uuid(
                         &DATA_SRV.u,
@@ -351,6 +426,18 @@ namespace b2h::device::xiaomi
                         });
                 };
 
+                // Readings come in advertisements, skip straight to the
+                // discovery config.
+                const auto on_listen =
+                    [](lywsd03mmc_state& state,
+                        back::process<events::write_finished> back_process) {
+                        state.state_var
+                            .template emplace<lywsd03mmc_state::configure>();
+                        state.discovery_generation =
+                            hass::discovery_cache::instance().generation();
+                        back_process(events::write_finished{});
+                    };
+
                 const auto on_srv_disced = [](lywsd03mmc_state& state,
                                                events::srv_disced event) {
                     state.gatt_client.async_discover_characteristics(
@@ -402,96 +489,97 @@ namespace b2h::device::xiaomi
                         });
                 };
 
-                auto on_data_subscribe = [=](lywsd03mmc_state& state) mutable {
-                    using namespace std::literals;
+                // Sensor config with template slot in place of the device id,
+                // buffers hold the strings it references.
+                const auto make_sensor =
+                    [=](const std::string_view unique_id_tmpl,
+                        const auto& describe,
+                        topic_buffer_t& topic_buf,
+                        unique_id_buffer_t& unique_id_buf) {
+                        const auto id = hass::payload_template::slot(ID_SLOT);
 
-                    const utils::mac& mac = state.gatt_client.mac();
+                        hass::sensor_type sens;
 
-                    topic_buffer_t topic_buf;
-                    unique_id_buffer_t unique_id_buf{};
-                    hass::sensor_type sens;
+                        sens.qos = 0;
+                        sens.state_topic =
+                            make_state_topic(unique_id_tmpl, id, topic_buf);
+                        sens.unique_id =
+                            make_unique_id(unique_id_tmpl, id, unique_id_buf);
 
-                    auto& state_var =
-                        std::get<lywsd03mmc_state::configure>(state.state_var);
+                        describe(sens);
+
+                        return sens;
+                    };
+
+                // Serializes sensor config with template slots in place of the
+                // device id and MAC. Done once per sensor, every device then
+                // only fills in the slots.
+                const auto make_payload_template =
+                    [=](const std::string_view unique_id_tmpl,
+                        const auto& describe) {
+                        using namespace std::literals;
+
+                        const auto mac = hass::payload_template::slot(MAC_SLOT);
+
+                        lywsd03mmc_state::configure::connections_list_t conn{ {
+                            { "mac"sv, mac },
+                        } };
+
+                        topic_buffer_t topic_buf{};
+                        unique_id_buffer_t unique_id_buf{};
+
+                        auto sens = make_sensor(unique_id_tmpl,
+                            describe,
+                            topic_buf,
+                            unique_id_buf);
+
+                        sens.device = make_hass_device(conn);
+
+                        return hass::payload_template{
+                            utils::json::dump(hass::serialize(sens,
+                                hass::payload_mode::minimal)),
+                        };
+                    };
+
+                const auto render_payload =
+                    [=](lywsd03mmc_state& state,
+                        const hass::payload_template& tmpl) {
+                        // Indexed by ID_SLOT and MAC_SLOT.
+                        const std::array<std::string_view, 2> values{
+                            device_id(state),
+                            state.gatt_client.mac().str(),
+                        };
+
+                        return tmpl.render(values);
+                    };
+
+                const auto describe_temp_sens = [](hass::sensor_type& sens) {
+                    using namespace std::literals;
+
+                    sens.name = TEMPERATURE_SENSOR_NAME;
 
-                    sens.device              = make_hass_device(state_var);
-                    sens.state_topic         = state.temp_sens_topic.data();
-                    sens.name                = TEMPERATURE_SENSOR_NAME;
                     sens.device_class        = "temperature"sv;
                     sens.unit_of_measurement = "°C"sv;
-                    sens.qos                 = 0;
-                    sens.unique_id =
-                        make_unique_id(TEMPERATURE_SENSOR_UNIQUE_ID_TMPL,
-                            mac,
-                            unique_id_buf);
                     sens.value_template =
                         "{{ ((value_json | float(0)) * 0.01) | round(2) }}"sv;
-
-                    state.mqtt_client.async_publish(
-                        make_config_topic(TEMPERATURE_SENSOR_UNIQUE_ID_TMPL,
-                            mac,
-                            topic_buf),
-                        utils::json::dump(hass::serialize(sens)),
-                        1,
-                        true,
-                        write_handler(state));
                 };
 
-                auto on_conf_temp_sens = [=](lywsd03mmc_state& state) mutable {
+                const auto describe_humi_sens = [](hass::sensor_type& sens) {
                     using namespace std::literals;
 
-                    const utils::mac& mac = state.gatt_client.mac();
-
-                    topic_buffer_t topic_buf;
-                    unique_id_buffer_t unique_id_buf{};
-                    hass::sensor_type sens;
+                    sens.name = HUMIDITY_SENSOR_NAME;
 
-                    auto& state_var =
-                        std::get<lywsd03mmc_state::configure>(state.state_var);
-
-                    sens.device              = make_hass_device(state_var);
-                    sens.state_topic         = state.hum_sens_topic.data();
-                    sens.name                = HUMIDITY_SENSOR_NAME;
                     sens.device_class        = "humidity"sv;
                     sens.unit_of_measurement = "%"sv;
-                    sens.qos                 = 0;
-                    sens.unique_id =
-                        make_unique_id(HUMIDITY_SENSOR_UNIQUE_ID_TMPL,
-                            mac,
-                            unique_id_buf);
-
-                    state.mqtt_client.async_publish(
-                        make_config_topic(HUMIDITY_SENSOR_UNIQUE_ID_TMPL,
-                            mac,
-                            topic_buf),
-                        utils::json::dump(hass::serialize(sens)),
-                        1,
-                        true,
-                        write_handler(state));
                 };
 
-                auto on_conf_humi_sens = [=](lywsd03mmc_state& state) mutable {
+                const auto describe_batt_sens = [](hass::sensor_type& sens) {
                     using namespace std::literals;
 
-                    const utils::mac& mac = state.gatt_client.mac();
-
-                    topic_buffer_t topic_buf;
-                    unique_id_buffer_t unique_id_buf{};
-                    hass::sensor_type sens;
+                    sens.name = BATTERY_SENSOR_NAME;
 
-                    auto& state_var =
-                        std::get<lywsd03mmc_state::configure>(state.state_var);
-
-                    sens.device              = make_hass_device(state_var);
-                    sens.state_topic         = state.batt_sens_topic.data();
-                    sens.name                = BATTERY_SENSOR_NAME;
                     sens.device_class        = "battery"sv;
                     sens.unit_of_measurement = "%"sv;
-                    sens.qos                 = 0;
-                    sens.unique_id =
-                        make_unique_id(BATTERY_SENSOR_UNIQUE_ID_TMPL,
-                            mac,
-                            unique_id_buf);
                     sens.value_template =
                         "{% if value_json >= 3000 %}"
                         "{{ 100 }}"
@@ -500,149 +588,323 @@ namespace b2h::device::xiaomi
                         "{% else %}"
                         "{{ (100.0 * (((value_json | float(0)) - 2100.0) / 900.0)) | round(0) }}"
                         "{% endif %}"sv;
+                };
 
-                    state.mqtt_client.async_publish(
-                        make_config_topic(BATTERY_SENSOR_UNIQUE_ID_TMPL,
-                            mac,
-                            topic_buf),
-                        utils::json::dump(hass::serialize(sens)),
-                        1,
-                        true,
-                        write_handler(state));
+                const auto render_temp_sens = [=](lywsd03mmc_state& state) {
+                    static const hass::payload_template tmpl =
+                        make_payload_template(TEMPERATURE_SENSOR_UNIQUE_ID_TMPL,
+                            describe_temp_sens);
+
+                    return render_payload(state, tmpl);
                 };
 
-                const auto set_operate = [](lywsd03mmc_state& state) {
-                    state.state_var
-                        .template emplace<lywsd03mmc_state::operate>();
+                const auto render_humi_sens = [=](lywsd03mmc_state& state) {
+                    static const hass::payload_template tmpl =
+                        make_payload_template(HUMIDITY_SENSOR_UNIQUE_ID_TMPL,
+                            describe_humi_sens);
+
+                    return render_payload(state, tmpl);
                 };
 
-                const auto is_data_handle = [](lywsd03mmc_state& state,
-                                                const events::notify& event) {
-                    return event.attr_handle == state.data_attr_handle;
+                const auto render_batt_sens = [=](lywsd03mmc_state& state) {
+                    static const hass::payload_template tmpl =
+                        make_payload_template(BATTERY_SENSOR_UNIQUE_ID_TMPL,
+                            describe_batt_sens);
+
+                    return render_payload(state, tmpl);
                 };
 
-                const auto is_temp_upd = [](lywsd03mmc_state& state,
-                                             const events::notify& event) {
-                    const std::uint16_t temperature =
-                        (static_cast<std::uint16_t>(event.data[1]) << 8) |
-                        event.data[0];
+                // All three sensors in a single device discovery payload.
+                const auto make_device_payload_template = [=]() {
+                    using namespace std::literals;
 
-                    auto& state_var =
-                        std::get<lywsd03mmc_state::operate>(state.state_var);
+                    const auto mac = hass::payload_template::slot(MAC_SLOT);
+
+                    lywsd03mmc_state::configure::connections_list_t conn{ {
+                        { "mac"sv, mac },
+                    } };
+
+                    std::array<topic_buffer_t, 3> topic_bufs{};
+                    std::array<unique_id_buffer_t, 3> unique_id_bufs{};
+
+                    const std::array<hass::sensor_type, 3> sensors{
+                        make_sensor(TEMPERATURE_SENSOR_UNIQUE_ID_TMPL,
+                            describe_temp_sens,
+                            topic_bufs[0],
+                            unique_id_bufs[0]),
+                        make_sensor(HUMIDITY_SENSOR_UNIQUE_ID_TMPL,
+                            describe_humi_sens,
+                            topic_bufs[1],
+                            unique_id_bufs[1]),
+                        make_sensor(BATTERY_SENSOR_UNIQUE_ID_TMPL,
+                            describe_batt_sens,
+                            topic_bufs[2],
+                            unique_id_bufs[2]),
+                    };
 
-                    if (temperature == state_var.temperature)
-                    {
-                        return false;
-                    }
+                    const std::array<hass::component_type, 3> components{ {
+                        { "temperature"sv, &sensors[0] },
+                        { "humidity"sv, &sensors[1] },
+                        { "battery"sv, &sensors[2] },
+                    } };
+
+                    hass::device_discovery_type discovery;
 
-                    state_var.temperature = temperature;
-                    return true;
+                    discovery.device      = make_hass_device(conn);
+                    discovery.origin.name = ORIGIN_NAME;
+                    discovery.components  = components;
+
+                    return hass::payload_template{
+                        utils::json::dump(hass::serialize(discovery,
+                            hass::payload_mode::minimal)),
+                    };
                 };
 
-                const auto upd_temp = [=](lywsd03mmc_state& state) {
-                    using namespace std::literals;
+                const auto render_device = [=](lywsd03mmc_state& state) {
+                    static const hass::payload_template tmpl =
+                        make_device_payload_template();
 
-                    auto& state_var =
-                        std::get<lywsd03mmc_state::operate>(state.state_var);
+                    return render_payload(state, tmpl);
+                };
+
+                // Config topic rendered on the stack, the client copies it.
+                const auto make_config_topic =
+                    [=](lywsd03mmc_state& state,
+                        const std::string_view topic_tmpl,
+                        const std::string_view unique_id_tmpl,
+                        topic_buffer_t& buf) {
+                        return make_topic(topic_tmpl,
+                            unique_id_tmpl,
+                            device_id(state),
+                            buf);
+                    };
+
+                // Publishes discovery config through the discovery cache. A
+                // config already retained by the broker completes immediately.
+                const auto publish_config =
+                    [=](lywsd03mmc_state& state,
+                        const std::uint8_t index,
+                        const std::string_view topic_tmpl,
+                        const std::string_view unique_id_tmpl,
+                        const auto& render,
+                        back::process<events::write_finished> back_process) {
+                        const hass::discovery_cache::key key{ DEVICE_MODEL,
+                            state.gatt_client.mac(),
+                            index };
+
+                        topic_buffer_t topic_buf;
+
+                        const bool started = publish_discovery(
+                            state.mqtt_client,
+                            key,
+                            make_config_topic(state,
+                                topic_tmpl,
+                                unique_id_tmpl,
+                                topic_buf),
+                            [&] { return render(state); },
+                            write_handler(state));
+
+                        if (!started)
+                        {
+                            back_process(events::write_finished{});
+                        }
+                    };
+
+                const auto on_data_subscribe =
+                    [=](lywsd03mmc_state& state,
+                        back::process<events::write_finished> back_process) {
+                        publish_config(state,
+                            TEMPERATURE_SENSOR_INDEX,
+                            SENSOR_CONFIG_TOPIC_TMPL,
+                            TEMPERATURE_SENSOR_UNIQUE_ID_TMPL,
+                            render_temp_sens,
+                            back_process);
+                    };
+
+                const auto on_conf_temp_sens =
+                    [=](lywsd03mmc_state& state,
+                        back::process<events::write_finished> back_process) {
+                        publish_config(state,
+                            HUMIDITY_SENSOR_INDEX,
+                            SENSOR_CONFIG_TOPIC_TMPL,
+                            HUMIDITY_SENSOR_UNIQUE_ID_TMPL,
+                            render_humi_sens,
+                            back_process);
+                    };
+
+                const auto on_conf_humi_sens =
+                    [=](lywsd03mmc_state& state,
+                        back::process<events::write_finished> back_process) {
+                        publish_config(state,
+                            BATTERY_SENSOR_INDEX,
+                            SENSOR_CONFIG_TOPIC_TMPL,
+                            BATTERY_SENSOR_UNIQUE_ID_TMPL,
+                            render_batt_sens,
+                            back_process);
+                    };
+
+                const auto on_conf_device =
+                    [=](lywsd03mmc_state& state,
+                        back::process<events::write_finished> back_process) {
+                        publish_config(state,
+                            DEVICE_INDEX,
+                            DEVICE_CONFIG_TOPIC_TMPL,
+                            DEVICE_UNIQUE_ID_TMPL,
+                            render_device,
+                            back_process);
+                    };
+
+                const auto device_discovery = [] { return DEVICE_DISCOVERY; };
+
+                const auto set_operate = [](lywsd03mmc_state& state) {
+                    state.state_var
+                        .template emplace<lywsd03mmc_state::operate>();
+                };
+
+                const auto is_data_handle = [](lywsd03mmc_state& state,
+                                                const events::notify& event) {
+                    return event.attr_handle == state.data_attr_handle;
+                };
+
+                const auto publish_measurement = [=](lywsd03mmc_state& state,
+                                                     const std::size_t topic,
+                                                     const auto value) {
                     meas_buffer_t buff;
 
-                    const auto [iter, size] = fmt::format_to_n(buff.begin(),
-                        buff.size(),
-                        "{}",
-                        state_var.temperature);
+                    const auto [iter, size] = fmt::format_to_n(
+                        buff.begin(), buff.size(), "{}", value);
 
-                    state.mqtt_client.async_publish(
-                        state.temp_sens_topic.data(),
+                    state.mqtt_client.async_publish(state.topics.c_str(topic),
                         std::string_view{
                             buff.data(),
                             size,
                         },
                         0,
                         true,
-                        write_handler(state));
+                        publish_handler);
                 };
 
-                const auto is_hum_upd = [](lywsd03mmc_state& state,
+                // Configs lost by the broker or Home Assistant since the
+                // device was configured, published ahead of the reading.
+                const auto republish_config = [=](lywsd03mmc_state& state) {
+                    const auto republish =
+                        [&](const std::uint8_t index,
+                            const std::string_view topic_tmpl,
+                            const std::string_view unique_id_tmpl,
+                            const auto& render) {
+                            topic_buffer_t topic_buf;
+
+                            publish_discovery(state.mqtt_client,
+                                { DEVICE_MODEL,
+                                    state.gatt_client.mac(),
+                                    index },
+                                make_config_topic(state,
+                                    topic_tmpl,
+                                    unique_id_tmpl,
+                                    topic_buf),
+                                [&] { return render(state); },
+                                publish_handler);
+                        };
+
+                    log::info(COMPONENT, "Publishing discovery again.");
+
+                    if constexpr (DEVICE_DISCOVERY)
+                    {
+                        republish(DEVICE_INDEX,
+                            DEVICE_CONFIG_TOPIC_TMPL,
+                            DEVICE_UNIQUE_ID_TMPL,
+                            render_device);
+                    }
+                    else
+                    {
+                        republish(TEMPERATURE_SENSOR_INDEX,
+                            SENSOR_CONFIG_TOPIC_TMPL,
+                            TEMPERATURE_SENSOR_UNIQUE_ID_TMPL,
+                            render_temp_sens);
+                        republish(HUMIDITY_SENSOR_INDEX,
+                            SENSOR_CONFIG_TOPIC_TMPL,
+                            HUMIDITY_SENSOR_UNIQUE_ID_TMPL,
+                            render_humi_sens);
+                        republish(BATTERY_SENSOR_INDEX,
+                            SENSOR_CONFIG_TOPIC_TMPL,
+                            BATTERY_SENSOR_UNIQUE_ID_TMPL,
+                            render_batt_sens);
+                    }
+                };
+
+                // A notification carries all three quantities, each one that
+                // passes its filter is published.
+                const auto on_reading = [=](lywsd03mmc_state& state,
                                             const events::notify& event) {
                     auto& state_var =
                         std::get<lywsd03mmc_state::operate>(state.state_var);
 
-                    if (state_var.humidity == event.data[2])
+                    if (rediscover(state.discovery_generation))
                     {
-                        return false;
+                        republish_config(state);
                     }
 
-                    state_var.humidity = event.data[2];
-                    return true;
-                };
-
-                const auto upd_hum = [=](lywsd03mmc_state& state) {
-                    auto& state_var =
-                        std::get<lywsd03mmc_state::operate>(state.state_var);
-                    meas_buffer_t buff;
+                    const std::uint16_t temperature =
+                        (static_cast<std::uint16_t>(event.data[1]) << 8) |
+                        event.data[0];
 
-                    const auto [iter, size] = fmt::format_to_n(buff.begin(),
-                        buff.size(),
-                        "{}",
-                        state_var.humidity);
+                    // Filtered in °C, the reading is in hundredths of it.
+                    if (state.temp_filter.pass(
+                            static_cast<std::int16_t>(temperature) * 0.01f))
+                    {
+                        state_var.temperature = temperature;
+                        publish_measurement(state,
+                            TEMPERATURE_STATE_TOPIC,
+                            state_var.temperature);
+                    }
 
-                    state.mqtt_client.async_publish(state.hum_sens_topic.data(),
-                        std::string_view{
-                            buff.data(),
-                            size,
-                        },
-                        0,
-                        true,
-                        write_handler(state));
-                };
+                    if (state.hum_filter.pass(event.data[2]))
+                    {
+                        state_var.humidity = event.data[2];
+                        publish_measurement(
+                            state, HUMIDITY_STATE_TOPIC, state_var.humidity);
+                    }
 
-                const auto is_batt_upd = [](lywsd03mmc_state& state,
-                                             const events::notify& event) {
                     const std::uint16_t voltage =
                         (static_cast<std::uint16_t>(event.data[4]) << 8) |
                         event.data[3];
 
-                    auto& state_var =
-                        std::get<lywsd03mmc_state::operate>(state.state_var);
-
-                    if (state_var.voltage == voltage)
+                    if (state.batt_filter.pass(voltage))
                     {
-                        return false;
+                        state_var.voltage = voltage;
+                        publish_measurement(
+                            state, BATTERY_STATE_TOPIC, state_var.voltage);
                     }
-
-                    state_var.voltage = voltage;
-                    return true;
                 };
 
-                const auto upd_batt = [=](lywsd03mmc_state& state) {
-                    auto& state_var =
-                        std::get<lywsd03mmc_state::operate>(state.state_var);
-                    meas_buffer_t buff;
-
-                    const auto [iter, size] = fmt::format_to_n(buff.begin(),
-                        buff.size(),
-                        "{}",
-                        state_var.voltage);
+                // Devices read from advertisements have no connection, they
+                // go back to idle and retry with the next advertisement.
+                const auto is_listening = [](lywsd03mmc_state& state) {
+                    return state.gatt_client.connection_handle() ==
+                           BLE_HS_CONN_HANDLE_NONE;
+                };
 
-                    state.mqtt_client.async_publish(
-                        state.batt_sens_topic.data(),
-                        std::string_view{
-                            buff.data(),
-                            size,
-                        },
-                        0,
-                        true,
-                        write_handler(state));
+                const auto on_abort_listen = [](lywsd03mmc_state& state) {
+                    log::warning(COMPONENT,
+                        "Configuration aborted, waiting for advertisement.");
+                    state.state_var.template emplace<std::monostate>();
                 };
 
                 const auto on_abort_conn = [](lywsd03mmc_state& state) {
+                    if (state.gatt_client.connection_handle() ==
+                        BLE_HS_CONN_HANDLE_NONE)
+                    {
+                        return;
+                    }
+
                     log::warning(COMPONENT, "Terminating BLE connection.");
                     state.gatt_client.terminate();
                 };
 
                 // clang-format off
                 return make_transition_table(
-                    *"idle"_s + sml::event<events::connected> / on_start = "disc_data_srv"_s,
+                    *"idle"_s + sml::event<events::connected>  / on_start  = "disc_data_srv"_s,
+                    "idle"_s  + sml::event<events::advertised> / on_listen = "data_subscribe"_s,
 
                     "disc_data_srv"_s + sml::event<events::srv_disced> / on_srv_disced = "disc_data_chrs"_s,
                     "disc_data_srv"_s + sml::event<events::abort>                      = "terminate"_s,
@@ -650,28 +912,32 @@ namespace b2h::device::xiaomi
                     "disc_data_chrs"_s + sml::event<events::chrs_disced> / on_chrs_disced = "data_subscribe"_s,
                     "disc_data_chrs"_s + sml::event<events::abort>                        = "terminate"_s,
 
-                    "data_subscribe"_s + sml::event<events::write_finished> / on_data_subscribe = "conf_temp_sens"_s,
-                    "data_subscribe"_s + sml::event<events::abort>                              = "terminate"_s,
+                    "data_subscribe"_s + sml::event<events::write_finished> [!device_discovery] / on_data_subscribe = "conf_temp_sens"_s,
+                    "data_subscribe"_s + sml::event<events::write_finished> [device_discovery]  / on_conf_device    = "conf_device"_s,
+                    "data_subscribe"_s + sml::event<events::abort>          [is_listening]      / on_abort_listen   = "idle"_s,
+                    "data_subscribe"_s + sml::event<events::abort>                                                  = "terminate"_s,
 
-                    "conf_temp_sens"_s + sml::event<events::write_finished> / on_conf_temp_sens = "conf_humi_sens"_s,
-                    "conf_temp_sens"_s + sml::event<events::abort>                              = "terminate"_s,
+                    "conf_device"_s + sml::event<events::write_finished>                / set_operate     = "operate"_s,
+                    "conf_device"_s + sml::event<events::abort>          [is_listening] / on_abort_listen = "idle"_s,
+                    "conf_device"_s + sml::event<events::abort>                                           = "terminate"_s,
 
-                    "conf_humi_sens"_s + sml::event<events::write_finished> / on_conf_humi_sens = "conf_batt_sens"_s,
-                    "conf_humi_sens"_s + sml::event<events::abort>                              = "terminate"_s,
+                    "conf_temp_sens"_s + sml::event<events::write_finished>                / on_conf_temp_sens = "conf_humi_sens"_s,
+                    "conf_temp_sens"_s + sml::event<events::abort>          [is_listening] / on_abort_listen   = "idle"_s,
+                    "conf_temp_sens"_s + sml::event<events::abort>                                             = "terminate"_s,
 
-                    "conf_batt_sens"_s + sml::event<events::write_finished> / set_operate = "operate"_s,
-                    "conf_batt_sens"_s + sml::event<events::abort>                        = "terminate"_s,
-            
-                    "operate"_s + sml::event<events::notify> [is_data_handle && is_batt_upd] / upd_batt = "param_write"_s,
-                    "operate"_s + sml::event<events::notify> [is_data_handle && is_hum_upd]  / upd_hum  = "param_write"_s,
-                    "operate"_s + sml::event<events::notify> [is_data_handle && is_temp_upd] / upd_temp = "param_write"_s,
+                    "conf_humi_sens"_s + sml::event<events::write_finished>                / on_conf_humi_sens = "conf_batt_sens"_s,
+                    "conf_humi_sens"_s + sml::event<events::abort>          [is_listening] / on_abort_listen   = "idle"_s,
+                    "conf_humi_sens"_s + sml::event<events::abort>                                             = "terminate"_s,
 
-                    "operate"_s + sml::event<events::abort>        = "terminate"_s,
-                    "operate"_s + sml::event<events::disconnected> = X,
+                    "conf_batt_sens"_s + sml::event<events::write_finished>                / set_operate     = "operate"_s,
+                    "conf_batt_sens"_s + sml::event<events::abort>          [is_listening] / on_abort_listen = "idle"_s,
+                    "conf_batt_sens"_s + sml::event<events::abort>                                           = "terminate"_s,
+            
+                    "operate"_s + sml::event<events::notify> [is_data_handle] / on_reading,
 
-                    "param_write"_s + sml::event<events::write_finished> = "operate"_s,
-                    "param_write"_s + sml::event<events::abort>          = "operate"_s,
-                    "param_write"_s + sml::event<events::disconnected>   = X,
+                    "operate"_s + sml::event<events::abort>        [is_listening] / on_abort_listen = "idle"_s,
+                    "operate"_s + sml::event<events::abort>                                         = "terminate"_s,
+                    "operate"_s + sml::event<events::disconnected>                                  = X,
 
                     "terminate"_s + on_entry<_> / on_abort_conn
                 );
@@ -684,7 +950,8 @@ namespace b2h::device::xiaomi
     {
     public:
         lywsd03mmc(std::unique_ptr<mqtt::client>&& mqtt_client,
-            std::unique_ptr<ble::gatt::client>&& gatt_client) noexcept;
+            std::unique_ptr<ble::gatt::client>&& gatt_client,
+            const options& opts = {}) noexcept;
 
         lywsd03mmc()                  = delete;
         lywsd03mmc(const lywsd03mmc&) = delete;
@@ -697,6 +964,8 @@ namespace b2h::device::xiaomi
         void on_connected() noexcept override;
         void on_notify(std::uint16_t attribute_handle,
             std::vector<std::uint8_t>&& data) noexcept override;
+        void on_advertisement(std::uint16_t service_uuid,
+            tcb::span<const std::uint8_t> service_data) noexcept override;
 
     private:
         using fsm_t = boost::sml::sm<lywsd03mmc_impl::lywsd03mmc_fsm,
@@ -706,6 +975,16 @@ namespace b2h::device::xiaomi
         lywsd03mmc_impl::lywsd03mmc_state m_state;
         fsm_t m_fsm;
 
+        // Counter of the last published advertised reading, repeats are
+        // dropped.
+        std::optional<std::uint8_t> m_adv_counter;
+
+        std::optional<aes_key> m_bindkey;
+        lywsd03mmc_impl::mibeacon_reading m_mibeacon;
+
+        std::optional<custom_reading> decode_mibeacon(
+            tcb::span<const std::uint8_t> service_data) noexcept;
+
         auto make_process_external_event()
         {
             using external_event_variant_t =
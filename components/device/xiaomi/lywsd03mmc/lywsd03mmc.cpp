@@ -20,23 +20,36 @@
 
 #include "xiaomi/lywsd03mmc.hpp"
 
+#include <cmath>
+
 namespace b2h::device::xiaomi
 {
     lywsd03mmc::lywsd03mmc(std::unique_ptr<mqtt::client>&& mqtt_client,
-        std::unique_ptr<ble::gatt::client>&& gatt_client) noexcept :
+        std::unique_ptr<ble::gatt::client>&& gatt_client,
+        const options& opts) noexcept :
         base{ std::move(mqtt_client), std::move(gatt_client) },
         m_state{
             this->gatt_client(),
             this->mqtt_client(),
+            lywsd03mmc_impl::make_topics(this->gatt_client().mac()),
+            publish_filter{ opts.filter("temperature") },
+            publish_filter{ opts.filter("humidity") },
+            publish_filter{ opts.filter("battery") },
             {},
-            {},
-            {},
-            {},
+            0U,
             0U,
             make_process_external_event(),
         },
-        m_fsm{ m_state }
+        m_fsm{ m_state },
+        m_adv_counter{},
+        m_bindkey{ mibeacon::parse_bindkey(opts.bindkey) },
+        m_mibeacon{}
     {
+        if (!opts.bindkey.empty() && !m_bindkey)
+        {
+            log::warning(lywsd03mmc_impl::COMPONENT,
+                "Invalid bindkey, expected 32 hex digits.");
+        }
     }
 
     void lywsd03mmc::on_connected() noexcept
@@ -52,4 +65,102 @@ namespace b2h::device::xiaomi
             std::move(data),
         });
     }
+
+    void lywsd03mmc::on_advertisement(std::uint16_t service_uuid,
+        tcb::span<const std::uint8_t> service_data) noexcept
+    {
+        std::optional<custom_reading> reading;
+
+        if (service_uuid == CUSTOM_ADV_SERVICE_UUID)
+        {
+            reading = decode_custom_advertisement(service_data);
+        }
+        else if (service_uuid == mibeacon::SERVICE_UUID)
+        {
+            reading = decode_mibeacon(service_data);
+        }
+
+        if (!reading)
+        {
+            return;
+        }
+
+        if (m_adv_counter == reading->counter)
+        {
+            return;
+        }
+
+        // Fed in as a notification, readings share the publish path with
+        // connected sensors.
+        const auto data = to_notify_data(*reading);
+
+        m_fsm.process_event(lywsd03mmc_impl::events::advertised{});
+
+        // Only handled once the device operates, until then the sensor keeps
+        // repeating the reading and a later copy is published.
+        const bool published =
+            m_fsm.process_event(lywsd03mmc_impl::events::notify{
+                m_state.data_attr_handle,
+                { data.begin(), data.end() },
+            });
+
+        if (published)
+        {
+            m_adv_counter = reading->counter;
+        }
+    }
+
+    std::optional<custom_reading> lywsd03mmc::decode_mibeacon(
+        tcb::span<const std::uint8_t> service_data) noexcept
+    {
+        const auto frame = mibeacon::decode(service_data,
+            m_bindkey ? &*m_bindkey : nullptr,
+            m_state.gatt_client.mac().as_bytes());
+
+        if (!frame)
+        {
+            log::debug(lywsd03mmc_impl::COMPONENT,
+                "MiBeacon frame not decoded, error: {}.",
+                static_cast<int>(frame.error()));
+            return std::nullopt;
+        }
+
+        for (const auto& reading : frame->readings())
+        {
+            switch (reading.type)
+            {
+            case mibeacon::quantity::temperature:
+                m_mibeacon.temperature = reading.value;
+                break;
+            case mibeacon::quantity::humidity:
+                m_mibeacon.humidity = reading.value;
+                break;
+            case mibeacon::quantity::battery:
+                m_mibeacon.battery = reading.value;
+                break;
+            default:
+                break;
+            }
+        }
+
+        // Published together, wait until each has been received once.
+        if (!m_mibeacon.temperature || !m_mibeacon.humidity ||
+            !m_mibeacon.battery)
+        {
+            return std::nullopt;
+        }
+
+        // The battery sensor is in mV, map the level back onto the
+        // 2100 mV - 3000 mV range its template turns into %.
+        return custom_reading{
+            static_cast<std::int16_t>(
+                std::lround(*m_mibeacon.temperature * 100.0f)),
+            static_cast<std::uint16_t>(
+                std::lround(*m_mibeacon.humidity * 100.0f)),
+            static_cast<std::uint16_t>(
+                std::lround(2100.0f + *m_mibeacon.battery * 9.0f)),
+            static_cast<std::uint8_t>(*m_mibeacon.battery),
+            frame->counter,
+        };
+    }
 } // namespace b2h::device::xiaomi
@@ -0,0 +1,82 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "catch2/catch.hpp"
+
+#include <array>
+#include <cstdint>
+
+#include "xiaomi/custom_advertisement.hpp"
+
+TEST_CASE("Decode atc1441 advertisement.", "[lywsd03mmc]")
+{
+    // 21.3 °C, 45 %, 87 %, 2954 mV, frame 0x2A.
+    const std::array<std::uint8_t, 13> data{
+        0xA4, 0xC1, 0x38, 0x01, 0x02, 0x03, // MAC
+        0x00, 0xD5,                         // Temperature
+        0x2D,                               // Humidity
+        0x57,                               // Battery
+        0x0B, 0x8A,                         // Voltage
+        0x2A,                               // Counter
+    };
+
+    const auto reading = b2h::device::xiaomi::decode_custom_advertisement(data);
+    REQUIRE(reading.has_value());
+    REQUIRE(reading->temperature == 2130);
+    REQUIRE(reading->humidity == 4500);
+    REQUIRE(reading->battery == 87);
+    REQUIRE(reading->voltage == 2954);
+    REQUIRE(reading->counter == 0x2A);
+}
+
+TEST_CASE("Decode pvvx advertisement.", "[lywsd03mmc]")
+{
+    // -5.25 °C, 45.67 %, 2954 mV, 87 %, frame 0x07.
+    const std::array<std::uint8_t, 15> data{
+        0x03, 0x02, 0x01, 0x38, 0xC1, 0xA4, // MAC
+        0xF3, 0xFD,                         // Temperature
+        0xD7, 0x11,                         // Humidity
+        0x8A, 0x0B,                         // Voltage
+        0x57,                               // Battery
+        0x07,                               // Counter
+        0x05,                               // Flags
+    };
+
+    const auto reading = b2h::device::xiaomi::decode_custom_advertisement(data);
+    REQUIRE(reading.has_value());
+    REQUIRE(reading->temperature == -525);
+    REQUIRE(reading->humidity == 4567);
+    REQUIRE(reading->voltage == 2954);
+    REQUIRE(reading->battery == 87);
+    REQUIRE(reading->counter == 0x07);
+
+    // Laid out as the DATA characteristic notifies it.
+    const std::array<std::uint8_t, 5> expected{ 0xF3, 0xFD, 46, 0x8A, 0x0B };
+    REQUIRE(b2h::device::xiaomi::to_notify_data(*reading) == expected);
+}
+
+TEST_CASE("Ignore other advertisement formats.", "[lywsd03mmc]")
+{
+    // Encrypted pvvx format.
+    const std::array<std::uint8_t, 11> encrypted{};
+    REQUIRE(!b2h::device::xiaomi::decode_custom_advertisement(encrypted));
+
+    REQUIRE(!b2h::device::xiaomi::decode_custom_advertisement({}));
+}
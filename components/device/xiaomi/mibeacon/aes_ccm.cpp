@@ -0,0 +1,334 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "xiaomi/aes_ccm.hpp"
+
+#include <algorithm>
+#include <cstddef>
+
+#include "sdkconfig.h"
+
+#if CONFIG_MBEDTLS_HARDWARE_AES
+#include "mbedtls/ccm.h"
+#endif
+
+namespace b2h::device::xiaomi
+{
+    namespace
+    {
+        using block = std::array<std::uint8_t, 16>;
+
+        // clang-format off
+        constexpr std::array<std::uint8_t, 256> SBOX{
+            0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5,
+            0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+            0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0,
+            0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+            0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc,
+            0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+            0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a,
+            0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+            0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0,
+            0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+            0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b,
+            0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+            0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85,
+            0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+            0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5,
+            0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+            0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17,
+            0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+            0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88,
+            0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+            0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c,
+            0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+            0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9,
+            0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+            0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6,
+            0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+            0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e,
+            0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+            0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94,
+            0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+            0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68,
+            0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16,
+        };
+        // clang-format on
+
+        constexpr std::size_t ROUNDS{ 10 };
+
+        constexpr std::uint8_t xtime(std::uint8_t x) noexcept
+        {
+            return static_cast<std::uint8_t>((x << 1) ^ ((x >> 7) * 0x1b));
+        }
+
+        // Byte oriented AES-128 encryption, CCM never uses the inverse
+        // cipher.
+        class aes128
+        {
+        public:
+            explicit aes128(const aes_key& key) noexcept
+            {
+                std::copy(key.begin(), key.end(), m_round_keys[0].begin());
+
+                std::uint8_t rcon = 0x01;
+
+                for (std::size_t round = 1; round <= ROUNDS; ++round)
+                {
+                    const block& prev = m_round_keys[round - 1];
+                    block& next       = m_round_keys[round];
+
+                    next[0] = prev[0] ^ SBOX[prev[13]] ^ rcon;
+                    next[1] = prev[1] ^ SBOX[prev[14]];
+                    next[2] = prev[2] ^ SBOX[prev[15]];
+                    next[3] = prev[3] ^ SBOX[prev[12]];
+
+                    for (std::size_t i = 4; i < next.size(); ++i)
+                    {
+                        next[i] = prev[i] ^ next[i - 4];
+                    }
+
+                    rcon = xtime(rcon);
+                }
+            }
+
+            void encrypt(block& state) const noexcept
+            {
+                // Column major state, row r rotates left by r.
+                static constexpr std::array<std::uint8_t, 16> SHIFT_ROWS{ 0,
+                    5, 10, 15, 4, 9, 14, 3, 8, 13, 2, 7, 12, 1, 6, 11 };
+
+                for (std::size_t i = 0; i < state.size(); ++i)
+                {
+                    state[i] ^= m_round_keys[0][i];
+                }
+
+                for (std::size_t round = 1; round <= ROUNDS; ++round)
+                {
+                    const block in  = state;
+                    const block& rk = m_round_keys[round];
+
+                    for (std::size_t i = 0; i < state.size(); i += 4)
+                    {
+                        // SubBytes and ShiftRows of a column.
+                        const std::uint8_t a0 = SBOX[in[SHIFT_ROWS[i]]];
+                        const std::uint8_t a1 = SBOX[in[SHIFT_ROWS[i + 1]]];
+                        const std::uint8_t a2 = SBOX[in[SHIFT_ROWS[i + 2]]];
+                        const std::uint8_t a3 = SBOX[in[SHIFT_ROWS[i + 3]]];
+
+                        if (round == ROUNDS)
+                        {
+                            state[i]     = a0 ^ rk[i];
+                            state[i + 1] = a1 ^ rk[i + 1];
+                            state[i + 2] = a2 ^ rk[i + 2];
+                            state[i + 3] = a3 ^ rk[i + 3];
+                            continue;
+                        }
+
+                        // MixColumns.
+                        const std::uint8_t all = a0 ^ a1 ^ a2 ^ a3;
+
+                        state[i]     = a0 ^ all ^ xtime(a0 ^ a1) ^ rk[i];
+                        state[i + 1] = a1 ^ all ^ xtime(a1 ^ a2) ^ rk[i + 1];
+                        state[i + 2] = a2 ^ all ^ xtime(a2 ^ a3) ^ rk[i + 2];
+                        state[i + 3] = a3 ^ all ^ xtime(a3 ^ a0) ^ rk[i + 3];
+                    }
+                }
+            }
+
+        private:
+            std::array<block, ROUNDS + 1> m_round_keys;
+        };
+
+        bool valid_parameters(tcb::span<const std::uint8_t> nonce,
+            tcb::span<const std::uint8_t> aad,
+            tcb::span<const std::uint8_t> tag) noexcept
+        {
+            return nonce.size() >= 7 && nonce.size() <= 13 &&
+                   aad.size() < 0xFF00 && tag.size() >= 4 &&
+                   tag.size() <= 16 && tag.size() % 2 == 0;
+        }
+    } // namespace
+
+    namespace impl
+    {
+        bool aes_ccm_decrypt_soft(const aes_key& key,
+            tcb::span<const std::uint8_t> nonce,
+            tcb::span<const std::uint8_t> aad,
+            tcb::span<const std::uint8_t> ciphertext,
+            tcb::span<const std::uint8_t> tag,
+            std::uint8_t* plaintext) noexcept
+        {
+            if (!valid_parameters(nonce, aad, tag))
+            {
+                return false;
+            }
+
+            const aes128 cipher{ key };
+
+            // Size of the length and counter fields.
+            const std::size_t length_size = 15 - nonce.size();
+
+            if (length_size < sizeof(std::size_t) &&
+                ciphertext.size() >> (8 * length_size) != 0)
+            {
+                return false;
+            }
+
+            const auto counter_block = [&](std::size_t value) {
+                block ctr{};
+
+                ctr[0] = static_cast<std::uint8_t>(length_size - 1);
+                std::copy(nonce.begin(), nonce.end(), ctr.begin() + 1);
+
+                for (std::size_t i = 0; i < length_size && value != 0; ++i)
+                {
+                    ctr[15 - i] = static_cast<std::uint8_t>(value & 0xFF);
+                    value >>= 8;
+                }
+
+                return ctr;
+            };
+
+            // CTR decryption, counter 0 is reserved for the tag.
+            for (std::size_t offset = 0; offset < ciphertext.size();
+                 offset += 16)
+            {
+                block stream = counter_block(offset / 16 + 1);
+                cipher.encrypt(stream);
+
+                const std::size_t size =
+                    std::min<std::size_t>(16, ciphertext.size() - offset);
+
+                for (std::size_t i = 0; i < size; ++i)
+                {
+                    plaintext[offset + i] = ciphertext[offset + i] ^ stream[i];
+                }
+            }
+
+            // CBC-MAC over the flags block, length prefixed AAD and the
+            // plaintext, each zero padded to whole blocks.
+            block mac = counter_block(ciphertext.size());
+            mac[0]    = static_cast<std::uint8_t>((aad.empty() ? 0 : 0x40) |
+                                                 ((tag.size() - 2) / 2) << 3 |
+                                                 (length_size - 1));
+            cipher.encrypt(mac);
+
+            const auto absorb = [&](const std::uint8_t* data,
+                                    std::size_t size,
+                                    std::size_t used) {
+                for (std::size_t i = 0; i < size; ++i)
+                {
+                    mac[used++] ^= data[i];
+
+                    if (used == mac.size())
+                    {
+                        cipher.encrypt(mac);
+                        used = 0;
+                    }
+                }
+
+                return used;
+            };
+
+            if (!aad.empty())
+            {
+                const std::array<std::uint8_t, 2> aad_size{
+                    static_cast<std::uint8_t>(aad.size() >> 8),
+                    static_cast<std::uint8_t>(aad.size() & 0xFF),
+                };
+
+                const std::size_t used = absorb(aad.data(),
+                    aad.size(),
+                    absorb(aad_size.data(), aad_size.size(), 0));
+
+                if (used != 0)
+                {
+                    cipher.encrypt(mac);
+                }
+            }
+
+            if (absorb(plaintext, ciphertext.size(), 0) != 0)
+            {
+                cipher.encrypt(mac);
+            }
+
+            block tag_stream = counter_block(0);
+            cipher.encrypt(tag_stream);
+
+            // Constant time comparison.
+            std::uint8_t diff = 0;
+            for (std::size_t i = 0; i < tag.size(); ++i)
+            {
+                diff |= mac[i] ^ tag_stream[i] ^ tag[i];
+            }
+
+            return diff == 0;
+        }
+    } // namespace impl
+
+    bool aes_ccm_decrypt(const aes_key& key,
+        tcb::span<const std::uint8_t> nonce,
+        tcb::span<const std::uint8_t> aad,
+        tcb::span<const std::uint8_t> ciphertext,
+        tcb::span<const std::uint8_t> tag,
+        std::uint8_t* plaintext) noexcept
+    {
+#if CONFIG_MBEDTLS_HARDWARE_AES
+        if (!valid_parameters(nonce, aad, tag))
+        {
+            return false;
+        }
+
+        ::mbedtls_ccm_context ctx;
+        ::mbedtls_ccm_init(&ctx);
+
+        int rc = ::mbedtls_ccm_setkey(&ctx,
+            MBEDTLS_CIPHER_ID_AES,
+            key.data(),
+            key.size() * 8);
+
+        if (rc == 0)
+        {
+            rc = ::mbedtls_ccm_auth_decrypt(&ctx,
+                ciphertext.size(),
+                nonce.data(),
+                nonce.size(),
+                aad.data(),
+                aad.size(),
+                ciphertext.data(),
+                plaintext,
+                tag.data(),
+                tag.size());
+        }
+
+        ::mbedtls_ccm_free(&ctx);
+
+        return rc == 0;
+#else
+        return impl::aes_ccm_decrypt_soft(key,
+            nonce,
+            aad,
+            ciphertext,
+            tag,
+            plaintext);
+#endif
+    }
+} // namespace b2h::device::xiaomi
@@ -0,0 +1,126 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "benchmark/benchmark.h"
+
+#include <array>
+#include <cstdint>
+
+#include "xiaomi/aes_ccm.hpp"
+#include "xiaomi/custom_advertisement.hpp"
+#include "xiaomi/mibeacon.hpp"
+
+namespace
+{
+    namespace mibeacon = b2h::device::xiaomi::mibeacon;
+
+    const auto BINDKEY =
+        mibeacon::parse_bindkey("814aac74c4f17b6c1581e1ab87816b99").value();
+
+    // Temperature and humidity object in a plain frame.
+    constexpr std::array<std::uint8_t, 18> PLAIN_FRAME{ 0x50, 0x50, 0x5b,
+        0x05, 0x51, 0xcc, 0xbb, 0xaa, 0x38, 0xc1, 0xa4, 0x0d, 0x10, 0x04,
+        0xd7, 0x00, 0xc2, 0x01 };
+
+    // Temperature object encrypted with BINDKEY.
+    constexpr std::array<std::uint8_t, 23> ENCRYPTED_FRAME{ 0x58, 0x58, 0x5b,
+        0x05, 0x50, 0xcc, 0xbb, 0xaa, 0x38, 0xc1, 0xa4, 0x37, 0x7c, 0x31,
+        0xa2, 0xde, 0x01, 0x02, 0x03, 0x54, 0xb4, 0x72, 0x43 };
+
+    // pvvx custom format, for comparison.
+    constexpr std::array<std::uint8_t, 15> PVVX_FRAME{ 0x03, 0x02, 0x01, 0x38,
+        0xc1, 0xa4, 0xf3, 0xfd, 0xd7, 0x11, 0x8a, 0x0b, 0x57, 0x07, 0x05 };
+
+    template<std::size_t N>
+    void set_processed(benchmark::State& state,
+        const std::array<std::uint8_t, N>&)
+    {
+        state.SetItemsProcessed(state.iterations());
+        state.SetBytesProcessed(state.iterations() * N);
+    }
+} // namespace
+
+static void mibeacon_decode_plain(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        auto frame = mibeacon::decode(PLAIN_FRAME);
+        benchmark::DoNotOptimize(frame);
+    }
+
+    set_processed(state, PLAIN_FRAME);
+}
+BENCHMARK(mibeacon_decode_plain);
+
+// Goes through the hardware AES when built for the ESP32 with
+// CONFIG_MBEDTLS_HARDWARE_AES, the portable one elsewhere.
+static void mibeacon_decode_encrypted(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        auto frame = mibeacon::decode(ENCRYPTED_FRAME, &BINDKEY);
+        benchmark::DoNotOptimize(frame);
+    }
+
+    set_processed(state, ENCRYPTED_FRAME);
+}
+BENCHMARK(mibeacon_decode_encrypted);
+
+static void custom_decode_pvvx(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        auto reading =
+            b2h::device::xiaomi::decode_custom_advertisement(PVVX_FRAME);
+        benchmark::DoNotOptimize(reading);
+    }
+
+    set_processed(state, PVVX_FRAME);
+}
+BENCHMARK(custom_decode_pvvx);
+
+// Portable AES-CCM alone with the MiBeacon nonce, AAD and MIC sizes. Arg:
+// ciphertext size. The tag does not match, checking it costs the same.
+static void aes_ccm_decrypt_soft(benchmark::State& state)
+{
+    const std::array<std::uint8_t, 12> nonce{};
+    const std::array<std::uint8_t, 1> aad{ 0x11 };
+    const std::array<std::uint8_t, 4> tag{};
+    std::array<std::uint8_t, 64> ciphertext{};
+    std::array<std::uint8_t, 64> plaintext{};
+
+    const auto size = static_cast<std::size_t>(state.range(0));
+
+    for (auto _ : state)
+    {
+        const bool authentic =
+            b2h::device::xiaomi::impl::aes_ccm_decrypt_soft(BINDKEY,
+                nonce,
+                aad,
+                { ciphertext.data(), size },
+                tag,
+                plaintext.data());
+        benchmark::DoNotOptimize(authentic);
+        benchmark::DoNotOptimize(plaintext);
+    }
+
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(aes_ccm_decrypt_soft)->ArgName("bytes")->Arg(4)->Arg(16)->Arg(64);
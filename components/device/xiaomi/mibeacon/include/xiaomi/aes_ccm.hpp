@@ -0,0 +1,70 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef B2H_DEVICE_XIAOMI_AES_CCM_HPP
+#define B2H_DEVICE_XIAOMI_AES_CCM_HPP
+
+#include <array>
+#include <cstdint>
+
+#include "tcb/span.hpp"
+
+namespace b2h::device::xiaomi
+{
+    using aes_key = std::array<std::uint8_t, 16>;
+
+    /**
+     * @brief AES-128-CCM authenticated decryption (RFC 3610). Uses the
+     * hardware AES through mbedTLS when CONFIG_MBEDTLS_HARDWARE_AES is set,
+     * the portable implementation otherwise.
+     *
+     * @param key
+     * @param nonce 7 to 13 bytes.
+     * @param aad Additional authenticated data, shorter than 0xFF00 bytes.
+     * @param ciphertext
+     * @param tag 4 to 16 bytes, even.
+     * @param plaintext Output, ciphertext.size() bytes. Contents are
+     * unspecified if authentication fails.
+     * @return true if the tag matches.
+     */
+    bool aes_ccm_decrypt(const aes_key& key,
+        tcb::span<const std::uint8_t> nonce,
+        tcb::span<const std::uint8_t> aad,
+        tcb::span<const std::uint8_t> ciphertext,
+        tcb::span<const std::uint8_t> tag,
+        std::uint8_t* plaintext) noexcept;
+
+    namespace impl
+    {
+        /**
+         * @brief Portable AES-128-CCM decryption, the fallback of
+         * aes_ccm_decrypt(), exposed for tests and benchmarks.
+         *
+         */
+        bool aes_ccm_decrypt_soft(const aes_key& key,
+            tcb::span<const std::uint8_t> nonce,
+            tcb::span<const std::uint8_t> aad,
+            tcb::span<const std::uint8_t> ciphertext,
+            tcb::span<const std::uint8_t> tag,
+            std::uint8_t* plaintext) noexcept;
+    } // namespace impl
+} // namespace b2h::device::xiaomi
+
+#endif
@@ -0,0 +1,107 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef B2H_DEVICE_XIAOMI_MIBEACON_HPP
+#define B2H_DEVICE_XIAOMI_MIBEACON_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#include "tcb/span.hpp"
+#include "tl/expected.hpp"
+
+#include "xiaomi/aes_ccm.hpp"
+
+namespace b2h::device::xiaomi::mibeacon
+{
+    // Xiaomi service, MiBeacon frames come as its service data.
+    inline constexpr std::uint16_t SERVICE_UUID{ 0xFE95 };
+
+    // Measurements a single frame can carry.
+    inline constexpr std::size_t MAX_MEASUREMENTS{ 6 };
+
+    enum class quantity : std::uint8_t
+    {
+        temperature,  // °C
+        humidity,     // %
+        battery,      // %
+        illuminance,  // lx
+        moisture,     // %
+        conductivity, // µS/cm
+        power,        // 0 off, 1 on
+    };
+
+    struct measurement {
+        quantity type;
+        float value;
+    };
+
+    struct frame {
+        std::uint16_t product_id;
+        std::uint8_t counter; // Changes with each new frame.
+        // Device MAC, least significant byte first.
+        std::optional<std::array<std::uint8_t, 6>> mac;
+        std::array<measurement, MAX_MEASUREMENTS> measurements;
+        std::uint8_t measurement_count;
+
+        tcb::span<const measurement> readings() const noexcept
+        {
+            return { measurements.data(), measurement_count };
+        }
+    };
+
+    enum class error : std::uint8_t
+    {
+        malformed,
+        unsupported_version, // Legacy encryption of versions 2 and 3.
+        missing_key,
+        missing_mac, // Encrypted frame, no MAC in it nor advertiser address.
+        authentication,
+    };
+
+    /**
+     * @brief Parse a bindkey given as 32 hex digits.
+     *
+     * @param hex
+     * @return Key, std::nullopt if malformed.
+     */
+    std::optional<aes_key> parse_bindkey(std::string_view hex) noexcept;
+
+    /**
+     * @brief Decode a MiBeacon frame, decrypting its objects if encrypted.
+     * Objects of unknown ids are skipped.
+     *
+     * @param service_data Service data of SERVICE_UUID.
+     * @param bindkey Key of the device, needed only for encrypted frames.
+     * @param advertiser Address the frame was received from, least
+     * significant byte first. Used for the nonce of encrypted frames that
+     * leave out the MAC.
+     * @return Decoded frame or the reason it could not be decoded.
+     */
+    tl::expected<frame, error> decode(
+        tcb::span<const std::uint8_t> service_data,
+        const aes_key* bindkey                   = nullptr,
+        tcb::span<const std::uint8_t> advertiser = {}) noexcept;
+} // namespace b2h::device::xiaomi::mibeacon
+
+#endif
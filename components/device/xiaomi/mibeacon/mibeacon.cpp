@@ -0,0 +1,350 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "xiaomi/mibeacon.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace b2h::device::xiaomi::mibeacon
+{
+    namespace
+    {
+        // Frame control bits.
+        constexpr std::uint16_t ENCRYPTED{ 1 << 3 };
+        constexpr std::uint16_t MAC_INCLUDED{ 1 << 4 };
+        constexpr std::uint16_t CAPABILITY_INCLUDED{ 1 << 5 };
+        constexpr std::uint16_t OBJECT_INCLUDED{ 1 << 6 };
+
+        // Capability followed by two bytes of I/O capability.
+        constexpr std::uint8_t IO_CAPABILITY{ 1 << 5 };
+
+        // First version encrypted with AES-CCM.
+        constexpr std::uint8_t CCM_VERSION{ 4 };
+
+        // Frame control, product id and frame counter.
+        constexpr std::size_t HEADER_SIZE{ 5 };
+        constexpr std::size_t MAC_SIZE{ 6 };
+        constexpr std::size_t EXT_COUNTER_SIZE{ 3 };
+        constexpr std::size_t MIC_SIZE{ 4 };
+
+        // Object id, length.
+        constexpr std::size_t OBJECT_HEADER_SIZE{ 3 };
+
+        // Larger than any legacy advertisement.
+        constexpr std::size_t MAX_OBJECTS_SIZE{ 32 };
+
+        // Additional authenticated data of AES-CCM frames.
+        constexpr std::array<std::uint8_t, 1> CCM_AAD{ 0x11 };
+
+        enum class field_type : std::uint8_t
+        {
+            u8,
+            u16,
+            s16,
+            u24,
+            f32,
+        };
+
+        struct object_field {
+            std::uint16_t id;
+            std::uint8_t offset;
+            field_type type;
+            float scale;
+            quantity measured;
+        };
+
+        // clang-format off
+        // Objects with more than one value have a row for each, in order.
+        constexpr std::array<object_field, 14> OBJECT_FIELDS{ {
+            { 0x1004, 0, field_type::s16, 0.1f, quantity::temperature  },
+            { 0x1005, 0, field_type::u8,  1.0f, quantity::power        },
+            { 0x1005, 1, field_type::u8,  1.0f, quantity::temperature  },
+            { 0x1006, 0, field_type::u16, 0.1f, quantity::humidity     },
+            { 0x1007, 0, field_type::u24, 1.0f, quantity::illuminance  },
+            { 0x1008, 0, field_type::u8,  1.0f, quantity::moisture     },
+            { 0x1009, 0, field_type::u16, 1.0f, quantity::conductivity },
+            { 0x100A, 0, field_type::u8,  1.0f, quantity::battery      },
+            { 0x100D, 0, field_type::s16, 0.1f, quantity::temperature  },
+            { 0x100D, 2, field_type::u16, 0.1f, quantity::humidity     },
+            { 0x4803, 0, field_type::u8,  1.0f, quantity::battery      },
+            { 0x4C01, 0, field_type::f32, 1.0f, quantity::temperature  },
+            { 0x4C02, 0, field_type::u8,  1.0f, quantity::humidity     },
+            { 0x4C08, 0, field_type::f32, 1.0f, quantity::humidity     },
+        } };
+        // clang-format on
+
+        constexpr std::size_t field_size(field_type type) noexcept
+        {
+            switch (type)
+            {
+            case field_type::u8:
+                return 1;
+            case field_type::u16:
+            case field_type::s16:
+                return 2;
+            case field_type::u24:
+                return 3;
+            case field_type::f32:
+                return 4;
+            }
+
+            return 0;
+        }
+
+        float read_field(const std::uint8_t* data, field_type type) noexcept
+        {
+            switch (type)
+            {
+            case field_type::u8:
+                return data[0];
+            case field_type::u16:
+                return static_cast<std::uint16_t>(data[0] | (data[1] << 8));
+            case field_type::s16:
+                return static_cast<std::int16_t>(data[0] | (data[1] << 8));
+            case field_type::u24:
+                return static_cast<float>(
+                    data[0] | (data[1] << 8) | (data[2] << 16));
+            case field_type::f32:
+            {
+                // Little endian IEEE 754, as is the ESP32.
+                float value;
+                std::memcpy(&value, data, sizeof(value));
+                return value;
+            }
+            }
+
+            return 0.0f;
+        }
+
+        bool decode_objects(
+            tcb::span<const std::uint8_t> objects, frame& result) noexcept
+        {
+            std::size_t offset = 0;
+
+            while (offset < objects.size())
+            {
+                if (objects.size() - offset < OBJECT_HEADER_SIZE)
+                {
+                    return false;
+                }
+
+                const std::uint16_t id =
+                    objects[offset] | (objects[offset + 1] << 8);
+                const std::size_t length = objects[offset + 2];
+
+                offset += OBJECT_HEADER_SIZE;
+
+                if (objects.size() - offset < length)
+                {
+                    return false;
+                }
+
+                const std::uint8_t* const data = &objects[offset];
+
+                for (const auto& field : OBJECT_FIELDS)
+                {
+                    if (field.id != id ||
+                        field.offset + field_size(field.type) > length ||
+                        result.measurement_count == MAX_MEASUREMENTS)
+                    {
+                        continue;
+                    }
+
+                    result.measurements[result.measurement_count++] = {
+                        field.measured,
+                        read_field(data + field.offset, field.type) *
+                            field.scale,
+                    };
+                }
+
+                offset += length;
+            }
+
+            return true;
+        }
+
+        constexpr std::uint8_t hex_value(char c) noexcept
+        {
+            if (c >= '0' && c <= '9')
+            {
+                return c - '0';
+            }
+
+            if (c >= 'a' && c <= 'f')
+            {
+                return c - 'a' + 10;
+            }
+
+            if (c >= 'A' && c <= 'F')
+            {
+                return c - 'A' + 10;
+            }
+
+            return 0xFF;
+        }
+    } // namespace
+
+    std::optional<aes_key> parse_bindkey(std::string_view hex) noexcept
+    {
+        aes_key key;
+
+        if (hex.size() != key.size() * 2)
+        {
+            return std::nullopt;
+        }
+
+        for (std::size_t i = 0; i < key.size(); ++i)
+        {
+            const std::uint8_t high = hex_value(hex[2 * i]);
+            const std::uint8_t low  = hex_value(hex[2 * i + 1]);
+
+            if (high == 0xFF || low == 0xFF)
+            {
+                return std::nullopt;
+            }
+
+            key[i] = static_cast<std::uint8_t>((high << 4) | low);
+        }
+
+        return key;
+    }
+
+    tl::expected<frame, error> decode(
+        tcb::span<const std::uint8_t> service_data,
+        const aes_key* bindkey,
+        tcb::span<const std::uint8_t> advertiser) noexcept
+    {
+        const auto data = service_data;
+
+        if (data.size() < HEADER_SIZE)
+        {
+            return tl::make_unexpected(error::malformed);
+        }
+
+        const std::uint16_t frame_control = data[0] | (data[1] << 8);
+        const std::uint8_t version        = frame_control >> 12;
+
+        frame result{};
+        result.product_id = data[2] | (data[3] << 8);
+        result.counter    = data[4];
+
+        std::size_t offset = HEADER_SIZE;
+
+        if (frame_control & MAC_INCLUDED)
+        {
+            if (data.size() < offset + MAC_SIZE)
+            {
+                return tl::make_unexpected(error::malformed);
+            }
+
+            result.mac.emplace();
+            std::copy_n(&data[offset], MAC_SIZE, result.mac->begin());
+            offset += MAC_SIZE;
+        }
+
+        if (frame_control & CAPABILITY_INCLUDED)
+        {
+            if (data.size() < offset + 1)
+            {
+                return tl::make_unexpected(error::malformed);
+            }
+
+            offset += (data[offset] & IO_CAPABILITY) ? 3 : 1;
+
+            if (data.size() < offset)
+            {
+                return tl::make_unexpected(error::malformed);
+            }
+        }
+
+        if (!(frame_control & OBJECT_INCLUDED))
+        {
+            return result;
+        }
+
+        if (!(frame_control & ENCRYPTED))
+        {
+            if (!decode_objects(data.subspan(offset), result))
+            {
+                return tl::make_unexpected(error::malformed);
+            }
+
+            return result;
+        }
+
+        if (version < CCM_VERSION)
+        {
+            return tl::make_unexpected(error::unsupported_version);
+        }
+
+        if (!bindkey)
+        {
+            return tl::make_unexpected(error::missing_key);
+        }
+
+        const tcb::span<const std::uint8_t> mac =
+            result.mac ? tcb::make_span(*result.mac) : advertiser;
+
+        if (mac.size() != MAC_SIZE)
+        {
+            return tl::make_unexpected(error::missing_mac);
+        }
+
+        if (data.size() < offset + EXT_COUNTER_SIZE + MIC_SIZE ||
+            data.size() - offset - EXT_COUNTER_SIZE - MIC_SIZE >
+                MAX_OBJECTS_SIZE)
+        {
+            return tl::make_unexpected(error::malformed);
+        }
+
+        const auto ciphertext = data.subspan(offset,
+            data.size() - offset - EXT_COUNTER_SIZE - MIC_SIZE);
+        const auto ext_counter =
+            data.subspan(data.size() - EXT_COUNTER_SIZE - MIC_SIZE,
+                EXT_COUNTER_SIZE);
+        const auto mic = data.last(MIC_SIZE);
+
+        // MAC, product id, frame counter and extended frame counter.
+        std::array<std::uint8_t, 12> nonce;
+        auto nonce_end = std::copy(mac.begin(), mac.end(), nonce.begin());
+        nonce_end      = std::copy_n(&data[2], 3, nonce_end);
+        std::copy(ext_counter.begin(), ext_counter.end(), nonce_end);
+
+        std::array<std::uint8_t, MAX_OBJECTS_SIZE> objects;
+
+        if (!aes_ccm_decrypt(*bindkey,
+                nonce,
+                CCM_AAD,
+                ciphertext,
+                mic,
+                objects.data()))
+        {
+            return tl::make_unexpected(error::authentication);
+        }
+
+        if (!decode_objects({ objects.data(), ciphertext.size() }, result))
+        {
+            return tl::make_unexpected(error::malformed);
+        }
+
+        return result;
+    }
+} // namespace b2h::device::xiaomi::mibeacon
@@ -0,0 +1,110 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "catch2/catch.hpp"
+
+#include <array>
+#include <cstdint>
+
+#include "xiaomi/aes_ccm.hpp"
+
+namespace
+{
+    // NIST SP 800-38C, appendix C.
+    constexpr b2h::device::xiaomi::aes_key KEY{ 0x40, 0x41, 0x42, 0x43, 0x44,
+        0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x4b, 0x4c, 0x4d, 0x4e, 0x4f };
+} // namespace
+
+TEST_CASE("Decrypt NIST SP 800-38C example 1.", "[aes_ccm]")
+{
+    const std::array<std::uint8_t, 7> nonce{ 0x10, 0x11, 0x12, 0x13, 0x14,
+        0x15, 0x16 };
+    const std::array<std::uint8_t, 8> aad{ 0x00, 0x01, 0x02, 0x03, 0x04,
+        0x05, 0x06, 0x07 };
+    const std::array<std::uint8_t, 4> ciphertext{ 0x71, 0x62, 0x01, 0x5b };
+    std::array<std::uint8_t, 4> tag{ 0x4d, 0xac, 0x25, 0x5d };
+
+    const std::array<std::uint8_t, 4> expected{ 0x20, 0x21, 0x22, 0x23 };
+    std::array<std::uint8_t, 4> plaintext{};
+
+    REQUIRE(b2h::device::xiaomi::aes_ccm_decrypt(KEY,
+        nonce,
+        aad,
+        ciphertext,
+        tag,
+        plaintext.data()));
+    REQUIRE(plaintext == expected);
+
+    tag[3] ^= 0x01;
+    REQUIRE(!b2h::device::xiaomi::aes_ccm_decrypt(KEY,
+        nonce,
+        aad,
+        ciphertext,
+        tag,
+        plaintext.data()));
+}
+
+TEST_CASE("Decrypt NIST SP 800-38C example 2.", "[aes_ccm]")
+{
+    const std::array<std::uint8_t, 8> nonce{ 0x10, 0x11, 0x12, 0x13, 0x14,
+        0x15, 0x16, 0x17 };
+    const std::array<std::uint8_t, 16> aad{ 0x00, 0x01, 0x02, 0x03, 0x04,
+        0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+    const std::array<std::uint8_t, 16> ciphertext{ 0xd2, 0xa1, 0xf0, 0xe0,
+        0x51, 0xea, 0x5f, 0x62, 0x08, 0x1a, 0x77, 0x92, 0x07, 0x3d, 0x59,
+        0x3d };
+    const std::array<std::uint8_t, 6> tag{ 0x1f, 0xc6, 0x4f, 0xbf, 0xac,
+        0xcd };
+
+    const std::array<std::uint8_t, 16> expected{ 0x20, 0x21, 0x22, 0x23,
+        0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e,
+        0x2f };
+    std::array<std::uint8_t, 16> plaintext{};
+
+    REQUIRE(b2h::device::xiaomi::impl::aes_ccm_decrypt_soft(KEY,
+        nonce,
+        aad,
+        ciphertext,
+        tag,
+        plaintext.data()));
+    REQUIRE(plaintext == expected);
+}
+
+TEST_CASE("Reject invalid AES-CCM parameters.", "[aes_ccm]")
+{
+    const std::array<std::uint8_t, 6> short_nonce{};
+    const std::array<std::uint8_t, 12> nonce{};
+    const std::array<std::uint8_t, 3> odd_tag{};
+    const std::array<std::uint8_t, 4> tag{};
+    std::array<std::uint8_t, 1> plaintext{};
+
+    REQUIRE(!b2h::device::xiaomi::aes_ccm_decrypt(KEY,
+        short_nonce,
+        {},
+        {},
+        tag,
+        plaintext.data()));
+    REQUIRE(!b2h::device::xiaomi::aes_ccm_decrypt(KEY,
+        nonce,
+        {},
+        {},
+        odd_tag,
+        plaintext.data()));
+}
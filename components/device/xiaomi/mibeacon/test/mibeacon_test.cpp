@@ -0,0 +1,194 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "catch2/catch.hpp"
+
+#include <array>
+#include <cstdint>
+
+#include "xiaomi/mibeacon.hpp"
+
+namespace
+{
+    namespace mibeacon = b2h::device::xiaomi::mibeacon;
+
+    constexpr std::array<std::uint8_t, 6> MAC{ 0xcc, 0xbb, 0xaa, 0x38, 0xc1,
+        0xa4 };
+
+    const auto BINDKEY =
+        mibeacon::parse_bindkey("814aac74c4f17b6c1581e1ab87816b99").value();
+
+    // LYWSD03MMC, version 5, MAC included, encrypted temperature of 21.5 °C.
+    constexpr std::array<std::uint8_t, 23> ENCRYPTED_TEMPERATURE{
+        0x58, 0x58, 0x5b, 0x05, 0x50,       // Frame control, product, counter
+        0xcc, 0xbb, 0xaa, 0x38, 0xc1, 0xa4, // MAC
+        0x37, 0x7c, 0x31, 0xa2, 0xde,       // Object
+        0x01, 0x02, 0x03,                   // Extended counter
+        0x54, 0xb4, 0x72, 0x43,             // MIC
+    };
+} // namespace
+
+TEST_CASE("Parse bindkey.", "[mibeacon]")
+{
+    const auto key =
+        mibeacon::parse_bindkey("0123456789abcdefABCDEF0011223344");
+    REQUIRE(key.has_value());
+    REQUIRE((*key)[0] == 0x01);
+    REQUIRE((*key)[7] == 0xef);
+    REQUIRE((*key)[8] == 0xab);
+    REQUIRE((*key)[15] == 0x44);
+
+    REQUIRE(!mibeacon::parse_bindkey("0123456789abcdef"));
+    REQUIRE(!mibeacon::parse_bindkey("0123456789abcdefABCDEF001122334g"));
+}
+
+TEST_CASE("Decode plain MiBeacon objects.", "[mibeacon]")
+{
+    // Temperature and humidity object followed by an unknown one.
+    const std::array<std::uint8_t, 23> data{
+        0x50, 0x50, 0x5b, 0x05, 0x51,
+        0xcc, 0xbb, 0xaa, 0x38, 0xc1, 0xa4,
+        0x0d, 0x10, 0x04, 0xd7, 0x00, 0xc2, 0x01,
+        0xff, 0x10, 0x02, 0x01, 0x02,
+    };
+
+    const auto frame = mibeacon::decode(data);
+    REQUIRE(frame.has_value());
+    REQUIRE(frame->product_id == 0x055b);
+    REQUIRE(frame->counter == 0x51);
+    REQUIRE(frame->mac == MAC);
+
+    const auto readings = frame->readings();
+    REQUIRE(readings.size() == 2);
+    REQUIRE(readings[0].type == mibeacon::quantity::temperature);
+    REQUIRE(readings[0].value == Approx(21.5f));
+    REQUIRE(readings[1].type == mibeacon::quantity::humidity);
+    REQUIRE(readings[1].value == Approx(45.0f));
+}
+
+TEST_CASE("Skip the capability of MiBeacon frames.", "[mibeacon]")
+{
+    // Capability with I/O capability, no MAC, battery of 87 %.
+    const std::array<std::uint8_t, 12> data{
+        0x60, 0x30, 0x98, 0x00, 0x01,
+        0x28, 0x01, 0x00,
+        0x0a, 0x10, 0x01, 0x57,
+    };
+
+    const auto frame = mibeacon::decode(data);
+    REQUIRE(frame.has_value());
+    REQUIRE(!frame->mac.has_value());
+    REQUIRE(frame->readings().size() == 1);
+    REQUIRE(frame->readings()[0].type == mibeacon::quantity::battery);
+    REQUIRE(frame->readings()[0].value == 87.0f);
+}
+
+TEST_CASE("Decrypt MiBeacon objects with the bindkey.", "[mibeacon]")
+{
+    const auto frame = mibeacon::decode(ENCRYPTED_TEMPERATURE, &BINDKEY);
+    REQUIRE(frame.has_value());
+    REQUIRE(frame->counter == 0x50);
+    REQUIRE(frame->mac == MAC);
+    REQUIRE(frame->readings().size() == 1);
+    REQUIRE(frame->readings()[0].type == mibeacon::quantity::temperature);
+    REQUIRE(frame->readings()[0].value == Approx(21.5f));
+
+    // Battery of 87 %.
+    const std::array<std::uint8_t, 22> battery{
+        0x58, 0x58, 0x5b, 0x05, 0x52,
+        0xcc, 0xbb, 0xaa, 0x38, 0xc1, 0xa4,
+        0xa6, 0xa5, 0x65, 0x1e,
+        0x01, 0x02, 0x03,
+        0x22, 0x82, 0x86, 0x35,
+    };
+
+    const auto battery_frame = mibeacon::decode(battery, &BINDKEY);
+    REQUIRE(battery_frame.has_value());
+    REQUIRE(battery_frame->readings().size() == 1);
+    REQUIRE(battery_frame->readings()[0].type == mibeacon::quantity::battery);
+    REQUIRE(battery_frame->readings()[0].value == 87.0f);
+}
+
+TEST_CASE("Decrypt MiBeacon objects with the advertiser address.", "[mibeacon]")
+{
+    // The same frame with the MAC left out.
+    const std::array<std::uint8_t, 17> no_mac{
+        0x48, 0x58, 0x5b, 0x05, 0x50,
+        0x37, 0x7c, 0x31, 0xa2, 0xde,
+        0x01, 0x02, 0x03,
+        0x54, 0xb4, 0x72, 0x43,
+    };
+
+    REQUIRE(mibeacon::decode(no_mac, &BINDKEY).error() ==
+            mibeacon::error::missing_mac);
+
+    const auto frame = mibeacon::decode(no_mac, &BINDKEY, MAC);
+    REQUIRE(frame.has_value());
+    REQUIRE(!frame->mac.has_value());
+    REQUIRE(frame->readings().size() == 1);
+    REQUIRE(frame->readings()[0].type == mibeacon::quantity::temperature);
+    REQUIRE(frame->readings()[0].value == Approx(21.5f));
+
+    auto other_mac = MAC;
+    other_mac[0] ^= 0x01;
+    REQUIRE(mibeacon::decode(no_mac, &BINDKEY, other_mac).error() ==
+            mibeacon::error::authentication);
+}
+
+TEST_CASE("Reject MiBeacon frames that cannot be decrypted.", "[mibeacon]")
+{
+    REQUIRE(mibeacon::decode(ENCRYPTED_TEMPERATURE).error() ==
+            mibeacon::error::missing_key);
+
+    auto other_key = BINDKEY;
+    other_key[0] ^= 0x01;
+    REQUIRE(mibeacon::decode(ENCRYPTED_TEMPERATURE, &other_key).error() ==
+            mibeacon::error::authentication);
+
+    auto tampered = ENCRYPTED_TEMPERATURE;
+    tampered[12] ^= 0x01;
+    REQUIRE(mibeacon::decode(tampered, &BINDKEY).error() ==
+            mibeacon::error::authentication);
+
+    // Version 3 used the legacy encryption.
+    auto legacy = ENCRYPTED_TEMPERATURE;
+    legacy[1]   = 0x30;
+    REQUIRE(mibeacon::decode(legacy, &BINDKEY).error() ==
+            mibeacon::error::unsupported_version);
+}
+
+TEST_CASE("Reject malformed MiBeacon frames.", "[mibeacon]")
+{
+    const std::array<std::uint8_t, 4> short_header{ 0x50, 0x50, 0x5b, 0x05 };
+    REQUIRE(mibeacon::decode(short_header).error() ==
+            mibeacon::error::malformed);
+
+    // Object longer than the frame.
+    const std::array<std::uint8_t, 9> truncated{ 0x40, 0x50, 0x5b, 0x05,
+        0x01, 0x04, 0x10, 0x02, 0xd7 };
+    REQUIRE(mibeacon::decode(truncated).error() ==
+            mibeacon::error::malformed);
+
+    // Encrypted, but too short for the counter and MIC.
+    const std::array<std::uint8_t, 14> no_mic{ 0x58, 0x58, 0x5b, 0x05, 0x50,
+        0xcc, 0xbb, 0xaa, 0x38, 0xc1, 0xa4, 0x01, 0x02, 0x03 };
+    REQUIRE(mibeacon::decode(no_mic, &BINDKEY).error() ==
+            mibeacon::error::malformed);
+}
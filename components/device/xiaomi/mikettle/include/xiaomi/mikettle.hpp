@@ -38,10 +38,15 @@
 
 #include "ble/gatt/client.hpp"
 #include "device/base.hpp"
+#include "device/command_queue.hpp"
+#include "device/discovery.hpp"
+#include "device/options.hpp"
 #include "hass/device_types.hpp"
 #include "mqtt/client.hpp"
+#include "mqtt/router.hpp"
 #include "utils/const_map.hpp"
 #include "utils/json.hpp"
+#include "utils/logger.hpp"
 
 #include "host/ble_uuid.h"
 
@@ -81,19 +86,35 @@ namespace b2h::device::xiaomi
                 tcb::span<std::uint8_t> data;
             };
 
-            struct mqtt_data {
-                std::string_view topic;
+            struct warm_type_cmd {
+                std::string_view data;
+            };
+
+            struct temp_set_cmd {
+                std::string_view data;
+            };
+
+            struct warm_time_limit_cmd {
+                std::string_view data;
+            };
+
+            struct toab_cmd {
                 std::string_view data;
             };
 
             struct sub_finished {
             };
 
+            // Sent ahead of every notification, publishes discovery again
+            // when the broker or Home Assistant lost it.
+            struct rediscover {
+            };
+
             struct abort {
             };
         }; // namespace events
 
-        inline constexpr std::string_view COMPONENT{ "xiaomi::mikettle" };
+        inline constexpr log::component COMPONENT{ "xiaomi::mikettle" };
 
         inline constexpr std::uint8_t KEY_LENGTH{ 4 };
         inline constexpr std::uint8_t TOKEN_LENGTH{ 12 };
@@ -208,6 +229,19 @@ namespace b2h::device::xiaomi
             0x2902,
         };
 
+        inline constexpr std::string_view DEVICE_MODEL{ "MiKettle" };
+
+        // Discovery cache entries of the entities.
+        inline constexpr std::uint8_t TEMPERATURE_SENSOR_INDEX{ 0 };
+        inline constexpr std::uint8_t ACTION_SENSOR_INDEX{ 1 };
+        inline constexpr std::uint8_t MODE_SENSOR_INDEX{ 2 };
+        inline constexpr std::uint8_t KEEP_WARM_TIME_SENSOR_INDEX{ 3 };
+        inline constexpr std::uint8_t TEMPERATURE_SET_NUMBER_INDEX{ 4 };
+        inline constexpr std::uint8_t KEEP_WARM_TIME_LIMIT_NUMBER_INDEX{ 5 };
+        inline constexpr std::uint8_t KEEP_WARM_TYPE_SELECT_INDEX{ 6 };
+        inline constexpr std::uint8_t TURN_OFF_AFTER_BOIL_SWITCH_INDEX{ 7 };
+        inline constexpr std::uint8_t DEVICE_INDEX{ 8 };
+
         inline constexpr const char* TEMPERATURE_SENSOR_NAME{
             "MiKettle Temperature"
         };
@@ -316,6 +350,47 @@ namespace b2h::device::xiaomi
             "homeassistant/switch/mikettle_turn_off_after_boil/cmd"
         };
 
+        // Command topics, subscribed together once the kettle is set up.
+        inline constexpr std::array<mqtt::subscription, 4> CMD_SUBSCRIPTIONS{ {
+            { TEMPERATURE_SET_NUMBER_CMD_TOPIC, 1 },
+            { KEEP_WARM_TIME_LIMIT_NUMBER_CMD_TOPIC, 1 },
+            { KEEP_WARM_TYPE_SELECT_CMD_TOPIC, 1 },
+            { TURN_OFF_AFTER_BOIL_SWITCH_CMD_TOPIC, 1 },
+        } };
+
+        inline constexpr const char* DEVICE_CONFIG_TOPIC{
+            "homeassistant/device/mikettle/config"
+        };
+
+        // Slots of the inbound command queue, one per command topic.
+        inline constexpr std::size_t WARM_TYPE_CMD_SLOT{ 0 };
+        inline constexpr std::size_t TEMP_SET_CMD_SLOT{ 1 };
+        inline constexpr std::size_t WARM_TIME_LIMIT_CMD_SLOT{ 2 };
+        inline constexpr std::size_t TOAB_CMD_SLOT{ 3 };
+        inline constexpr std::size_t CMD_SLOTS{ 4 };
+
+        // Component ids of the device discovery payload, used as unique ids.
+        inline constexpr std::string_view TEMPERATURE_SENSOR_ID{
+            "mikettle_temperature"
+        };
+        inline constexpr std::string_view ACTION_SENSOR_ID{ "mikettle_action" };
+        inline constexpr std::string_view MODE_SENSOR_ID{ "mikettle_mode" };
+        inline constexpr std::string_view KEEP_WARM_TIME_SENSOR_ID{
+            "mikettle_keep_warm_time"
+        };
+        inline constexpr std::string_view TEMPERATURE_SET_NUMBER_ID{
+            "mikettle_temperature_set"
+        };
+        inline constexpr std::string_view KEEP_WARM_TIME_LIMIT_NUMBER_ID{
+            "mikettle_keep_warm_time_limit"
+        };
+        inline constexpr std::string_view KEEP_WARM_TYPE_SELECT_ID{
+            "mikettle_keep_warm_type"
+        };
+        inline constexpr std::string_view TURN_OFF_AFTER_BOIL_SWITCH_ID{
+            "mikettle_turn_off_after_boil"
+        };
+
         inline constexpr std::string_view ACTION_IDLE{ "idle" };
         inline constexpr std::string_view ACTION_HEATING{ "heating" };
         inline constexpr std::string_view ACTION_COOLING{ "cooling" };
@@ -539,7 +614,10 @@ namespace b2h::device::xiaomi
                 events::descs_disced,
                 events::read_finished, 
                 events::write_finished,
-                events::mqtt_data, 
+                events::warm_type_cmd,
+                events::temp_set_cmd,
+                events::warm_time_limit_cmd,
+                events::toab_cmd,
                 events::sub_finished
             >;
             // clang-format on
@@ -586,6 +664,14 @@ namespace b2h::device::xiaomi
 
             state_variant_t state_var;
 
+            publish_filter temp_filter;
+
+            // Commands received while a parameter write is running.
+            command_queue<CMD_SLOTS> commands;
+
+            // Discovery cache generation the configs were published at.
+            std::uint32_t discovery_generation;
+
             std::function<void(external_event_variant_t)>
                 process_external_event;
         };
@@ -663,9 +749,23 @@ namespace b2h::device::xiaomi
                     };
                 };
 
+                // State publishes are pipelined by the MQTT client, so their
+                // completion does not gate the state machine.
+                const auto publish_handler = [](auto&& result) {
+                    if (!result.has_value())
+                    {
+                        log::warning(COMPONENT,
+                            "Publish failed: {}.",
+                            esp_err_to_name(result.error()));
+                    }
+                };
+
                 const auto subscribe_handler = [](mikettle_state& state) {
                     return [&](auto&& result) {
-                        if (!result.has_value())
+                        if (!result.has_value() ||
+                            std::any_of(result.value().cbegin(),
+                                result.value().cend(),
+                                [](esp_err_t err) { return err != ESP_OK; }))
                         {
                             log::warning(COMPONENT, "Subscribe failed.");
                             state.process_external_event(events::abort{});
@@ -676,12 +776,11 @@ namespace b2h::device::xiaomi
                     };
                 };
 
-                const auto mqtt_sub = [=](const char* topic) {
-                    return [=](mikettle_state& state) {
-                        state.mqtt_client.async_subscribe(topic,
-                            1,
-                            subscribe_handler(state));
-                    };
+                // One batch, the broker acknowledges all the command topics
+                // in a single round trip.
+                const auto mqtt_sub = [=](mikettle_state& state) {
+                    state.mqtt_client.async_subscribe(CMD_SUBSCRIPTIONS,
+                        subscribe_handler(state));
                 };
 
                 const auto on_start = [=](mikettle_state& state) {
@@ -827,7 +926,7 @@ namespace b2h::device::xiaomi
                         });
                 };
 
-                const auto on_conf_temp_sens = [=](mikettle_state& state) {
+                const auto make_temp_sens = []() {
                     hass::sensor_type sens;
 
                     sens.name                = TEMPERATURE_SENSOR_NAME;
@@ -836,43 +935,30 @@ namespace b2h::device::xiaomi
                     sens.unit_of_measurement = "°C";
                     sens.qos                 = 0;
 
-                    state.mqtt_client.async_publish(
-                        TEMPERATURE_SENSOR_CONFIG_TOPIC,
-                        utils::json::dump(hass::serialize(sens)),
-                        1,
-                        true,
-                        write_handler(state));
+                    return sens;
                 };
 
-                const auto on_conf_actn_sens = [=](mikettle_state& state) {
+                const auto make_actn_sens = []() {
                     hass::sensor_type sens;
 
                     sens.name        = ACTION_SENSOR_NAME;
                     sens.state_topic = ACTION_SENSOR_STATE_TOPIC;
                     sens.qos         = 0;
 
-                    state.mqtt_client.async_publish(ACTION_SENSOR_CONFIG_TOPIC,
-                        utils::json::dump(hass::serialize(sens)),
-                        1,
-                        true,
-                        write_handler(state));
+                    return sens;
                 };
 
-                const auto on_conf_mode_sens = [=](mikettle_state& state) {
+                const auto make_mode_sens = []() {
                     hass::sensor_type sens;
 
                     sens.name        = MODE_SENSOR_NAME;
                     sens.state_topic = MODE_SENSOR_STATE_TOPIC;
                     sens.qos         = 0;
 
-                    state.mqtt_client.async_publish(MODE_SENSOR_CONFIG_TOPIC,
-                        utils::json::dump(hass::serialize(sens)),
-                        1,
-                        true,
-                        write_handler(state));
+                    return sens;
                 };
 
-                const auto on_conf_warm_time_sens = [=](mikettle_state& state) {
+                const auto make_warm_time_sens = []() {
                     hass::sensor_type sens;
 
                     sens.name        = KEEP_WARM_TIME_SENSOR_NAME;
@@ -880,15 +966,10 @@ namespace b2h::device::xiaomi
                     sens.unit_of_measurement = "min";
                     sens.qos                 = 0;
 
-                    state.mqtt_client.async_publish(
-                        KEEP_WARM_TIME_SENSOR_CONFIG_TOPIC,
-                        utils::json::dump(hass::serialize(sens)),
-                        1,
-                        true,
-                        write_handler(state));
+                    return sens;
                 };
 
-                const auto on_conf_temp_set_num = [=](mikettle_state& state) {
+                const auto make_temp_set_num = []() {
                     hass::number_type num;
 
                     num.name          = TEMPERATURE_SET_NUMBER_NAME;
@@ -901,15 +982,10 @@ namespace b2h::device::xiaomi
                     num.retain              = true;
                     num.qos                 = 1;
 
-                    state.mqtt_client.async_publish(
-                        TEMPERATURE_SET_NUMBER_CONFIG_TOPIC,
-                        utils::json::dump(hass::serialize(num)),
-                        1,
-                        true,
-                        write_handler(state));
+                    return num;
                 };
 
-                const auto on_conf_warm_limit_num = [=](mikettle_state& state) {
+                const auto make_warm_limit_num = []() {
                     hass::number_type num;
 
                     num.name          = KEEP_WARM_TIME_LIMIT_NUMBER_NAME;
@@ -922,20 +998,14 @@ namespace b2h::device::xiaomi
                     num.retain              = true;
                     num.qos                 = 1;
 
-                    state.mqtt_client.async_publish(
-                        KEEP_WARM_TIME_LIMIT_NUMBER_CONFIG_TOPIC,
-                        utils::json::dump(hass::serialize(num)),
-                        1,
-                        true,
-                        write_handler(state));
+                    return num;
                 };
 
-                const auto on_conf_warm_type = [=](mikettle_state& state) {
-                    using namespace std::literals;
-
+                const auto make_warm_type = []() {
                     hass::select_type sel;
 
-                    std::array opts{
+                    // Referenced by the returned entity.
+                    static std::array opts{
                         KEEP_WARM_TYPE_BOIL_AND_COOL,
                         KEEP_WARM_TYPE_HEAT_UP,
                     };
@@ -947,15 +1017,10 @@ namespace b2h::device::xiaomi
                     sel.retain        = true;
                     sel.qos           = 1;
 
-                    state.mqtt_client.async_publish(
-                        KEEP_WARM_TYPE_SELECT_CONFIG_TOPIC,
-                        utils::json::dump(hass::serialize(sel)),
-                        1,
-                        true,
-                        write_handler(state));
+                    return sel;
                 };
 
-                const auto on_conf_toab_sel = [=](mikettle_state& state) {
+                const auto make_toab_sel = []() {
                     hass::switch_type sw;
 
                     sw.name          = TURN_OFF_AFTER_BOIL_SWITCH_NAME;
@@ -964,12 +1029,245 @@ namespace b2h::device::xiaomi
                     sw.retain        = true;
                     sw.qos           = 1;
 
-                    state.mqtt_client.async_publish(
-                        TURN_OFF_AFTER_BOIL_SWITCH_CONFIG_TOPIC,
-                        utils::json::dump(hass::serialize(sw)),
-                        1,
-                        true,
-                        write_handler(state));
+                    return sw;
+                };
+
+                // Serializes discovery config of a single entity.
+                const auto render_entity = [](const auto& make_entity) {
+                    return [&make_entity]() {
+                        return utils::json::dump(hass::serialize(make_entity(),
+                            hass::payload_mode::minimal));
+                    };
+                };
+
+                // Publishes discovery config through the discovery cache. A
+                // config already retained by the broker completes immediately.
+                const auto publish_config =
+                    [=](mikettle_state& state,
+                        const std::uint8_t index,
+                        const char* topic,
+                        const auto& render,
+                        back::process<events::write_finished> back_process) {
+                        const hass::discovery_cache::key key{ DEVICE_MODEL,
+                            state.gatt_client.mac(),
+                            index };
+
+                        const bool started = publish_discovery(
+                            state.mqtt_client,
+                            key,
+                            topic,
+                            render,
+                            write_handler(state));
+
+                        if (!started)
+                        {
+                            back_process(events::write_finished{});
+                        }
+                    };
+
+                const auto on_conf_temp_sens =
+                    [=](mikettle_state& state,
+                        back::process<events::write_finished> back_process) {
+                        state.discovery_generation =
+                            hass::discovery_cache::instance().generation();
+                        publish_config(state,
+                            TEMPERATURE_SENSOR_INDEX,
+                            TEMPERATURE_SENSOR_CONFIG_TOPIC,
+                            render_entity(make_temp_sens),
+                            back_process);
+                    };
+
+                const auto on_conf_actn_sens =
+                    [=](mikettle_state& state,
+                        back::process<events::write_finished> back_process) {
+                        publish_config(state,
+                            ACTION_SENSOR_INDEX,
+                            ACTION_SENSOR_CONFIG_TOPIC,
+                            render_entity(make_actn_sens),
+                            back_process);
+                    };
+
+                const auto on_conf_mode_sens =
+                    [=](mikettle_state& state,
+                        back::process<events::write_finished> back_process) {
+                        publish_config(state,
+                            MODE_SENSOR_INDEX,
+                            MODE_SENSOR_CONFIG_TOPIC,
+                            render_entity(make_mode_sens),
+                            back_process);
+                    };
+
+                const auto on_conf_warm_time_sens =
+                    [=](mikettle_state& state,
+                        back::process<events::write_finished> back_process) {
+                        publish_config(state,
+                            KEEP_WARM_TIME_SENSOR_INDEX,
+                            KEEP_WARM_TIME_SENSOR_CONFIG_TOPIC,
+                            render_entity(make_warm_time_sens),
+                            back_process);
+                    };
+
+                const auto on_conf_temp_set_num =
+                    [=](mikettle_state& state,
+                        back::process<events::write_finished> back_process) {
+                        publish_config(state,
+                            TEMPERATURE_SET_NUMBER_INDEX,
+                            TEMPERATURE_SET_NUMBER_CONFIG_TOPIC,
+                            render_entity(make_temp_set_num),
+                            back_process);
+                    };
+
+                const auto on_conf_warm_limit_num =
+                    [=](mikettle_state& state,
+                        back::process<events::write_finished> back_process) {
+                        publish_config(state,
+                            KEEP_WARM_TIME_LIMIT_NUMBER_INDEX,
+                            KEEP_WARM_TIME_LIMIT_NUMBER_CONFIG_TOPIC,
+                            render_entity(make_warm_limit_num),
+                            back_process);
+                    };
+
+                const auto on_conf_warm_type =
+                    [=](mikettle_state& state,
+                        back::process<events::write_finished> back_process) {
+                        publish_config(state,
+                            KEEP_WARM_TYPE_SELECT_INDEX,
+                            KEEP_WARM_TYPE_SELECT_CONFIG_TOPIC,
+                            render_entity(make_warm_type),
+                            back_process);
+                    };
+
+                const auto on_conf_toab_sel =
+                    [=](mikettle_state& state,
+                        back::process<events::write_finished> back_process) {
+                        publish_config(state,
+                            TURN_OFF_AFTER_BOIL_SWITCH_INDEX,
+                            TURN_OFF_AFTER_BOIL_SWITCH_CONFIG_TOPIC,
+                            render_entity(make_toab_sel),
+                            back_process);
+                    };
+
+                // Serializes discovery config of all the entities as a single
+                // device payload.
+                const auto render_device = [=](mikettle_state& state) {
+                    using namespace std::literals;
+
+                    std::array<std::pair<std::string_view, std::string_view>, 1>
+                        conn{ {
+                            { "mac"sv, state.gatt_client.mac().str() },
+                        } };
+
+                    const auto with_id = [](auto entity,
+                                             const std::string_view id) {
+                        entity.unique_id = id;
+                        return entity;
+                    };
+
+                    const auto temp_sens =
+                        with_id(make_temp_sens(), TEMPERATURE_SENSOR_ID);
+                    const auto actn_sens =
+                        with_id(make_actn_sens(), ACTION_SENSOR_ID);
+                    const auto mode_sens =
+                        with_id(make_mode_sens(), MODE_SENSOR_ID);
+                    const auto warm_time_sens = with_id(make_warm_time_sens(),
+                        KEEP_WARM_TIME_SENSOR_ID);
+                    const auto temp_set_num =
+                        with_id(make_temp_set_num(), TEMPERATURE_SET_NUMBER_ID);
+                    const auto warm_limit_num = with_id(make_warm_limit_num(),
+                        KEEP_WARM_TIME_LIMIT_NUMBER_ID);
+                    const auto warm_type =
+                        with_id(make_warm_type(), KEEP_WARM_TYPE_SELECT_ID);
+                    const auto toab_sel =
+                        with_id(make_toab_sel(), TURN_OFF_AFTER_BOIL_SWITCH_ID);
+
+                    const std::array<hass::component_type, 8> components{ {
+                        { TEMPERATURE_SENSOR_ID, &temp_sens },
+                        { ACTION_SENSOR_ID, &actn_sens },
+                        { MODE_SENSOR_ID, &mode_sens },
+                        { KEEP_WARM_TIME_SENSOR_ID, &warm_time_sens },
+                        { TEMPERATURE_SET_NUMBER_ID, &temp_set_num },
+                        { KEEP_WARM_TIME_LIMIT_NUMBER_ID, &warm_limit_num },
+                        { KEEP_WARM_TYPE_SELECT_ID, &warm_type },
+                        { TURN_OFF_AFTER_BOIL_SWITCH_ID, &toab_sel },
+                    } };
+
+                    hass::device_discovery_type discovery;
+
+                    discovery.device.name        = DEVICE_MODEL;
+                    discovery.device.model       = DEVICE_MODEL;
+                    discovery.device.connections = tcb::make_span(conn);
+                    discovery.origin.name        = ORIGIN_NAME;
+                    discovery.components         = components;
+
+                    return utils::json::dump(hass::serialize(discovery,
+                        hass::payload_mode::minimal));
+                };
+
+                const auto on_conf_device =
+                    [=](mikettle_state& state,
+                        back::process<events::write_finished> back_process) {
+                        state.discovery_generation =
+                            hass::discovery_cache::instance().generation();
+                        publish_config(state,
+                            DEVICE_INDEX,
+                            DEVICE_CONFIG_TOPIC,
+                            [&] { return render_device(state); },
+                            back_process);
+                    };
+
+                const auto device_discovery = [] { return DEVICE_DISCOVERY; };
+
+                const auto on_rediscover = [=](mikettle_state& state) {
+                    if (!rediscover(state.discovery_generation))
+                    {
+                        return;
+                    }
+
+                    const auto republish = [&](const std::uint8_t index,
+                                               const char* topic,
+                                               const auto& render) {
+                        publish_discovery(state.mqtt_client,
+                            { DEVICE_MODEL, state.gatt_client.mac(), index },
+                            topic,
+                            render,
+                            publish_handler);
+                    };
+
+                    log::info(COMPONENT, "Publishing discovery again.");
+
+                    if constexpr (DEVICE_DISCOVERY)
+                    {
+                        republish(DEVICE_INDEX,
+                            DEVICE_CONFIG_TOPIC,
+                            [&] { return render_device(state); });
+                    }
+                    else
+                    {
+                        republish(TEMPERATURE_SENSOR_INDEX,
+                            TEMPERATURE_SENSOR_CONFIG_TOPIC,
+                            render_entity(make_temp_sens));
+                        republish(ACTION_SENSOR_INDEX,
+                            ACTION_SENSOR_CONFIG_TOPIC,
+                            render_entity(make_actn_sens));
+                        republish(MODE_SENSOR_INDEX,
+                            MODE_SENSOR_CONFIG_TOPIC,
+                            render_entity(make_mode_sens));
+                        republish(KEEP_WARM_TIME_SENSOR_INDEX,
+                            KEEP_WARM_TIME_SENSOR_CONFIG_TOPIC,
+                            render_entity(make_warm_time_sens));
+                        republish(TEMPERATURE_SET_NUMBER_INDEX,
+                            TEMPERATURE_SET_NUMBER_CONFIG_TOPIC,
+                            render_entity(make_temp_set_num));
+                        republish(KEEP_WARM_TIME_LIMIT_NUMBER_INDEX,
+                            KEEP_WARM_TIME_LIMIT_NUMBER_CONFIG_TOPIC,
+                            render_entity(make_warm_limit_num));
+                        republish(KEEP_WARM_TYPE_SELECT_INDEX,
+                            KEEP_WARM_TYPE_SELECT_CONFIG_TOPIC,
+                            render_entity(make_warm_type));
+                        republish(TURN_OFF_AFTER_BOIL_SWITCH_INDEX,
+                            TURN_OFF_AFTER_BOIL_SWITCH_CONFIG_TOPIC,
+                            render_entity(make_toab_sel));
+                    }
                 };
 
                 const auto on_disc_data_srv = [=](mikettle_state& state) {
@@ -1034,18 +1332,6 @@ namespace b2h::device::xiaomi
                         disc_desc_handler(state));
                 };
 
-                const auto sub_temp_set =
-                    mqtt_sub(TEMPERATURE_SET_NUMBER_CMD_TOPIC);
-
-                const auto sub_warm_time_limit =
-                    mqtt_sub(KEEP_WARM_TIME_LIMIT_NUMBER_CMD_TOPIC);
-
-                const auto sub_warm_type =
-                    mqtt_sub(KEEP_WARM_TYPE_SELECT_CMD_TOPIC);
-
-                const auto sub_toab =
-                    mqtt_sub(TURN_OFF_AFTER_BOIL_SWITCH_CMD_TOPIC);
-
                 const auto time_set_start_read = [](mikettle_state& state) {
                     auto& state_var =
                         std::get<mikettle_state::operating>(state.state_var);
@@ -1120,7 +1406,7 @@ namespace b2h::device::xiaomi
                         action_to_sv(event.data[0]),
                         0,
                         true,
-                        write_handler(state));
+                        publish_handler);
                 };
 
                 const auto is_mode_upd = [](mikettle_state& state,
@@ -1141,7 +1427,7 @@ namespace b2h::device::xiaomi
                         mode_to_sv(event.data[1]),
                         0,
                         true,
-                        write_handler(state));
+                        publish_handler);
                 };
 
                 const auto is_temp_set_upd = [](mikettle_state& state,
@@ -1175,14 +1461,12 @@ namespace b2h::device::xiaomi
                         },
                         1,
                         true,
-                        write_handler(state));
+                        publish_handler);
                 };
 
                 const auto is_temp_upd = [](mikettle_state& state,
                                              const events::notify& event) {
-                    auto& state_var =
-                        std::get<mikettle_state::operating>(state.state_var);
-                    return state_var.cache.temperature_current != event.data[5];
+                    return state.temp_filter.pass(event.data[5]);
                 };
 
                 const auto upd_temp = [=](mikettle_state& state,
@@ -1209,7 +1493,7 @@ namespace b2h::device::xiaomi
                         },
                         0,
                         true,
-                        write_handler(state));
+                        publish_handler);
                 };
 
                 const auto is_warm_type_upd = [](mikettle_state& state,
@@ -1231,7 +1515,7 @@ namespace b2h::device::xiaomi
                         keep_warm_type_to_sv(state_var.cache.keep_warm_type),
                         1,
                         true,
-                        write_handler(state));
+                        publish_handler);
                 };
 
                 const auto is_warm_time_upd = [](mikettle_state& state,
@@ -1270,10 +1554,42 @@ namespace b2h::device::xiaomi
                         },
                         0,
                         true,
-                        write_handler(state));
+                        publish_handler);
                 };
 
                 const auto mqtt_receive = [](mikettle_state& state) {
+                    using command_t = void (*)(mikettle_state&,
+                        std::string_view);
+
+                    // Command topics mapped straight to their FSM events,
+                    // data on any other topic is dropped without an event.
+                    static const mqtt::router<command_t> commands = []() {
+                        mqtt::router<command_t> router;
+
+                        router[KEEP_WARM_TYPE_SELECT_CMD_TOPIC] =
+                            [](mikettle_state& state, std::string_view data) {
+                                state.process_external_event(
+                                    events::warm_type_cmd{ data });
+                            };
+                        router[TEMPERATURE_SET_NUMBER_CMD_TOPIC] =
+                            [](mikettle_state& state, std::string_view data) {
+                                state.process_external_event(
+                                    events::temp_set_cmd{ data });
+                            };
+                        router[KEEP_WARM_TIME_LIMIT_NUMBER_CMD_TOPIC] =
+                            [](mikettle_state& state, std::string_view data) {
+                                state.process_external_event(
+                                    events::warm_time_limit_cmd{ data });
+                            };
+                        router[TURN_OFF_AFTER_BOIL_SWITCH_CMD_TOPIC] =
+                            [](mikettle_state& state, std::string_view data) {
+                                state.process_external_event(
+                                    events::toab_cmd{ data });
+                            };
+
+                        return router;
+                    }();
+
                     const auto mqtt_receive_impl = [](auto self,
                                                        mikettle_state& state) {
                         state.mqtt_client.async_receive([&, self](
@@ -1286,10 +1602,10 @@ namespace b2h::device::xiaomi
                                 return;
                             }
 
-                            state.process_external_event(events::mqtt_data{
-                                result.value().topic,
-                                result.value().data,
-                            });
+                            commands.match(result.value().topic,
+                                [&](command_t command) {
+                                    command(state, result.value().data);
+                                });
 
                             self(self, state);
                         });
@@ -1298,17 +1614,8 @@ namespace b2h::device::xiaomi
                     mqtt_receive_impl(mqtt_receive_impl, state);
                 };
 
-                const auto make_topic_guard = [](const std::string_view topic) {
-                    return [=](events::mqtt_data event) {
-                        return topic == event.topic;
-                    };
-                };
-
-                const auto topic_warm_type =
-                    make_topic_guard(KEEP_WARM_TYPE_SELECT_CMD_TOPIC);
-
                 const auto is_warm_type_mqtt_upd =
-                    [](mikettle_state& state, events::mqtt_data event) {
+                    [](mikettle_state& state, events::warm_type_cmd event) {
                         const std::uint8_t keep_warm_type =
                             sv_to_keep_warm_type(event.data);
 
@@ -1338,39 +1645,36 @@ namespace b2h::device::xiaomi
                         write_handler(state));
                 };
 
-                const auto topic_temp_set =
-                    make_topic_guard(TEMPERATURE_SET_NUMBER_CMD_TOPIC);
-
-                const auto is_temp_set_mqtt_upd = [](mikettle_state& state,
-                                                      events::mqtt_data event) {
-                    std::uint8_t temperature_set = 0U;
-                    if (const auto [ptr, ec] =
-                            std::from_chars(event.data.data(),
-                                event.data.data() + event.data.size(),
-                                temperature_set);
-                        ec != std::errc{})
-                    {
-                        log::warning(COMPONENT,
-                            "Temperature conversion failed.");
-                        return false;
-                    }
+                const auto is_temp_set_mqtt_upd =
+                    [](mikettle_state& state, events::temp_set_cmd event) {
+                        std::uint8_t temperature_set = 0U;
+                        if (const auto [ptr, ec] =
+                                std::from_chars(event.data.data(),
+                                    event.data.data() + event.data.size(),
+                                    temperature_set);
+                            ec != std::errc{})
+                        {
+                            log::warning(COMPONENT,
+                                "Temperature conversion failed.");
+                            return false;
+                        }
 
-                    auto& state_var =
-                        std::get<mikettle_state::operating>(state.state_var);
+                        auto& state_var = std::get<mikettle_state::operating>(
+                            state.state_var);
 
-                    if (temperature_set == state_var.cache.temperature_set)
-                    {
-                        return false;
-                    }
+                        if (temperature_set ==
+                            state_var.cache.temperature_set)
+                        {
+                            return false;
+                        }
 
-                    state_var.temp_val =
-                        static_cast<std::uint16_t>(temperature_set);
+                        state_var.temp_val =
+                            static_cast<std::uint16_t>(temperature_set);
 
-                    return true;
-                };
+                        return true;
+                    };
 
-                const auto temp_set_write = [=](mikettle_state& state,
-                                                events::mqtt_data event) {
+                const auto temp_set_write = [=](mikettle_state& state) {
                     auto& state_var =
                         std::get<mikettle_state::operating>(state.state_var);
 
@@ -1382,11 +1686,9 @@ namespace b2h::device::xiaomi
                         write_handler(state));
                 };
 
-                const auto topic_warm_time_limit =
-                    make_topic_guard(KEEP_WARM_TIME_LIMIT_NUMBER_CMD_TOPIC);
-
                 const auto is_warm_time_limit_mqtt_upd =
-                    [](mikettle_state& state, events::mqtt_data event) {
+                    [](mikettle_state& state,
+                        events::warm_time_limit_cmd event) {
                         const std::uint8_t time_limit =
                             static_cast<std::uint8_t>(
                                 2.0f * std::stof(std::string{ event.data }));
@@ -1413,7 +1715,7 @@ namespace b2h::device::xiaomi
                         std::array{
                             static_cast<std::uint8_t>(state_var.temp_val),
                         },
-                        [&, write_handler](auto&& result) {
+                        [&, publish_handler](auto&& result) {
                             using buff_t = std::array<char, 4>;
 
                             if (!result.has_value())
@@ -1444,15 +1746,15 @@ namespace b2h::device::xiaomi
                                 },
                                 1,
                                 true,
-                                write_handler(state));
+                                publish_handler);
+
+                            state.process_external_event(
+                                events::write_finished{});
                         });
                 };
 
-                const auto topic_toab =
-                    make_topic_guard(TURN_OFF_AFTER_BOIL_SWITCH_CMD_TOPIC);
-
                 const auto is_toab_mqtt_upd = [](mikettle_state& state,
-                                                  events::mqtt_data event) {
+                                                  events::toab_cmd event) {
                     const std::uint8_t turn_off_after_boil =
                         switch_val_to_uint8(event.data);
 
@@ -1480,7 +1782,7 @@ namespace b2h::device::xiaomi
                         std::array{
                             static_cast<std::uint8_t>(state_var.temp_val),
                         },
-                        [&, write_handler](auto&& result) {
+                        [&, publish_handler](auto&& result) {
                             if (!result.has_value())
                             {
                                 state.process_external_event(events::abort{});
@@ -1495,10 +1797,72 @@ namespace b2h::device::xiaomi
                                 uint8_to_switch_val(state_var.temp_val),
                                 1,
                                 true,
-                                write_handler(state));
+                                publish_handler);
+
+                            state.process_external_event(
+                                events::write_finished{});
                         });
                 };
 
+                const auto queue_warm_type =
+                    [](mikettle_state& state,
+                        const events::warm_type_cmd& event) {
+                        state.commands.push(WARM_TYPE_CMD_SLOT, event.data);
+                    };
+
+                const auto queue_temp_set =
+                    [](mikettle_state& state,
+                        const events::temp_set_cmd& event) {
+                        state.commands.push(TEMP_SET_CMD_SLOT, event.data);
+                    };
+
+                const auto queue_warm_time_limit =
+                    [](mikettle_state& state,
+                        const events::warm_time_limit_cmd& event) {
+                        state.commands.push(WARM_TIME_LIMIT_CMD_SLOT,
+                            event.data);
+                    };
+
+                const auto queue_toab = [](mikettle_state& state,
+                                            const events::toab_cmd& event) {
+                    state.commands.push(TOAB_CMD_SLOT, event.data);
+                };
+
+                // Replays the latest value of each queued command. The first
+                // one that changes a parameter starts its write, the rest are
+                // queued again until that write completes.
+                const auto replay_cmds =
+                    [](mikettle_state& state,
+                        back::process<events::warm_type_cmd,
+                            events::temp_set_cmd,
+                            events::warm_time_limit_cmd,
+                            events::toab_cmd> back_process) {
+                        while (const auto command = state.commands.front())
+                        {
+                            const auto [slot, data] = command.value();
+                            state.commands.pop();
+
+                            switch (slot)
+                            {
+                            case WARM_TYPE_CMD_SLOT:
+                                back_process(events::warm_type_cmd{ data });
+                                break;
+                            case TEMP_SET_CMD_SLOT:
+                                back_process(events::temp_set_cmd{ data });
+                                break;
+                            case WARM_TIME_LIMIT_CMD_SLOT:
+                                back_process(
+                                    events::warm_time_limit_cmd{ data });
+                                break;
+                            case TOAB_CMD_SLOT:
+                                back_process(events::toab_cmd{ data });
+                                break;
+                            default:
+                                break;
+                            }
+                        }
+                    };
+
                 const auto on_abort_conn = [](mikettle_state& state) {
                     log::warning(COMPONENT, "Terminating BLE connection.");
                     state.gatt_client.terminate();
@@ -1524,9 +1888,14 @@ namespace b2h::device::xiaomi
                     "auth_subscribed"_s     + sml::event<events::write_finished> / on_auth_subscribe           = "wait_auth_notify"_s,
                     "auth_subscribed"_s     + sml::event<events::abort>                                        = "terminate"_s,
 
-                    "wait_auth_notify"_s    + sml::event<events::notify>         / on_auth_notify              = "conf_temp_sens"_s,
+                    "wait_auth_notify"_s    + sml::event<events::notify> [!device_discovery] / on_auth_notify  = "conf_temp_sens"_s,
+                    "wait_auth_notify"_s    + sml::event<events::notify> [device_discovery]  / on_auth_notify  = "conf_device"_s,
                     "wait_auth_notify"_s    + sml::event<events::abort>                                        = "terminate"_s,
 
+                    "conf_device"_s         + on_entry<_>                        / on_conf_device,
+                    "conf_device"_s         + sml::event<events::write_finished> / on_disc_data_srv            = "disc_data_srv"_s,
+                    "conf_device"_s         + sml::event<events::abort>                                        = "terminate"_s,
+
                     "conf_temp_sens"_s      + on_entry<_>                        / on_conf_temp_sens,
                     "conf_temp_sens"_s      + sml::event<events::write_finished>                               = "conf_actn_sens"_s,
                     "conf_temp_sens"_s      + sml::event<events::abort>                                        = "terminate"_s,
@@ -1573,41 +1942,40 @@ namespace b2h::device::xiaomi
                     "read_time_set"_s       + sml::event<events::abort>                                        = "terminate"_s,
 
                     "read_toab"_s           + on_entry<_>                        / toab_start_read,
-                    "read_toab"_s           + sml::event<events::read_finished>  / sub_temp_set                = "sub_temp_set"_s,
+                    "read_toab"_s           + sml::event<events::read_finished>  / mqtt_sub                    = "subscribe"_s,
                     "read_toab"_s           + sml::event<events::abort>                                        = "terminate"_s,
 
-                    "sub_temp_set"_s        + sml::event<events::sub_finished>   / sub_warm_time_limit         = "sub_warm_time"_s,
-                    "sub_temp_set"_s        + sml::event<events::abort>                                        = "terminate"_s,
-                    
-                    "sub_warm_time"_s       + sml::event<events::sub_finished>   / sub_warm_type               = "sub_warm_type"_s,
-                    "sub_warm_time"_s       + sml::event<events::abort>                                        = "terminate"_s,
-          
-                    "sub_warm_type"_s       + sml::event<events::sub_finished>   / sub_toab                    = "sub_toab"_s,
-                    "sub_warm_type"_s       + sml::event<events::abort>                                        = "terminate"_s,
-
-                    "sub_toab"_s            + sml::event<events::sub_finished>   / mqtt_receive                = "operate"_s,
-                    "sub_toab"_s            + sml::event<events::abort>                                        = "terminate"_s,
+                    "subscribe"_s           + sml::event<events::sub_finished>   / mqtt_receive                = "operate"_s,
+                    "subscribe"_s           + sml::event<events::abort>                                        = "terminate"_s,
 
                     // Configuration is finished, start normal operation.
                     
-                    "operate"_s + sml::event<events::notify> [is_status_chr && is_temp_set_upd]  / upd_temp_set  = "param_write"_s,
-                    "operate"_s + sml::event<events::notify> [is_status_chr && is_warm_type_upd] / upd_warm_type = "param_write"_s,
-                    "operate"_s + sml::event<events::notify> [is_status_chr && is_warm_time_upd] / upd_warm_time = "param_write"_s,
-                    "operate"_s + sml::event<events::notify> [is_status_chr && is_actn_upd]      / upd_actn      = "param_write"_s,
-                    "operate"_s + sml::event<events::notify> [is_status_chr && is_mode_upd]      / upd_mode      = "param_write"_s,          
-                    "operate"_s + sml::event<events::notify> [is_status_chr && is_temp_upd]      / upd_temp      = "param_write"_s,
+                    "operate"_s + sml::event<events::notify> [is_status_chr && is_temp_set_upd]  / upd_temp_set,
+                    "operate"_s + sml::event<events::notify> [is_status_chr && is_warm_type_upd] / upd_warm_type,
+                    "operate"_s + sml::event<events::notify> [is_status_chr && is_warm_time_upd] / upd_warm_time,
+                    "operate"_s + sml::event<events::notify> [is_status_chr && is_actn_upd]      / upd_actn,
+                    "operate"_s + sml::event<events::notify> [is_status_chr && is_mode_upd]      / upd_mode,
+                    "operate"_s + sml::event<events::notify> [is_status_chr && is_temp_upd]      / upd_temp,
     
-                    "operate"_s + sml::event<events::mqtt_data> [topic_warm_type && is_warm_type_mqtt_upd]             / warm_type_write       = "param_write"_s,
-                    "operate"_s + sml::event<events::mqtt_data> [topic_temp_set && is_temp_set_mqtt_upd]               / temp_set_write        = "param_write"_s,
-                    "operate"_s + sml::event<events::mqtt_data> [topic_toab && is_toab_mqtt_upd]                       / toab_write            = "param_write"_s,
-                    "operate"_s + sml::event<events::mqtt_data> [topic_warm_time_limit && is_warm_time_limit_mqtt_upd] / warm_time_limit_write = "param_write"_s,
+                    "operate"_s + sml::event<events::warm_type_cmd>       [is_warm_type_mqtt_upd]       / warm_type_write       = "param_write"_s,
+                    "operate"_s + sml::event<events::temp_set_cmd>        [is_temp_set_mqtt_upd]        / temp_set_write        = "param_write"_s,
+                    "operate"_s + sml::event<events::toab_cmd>            [is_toab_mqtt_upd]            / toab_write            = "param_write"_s,
+                    "operate"_s + sml::event<events::warm_time_limit_cmd> [is_warm_time_limit_mqtt_upd] / warm_time_limit_write = "param_write"_s,
+
+                    "operate"_s + sml::event<events::rediscover> / on_rediscover,
 
                     "operate"_s + sml::event<events::abort>         = "terminate"_s,
                     "operate"_s + sml::event<events::disconnected>  = X,        
 
-                    "param_write"_s + sml::event<events::write_finished> = "operate"_s,
-                    "param_write"_s + sml::event<events::abort>          = "operate"_s,
-                    "param_write"_s + sml::event<events::disconnected>   = X,
+                    // Commands arriving during a write keep their latest value only.
+                    "param_write"_s + sml::event<events::warm_type_cmd>       / queue_warm_type,
+                    "param_write"_s + sml::event<events::temp_set_cmd>        / queue_temp_set,
+                    "param_write"_s + sml::event<events::warm_time_limit_cmd> / queue_warm_time_limit,
+                    "param_write"_s + sml::event<events::toab_cmd>            / queue_toab,
+
+                    "param_write"_s + sml::event<events::write_finished> / replay_cmds = "operate"_s,
+                    "param_write"_s + sml::event<events::abort>          / replay_cmds = "operate"_s,
+                    "param_write"_s + sml::event<events::disconnected>                 = X,
 
                     "terminate"_s + on_entry<_> / on_abort_conn
                 );
@@ -1621,7 +1989,8 @@ namespace b2h::device::xiaomi
     {
     public:
         mikettle(std::unique_ptr<mqtt::client>&& mqtt_client,
-            std::unique_ptr<ble::gatt::client>&& gatt_client) noexcept;
+            std::unique_ptr<ble::gatt::client>&& gatt_client,
+            const options& opts = {}) noexcept;
 
         mikettle()                = delete;
         mikettle(const mikettle&) = delete;
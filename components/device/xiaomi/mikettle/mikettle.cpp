@@ -24,12 +24,16 @@
 namespace b2h::device::xiaomi
 {
     mikettle::mikettle(std::unique_ptr<mqtt::client>&& mqtt_client,
-        std::unique_ptr<ble::gatt::client>&& gatt_client) noexcept :
+        std::unique_ptr<ble::gatt::client>&& gatt_client,
+        const options& opts) noexcept :
         base{ std::move(mqtt_client), std::move(gatt_client) },
         m_state{
             this->gatt_client(),
             this->mqtt_client(),
             {},
+            publish_filter{ opts.filter("temperature") },
+            {},
+            0U,
             make_process_external_event(),
         },
         m_fsm{ m_state }
@@ -44,6 +48,7 @@ namespace b2h::device::xiaomi
     void mikettle::on_notify(std::uint16_t attribute_handle,
         std::vector<std::uint8_t>&& data) noexcept
     {
+        m_fsm.process_event(mikettle_impl::events::rediscover{});
         m_fsm.process_event(
             mikettle_impl::events::notify{ attribute_handle, std::move(data) });
     }
@@ -22,9 +22,11 @@
 #define B2H_EVENT_CONTEXT_HPP
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <cstdint>
 #include <functional>
+#include <map>
 #include <mutex>
 #include <queue>
 #include <thread>
@@ -44,6 +46,7 @@ namespace b2h::event
             m_mutex{},
             m_cv{},
             m_dispatch_queue{},
+            m_timer_queue{},
             m_active_events{ 0ULL }
         {
         }
@@ -73,29 +76,58 @@ namespace b2h::event
             m_cv.notify_one();
         }
 
+        /**
+         * @brief Shedule the function to run once the delay elapses.
+         *
+         * The function does not keep the context running by itself, the
+         * caller accounts for it in active_events().
+         *
+         * @param delay Time to wait before running the function.
+         * @param func Function to run.
+         */
+        template<typename Rep, typename Period, typename FuncT>
+        void shedule_after(
+            std::chrono::duration<Rep, Period> delay, FuncT&& func) noexcept
+        {
+            const auto deadline = clock_type::now() +
+                std::chrono::duration_cast<clock_type::duration>(delay);
+
+            {
+                std::lock_guard<std::mutex> lock{ m_mutex };
+                m_timer_queue.emplace(deadline, std::forward<FuncT>(func));
+            }
+            m_cv.notify_one();
+        }
+
         void run()
         {
             std::function<void(void)> func;
 
             while (m_active_events)
             {
-                log::verbose(COMPONENT,
+                B2H_LOG_VERBOSE(COMPONENT,
                     "Current active events: {}.",
                     m_active_events.load());
 
                 {
                     std::unique_lock<std::mutex> lock{ m_mutex };
-                    while (m_dispatch_queue.empty())
+                    while (!next(func))
                     {
-                        log::verbose(COMPONENT, "Context idle.");
-                        m_cv.wait(lock);
+                        B2H_LOG_VERBOSE(COMPONENT, "Context idle.");
+
+                        if (m_timer_queue.empty())
+                        {
+                            m_cv.wait(lock);
+                        }
+                        else
+                        {
+                            m_cv.wait_until(lock,
+                                m_timer_queue.cbegin()->first);
+                        }
                     }
-
-                    func = std::move(m_dispatch_queue.front());
-                    m_dispatch_queue.pop();
                 }
 
-                log::verbose(COMPONENT,
+                B2H_LOG_VERBOSE(COMPONENT,
                     "Calling event handler.",
                     m_active_events.load());
                 func();
@@ -103,12 +135,37 @@ namespace b2h::event
         }
 
     private:
-        static constexpr std::string_view COMPONENT{ "event::context" };
+        using clock_type = std::chrono::steady_clock;
+
+        static constexpr log::component COMPONENT{ "event::context" };
 
         std::mutex m_mutex;
         std::condition_variable m_cv;
         std::queue<std::function<void(void)>> m_dispatch_queue;
+        std::multimap<clock_type::time_point, std::function<void(void)>>
+            m_timer_queue;
         std::atomic<std::size_t> m_active_events;
+
+        // Expired timers go first, m_mutex must be held.
+        bool next(std::function<void(void)>& func)
+        {
+            if (!m_timer_queue.empty() &&
+                m_timer_queue.cbegin()->first <= clock_type::now())
+            {
+                func = std::move(m_timer_queue.begin()->second);
+                m_timer_queue.erase(m_timer_queue.begin());
+                return true;
+            }
+
+            if (m_dispatch_queue.empty())
+            {
+                return false;
+            }
+
+            func = std::move(m_dispatch_queue.front());
+            m_dispatch_queue.pop();
+            return true;
+        }
     };
 } // namespace b2h::event
 
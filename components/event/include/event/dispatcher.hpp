@@ -92,7 +92,7 @@ namespace b2h::event
 
             static constexpr std::size_t id = event_id<EventT>();
 
-            log::verbose(COMPONENT,
+            B2H_LOG_VERBOSE(COMPONENT,
                 "Sheduling work for event id: {}. Current event flags: {}",
                 id,
                 m_flags);
@@ -110,7 +110,7 @@ namespace b2h::event
         {
             static constexpr std::size_t id = event_id<EventT>();
 
-            log::verbose(COMPONENT,
+            B2H_LOG_VERBOSE(COMPONENT,
                 "Dispatching handler for event id: {}. Current event flags: {}",
                 id,
                 m_flags);
@@ -118,7 +118,7 @@ namespace b2h::event
             if (!m_flags[id])
             {
                 // Nobody is listening, ignore the event
-                log::verbose(COMPONENT, "Event with id {} ignored.", id);
+                B2H_LOG_VERBOSE(COMPONENT, "Event with id {} ignored.", id);
                 return;
             }
 
@@ -140,7 +140,7 @@ namespace b2h::event
     private:
         using dispatch_table_type = impl::dispatch_table<EventsT...>;
 
-        static constexpr std::string_view COMPONENT{ "event::dispatcher" };
+        static constexpr log::component COMPONENT{ "event::dispatcher" };
 
         std::reference_wrapper<context_type> m_context;
         std::array<bool, sizeof...(EventsT)> m_flags;
@@ -20,9 +20,11 @@
 
 #include "catch2/catch.hpp"
 
+#include <chrono>
 #include <functional>
 #include <future>
 #include <stdexcept>
+#include <vector>
 
 #include "event/event.hpp"
 
@@ -189,3 +191,34 @@ TEST_CASE("Throw in handler.", "[event]")
 
     REQUIRE(invoked);
 }
+
+TEST_CASE("Run delayed work.", "[event]")
+{
+    using namespace b2h::event;
+    using namespace std::chrono_literals;
+
+    context ctx{};
+    std::vector<int> order;
+
+    const auto start = std::chrono::steady_clock::now();
+    ctx.active_events() += 3;
+
+    ctx.shedule_after(20ms, [&]() {
+        --ctx.active_events();
+        order.push_back(2);
+        REQUIRE(std::chrono::steady_clock::now() - start >= 20ms);
+    });
+
+    ctx.shedule_after(10ms, [&]() {
+        --ctx.active_events();
+        order.push_back(1);
+    });
+
+    ctx.shedule([&]() {
+        --ctx.active_events();
+        order.push_back(0);
+    });
+
+    ctx.run();
+    REQUIRE(order == std::vector<int>{ 0, 1, 2 });
+}
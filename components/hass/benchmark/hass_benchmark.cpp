@@ -0,0 +1,936 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "benchmark/benchmark.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "fmt/format.h"
+
+#include "hass/device_types.hpp"
+#include "hass/payload_template.hpp"
+#include "utils/json.hpp"
+
+// Allocation counter. With glibc every malloc, including the ones made by
+// operator new and rapidjson allocators, goes through the functions below.
+// Elsewhere the counter stays at zero.
+static std::atomic<std::size_t> allocations{ 0 };
+
+#if defined(__GLIBC__)
+extern "C"
+{
+    void* __libc_malloc(std::size_t size);
+    void* __libc_calloc(std::size_t count, std::size_t size);
+    void* __libc_realloc(void* ptr, std::size_t size);
+
+    void* malloc(std::size_t size)
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        return __libc_malloc(size);
+    }
+
+    void* calloc(std::size_t count, std::size_t size)
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* ptr, std::size_t size)
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        return __libc_realloc(ptr, size);
+    }
+}
+#endif
+
+namespace
+{
+    std::array<std::pair<std::string_view, std::string_view>, 2> CONNECTIONS{ {
+        { "mac", "A4:C1:38:00:00:00" },
+        { "zigbee", "0x00158d0001a2b3c4" },
+    } };
+
+    std::array<std::string_view, 2> STRINGS{
+        "first",
+        "second",
+    };
+
+    b2h::hass::device_type full_device()
+    {
+        b2h::hass::device_type device;
+
+        device.manufacturer   = "manufacturer";
+        device.model          = "model";
+        device.name           = "name";
+        device.suggested_area = "suggested_area";
+        device.sw_version     = "sw_version";
+        device.via_device     = "via_device";
+        device.connections    = tcb::make_span(CONNECTIONS);
+        device.identifiers    = tcb::make_span(STRINGS);
+
+        return device;
+    }
+
+    // Minimal structs set only the required members, full ones set all of
+    // them. Generated from device_types.hpp.
+
+    b2h::hass::alarm_control_panel_type minimal_alarm_control_panel()
+    {
+        b2h::hass::alarm_control_panel_type entity;
+
+        entity.command_topic = "command_topic";
+        entity.state_topic   = "state_topic";
+
+        return entity;
+    }
+
+    b2h::hass::alarm_control_panel_type full_alarm_control_panel()
+    {
+        b2h::hass::alarm_control_panel_type entity;
+
+        entity.command_topic             = "command_topic";
+        entity.state_topic               = "state_topic";
+        entity.code_arm_required         = true;
+        entity.code_disarm_required      = true;
+        entity.enabled_by_default        = true;
+        entity.retain                    = true;
+        entity.device                    = full_device();
+        entity.qos                       = 1;
+        entity.availability_mode         = "availability_mode";
+        entity.availability_topic        = "availability_topic";
+        entity.code                      = "code";
+        entity.command_template          = "command_template";
+        entity.entity_category           = "entity_category";
+        entity.icon                      = "icon";
+        entity.json_attributes_template  = "json_attributes_template";
+        entity.json_attributes_topic     = "json_attributes_topic";
+        entity.name                      = "name";
+        entity.payload_arm_away          = "payload_arm_away";
+        entity.payload_arm_custom_bypass = "payload_arm_custom_bypass";
+        entity.payload_arm_home          = "payload_arm_home";
+        entity.payload_arm_night         = "payload_arm_night";
+        entity.payload_arm_vacation      = "payload_arm_vacation";
+        entity.payload_available         = "payload_available";
+        entity.payload_disarm            = "payload_disarm";
+        entity.payload_not_available     = "payload_not_available";
+        entity.unique_id                 = "unique_id";
+        entity.value_template            = "value_template";
+        entity.availability              = tcb::make_span(STRINGS);
+
+        return entity;
+    }
+
+    b2h::hass::binary_sensor_type minimal_binary_sensor()
+    {
+        b2h::hass::binary_sensor_type entity;
+
+        entity.state_topic = "state_topic";
+
+        return entity;
+    }
+
+    b2h::hass::binary_sensor_type full_binary_sensor()
+    {
+        b2h::hass::binary_sensor_type entity;
+
+        entity.state_topic              = "state_topic";
+        entity.enabled_by_default       = true;
+        entity.force_update             = true;
+        entity.device                   = full_device();
+        entity.expire_after             = 1;
+        entity.off_delay                = 1;
+        entity.qos                      = 1;
+        entity.availability_mode        = "availability_mode";
+        entity.availability_topic       = "availability_topic";
+        entity.device_class             = "device_class";
+        entity.entity_category          = "entity_category";
+        entity.icon                     = "icon";
+        entity.json_attributes_template = "json_attributes_template";
+        entity.json_attributes_topic    = "json_attributes_topic";
+        entity.name                     = "name";
+        entity.payload_available        = "payload_available";
+        entity.payload_not_available    = "payload_not_available";
+        entity.payload_off              = "payload_off";
+        entity.payload_on               = "payload_on";
+        entity.unique_id                = "unique_id";
+        entity.value_template           = "value_template";
+        entity.availability             = tcb::make_span(STRINGS);
+
+        return entity;
+    }
+
+    b2h::hass::camera_type minimal_camera()
+    {
+        b2h::hass::camera_type entity;
+
+        entity.topic = "topic";
+
+        return entity;
+    }
+
+    b2h::hass::camera_type full_camera()
+    {
+        b2h::hass::camera_type entity;
+
+        entity.topic                    = "topic";
+        entity.enabled_by_default       = true;
+        entity.device                   = full_device();
+        entity.availability_mode        = "availability_mode";
+        entity.availability_topic       = "availability_topic";
+        entity.entity_category          = "entity_category";
+        entity.icon                     = "icon";
+        entity.json_attributes_template = "json_attributes_template";
+        entity.json_attributes_topic    = "json_attributes_topic";
+        entity.name                     = "name";
+        entity.unique_id                = "unique_id";
+        entity.availability             = tcb::make_span(STRINGS);
+
+        return entity;
+    }
+
+    b2h::hass::cover_type minimal_cover()
+    {
+        b2h::hass::cover_type entity;
+
+        return entity;
+    }
+
+    b2h::hass::cover_type full_cover()
+    {
+        b2h::hass::cover_type entity;
+
+        entity.enabled_by_default       = true;
+        entity.optimistic               = true;
+        entity.retain                   = true;
+        entity.tilt_optimistic          = true;
+        entity.device                   = full_device();
+        entity.position_closed          = 1;
+        entity.position_open            = 1;
+        entity.qos                      = 1;
+        entity.tilt_closed_value        = 1;
+        entity.tilt_max                 = 1;
+        entity.tilt_min                 = 1;
+        entity.tilt_opened_value        = 1;
+        entity.availability_mode        = "availability_mode";
+        entity.availability_topic       = "availability_topic";
+        entity.command_topic            = "command_topic";
+        entity.device_class             = "device_class";
+        entity.entity_category          = "entity_category";
+        entity.icon                     = "icon";
+        entity.json_attributes_template = "json_attributes_template";
+        entity.json_attributes_topic    = "json_attributes_topic";
+        entity.name                     = "name";
+        entity.payload_available        = "payload_available";
+        entity.payload_close            = "payload_close";
+        entity.payload_not_available    = "payload_not_available";
+        entity.payload_open             = "payload_open";
+        entity.payload_stop             = "payload_stop";
+        entity.position_template        = "position_template";
+        entity.position_topic           = "position_topic";
+        entity.set_position_template    = "set_position_template";
+        entity.set_position_topic       = "set_position_topic";
+        entity.state_closed             = "state_closed";
+        entity.state_closing            = "state_closing";
+        entity.state_open               = "state_open";
+        entity.state_opening            = "state_opening";
+        entity.state_stopped            = "state_stopped";
+        entity.state_topic              = "state_topic";
+        entity.tilt_command_template    = "tilt_command_template";
+        entity.tilt_command_topic       = "tilt_command_topic";
+        entity.tilt_status_template     = "tilt_status_template";
+        entity.tilt_status_topic        = "tilt_status_topic";
+        entity.unique_id                = "unique_id";
+        entity.value_template           = "value_template";
+        entity.availability             = tcb::make_span(STRINGS);
+
+        return entity;
+    }
+
+    b2h::hass::device_tracker_type minimal_device_tracker()
+    {
+        b2h::hass::device_tracker_type entity;
+
+        entity.devices = tcb::make_span(STRINGS);
+
+        return entity;
+    }
+
+    b2h::hass::device_tracker_type full_device_tracker()
+    {
+        b2h::hass::device_tracker_type entity;
+
+        entity.devices          = tcb::make_span(STRINGS);
+        entity.qos              = 1;
+        entity.payload_home     = "payload_home";
+        entity.payload_not_home = "payload_not_home";
+        entity.source_type      = "source_type";
+
+        return entity;
+    }
+
+    b2h::hass::device_trigger_type minimal_device_trigger()
+    {
+        b2h::hass::device_trigger_type entity;
+
+        entity.device          = b2h::hass::device_type{};
+        entity.automation_type = "automation_type";
+        entity.subtype         = "subtype";
+        entity.topic           = "topic";
+        entity.type            = "type";
+
+        return entity;
+    }
+
+    b2h::hass::device_trigger_type full_device_trigger()
+    {
+        b2h::hass::device_trigger_type entity;
+
+        entity.device          = full_device();
+        entity.automation_type = "automation_type";
+        entity.subtype         = "subtype";
+        entity.topic           = "topic";
+        entity.type            = "type";
+        entity.qos             = 1;
+        entity.payload         = "payload";
+
+        return entity;
+    }
+
+    b2h::hass::fan_type minimal_fan()
+    {
+        b2h::hass::fan_type entity;
+
+        entity.command_topic = "command_topic";
+
+        return entity;
+    }
+
+    b2h::hass::fan_type full_fan()
+    {
+        b2h::hass::fan_type entity;
+
+        entity.command_topic                = "command_topic";
+        entity.enabled_by_default           = true;
+        entity.optimistic                   = true;
+        entity.retain                       = true;
+        entity.device                       = full_device();
+        entity.qos                          = 1;
+        entity.speed_range_max              = 1;
+        entity.speed_range_min              = 1;
+        entity.availability_mode            = "availability_mode";
+        entity.availability_topic           = "availability_topic";
+        entity.command_template             = "command_template";
+        entity.entity_category              = "entity_category";
+        entity.icon                         = "icon";
+        entity.json_attributes_template     = "json_attributes_template";
+        entity.json_attributes_topic        = "json_attributes_topic";
+        entity.name                         = "name";
+        entity.oscillation_command_template = "oscillation_command_template";
+        entity.oscillation_command_topic    = "oscillation_command_topic";
+        entity.oscillation_state_topic      = "oscillation_state_topic";
+        entity.oscillation_value_template   = "oscillation_value_template";
+        entity.payload_available            = "payload_available";
+        entity.payload_not_available        = "payload_not_available";
+        entity.payload_off                  = "payload_off";
+        entity.payload_on                   = "payload_on";
+        entity.payload_oscillation_off      = "payload_oscillation_off";
+        entity.payload_oscillation_on       = "payload_oscillation_on";
+        entity.payload_reset_percentage     = "payload_reset_percentage";
+        entity.payload_reset_preset_mode    = "payload_reset_preset_mode";
+        entity.percentage_command_template  = "percentage_command_template";
+        entity.percentage_command_topic     = "percentage_command_topic";
+        entity.percentage_state_topic       = "percentage_state_topic";
+        entity.percentage_value_template    = "percentage_value_template";
+        entity.preset_mode_command_template = "preset_mode_command_template";
+        entity.preset_mode_command_topic    = "preset_mode_command_topic";
+        entity.preset_mode_state_topic      = "preset_mode_state_topic";
+        entity.preset_mode_value_template   = "preset_mode_value_template";
+        entity.state_topic                  = "state_topic";
+        entity.state_value_template         = "state_value_template";
+        entity.unique_id                    = "unique_id";
+        entity.availability                 = tcb::make_span(STRINGS);
+        entity.preset_modes                 = tcb::make_span(STRINGS);
+
+        return entity;
+    }
+
+    b2h::hass::humidifier_type minimal_humidifier()
+    {
+        b2h::hass::humidifier_type entity;
+
+        entity.command_topic                 = "command_topic";
+        entity.target_humidity_command_topic = "target_humidity_command_topic";
+
+        return entity;
+    }
+
+    b2h::hass::humidifier_type full_humidifier()
+    {
+        b2h::hass::humidifier_type entity;
+
+        entity.command_topic                    = "command_topic";
+        entity.target_humidity_command_topic    =
+            "target_humidity_command_topic";
+        entity.enabled_by_default               = true;
+        entity.optimistic                       = true;
+        entity.retain                           = true;
+        entity.device                           = full_device();
+        entity.max_humidity                     = 1;
+        entity.min_humidity                     = 1;
+        entity.qos                              = 1;
+        entity.availability_mode                = "availability_mode";
+        entity.availability_topic               = "availability_topic";
+        entity.command_template                 = "command_template";
+        entity.device_class                     = "device_class";
+        entity.entity_category                  = "entity_category";
+        entity.icon                             = "icon";
+        entity.json_attributes_template         = "json_attributes_template";
+        entity.json_attributes_topic            = "json_attributes_topic";
+        entity.mode_command_template            = "mode_command_template";
+        entity.mode_command_topic               = "mode_command_topic";
+        entity.mode_state_template              = "mode_state_template";
+        entity.mode_state_topic                 = "mode_state_topic";
+        entity.name                             = "name";
+        entity.payload_available                = "payload_available";
+        entity.payload_not_available            = "payload_not_available";
+        entity.payload_off                      = "payload_off";
+        entity.payload_on                       = "payload_on";
+        entity.payload_reset_humidity           = "payload_reset_humidity";
+        entity.payload_reset_mode               = "payload_reset_mode";
+        entity.state_topic                      = "state_topic";
+        entity.state_value_template             = "state_value_template";
+        entity.target_humidity_command_template =
+            "target_humidity_command_template";
+        entity.target_humidity_state_template   =
+            "target_humidity_state_template";
+        entity.target_humidity_state_topic      = "target_humidity_state_topic";
+        entity.unique_id                        = "unique_id";
+        entity.availability                     = tcb::make_span(STRINGS);
+        entity.modes                            = tcb::make_span(STRINGS);
+
+        return entity;
+    }
+
+    b2h::hass::light_type minimal_light()
+    {
+        b2h::hass::light_type entity;
+
+        entity.command_topic = "command_topic";
+
+        return entity;
+    }
+
+    b2h::hass::light_type full_light()
+    {
+        b2h::hass::light_type entity;
+
+        entity.command_topic               = "command_topic";
+        entity.enabled_by_default          = true;
+        entity.optimistic                  = true;
+        entity.retain                      = true;
+        entity.device                      = full_device();
+        entity.brightness_scale            = 1;
+        entity.max_mireds                  = 1;
+        entity.min_mireds                  = 1;
+        entity.qos                         = 1;
+        entity.white_scale                 = 1;
+        entity.availability_mode           = "availability_mode";
+        entity.availability_topic          = "availability_topic";
+        entity.brightness_command_topic    = "brightness_command_topic";
+        entity.brightness_state_topic      = "brightness_state_topic";
+        entity.brightness_value_template   = "brightness_value_template";
+        entity.color_mode_state_topic      = "color_mode_state_topic";
+        entity.color_mode_value_template   = "color_mode_value_template";
+        entity.color_temp_command_template = "color_temp_command_template";
+        entity.color_temp_command_topic    = "color_temp_command_topic";
+        entity.color_temp_state_topic      = "color_temp_state_topic";
+        entity.color_temp_value_template   = "color_temp_value_template";
+        entity.effect_command_topic        = "effect_command_topic";
+        entity.effect_state_topic          = "effect_state_topic";
+        entity.effect_value_template       = "effect_value_template";
+        entity.entity_category             = "entity_category";
+        entity.hs_command_topic            = "hs_command_topic";
+        entity.hs_state_topic              = "hs_state_topic";
+        entity.hs_value_template           = "hs_value_template";
+        entity.icon                        = "icon";
+        entity.json_attributes_template    = "json_attributes_template";
+        entity.json_attributes_topic       = "json_attributes_topic";
+        entity.name                        = "name";
+        entity.on_command_type             = "on_command_type";
+        entity.payload_available           = "payload_available";
+        entity.payload_not_available       = "payload_not_available";
+        entity.payload_off                 = "payload_off";
+        entity.payload_on                  = "payload_on";
+        entity.rgb_command_template        = "rgb_command_template";
+        entity.rgb_command_topic           = "rgb_command_topic";
+        entity.rgb_state_topic             = "rgb_state_topic";
+        entity.rgb_value_template          = "rgb_value_template";
+        entity.schema                      = "schema";
+        entity.state_topic                 = "state_topic";
+        entity.state_value_template        = "state_value_template";
+        entity.unique_id                   = "unique_id";
+        entity.white_command_topic         = "white_command_topic";
+        entity.xy_command_topic            = "xy_command_topic";
+        entity.xy_state_topic              = "xy_state_topic";
+        entity.xy_value_template           = "xy_value_template";
+        entity.availability                = tcb::make_span(STRINGS);
+        entity.effect_list                 = tcb::make_span(STRINGS);
+
+        return entity;
+    }
+
+    b2h::hass::lock_type minimal_lock()
+    {
+        b2h::hass::lock_type entity;
+
+        entity.command_topic = "command_topic";
+
+        return entity;
+    }
+
+    b2h::hass::lock_type full_lock()
+    {
+        b2h::hass::lock_type entity;
+
+        entity.command_topic            = "command_topic";
+        entity.enabled_by_default       = true;
+        entity.optimistic               = true;
+        entity.retain                   = true;
+        entity.device                   = full_device();
+        entity.qos                      = 1;
+        entity.availability_mode        = "availability_mode";
+        entity.availability_topic       = "availability_topic";
+        entity.entity_category          = "entity_category";
+        entity.icon                     = "icon";
+        entity.json_attributes_template = "json_attributes_template";
+        entity.json_attributes_topic    = "json_attributes_topic";
+        entity.name                     = "name";
+        entity.payload_available        = "payload_available";
+        entity.payload_lock             = "payload_lock";
+        entity.payload_not_available    = "payload_not_available";
+        entity.payload_unlock           = "payload_unlock";
+        entity.state_locked             = "state_locked";
+        entity.state_topic              = "state_topic";
+        entity.state_unlocked           = "state_unlocked";
+        entity.unique_id                = "unique_id";
+        entity.value_template           = "value_template";
+        entity.availability             = tcb::make_span(STRINGS);
+
+        return entity;
+    }
+
+    b2h::hass::number_type minimal_number()
+    {
+        b2h::hass::number_type entity;
+
+        return entity;
+    }
+
+    b2h::hass::number_type full_number()
+    {
+        b2h::hass::number_type entity;
+
+        entity.enabled_by_default       = true;
+        entity.optimistic               = true;
+        entity.retain                   = true;
+        entity.device                   = full_device();
+        entity.max                      = 0.5;
+        entity.min                      = 0.5;
+        entity.step                     = 0.5;
+        entity.qos                      = 1;
+        entity.availability_mode        = "availability_mode";
+        entity.availability_topic       = "availability_topic";
+        entity.command_topic            = "command_topic";
+        entity.entity_category          = "entity_category";
+        entity.icon                     = "icon";
+        entity.json_attributes_template = "json_attributes_template";
+        entity.json_attributes_topic    = "json_attributes_topic";
+        entity.name                     = "name";
+        entity.payload_reset            = "payload_reset";
+        entity.state_topic              = "state_topic";
+        entity.unique_id                = "unique_id";
+        entity.unit_of_measurement      = "unit_of_measurement";
+        entity.value_template           = "value_template";
+        entity.availability             = tcb::make_span(STRINGS);
+
+        return entity;
+    }
+
+    b2h::hass::scene_type minimal_scene()
+    {
+        b2h::hass::scene_type entity;
+
+        return entity;
+    }
+
+    b2h::hass::scene_type full_scene()
+    {
+        b2h::hass::scene_type entity;
+
+        entity.enabled_by_default    = true;
+        entity.retain                = true;
+        entity.qos                   = 1;
+        entity.availability_mode     = "availability_mode";
+        entity.availability_topic    = "availability_topic";
+        entity.command_topic         = "command_topic";
+        entity.entity_category       = "entity_category";
+        entity.icon                  = "icon";
+        entity.name                  = "name";
+        entity.payload_available     = "payload_available";
+        entity.payload_not_available = "payload_not_available";
+        entity.payload_on            = "payload_on";
+        entity.unique_id             = "unique_id";
+        entity.availability          = tcb::make_span(STRINGS);
+
+        return entity;
+    }
+
+    b2h::hass::select_type minimal_select()
+    {
+        b2h::hass::select_type entity;
+
+        entity.command_topic = "command_topic";
+        entity.options       = tcb::make_span(STRINGS);
+
+        return entity;
+    }
+
+    b2h::hass::select_type full_select()
+    {
+        b2h::hass::select_type entity;
+
+        entity.command_topic            = "command_topic";
+        entity.options                  = tcb::make_span(STRINGS);
+        entity.enabled_by_default       = true;
+        entity.optimistic               = true;
+        entity.retain                   = true;
+        entity.device                   = full_device();
+        entity.qos                      = 1;
+        entity.availability_mode        = "availability_mode";
+        entity.availability_topic       = "availability_topic";
+        entity.entity_category          = "entity_category";
+        entity.icon                     = "icon";
+        entity.json_attributes_template = "json_attributes_template";
+        entity.json_attributes_topic    = "json_attributes_topic";
+        entity.name                     = "name";
+        entity.state_topic              = "state_topic";
+        entity.unique_id                = "unique_id";
+        entity.value_template           = "value_template";
+        entity.availability             = tcb::make_span(STRINGS);
+
+        return entity;
+    }
+
+    b2h::hass::sensor_type minimal_sensor()
+    {
+        b2h::hass::sensor_type entity;
+
+        entity.state_topic = "state_topic";
+
+        return entity;
+    }
+
+    b2h::hass::sensor_type full_sensor()
+    {
+        b2h::hass::sensor_type entity;
+
+        entity.state_topic               = "state_topic";
+        entity.enabled_by_default        = true;
+        entity.force_update              = true;
+        entity.device                    = full_device();
+        entity.expire_after              = 1;
+        entity.qos                       = 1;
+        entity.availability_mode         = "availability_mode";
+        entity.availability_topic        = "availability_topic";
+        entity.device_class              = "device_class";
+        entity.entity_category           = "entity_category";
+        entity.icon                      = "icon";
+        entity.json_attributes_template  = "json_attributes_template";
+        entity.json_attributes_topic     = "json_attributes_topic";
+        entity.last_reset_value_template = "last_reset_value_template";
+        entity.name                      = "name";
+        entity.payload_available         = "payload_available";
+        entity.payload_not_available     = "payload_not_available";
+        entity.state_class               = "state_class";
+        entity.unique_id                 = "unique_id";
+        entity.unit_of_measurement       = "unit_of_measurement";
+        entity.value_template            = "value_template";
+        entity.availability              = tcb::make_span(STRINGS);
+
+        return entity;
+    }
+
+    b2h::hass::switch_type minimal_switch()
+    {
+        b2h::hass::switch_type entity;
+
+        return entity;
+    }
+
+    b2h::hass::switch_type full_switch()
+    {
+        b2h::hass::switch_type entity;
+
+        entity.enabled_by_default       = true;
+        entity.optimistic               = true;
+        entity.retain                   = true;
+        entity.device                   = full_device();
+        entity.qos                      = 1;
+        entity.availability_mode        = "availability_mode";
+        entity.availability_topic       = "availability_topic";
+        entity.command_topic            = "command_topic";
+        entity.entity_category          = "entity_category";
+        entity.icon                     = "icon";
+        entity.json_attributes_template = "json_attributes_template";
+        entity.json_attributes_topic    = "json_attributes_topic";
+        entity.name                     = "name";
+        entity.payload_available        = "payload_available";
+        entity.payload_not_available    = "payload_not_available";
+        entity.payload_off              = "payload_off";
+        entity.payload_on               = "payload_on";
+        entity.state_off                = "state_off";
+        entity.state_on                 = "state_on";
+        entity.state_topic              = "state_topic";
+        entity.unique_id                = "unique_id";
+        entity.value_template           = "value_template";
+        entity.availability             = tcb::make_span(STRINGS);
+
+        return entity;
+    }
+
+    b2h::hass::vacuum_type minimal_vacuum()
+    {
+        b2h::hass::vacuum_type entity;
+
+        return entity;
+    }
+
+    b2h::hass::vacuum_type full_vacuum()
+    {
+        b2h::hass::vacuum_type entity;
+
+        entity.enabled_by_default       = true;
+        entity.retain                   = true;
+        entity.qos                      = 1;
+        entity.availability_mode        = "availability_mode";
+        entity.availability_topic       = "availability_topic";
+        entity.battery_level_template   = "battery_level_template";
+        entity.battery_level_topic      = "battery_level_topic";
+        entity.charging_template        = "charging_template";
+        entity.charging_topic           = "charging_topic";
+        entity.cleaning_template        = "cleaning_template";
+        entity.cleaning_topic           = "cleaning_topic";
+        entity.command_topic            = "command_topic";
+        entity.docked_template          = "docked_template";
+        entity.docked_topic             = "docked_topic";
+        entity.entity_category          = "entity_category";
+        entity.error_template           = "error_template";
+        entity.error_topic              = "error_topic";
+        entity.fan_speed_template       = "fan_speed_template";
+        entity.fan_speed_topic          = "fan_speed_topic";
+        entity.icon                     = "icon";
+        entity.json_attributes_template = "json_attributes_template";
+        entity.json_attributes_topic    = "json_attributes_topic";
+        entity.name                     = "name";
+        entity.payload_available        = "payload_available";
+        entity.payload_clean_spot       = "payload_clean_spot";
+        entity.payload_locate           = "payload_locate";
+        entity.payload_not_available    = "payload_not_available";
+        entity.payload_return_to_base   = "payload_return_to_base";
+        entity.payload_start_pause      = "payload_start_pause";
+        entity.payload_stop             = "payload_stop";
+        entity.payload_turn_off         = "payload_turn_off";
+        entity.payload_turn_on          = "payload_turn_on";
+        entity.schema                   = "schema";
+        entity.send_command_topic       = "send_command_topic";
+        entity.set_fan_speed_topic      = "set_fan_speed_topic";
+        entity.unique_id                = "unique_id";
+        entity.availability             = tcb::make_span(STRINGS);
+        entity.fan_speed_list           = tcb::make_span(STRINGS);
+        entity.supported_features       = tcb::make_span(STRINGS);
+
+        return entity;
+    }
+
+    // Mirrors the LYWSD03MMC temperature sensor config.
+    std::string make_sensor_payload(std::string_view id, std::string_view mac)
+    {
+        using namespace std::literals;
+
+        const std::string unique_id =
+            fmt::format("lywsd03mmc_{}_temperature", id);
+        const std::string state_topic =
+            fmt::format("homeassistant/sensor/{}/state", unique_id);
+        std::array<std::pair<std::string_view, std::string_view>, 1> conn{ {
+            { "mac"sv, mac },
+        } };
+
+        b2h::hass::device_type device;
+        device.name         = "Mi Temperature & Humidity Monitor 2"sv;
+        device.model        = "LYWSD03MMC"sv;
+        device.manufacturer = "Xiaomi"sv;
+        device.connections  = tcb::make_span(conn);
+
+        b2h::hass::sensor_type sens;
+        sens.device              = device;
+        sens.state_topic         = state_topic;
+        sens.name                = "LYWSD03MMC Temperature"sv;
+        sens.device_class        = "temperature"sv;
+        sens.unit_of_measurement = "°C"sv;
+        sens.qos                 = 0;
+        sens.unique_id           = unique_id;
+        sens.value_template =
+            "{{ ((value_json | float(0)) * 0.01) | round(2) }}"sv;
+
+        return b2h::utils::json::dump(b2h::hass::serialize(sens));
+    }
+
+    constexpr std::array<std::string_view, 2> SENSOR_VALUES{ "a4c1380d53a1",
+        "A4:C1:38:0D:53:A1" };
+
+    b2h::hass::payload_template sensor_template()
+    {
+        using b2h::hass::payload_template;
+
+        return payload_template{ make_sensor_payload(
+            payload_template::slot(0), payload_template::slot(1)) };
+    }
+} // namespace
+
+// Serialization to the published payload. Reports time per payload, payload
+// size in bytes and heap allocations per call.
+template<typename T>
+static void serialize_entity(benchmark::State& state, const T& entity)
+{
+    std::size_t bytes = 0;
+
+    const std::size_t allocations_before = allocations.load();
+
+    for (auto _ : state)
+    {
+        std::string payload =
+            b2h::utils::json::dump(b2h::hass::serialize(entity));
+        bytes = payload.size();
+        benchmark::DoNotOptimize(payload);
+    }
+
+    const std::size_t allocations_after = allocations.load();
+
+    state.counters["bytes"] = static_cast<double>(bytes);
+    state.counters["allocs"] =
+        benchmark::Counter(static_cast<double>(allocations_after -
+                                               allocations_before),
+            benchmark::Counter::kAvgIterations);
+    state.SetBytesProcessed(
+        static_cast<std::int64_t>(state.iterations() * bytes));
+}
+
+BENCHMARK_CAPTURE(serialize_entity,
+    alarm_control_panel_minimal,
+    minimal_alarm_control_panel());
+BENCHMARK_CAPTURE(serialize_entity,
+    alarm_control_panel_full,
+    full_alarm_control_panel());
+BENCHMARK_CAPTURE(serialize_entity,
+    binary_sensor_minimal,
+    minimal_binary_sensor());
+BENCHMARK_CAPTURE(serialize_entity, binary_sensor_full, full_binary_sensor());
+BENCHMARK_CAPTURE(serialize_entity, camera_minimal, minimal_camera());
+BENCHMARK_CAPTURE(serialize_entity, camera_full, full_camera());
+BENCHMARK_CAPTURE(serialize_entity, cover_minimal, minimal_cover());
+BENCHMARK_CAPTURE(serialize_entity, cover_full, full_cover());
+BENCHMARK_CAPTURE(serialize_entity,
+    device_tracker_minimal,
+    minimal_device_tracker());
+BENCHMARK_CAPTURE(serialize_entity, device_tracker_full, full_device_tracker());
+BENCHMARK_CAPTURE(serialize_entity,
+    device_trigger_minimal,
+    minimal_device_trigger());
+BENCHMARK_CAPTURE(serialize_entity, device_trigger_full, full_device_trigger());
+BENCHMARK_CAPTURE(serialize_entity, fan_minimal, minimal_fan());
+BENCHMARK_CAPTURE(serialize_entity, fan_full, full_fan());
+BENCHMARK_CAPTURE(serialize_entity, humidifier_minimal, minimal_humidifier());
+BENCHMARK_CAPTURE(serialize_entity, humidifier_full, full_humidifier());
+BENCHMARK_CAPTURE(serialize_entity, light_minimal, minimal_light());
+BENCHMARK_CAPTURE(serialize_entity, light_full, full_light());
+BENCHMARK_CAPTURE(serialize_entity, lock_minimal, minimal_lock());
+BENCHMARK_CAPTURE(serialize_entity, lock_full, full_lock());
+BENCHMARK_CAPTURE(serialize_entity, number_minimal, minimal_number());
+BENCHMARK_CAPTURE(serialize_entity, number_full, full_number());
+BENCHMARK_CAPTURE(serialize_entity, scene_minimal, minimal_scene());
+BENCHMARK_CAPTURE(serialize_entity, scene_full, full_scene());
+BENCHMARK_CAPTURE(serialize_entity, select_minimal, minimal_select());
+BENCHMARK_CAPTURE(serialize_entity, select_full, full_select());
+BENCHMARK_CAPTURE(serialize_entity, sensor_minimal, minimal_sensor());
+BENCHMARK_CAPTURE(serialize_entity, sensor_full, full_sensor());
+BENCHMARK_CAPTURE(serialize_entity, switch_minimal, minimal_switch());
+BENCHMARK_CAPTURE(serialize_entity, switch_full, full_switch());
+BENCHMARK_CAPTURE(serialize_entity, vacuum_minimal, minimal_vacuum());
+BENCHMARK_CAPTURE(serialize_entity, vacuum_full, full_vacuum());
+
+// Sensor config payload built from scratch on every call, as done before
+// payload templates were introduced.
+static void payload_serialize(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        std::string payload =
+            make_sensor_payload(SENSOR_VALUES[0], SENSOR_VALUES[1]);
+        benchmark::DoNotOptimize(payload);
+    }
+}
+
+// Sensor config payload rendered from a pre-serialized template into a
+// caller provided buffer.
+static void payload_template_render_to(benchmark::State& state)
+{
+    const b2h::hass::payload_template tmpl = sensor_template();
+    std::array<char, 512> buffer{};
+
+    for (auto _ : state)
+    {
+        auto payload = tmpl.render_to(buffer, SENSOR_VALUES);
+        benchmark::DoNotOptimize(payload);
+    }
+}
+
+// Sensor config payload rendered from a pre-serialized template into a new
+// std::string.
+static void payload_template_render(benchmark::State& state)
+{
+    const b2h::hass::payload_template tmpl = sensor_template();
+
+    for (auto _ : state)
+    {
+        std::string payload = tmpl.render(SENSOR_VALUES);
+        benchmark::DoNotOptimize(payload);
+    }
+}
+
+BENCHMARK(payload_serialize);
+BENCHMARK(payload_template_render_to);
+BENCHMARK(payload_template_render);
@@ -20,3178 +20,1293 @@
 
 #include "hass/device_types.hpp"
 
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
 namespace b2h::hass
 {
     namespace
     {
-        inline void serialize_device_type(
-            const device_type& device, rapidjson::Document& doc)
+        using allocator_type = rapidjson::Document::AllocatorType;
+
+        using string_list_type = tcb::span<std::string_view>;
+        using connections_type =
+            tcb::span<std::pair<std::string_view, std::string_view>>;
+
+        // Every member of the Home Assistant structures falls into one of
+        // these shapes. The kind selects both the active member pointer of
+        // field::member_ptr and the writer used for it.
+        enum class field_kind : std::uint8_t
+        {
+            string,
+            string_list,
+            device,
+            optional_bool,
+            optional_int,
+            optional_double,
+            optional_string,
+            optional_string_list,
+            optional_connections,
+            optional_device
+        };
+
+        // Describes how a single member of T is written out: the abbreviated
+        // JSON key and a pointer to the member. The kind is deduced from the
+        // member type, so the tables below only list key/member pairs.
+        template<typename T>
+        struct field
         {
-            using namespace rapidjson;
+            union member_ptr
+            {
+                std::string_view T::*string;
+                string_list_type T::*string_list;
+                device_type T::*device;
+                std::optional<bool> T::*optional_bool;
+                std::optional<int> T::*optional_int;
+                std::optional<double> T::*optional_double;
+                std::optional<std::string_view> T::*optional_string;
+                std::optional<string_list_type> T::*optional_string_list;
+                std::optional<connections_type> T::*optional_connections;
+                std::optional<device_type> T::*optional_device;
+
+                // clang-format off
+                constexpr member_ptr(std::string_view T::*ptr) noexcept : string{ ptr } {}
+                constexpr member_ptr(string_list_type T::*ptr) noexcept : string_list{ ptr } {}
+                constexpr member_ptr(device_type T::*ptr) noexcept : device{ ptr } {}
+                constexpr member_ptr(std::optional<bool> T::*ptr) noexcept : optional_bool{ ptr } {}
+                constexpr member_ptr(std::optional<int> T::*ptr) noexcept : optional_int{ ptr } {}
+                constexpr member_ptr(std::optional<double> T::*ptr) noexcept : optional_double{ ptr } {}
+                constexpr member_ptr(std::optional<std::string_view> T::*ptr) noexcept : optional_string{ ptr } {}
+                constexpr member_ptr(std::optional<string_list_type> T::*ptr) noexcept : optional_string_list{ ptr } {}
+                constexpr member_ptr(std::optional<connections_type> T::*ptr) noexcept : optional_connections{ ptr } {}
+                constexpr member_ptr(std::optional<device_type> T::*ptr) noexcept : optional_device{ ptr } {}
+                // clang-format on
+            };
 
-            Value v(kObjectType);
-            if (device.manufacturer.has_value())
+            std::string_view key;
+            field_kind kind;
+            member_ptr member;
+
+            constexpr field(
+                std::string_view key, std::string_view T::*ptr) noexcept :
+                key{ key },
+                kind{ field_kind::string },
+                member{ ptr }
             {
-                v.AddMember("mf",
-                    Value().SetString(
-                        StringRef(device.manufacturer.value().data(),
-                            device.manufacturer.value().size())),
-                    doc.GetAllocator());
             }
-            if (device.model.has_value())
+
+            constexpr field(
+                std::string_view key, string_list_type T::*ptr) noexcept :
+                key{ key },
+                kind{ field_kind::string_list },
+                member{ ptr }
             {
-                v.AddMember("mdl",
-                    Value().SetString(StringRef(device.model.value().data(),
-                        device.model.value().size())),
-                    doc.GetAllocator());
             }
-            if (device.name.has_value())
+
+            constexpr field(std::string_view key, device_type T::*ptr) noexcept
+                :
+                key{ key },
+                kind{ field_kind::device },
+                member{ ptr }
             {
-                v.AddMember("name",
-                    Value().SetString(StringRef(device.name.value().data(),
-                        device.name.value().size())),
-                    doc.GetAllocator());
             }
-            if (device.suggested_area.has_value())
+
+            constexpr field(
+                std::string_view key, std::optional<bool> T::*ptr) noexcept :
+                key{ key },
+                kind{ field_kind::optional_bool },
+                member{ ptr }
             {
-                v.AddMember("sa",
-                    Value().SetString(
-                        StringRef(device.suggested_area.value().data(),
-                            device.suggested_area.value().size())),
-                    doc.GetAllocator());
             }
-            if (device.sw_version.has_value())
+
+            constexpr field(
+                std::string_view key, std::optional<int> T::*ptr) noexcept :
+                key{ key },
+                kind{ field_kind::optional_int },
+                member{ ptr }
             {
-                v.AddMember("sw",
-                    Value().SetString(
-                        StringRef(device.sw_version.value().data(),
-                            device.sw_version.value().size())),
-                    doc.GetAllocator());
             }
-            if (device.via_device.has_value())
+
+            constexpr field(
+                std::string_view key, std::optional<double> T::*ptr) noexcept :
+                key{ key },
+                kind{ field_kind::optional_double },
+                member{ ptr }
             {
-                v.AddMember("mf",
-                    Value().SetString(
-                        StringRef(device.via_device.value().data(),
-                            device.via_device.value().size())),
-                    doc.GetAllocator());
             }
-            if (device.connections.has_value())
+
+            constexpr field(std::string_view key,
+                std::optional<std::string_view> T::*ptr) noexcept :
+                key{ key },
+                kind{ field_kind::optional_string },
+                member{ ptr }
             {
-                Value a;
-                a.SetArray();
-                for (const auto& [key, value] : device.connections.value())
-                {
-                    Value tuple;
-                    tuple.SetArray();
+            }
+
+            constexpr field(std::string_view key,
+                std::optional<string_list_type> T::*ptr) noexcept :
+                key{ key },
+                kind{ field_kind::optional_string_list },
+                member{ ptr }
+            {
+            }
+
+            constexpr field(std::string_view key,
+                std::optional<connections_type> T::*ptr) noexcept :
+                key{ key },
+                kind{ field_kind::optional_connections },
+                member{ ptr }
+            {
+            }
 
-                    tuple.PushBack(
-                        Value().SetString(StringRef(key.data(), key.size())),
-                        doc.GetAllocator());
-                    tuple.PushBack(Value().SetString(
-                                       StringRef(value.data(), value.size())),
-                        doc.GetAllocator());
+            constexpr field(std::string_view key,
+                std::optional<device_type> T::*ptr) noexcept :
+                key{ key },
+                kind{ field_kind::optional_device },
+                member{ ptr }
+            {
+            }
+        };
 
-                    a.PushBack(tuple, doc.GetAllocator());
-                }
-                v.AddMember("cns", std::move(a), doc.GetAllocator());
+        // Value Home Assistant assumes when a key is missing from the payload.
+        struct default_value
+        {
+            std::string_view key;
+            field_kind kind;
+            bool boolean{};
+            int integer{};
+            double number{};
+            std::string_view string{};
+
+            constexpr default_value(std::string_view key, bool value) noexcept :
+                key{ key },
+                kind{ field_kind::optional_bool },
+                boolean{ value }
+            {
+            }
+
+            constexpr default_value(std::string_view key, int value) noexcept :
+                key{ key },
+                kind{ field_kind::optional_int },
+                integer{ value }
+            {
+            }
+
+            constexpr default_value(
+                std::string_view key, double value) noexcept :
+                key{ key },
+                kind{ field_kind::optional_double },
+                number{ value }
+            {
             }
-            if (device.identifiers.has_value())
+
+            constexpr default_value(
+                std::string_view key, const char* value) noexcept :
+                key{ key },
+                kind{ field_kind::optional_string },
+                string{ value }
+            {
+            }
+        };
+
+        // Only keys whose default is the same on every platform using them.
+        constexpr default_value DEFAULTS[]{
+            { "qos", 0 },
+            { "ret", false },
+            { "enabled_by_default", true },
+            { "avty_mode", "latest" },
+            { "pl_avail", "online" },
+            { "pl_not_avail", "offline" },
+            { "exp_aft", 0 },
+            { "frc_upd", false },
+            { "pl_on", "ON" },
+            { "pl_off", "OFF" },
+            { "cod_arm_req", true },
+            { "cod_dis_req", true },
+            { "pl_arm_away", "ARM_AWAY" },
+            { "pl_arm_home", "ARM_HOME" },
+            { "pl_arm_nite", "ARM_NIGHT" },
+            { "payload_arm_vacation", "ARM_VACATION" },
+            { "pl_arm_custom_b", "ARM_CUSTOM_BYPASS" },
+            { "pl_disarm", "DISARM" },
+            { "pl_open", "OPEN" },
+            { "pl_cls", "CLOSE" },
+            { "stat_open", "open" },
+            { "stat_opening", "opening" },
+            { "stat_clsd", "closed" },
+            { "stat_closing", "closing" },
+            { "stat_stopped", "stopped" },
+            { "pos_open", 100 },
+            { "pos_clsd", 0 },
+            { "tilt_min", 0 },
+            { "tilt_max", 100 },
+            { "tilt_opnd_val", 100 },
+            { "tilt_clsd_val", 0 },
+            { "pl_osc_on", "oscillate_on" },
+            { "pl_osc_off", "oscillate_off" },
+            { "spd_rng_min", 1 },
+            { "spd_rng_max", 100 },
+            { "pl_rst_pct", "None" },
+            { "pl_rst_pr_mode", "None" },
+            { "min_hum", 0 },
+            { "max_hum", 100 },
+            { "pl_rst_hum", "None" },
+            { "pl_rst_mode", "None" },
+            { "bri_scl", 255 },
+            { "white_scale", 255 },
+            { "pl_lock", "LOCK" },
+            { "pl_unlk", "UNLOCK" },
+            { "stat_locked", "LOCKED" },
+            { "stat_unlocked", "UNLOCKED" },
+            { "min", 1.0 },
+            { "max", 100.0 },
+            { "step", 1.0 },
+            { "pl_home", "home" },
+            { "pl_not_home", "not_home" },
+        };
+
+        // Index into DEFAULTS, NO_DEFAULT if the key has none.
+        using default_index = std::int8_t;
+
+        constexpr default_index NO_DEFAULT{ -1 };
+
+        static_assert(std::size(DEFAULTS) <=
+                      std::numeric_limits<default_index>::max());
+
+        constexpr default_index find_default(
+            std::string_view key, field_kind kind) noexcept
+        {
+            for (std::size_t i = 0; i < std::size(DEFAULTS); ++i)
             {
-                Value a;
-                a.SetArray();
-                for (const auto& str : device.identifiers.value())
+                if (DEFAULTS[i].key == key && DEFAULTS[i].kind == kind)
                 {
-                    a.PushBack(
-                        Value().SetString(StringRef(str.data(), str.size())),
-                        doc.GetAllocator());
+                    return static_cast<default_index>(i);
                 }
-                v.AddMember("ids", std::move(a), doc.GetAllocator());
             }
-            doc.AddMember("dev", std::move(v), doc.GetAllocator());
-        }
-    } // namespace
 
-    rapidjson::Document serialize(
-        const alarm_control_panel_type& device) noexcept
-    {
-        using namespace rapidjson;
-        Document d;
-        d.SetObject();
-        d.AddMember("cmd_t",
-            Value().SetString(StringRef(device.command_topic.data(),
-                device.command_topic.size())),
-            d.GetAllocator());
-        d.AddMember("stat_t",
-            Value().SetString(StringRef(device.state_topic.data(),
-                device.state_topic.size())),
-            d.GetAllocator());
-        if (device.code_arm_required.has_value())
-        {
-            d.AddMember("cod_arm_req",
-                Value().SetBool(device.code_arm_required.value()),
-                d.GetAllocator());
-        }
-        if (device.code_disarm_required.has_value())
-        {
-            d.AddMember("cod_dis_req",
-                Value().SetBool(device.code_disarm_required.value()),
-                d.GetAllocator());
-        }
-        if (device.enabled_by_default.has_value())
-        {
-            d.AddMember("enabled_by_default",
-                Value().SetBool(device.enabled_by_default.value()),
-                d.GetAllocator());
-        }
-        if (device.retain.has_value())
-        {
-            d.AddMember("ret",
-                Value().SetBool(device.retain.value()),
-                d.GetAllocator());
-        }
-        if (device.device.has_value())
-        {
-            serialize_device_type(device.device.value(), d);
-        }
-        if (device.qos.has_value())
-        {
-            d.AddMember("qos",
-                Value().SetInt(device.qos.value()),
-                d.GetAllocator());
-        }
-        if (device.availability_mode.has_value())
-        {
-            d.AddMember("avty_mode",
-                Value().SetString(
-                    StringRef(device.availability_mode.value().data(),
-                        device.availability_mode.value().size())),
-                d.GetAllocator());
-        }
-        if (device.availability_topic.has_value())
-        {
-            d.AddMember("avty_t",
-                Value().SetString(
-                    StringRef(device.availability_topic.value().data(),
-                        device.availability_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.code.has_value())
-        {
-            d.AddMember("code",
-                Value().SetString(StringRef(device.code.value().data(),
-                    device.code.value().size())),
-                d.GetAllocator());
-        }
-        if (device.command_template.has_value())
-        {
-            d.AddMember("cmd_tpl",
-                Value().SetString(
-                    StringRef(device.command_template.value().data(),
-                        device.command_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.entity_category.has_value())
-        {
-            d.AddMember("entity_category",
-                Value().SetString(
-                    StringRef(device.entity_category.value().data(),
-                        device.entity_category.value().size())),
-                d.GetAllocator());
-        }
-        if (device.icon.has_value())
-        {
-            d.AddMember("ic",
-                Value().SetString(StringRef(device.icon.value().data(),
-                    device.icon.value().size())),
-                d.GetAllocator());
-        }
-        if (device.json_attributes_template.has_value())
-        {
-            d.AddMember("json_attr_tpl",
-                Value().SetString(
-                    StringRef(device.json_attributes_template.value().data(),
-                        device.json_attributes_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.json_attributes_topic.has_value())
-        {
-            d.AddMember("json_attr_t",
-                Value().SetString(
-                    StringRef(device.json_attributes_topic.value().data(),
-                        device.json_attributes_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.name.has_value())
-        {
-            d.AddMember("name",
-                Value().SetString(StringRef(device.name.value().data(),
-                    device.name.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_arm_away.has_value())
-        {
-            d.AddMember("pl_arm_away",
-                Value().SetString(
-                    StringRef(device.payload_arm_away.value().data(),
-                        device.payload_arm_away.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_arm_custom_bypass.has_value())
-        {
-            d.AddMember("pl_arm_custom_b",
-                Value().SetString(
-                    StringRef(device.payload_arm_custom_bypass.value().data(),
-                        device.payload_arm_custom_bypass.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_arm_home.has_value())
-        {
-            d.AddMember("pl_arm_home",
-                Value().SetString(
-                    StringRef(device.payload_arm_home.value().data(),
-                        device.payload_arm_home.value().size())),
-                d.GetAllocator());
+            return NO_DEFAULT;
         }
-        if (device.payload_arm_night.has_value())
+
+        template<typename EntryT, std::size_t N>
+        constexpr bool unique_keys(const EntryT (&entries)[N]) noexcept
         {
-            d.AddMember("pl_arm_nite",
-                Value().SetString(
-                    StringRef(device.payload_arm_night.value().data(),
-                        device.payload_arm_night.value().size())),
-                d.GetAllocator());
+            for (std::size_t i = 0; i < N; ++i)
+            {
+                for (std::size_t j = i + 1; j < N; ++j)
+                {
+                    if (entries[i].key == entries[j].key)
+                    {
+                        return false;
+                    }
+                }
+            }
+
+            return true;
         }
-        if (device.payload_arm_vacation.has_value())
+
+        static_assert(unique_keys(DEFAULTS), "Duplicate default.");
+
+        inline bool is_default(const default_value& def, bool value) noexcept
         {
-            d.AddMember("payload_arm_vacation",
-                Value().SetString(
-                    StringRef(device.payload_arm_vacation.value().data(),
-                        device.payload_arm_vacation.value().size())),
-                d.GetAllocator());
+            return def.boolean == value;
         }
-        if (device.payload_available.has_value())
+
+        inline bool is_default(const default_value& def, int value) noexcept
         {
-            d.AddMember("pl_avail",
-                Value().SetString(
-                    StringRef(device.payload_available.value().data(),
-                        device.payload_available.value().size())),
-                d.GetAllocator());
+            return def.integer == value;
         }
-        if (device.payload_disarm.has_value())
+
+        inline bool is_default(const default_value& def, double value) noexcept
         {
-            d.AddMember("pl_disarm",
-                Value().SetString(
-                    StringRef(device.payload_disarm.value().data(),
-                        device.payload_disarm.value().size())),
-                d.GetAllocator());
+            return def.number == value;
         }
-        if (device.payload_not_available.has_value())
+
+        inline bool is_default(
+            const default_value& def, std::string_view value) noexcept
         {
-            d.AddMember("pl_not_avail",
-                Value().SetString(
-                    StringRef(device.payload_not_available.value().data(),
-                        device.payload_not_available.value().size())),
-                d.GetAllocator());
+            return def.string == value;
         }
-        if (device.unique_id.has_value())
+
+        // Writers are deliberately non-template so that every structure shares
+        // a single copy of the rapidjson calls.
+
+        inline rapidjson::GenericStringRef<char> make_ref(
+            std::string_view str) noexcept
         {
-            d.AddMember("uniq_id",
-                Value().SetString(StringRef(device.unique_id.value().data(),
-                    device.unique_id.value().size())),
-                d.GetAllocator());
+            return rapidjson::StringRef(str.data(), str.size());
         }
-        if (device.value_template.has_value())
+
+        void add_string(rapidjson::Value& obj,
+            std::string_view key,
+            std::string_view value,
+            allocator_type& allocator)
         {
-            d.AddMember("val_tpl",
-                Value().SetString(
-                    StringRef(device.value_template.value().data(),
-                        device.value_template.value().size())),
-                d.GetAllocator());
+            obj.AddMember(make_ref(key),
+                rapidjson::Value().SetString(make_ref(value)),
+                allocator);
         }
-        if (device.availability.has_value())
+
+        void add_string_list(rapidjson::Value& obj,
+            std::string_view key,
+            string_list_type values,
+            allocator_type& allocator)
         {
-            Value a;
+            rapidjson::Value a;
             a.SetArray();
-            for (const auto& str : device.availability.value())
+            for (const auto& str : values)
             {
-                a.PushBack(Value().SetString(StringRef(str.data(), str.size())),
-                    d.GetAllocator());
+                a.PushBack(
+                    rapidjson::Value().SetString(make_ref(str)), allocator);
             }
-            d.AddMember("avty", std::move(a), d.GetAllocator());
+            obj.AddMember(make_ref(key), std::move(a), allocator);
         }
-        return d;
-    }
 
-    rapidjson::Document serialize(const binary_sensor_type& device) noexcept
-    {
-        using namespace rapidjson;
-        Document d;
-        d.SetObject();
-        d.AddMember("stat_t",
-            Value().SetString(StringRef(device.state_topic.data(),
-                device.state_topic.size())),
-            d.GetAllocator());
-        if (device.enabled_by_default.has_value())
-        {
-            d.AddMember("enabled_by_default",
-                Value().SetBool(device.enabled_by_default.value()),
-                d.GetAllocator());
-        }
-        if (device.force_update.has_value())
-        {
-            d.AddMember("frc_upd",
-                Value().SetBool(device.force_update.value()),
-                d.GetAllocator());
-        }
-        if (device.device.has_value())
-        {
-            serialize_device_type(device.device.value(), d);
-        }
-        if (device.expire_after.has_value())
-        {
-            d.AddMember("exp_aft",
-                Value().SetInt(device.expire_after.value()),
-                d.GetAllocator());
-        }
-        if (device.off_delay.has_value())
-        {
-            d.AddMember("off_dly",
-                Value().SetInt(device.off_delay.value()),
-                d.GetAllocator());
-        }
-        if (device.qos.has_value())
-        {
-            d.AddMember("qos",
-                Value().SetInt(device.qos.value()),
-                d.GetAllocator());
-        }
-        if (device.availability_mode.has_value())
-        {
-            d.AddMember("avty_mode",
-                Value().SetString(
-                    StringRef(device.availability_mode.value().data(),
-                        device.availability_mode.value().size())),
-                d.GetAllocator());
-        }
-        if (device.availability_topic.has_value())
-        {
-            d.AddMember("avty_t",
-                Value().SetString(
-                    StringRef(device.availability_topic.value().data(),
-                        device.availability_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.device_class.has_value())
-        {
-            d.AddMember("dev_cla",
-                Value().SetString(StringRef(device.device_class.value().data(),
-                    device.device_class.value().size())),
-                d.GetAllocator());
-        }
-        if (device.entity_category.has_value())
-        {
-            d.AddMember("entity_category",
-                Value().SetString(
-                    StringRef(device.entity_category.value().data(),
-                        device.entity_category.value().size())),
-                d.GetAllocator());
-        }
-        if (device.icon.has_value())
-        {
-            d.AddMember("ic",
-                Value().SetString(StringRef(device.icon.value().data(),
-                    device.icon.value().size())),
-                d.GetAllocator());
-        }
-        if (device.json_attributes_template.has_value())
-        {
-            d.AddMember("json_attr_tpl",
-                Value().SetString(
-                    StringRef(device.json_attributes_template.value().data(),
-                        device.json_attributes_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.json_attributes_topic.has_value())
-        {
-            d.AddMember("json_attr_t",
-                Value().SetString(
-                    StringRef(device.json_attributes_topic.value().data(),
-                        device.json_attributes_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.name.has_value())
-        {
-            d.AddMember("name",
-                Value().SetString(StringRef(device.name.value().data(),
-                    device.name.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_available.has_value())
+        void add_connections(rapidjson::Value& obj,
+            std::string_view key,
+            connections_type values,
+            allocator_type& allocator)
         {
-            d.AddMember("pl_avail",
-                Value().SetString(
-                    StringRef(device.payload_available.value().data(),
-                        device.payload_available.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_not_available.has_value())
-        {
-            d.AddMember("pl_not_avail",
-                Value().SetString(
-                    StringRef(device.payload_not_available.value().data(),
-                        device.payload_not_available.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_off.has_value())
-        {
-            d.AddMember("pl_off",
-                Value().SetString(StringRef(device.payload_off.value().data(),
-                    device.payload_off.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_on.has_value())
-        {
-            d.AddMember("pl_on",
-                Value().SetString(StringRef(device.payload_on.value().data(),
-                    device.payload_on.value().size())),
-                d.GetAllocator());
-        }
-        if (device.unique_id.has_value())
-        {
-            d.AddMember("uniq_id",
-                Value().SetString(StringRef(device.unique_id.value().data(),
-                    device.unique_id.value().size())),
-                d.GetAllocator());
-        }
-        if (device.value_template.has_value())
-        {
-            d.AddMember("val_tpl",
-                Value().SetString(
-                    StringRef(device.value_template.value().data(),
-                        device.value_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.availability.has_value())
-        {
-            Value a;
+            rapidjson::Value a;
             a.SetArray();
-            for (const auto& str : device.availability.value())
+            for (const auto& [name, value] : values)
             {
-                a.PushBack(Value().SetString(StringRef(str.data(), str.size())),
-                    d.GetAllocator());
+                rapidjson::Value tuple;
+                tuple.SetArray();
+                tuple.PushBack(
+                    rapidjson::Value().SetString(make_ref(name)), allocator);
+                tuple.PushBack(
+                    rapidjson::Value().SetString(make_ref(value)), allocator);
+                a.PushBack(tuple, allocator);
             }
-            d.AddMember("avty", std::move(a), d.GetAllocator());
+            obj.AddMember(make_ref(key), std::move(a), allocator);
         }
-        return d;
-    }
 
-    rapidjson::Document serialize(const camera_type& device) noexcept
-    {
-        using namespace rapidjson;
-        Document d;
-        d.SetObject();
-        d.AddMember("t",
-            Value().SetString(
-                StringRef(device.topic.data(), device.topic.size())),
-            d.GetAllocator());
-        if (device.enabled_by_default.has_value())
+        void add_bool(rapidjson::Value& obj,
+            std::string_view key,
+            bool value,
+            allocator_type& allocator)
         {
-            d.AddMember("enabled_by_default",
-                Value().SetBool(device.enabled_by_default.value()),
-                d.GetAllocator());
+            obj.AddMember(
+                make_ref(key), rapidjson::Value().SetBool(value), allocator);
         }
-        if (device.device.has_value())
-        {
-            serialize_device_type(device.device.value(), d);
-        }
-        if (device.availability_mode.has_value())
-        {
-            d.AddMember("avty_mode",
-                Value().SetString(
-                    StringRef(device.availability_mode.value().data(),
-                        device.availability_mode.value().size())),
-                d.GetAllocator());
-        }
-        if (device.availability_topic.has_value())
-        {
-            d.AddMember("avty_t",
-                Value().SetString(
-                    StringRef(device.availability_topic.value().data(),
-                        device.availability_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.entity_category.has_value())
-        {
-            d.AddMember("entity_category",
-                Value().SetString(
-                    StringRef(device.entity_category.value().data(),
-                        device.entity_category.value().size())),
-                d.GetAllocator());
-        }
-        if (device.icon.has_value())
-        {
-            d.AddMember("ic",
-                Value().SetString(StringRef(device.icon.value().data(),
-                    device.icon.value().size())),
-                d.GetAllocator());
-        }
-        if (device.json_attributes_template.has_value())
-        {
-            d.AddMember("json_attr_tpl",
-                Value().SetString(
-                    StringRef(device.json_attributes_template.value().data(),
-                        device.json_attributes_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.json_attributes_topic.has_value())
-        {
-            d.AddMember("json_attr_t",
-                Value().SetString(
-                    StringRef(device.json_attributes_topic.value().data(),
-                        device.json_attributes_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.name.has_value())
+
+        void add_int(rapidjson::Value& obj,
+            std::string_view key,
+            int value,
+            allocator_type& allocator)
         {
-            d.AddMember("name",
-                Value().SetString(StringRef(device.name.value().data(),
-                    device.name.value().size())),
-                d.GetAllocator());
+            obj.AddMember(
+                make_ref(key), rapidjson::Value().SetInt(value), allocator);
         }
-        if (device.unique_id.has_value())
+
+        void add_double(rapidjson::Value& obj,
+            std::string_view key,
+            double value,
+            allocator_type& allocator)
         {
-            d.AddMember("uniq_id",
-                Value().SetString(StringRef(device.unique_id.value().data(),
-                    device.unique_id.value().size())),
-                d.GetAllocator());
+            obj.AddMember(
+                make_ref(key), rapidjson::Value().SetDouble(value), allocator);
         }
-        if (device.availability.has_value())
-        {
-            Value a;
-            a.SetArray();
-            for (const auto& str : device.availability.value())
+
+        void add_device(rapidjson::Value& obj,
+            std::string_view key,
+            const device_type& device,
+            allocator_type& allocator);
+
+        // Writes row I of a field table. The row is a constant, so its kind
+        // and default are resolved at compile time and only the presence
+        // check and the call to the shared writer are left per member.
+        // Optional members equal to their default are left out when minimal.
+        template<const auto& Fields, std::size_t I, typename T>
+        void add_field(rapidjson::Value& obj,
+            const T& object,
+            bool minimal,
+            allocator_type& allocator)
+        {
+            constexpr std::string_view key = Fields[I].key;
+            constexpr field_kind kind       = Fields[I].kind;
+            constexpr auto member           = Fields[I].member;
+            constexpr default_index def     = find_default(key, kind);
+
+            const auto redundant = [minimal](const auto& value) {
+                if constexpr (def == NO_DEFAULT)
+                {
+                    return false;
+                }
+                else
+                {
+                    constexpr default_value dflt = DEFAULTS[def];
+                    return minimal && is_default(dflt, value);
+                }
+            };
+
+            if constexpr (kind == field_kind::string)
+            {
+                add_string(obj, key, object.*member.string, allocator);
+            }
+            else if constexpr (kind == field_kind::string_list)
+            {
+                add_string_list(
+                    obj, key, object.*member.string_list, allocator);
+            }
+            else if constexpr (kind == field_kind::device)
+            {
+                add_device(obj, key, object.*member.device, allocator);
+            }
+            else if constexpr (kind == field_kind::optional_bool)
+            {
+                if (const auto& value = object.*member.optional_bool;
+                    value && !redundant(*value))
+                {
+                    add_bool(obj, key, *value, allocator);
+                }
+            }
+            else if constexpr (kind == field_kind::optional_int)
+            {
+                if (const auto& value = object.*member.optional_int;
+                    value && !redundant(*value))
+                {
+                    add_int(obj, key, *value, allocator);
+                }
+            }
+            else if constexpr (kind == field_kind::optional_double)
+            {
+                if (const auto& value = object.*member.optional_double;
+                    value && !redundant(*value))
+                {
+                    add_double(obj, key, *value, allocator);
+                }
+            }
+            else if constexpr (kind == field_kind::optional_string)
+            {
+                if (const auto& value = object.*member.optional_string;
+                    value && !redundant(*value))
+                {
+                    add_string(obj, key, *value, allocator);
+                }
+            }
+            else if constexpr (kind == field_kind::optional_string_list)
             {
-                a.PushBack(Value().SetString(StringRef(str.data(), str.size())),
-                    d.GetAllocator());
+                if (const auto& value = object.*member.optional_string_list)
+                {
+                    add_string_list(obj, key, *value, allocator);
+                }
+            }
+            else if constexpr (kind == field_kind::optional_connections)
+            {
+                if (const auto& value = object.*member.optional_connections)
+                {
+                    add_connections(obj, key, *value, allocator);
+                }
+            }
+            else if constexpr (kind == field_kind::optional_device)
+            {
+                if (const auto& value = object.*member.optional_device)
+                {
+                    add_device(obj, key, *value, allocator);
+                }
             }
-            d.AddMember("avty", std::move(a), d.GetAllocator());
         }
-        return d;
-    }
 
-    rapidjson::Document serialize(const cover_type& device) noexcept
-    {
-        using namespace rapidjson;
-        Document d;
-        d.SetObject();
-        if (device.enabled_by_default.has_value())
-        {
-            d.AddMember("enabled_by_default",
-                Value().SetBool(device.enabled_by_default.value()),
-                d.GetAllocator());
-        }
-        if (device.optimistic.has_value())
+        template<const auto& Fields, typename T, std::size_t... I>
+        void add_fields(rapidjson::Value& obj,
+            const T& object,
+            bool minimal,
+            allocator_type& allocator,
+            std::index_sequence<I...>)
         {
-            d.AddMember("opt",
-                Value().SetBool(device.optimistic.value()),
-                d.GetAllocator());
+            (add_field<Fields, I>(obj, object, minimal, allocator), ...);
         }
-        if (device.retain.has_value())
-        {
-            d.AddMember("ret",
-                Value().SetBool(device.retain.value()),
-                d.GetAllocator());
+
+        template<const auto& Fields, typename T>
+        void add_fields(rapidjson::Value& obj,
+            const T& object,
+            bool minimal,
+            allocator_type& allocator)
+        {
+            add_fields<Fields>(obj,
+                object,
+                minimal,
+                allocator,
+                std::make_index_sequence<std::size(Fields)>{});
         }
-        if (device.tilt_optimistic.has_value())
+
+        // Field tables. Members are emitted in table order.
+
+        constexpr field<device_type> DEVICE_FIELDS[]{
+            { "mf", &device_type::manufacturer },
+            { "mdl", &device_type::model },
+            { "name", &device_type::name },
+            { "sa", &device_type::suggested_area },
+            { "sw", &device_type::sw_version },
+            { "via_device", &device_type::via_device },
+            { "cns", &device_type::connections },
+            { "ids", &device_type::identifiers },
+        };
+
+        constexpr field<alarm_control_panel_type> ALARM_CONTROL_PANEL_FIELDS[]{
+            { "cmd_t", &alarm_control_panel_type::command_topic },
+            { "stat_t", &alarm_control_panel_type::state_topic },
+            { "cod_arm_req", &alarm_control_panel_type::code_arm_required },
+            { "cod_dis_req", &alarm_control_panel_type::code_disarm_required },
+            { "enabled_by_default",
+                &alarm_control_panel_type::enabled_by_default },
+            { "ret", &alarm_control_panel_type::retain },
+            { "dev", &alarm_control_panel_type::device },
+            { "qos", &alarm_control_panel_type::qos },
+            { "avty_mode", &alarm_control_panel_type::availability_mode },
+            { "avty_t", &alarm_control_panel_type::availability_topic },
+            { "code", &alarm_control_panel_type::code },
+            { "cmd_tpl", &alarm_control_panel_type::command_template },
+            { "entity_category", &alarm_control_panel_type::entity_category },
+            { "ic", &alarm_control_panel_type::icon },
+            { "json_attr_tpl",
+                &alarm_control_panel_type::json_attributes_template },
+            { "json_attr_t", &alarm_control_panel_type::json_attributes_topic },
+            { "name", &alarm_control_panel_type::name },
+            { "pl_arm_away", &alarm_control_panel_type::payload_arm_away },
+            { "pl_arm_custom_b",
+                &alarm_control_panel_type::payload_arm_custom_bypass },
+            { "pl_arm_home", &alarm_control_panel_type::payload_arm_home },
+            { "pl_arm_nite", &alarm_control_panel_type::payload_arm_night },
+            { "payload_arm_vacation",
+                &alarm_control_panel_type::payload_arm_vacation },
+            { "pl_avail", &alarm_control_panel_type::payload_available },
+            { "pl_disarm", &alarm_control_panel_type::payload_disarm },
+            { "pl_not_avail",
+                &alarm_control_panel_type::payload_not_available },
+            { "uniq_id", &alarm_control_panel_type::unique_id },
+            { "val_tpl", &alarm_control_panel_type::value_template },
+            { "avty", &alarm_control_panel_type::availability },
+        };
+
+        constexpr field<binary_sensor_type> BINARY_SENSOR_FIELDS[]{
+            { "stat_t", &binary_sensor_type::state_topic },
+            { "enabled_by_default", &binary_sensor_type::enabled_by_default },
+            { "frc_upd", &binary_sensor_type::force_update },
+            { "dev", &binary_sensor_type::device },
+            { "exp_aft", &binary_sensor_type::expire_after },
+            { "off_dly", &binary_sensor_type::off_delay },
+            { "qos", &binary_sensor_type::qos },
+            { "avty_mode", &binary_sensor_type::availability_mode },
+            { "avty_t", &binary_sensor_type::availability_topic },
+            { "dev_cla", &binary_sensor_type::device_class },
+            { "entity_category", &binary_sensor_type::entity_category },
+            { "ic", &binary_sensor_type::icon },
+            { "json_attr_tpl", &binary_sensor_type::json_attributes_template },
+            { "json_attr_t", &binary_sensor_type::json_attributes_topic },
+            { "name", &binary_sensor_type::name },
+            { "pl_avail", &binary_sensor_type::payload_available },
+            { "pl_not_avail", &binary_sensor_type::payload_not_available },
+            { "pl_off", &binary_sensor_type::payload_off },
+            { "pl_on", &binary_sensor_type::payload_on },
+            { "uniq_id", &binary_sensor_type::unique_id },
+            { "val_tpl", &binary_sensor_type::value_template },
+            { "avty", &binary_sensor_type::availability },
+        };
+
+        constexpr field<camera_type> CAMERA_FIELDS[]{
+            { "t", &camera_type::topic },
+            { "enabled_by_default", &camera_type::enabled_by_default },
+            { "dev", &camera_type::device },
+            { "avty_mode", &camera_type::availability_mode },
+            { "avty_t", &camera_type::availability_topic },
+            { "entity_category", &camera_type::entity_category },
+            { "ic", &camera_type::icon },
+            { "json_attr_tpl", &camera_type::json_attributes_template },
+            { "json_attr_t", &camera_type::json_attributes_topic },
+            { "name", &camera_type::name },
+            { "uniq_id", &camera_type::unique_id },
+            { "avty", &camera_type::availability },
+        };
+
+        constexpr field<cover_type> COVER_FIELDS[]{
+            { "enabled_by_default", &cover_type::enabled_by_default },
+            { "opt", &cover_type::optimistic },
+            { "ret", &cover_type::retain },
+            { "tilt_opt", &cover_type::tilt_optimistic },
+            { "dev", &cover_type::device },
+            { "pos_clsd", &cover_type::position_closed },
+            { "pos_open", &cover_type::position_open },
+            { "qos", &cover_type::qos },
+            { "tilt_clsd_val", &cover_type::tilt_closed_value },
+            { "tilt_max", &cover_type::tilt_max },
+            { "tilt_min", &cover_type::tilt_min },
+            { "tilt_opnd_val", &cover_type::tilt_opened_value },
+            { "avty_mode", &cover_type::availability_mode },
+            { "avty_t", &cover_type::availability_topic },
+            { "cmd_t", &cover_type::command_topic },
+            { "dev_cla", &cover_type::device_class },
+            { "entity_category", &cover_type::entity_category },
+            { "ic", &cover_type::icon },
+            { "json_attr_tpl", &cover_type::json_attributes_template },
+            { "json_attr_t", &cover_type::json_attributes_topic },
+            { "name", &cover_type::name },
+            { "pl_avail", &cover_type::payload_available },
+            { "pl_cls", &cover_type::payload_close },
+            { "pl_not_avail", &cover_type::payload_not_available },
+            { "pl_open", &cover_type::payload_open },
+            { "pl_stop", &cover_type::payload_stop },
+            { "pos_tpl", &cover_type::position_template },
+            { "pos_t", &cover_type::position_topic },
+            { "set_pos_tpl", &cover_type::set_position_template },
+            { "set_pos_t", &cover_type::set_position_topic },
+            { "stat_clsd", &cover_type::state_closed },
+            { "stat_closing", &cover_type::state_closing },
+            { "stat_open", &cover_type::state_open },
+            { "stat_opening", &cover_type::state_opening },
+            { "stat_stopped", &cover_type::state_stopped },
+            { "stat_t", &cover_type::state_topic },
+            { "tilt_cmd_tpl", &cover_type::tilt_command_template },
+            { "tilt_cmd_t", &cover_type::tilt_command_topic },
+            { "tilt_status_tpl", &cover_type::tilt_status_template },
+            { "tilt_status_t", &cover_type::tilt_status_topic },
+            { "uniq_id", &cover_type::unique_id },
+            { "val_tpl", &cover_type::value_template },
+            { "avty", &cover_type::availability },
+        };
+
+        constexpr field<device_tracker_type> DEVICE_TRACKER_FIELDS[]{
+            { "devices", &device_tracker_type::devices },
+            { "qos", &device_tracker_type::qos },
+            { "pl_home", &device_tracker_type::payload_home },
+            { "pl_not_home", &device_tracker_type::payload_not_home },
+            { "src_type", &device_tracker_type::source_type },
+        };
+
+        constexpr field<device_trigger_type> DEVICE_TRIGGER_FIELDS[]{
+            { "dev", &device_trigger_type::device },
+            { "atype", &device_trigger_type::automation_type },
+            { "stype", &device_trigger_type::subtype },
+            { "t", &device_trigger_type::topic },
+            { "type", &device_trigger_type::type },
+            { "qos", &device_trigger_type::qos },
+            { "pl", &device_trigger_type::payload },
+        };
+
+        constexpr field<fan_type> FAN_FIELDS[]{
+            { "cmd_t", &fan_type::command_topic },
+            { "enabled_by_default", &fan_type::enabled_by_default },
+            { "opt", &fan_type::optimistic },
+            { "ret", &fan_type::retain },
+            { "dev", &fan_type::device },
+            { "qos", &fan_type::qos },
+            { "spd_rng_max", &fan_type::speed_range_max },
+            { "spd_rng_min", &fan_type::speed_range_min },
+            { "avty_mode", &fan_type::availability_mode },
+            { "avty_t", &fan_type::availability_topic },
+            { "cmd_tpl", &fan_type::command_template },
+            { "entity_category", &fan_type::entity_category },
+            { "ic", &fan_type::icon },
+            { "json_attr_tpl", &fan_type::json_attributes_template },
+            { "json_attr_t", &fan_type::json_attributes_topic },
+            { "name", &fan_type::name },
+            { "osc_cmd_tpl", &fan_type::oscillation_command_template },
+            { "osc_cmd_t", &fan_type::oscillation_command_topic },
+            { "osc_stat_t", &fan_type::oscillation_state_topic },
+            { "osc_val_tpl", &fan_type::oscillation_value_template },
+            { "pl_avail", &fan_type::payload_available },
+            { "pl_not_avail", &fan_type::payload_not_available },
+            { "pl_off", &fan_type::payload_off },
+            { "pl_on", &fan_type::payload_on },
+            { "pl_osc_off", &fan_type::payload_oscillation_off },
+            { "pl_osc_on", &fan_type::payload_oscillation_on },
+            { "pl_rst_pct", &fan_type::payload_reset_percentage },
+            { "pl_rst_pr_mode", &fan_type::payload_reset_preset_mode },
+            { "pct_cmd_tpl", &fan_type::percentage_command_template },
+            { "pct_cmd_t", &fan_type::percentage_command_topic },
+            { "pct_stat_t", &fan_type::percentage_state_topic },
+            { "pct_val_tpl", &fan_type::percentage_value_template },
+            { "pr_mode_cmd_tpl", &fan_type::preset_mode_command_template },
+            { "pr_mode_cmd_t", &fan_type::preset_mode_command_topic },
+            { "pr_mode_stat_t", &fan_type::preset_mode_state_topic },
+            { "pr_mode_val_tpl", &fan_type::preset_mode_value_template },
+            { "stat_t", &fan_type::state_topic },
+            { "stat_val_tpl", &fan_type::state_value_template },
+            { "uniq_id", &fan_type::unique_id },
+            { "avty", &fan_type::availability },
+            { "pr_modes", &fan_type::preset_modes },
+        };
+
+        constexpr field<humidifier_type> HUMIDIFIER_FIELDS[]{
+            { "cmd_t", &humidifier_type::command_topic },
+            { "hum_cmd_t", &humidifier_type::target_humidity_command_topic },
+            { "enabled_by_default", &humidifier_type::enabled_by_default },
+            { "opt", &humidifier_type::optimistic },
+            { "ret", &humidifier_type::retain },
+            { "dev", &humidifier_type::device },
+            { "max_hum", &humidifier_type::max_humidity },
+            { "min_hum", &humidifier_type::min_humidity },
+            { "qos", &humidifier_type::qos },
+            { "avty_mode", &humidifier_type::availability_mode },
+            { "avty_t", &humidifier_type::availability_topic },
+            { "cmd_tpl", &humidifier_type::command_template },
+            { "dev_cla", &humidifier_type::device_class },
+            { "entity_category", &humidifier_type::entity_category },
+            { "ic", &humidifier_type::icon },
+            { "json_attr_tpl", &humidifier_type::json_attributes_template },
+            { "json_attr_t", &humidifier_type::json_attributes_topic },
+            { "mode_cmd_tpl", &humidifier_type::mode_command_template },
+            { "mode_cmd_t", &humidifier_type::mode_command_topic },
+            { "mode_stat_tpl", &humidifier_type::mode_state_template },
+            { "mode_stat_t", &humidifier_type::mode_state_topic },
+            { "name", &humidifier_type::name },
+            { "pl_avail", &humidifier_type::payload_available },
+            { "pl_not_avail", &humidifier_type::payload_not_available },
+            { "pl_off", &humidifier_type::payload_off },
+            { "pl_on", &humidifier_type::payload_on },
+            { "pl_rst_hum", &humidifier_type::payload_reset_humidity },
+            { "pl_rst_mode", &humidifier_type::payload_reset_mode },
+            { "stat_t", &humidifier_type::state_topic },
+            { "stat_val_tpl", &humidifier_type::state_value_template },
+            { "hum_cmd_tpl",
+                &humidifier_type::target_humidity_command_template },
+            { "hum_stat_tpl",
+                &humidifier_type::target_humidity_state_template },
+            { "hum_stat_t", &humidifier_type::target_humidity_state_topic },
+            { "uniq_id", &humidifier_type::unique_id },
+            { "avty", &humidifier_type::availability },
+            { "modes", &humidifier_type::modes },
+        };
+
+        constexpr field<light_type> LIGHT_FIELDS[]{
+            { "cmd_t", &light_type::command_topic },
+            { "enabled_by_default", &light_type::enabled_by_default },
+            { "opt", &light_type::optimistic },
+            { "ret", &light_type::retain },
+            { "dev", &light_type::device },
+            { "bri_scl", &light_type::brightness_scale },
+            { "max_mirs", &light_type::max_mireds },
+            { "min_mirs", &light_type::min_mireds },
+            { "qos", &light_type::qos },
+            { "white_scale", &light_type::white_scale },
+            { "avty_mode", &light_type::availability_mode },
+            { "avty_t", &light_type::availability_topic },
+            { "bri_cmd_t", &light_type::brightness_command_topic },
+            { "bri_stat_t", &light_type::brightness_state_topic },
+            { "bri_val_tpl", &light_type::brightness_value_template },
+            { "color_mode_state_topic", &light_type::color_mode_state_topic },
+            { "color_mode_value_template",
+                &light_type::color_mode_value_template },
+            { "clr_temp_cmd_tpl", &light_type::color_temp_command_template },
+            { "clr_temp_cmd_t", &light_type::color_temp_command_topic },
+            { "clr_temp_stat_t", &light_type::color_temp_state_topic },
+            { "clr_temp_val_tpl", &light_type::color_temp_value_template },
+            { "fx_cmd_t", &light_type::effect_command_topic },
+            { "fx_stat_t", &light_type::effect_state_topic },
+            { "fx_val_tpl", &light_type::effect_value_template },
+            { "entity_category", &light_type::entity_category },
+            { "hs_cmd_t", &light_type::hs_command_topic },
+            { "hs_stat_t", &light_type::hs_state_topic },
+            { "hs_val_tpl", &light_type::hs_value_template },
+            { "ic", &light_type::icon },
+            { "json_attr_tpl", &light_type::json_attributes_template },
+            { "json_attr_t", &light_type::json_attributes_topic },
+            { "name", &light_type::name },
+            { "on_cmd_type", &light_type::on_command_type },
+            { "pl_avail", &light_type::payload_available },
+            { "pl_not_avail", &light_type::payload_not_available },
+            { "pl_off", &light_type::payload_off },
+            { "pl_on", &light_type::payload_on },
+            { "rgb_cmd_tpl", &light_type::rgb_command_template },
+            { "rgb_cmd_t", &light_type::rgb_command_topic },
+            { "rgb_stat_t", &light_type::rgb_state_topic },
+            { "rgb_val_tpl", &light_type::rgb_value_template },
+            { "schema", &light_type::schema },
+            { "stat_t", &light_type::state_topic },
+            { "stat_val_tpl", &light_type::state_value_template },
+            { "uniq_id", &light_type::unique_id },
+            { "white_command_topic", &light_type::white_command_topic },
+            { "xy_cmd_t", &light_type::xy_command_topic },
+            { "xy_stat_t", &light_type::xy_state_topic },
+            { "xy_val_tpl", &light_type::xy_value_template },
+            { "avty", &light_type::availability },
+            { "fx_list", &light_type::effect_list },
+        };
+
+        constexpr field<lock_type> LOCK_FIELDS[]{
+            { "cmd_t", &lock_type::command_topic },
+            { "enabled_by_default", &lock_type::enabled_by_default },
+            { "opt", &lock_type::optimistic },
+            { "ret", &lock_type::retain },
+            { "dev", &lock_type::device },
+            { "qos", &lock_type::qos },
+            { "avty_mode", &lock_type::availability_mode },
+            { "avty_t", &lock_type::availability_topic },
+            { "entity_category", &lock_type::entity_category },
+            { "ic", &lock_type::icon },
+            { "json_attr_tpl", &lock_type::json_attributes_template },
+            { "json_attr_t", &lock_type::json_attributes_topic },
+            { "name", &lock_type::name },
+            { "pl_avail", &lock_type::payload_available },
+            { "pl_lock", &lock_type::payload_lock },
+            { "pl_not_avail", &lock_type::payload_not_available },
+            { "pl_unlk", &lock_type::payload_unlock },
+            { "stat_locked", &lock_type::state_locked },
+            { "stat_t", &lock_type::state_topic },
+            { "stat_unlocked", &lock_type::state_unlocked },
+            { "uniq_id", &lock_type::unique_id },
+            { "val_tpl", &lock_type::value_template },
+            { "avty", &lock_type::availability },
+        };
+
+        constexpr field<number_type> NUMBER_FIELDS[]{
+            { "enabled_by_default", &number_type::enabled_by_default },
+            { "opt", &number_type::optimistic },
+            { "ret", &number_type::retain },
+            { "dev", &number_type::device },
+            { "max", &number_type::max },
+            { "min", &number_type::min },
+            { "step", &number_type::step },
+            { "qos", &number_type::qos },
+            { "avty_mode", &number_type::availability_mode },
+            { "avty_t", &number_type::availability_topic },
+            { "cmd_t", &number_type::command_topic },
+            { "entity_category", &number_type::entity_category },
+            { "ic", &number_type::icon },
+            { "json_attr_tpl", &number_type::json_attributes_template },
+            { "json_attr_t", &number_type::json_attributes_topic },
+            { "name", &number_type::name },
+            { "payload_reset", &number_type::payload_reset },
+            { "stat_t", &number_type::state_topic },
+            { "uniq_id", &number_type::unique_id },
+            { "unit_of_meas", &number_type::unit_of_measurement },
+            { "val_tpl", &number_type::value_template },
+            { "avty", &number_type::availability },
+        };
+
+        constexpr field<scene_type> SCENE_FIELDS[]{
+            { "enabled_by_default", &scene_type::enabled_by_default },
+            { "ret", &scene_type::retain },
+            { "qos", &scene_type::qos },
+            { "avty_mode", &scene_type::availability_mode },
+            { "avty_t", &scene_type::availability_topic },
+            { "cmd_t", &scene_type::command_topic },
+            { "entity_category", &scene_type::entity_category },
+            { "ic", &scene_type::icon },
+            { "name", &scene_type::name },
+            { "pl_avail", &scene_type::payload_available },
+            { "pl_not_avail", &scene_type::payload_not_available },
+            { "pl_on", &scene_type::payload_on },
+            { "uniq_id", &scene_type::unique_id },
+            { "avty", &scene_type::availability },
+        };
+
+        constexpr field<select_type> SELECT_FIELDS[]{
+            { "cmd_t", &select_type::command_topic },
+            { "options", &select_type::options },
+            { "enabled_by_default", &select_type::enabled_by_default },
+            { "opt", &select_type::optimistic },
+            { "ret", &select_type::retain },
+            { "dev", &select_type::device },
+            { "qos", &select_type::qos },
+            { "avty_mode", &select_type::availability_mode },
+            { "avty_t", &select_type::availability_topic },
+            { "entity_category", &select_type::entity_category },
+            { "ic", &select_type::icon },
+            { "json_attr_tpl", &select_type::json_attributes_template },
+            { "json_attr_t", &select_type::json_attributes_topic },
+            { "name", &select_type::name },
+            { "stat_t", &select_type::state_topic },
+            { "uniq_id", &select_type::unique_id },
+            { "val_tpl", &select_type::value_template },
+            { "avty", &select_type::availability },
+        };
+
+        constexpr field<sensor_type> SENSOR_FIELDS[]{
+            { "stat_t", &sensor_type::state_topic },
+            { "enabled_by_default", &sensor_type::enabled_by_default },
+            { "frc_upd", &sensor_type::force_update },
+            { "dev", &sensor_type::device },
+            { "exp_aft", &sensor_type::expire_after },
+            { "qos", &sensor_type::qos },
+            { "avty_mode", &sensor_type::availability_mode },
+            { "avty_t", &sensor_type::availability_topic },
+            { "dev_cla", &sensor_type::device_class },
+            { "entity_category", &sensor_type::entity_category },
+            { "ic", &sensor_type::icon },
+            { "json_attr_tpl", &sensor_type::json_attributes_template },
+            { "json_attr_t", &sensor_type::json_attributes_topic },
+            { "last_reset_value_template",
+                &sensor_type::last_reset_value_template },
+            { "name", &sensor_type::name },
+            { "pl_avail", &sensor_type::payload_available },
+            { "pl_not_avail", &sensor_type::payload_not_available },
+            { "stat_cla", &sensor_type::state_class },
+            { "uniq_id", &sensor_type::unique_id },
+            { "unit_of_meas", &sensor_type::unit_of_measurement },
+            { "val_tpl", &sensor_type::value_template },
+            { "avty", &sensor_type::availability },
+        };
+
+        constexpr field<switch_type> SWITCH_FIELDS[]{
+            { "enabled_by_default", &switch_type::enabled_by_default },
+            { "opt", &switch_type::optimistic },
+            { "ret", &switch_type::retain },
+            { "dev", &switch_type::device },
+            { "qos", &switch_type::qos },
+            { "avty_mode", &switch_type::availability_mode },
+            { "avty_t", &switch_type::availability_topic },
+            { "cmd_t", &switch_type::command_topic },
+            { "entity_category", &switch_type::entity_category },
+            { "ic", &switch_type::icon },
+            { "json_attr_tpl", &switch_type::json_attributes_template },
+            { "json_attr_t", &switch_type::json_attributes_topic },
+            { "name", &switch_type::name },
+            { "pl_avail", &switch_type::payload_available },
+            { "pl_not_avail", &switch_type::payload_not_available },
+            { "pl_off", &switch_type::payload_off },
+            { "pl_on", &switch_type::payload_on },
+            { "stat_off", &switch_type::state_off },
+            { "stat_on", &switch_type::state_on },
+            { "stat_t", &switch_type::state_topic },
+            { "uniq_id", &switch_type::unique_id },
+            { "val_tpl", &switch_type::value_template },
+            { "avty", &switch_type::availability },
+        };
+
+        constexpr field<vacuum_type> VACUUM_FIELDS[]{
+            { "enabled_by_default", &vacuum_type::enabled_by_default },
+            { "ret", &vacuum_type::retain },
+            { "qos", &vacuum_type::qos },
+            { "avty_mode", &vacuum_type::availability_mode },
+            { "avty_t", &vacuum_type::availability_topic },
+            { "bat_lev_tpl", &vacuum_type::battery_level_template },
+            { "bat_lev_t", &vacuum_type::battery_level_topic },
+            { "chrg_tpl", &vacuum_type::charging_template },
+            { "chrg_t", &vacuum_type::charging_topic },
+            { "cln_tpl", &vacuum_type::cleaning_template },
+            { "cln_t", &vacuum_type::cleaning_topic },
+            { "cmd_t", &vacuum_type::command_topic },
+            { "dock_tpl", &vacuum_type::docked_template },
+            { "dock_t", &vacuum_type::docked_topic },
+            { "entity_category", &vacuum_type::entity_category },
+            { "err_tpl", &vacuum_type::error_template },
+            { "err_t", &vacuum_type::error_topic },
+            { "fanspd_tpl", &vacuum_type::fan_speed_template },
+            { "fanspd_t", &vacuum_type::fan_speed_topic },
+            { "ic", &vacuum_type::icon },
+            { "json_attr_tpl", &vacuum_type::json_attributes_template },
+            { "json_attr_t", &vacuum_type::json_attributes_topic },
+            { "name", &vacuum_type::name },
+            { "pl_avail", &vacuum_type::payload_available },
+            { "pl_cln_sp", &vacuum_type::payload_clean_spot },
+            { "pl_loc", &vacuum_type::payload_locate },
+            { "pl_not_avail", &vacuum_type::payload_not_available },
+            { "pl_ret", &vacuum_type::payload_return_to_base },
+            { "pl_stpa", &vacuum_type::payload_start_pause },
+            { "pl_stop", &vacuum_type::payload_stop },
+            { "pl_toff", &vacuum_type::payload_turn_off },
+            { "pl_ton", &vacuum_type::payload_turn_on },
+            { "schema", &vacuum_type::schema },
+            { "send_cmd_t", &vacuum_type::send_command_topic },
+            { "set_fan_spd_t", &vacuum_type::set_fan_speed_topic },
+            { "uniq_id", &vacuum_type::unique_id },
+            { "avty", &vacuum_type::availability },
+            { "fanspd_lst", &vacuum_type::fan_speed_list },
+            { "sup_feat", &vacuum_type::supported_features },
+        };
+
+        void add_device(rapidjson::Value& obj,
+            std::string_view key,
+            const device_type& device,
+            allocator_type& allocator)
         {
-            d.AddMember("tilt_opt",
-                Value().SetBool(device.tilt_optimistic.value()),
-                d.GetAllocator());
+            rapidjson::Value v(rapidjson::kObjectType);
+            add_fields<DEVICE_FIELDS>(v, device, false, allocator);
+            obj.AddMember(make_ref(key), std::move(v), allocator);
         }
-        if (device.device.has_value())
-        {
-            serialize_device_type(device.device.value(), d);
+
+        constexpr field<origin_type> ORIGIN_FIELDS[]{
+            { "name", &origin_type::name },
+            { "sw", &origin_type::sw_version },
+            { "url", &origin_type::support_url },
+        };
+
+        // Platform name and field table of the entities allowed in a device
+        // discovery payload.
+        template<typename T>
+        struct entity_traits;
+
+        template<>
+        struct entity_traits<alarm_control_panel_type> {
+            static constexpr std::string_view platform{ "alarm_control_panel" };
+            static constexpr const auto& fields = ALARM_CONTROL_PANEL_FIELDS;
+        };
+
+        template<>
+        struct entity_traits<binary_sensor_type> {
+            static constexpr std::string_view platform{ "binary_sensor" };
+            static constexpr const auto& fields = BINARY_SENSOR_FIELDS;
+        };
+
+        template<>
+        struct entity_traits<camera_type> {
+            static constexpr std::string_view platform{ "camera" };
+            static constexpr const auto& fields = CAMERA_FIELDS;
+        };
+
+        template<>
+        struct entity_traits<cover_type> {
+            static constexpr std::string_view platform{ "cover" };
+            static constexpr const auto& fields = COVER_FIELDS;
+        };
+
+        template<>
+        struct entity_traits<device_tracker_type> {
+            static constexpr std::string_view platform{ "device_tracker" };
+            static constexpr const auto& fields = DEVICE_TRACKER_FIELDS;
+        };
+
+        template<>
+        struct entity_traits<device_trigger_type> {
+            static constexpr std::string_view platform{ "device_automation" };
+            static constexpr const auto& fields = DEVICE_TRIGGER_FIELDS;
+        };
+
+        template<>
+        struct entity_traits<fan_type> {
+            static constexpr std::string_view platform{ "fan" };
+            static constexpr const auto& fields = FAN_FIELDS;
+        };
+
+        template<>
+        struct entity_traits<humidifier_type> {
+            static constexpr std::string_view platform{ "humidifier" };
+            static constexpr const auto& fields = HUMIDIFIER_FIELDS;
+        };
+
+        template<>
+        struct entity_traits<light_type> {
+            static constexpr std::string_view platform{ "light" };
+            static constexpr const auto& fields = LIGHT_FIELDS;
+        };
+
+        template<>
+        struct entity_traits<lock_type> {
+            static constexpr std::string_view platform{ "lock" };
+            static constexpr const auto& fields = LOCK_FIELDS;
+        };
+
+        template<>
+        struct entity_traits<number_type> {
+            static constexpr std::string_view platform{ "number" };
+            static constexpr const auto& fields = NUMBER_FIELDS;
+        };
+
+        template<>
+        struct entity_traits<scene_type> {
+            static constexpr std::string_view platform{ "scene" };
+            static constexpr const auto& fields = SCENE_FIELDS;
+        };
+
+        template<>
+        struct entity_traits<select_type> {
+            static constexpr std::string_view platform{ "select" };
+            static constexpr const auto& fields = SELECT_FIELDS;
+        };
+
+        template<>
+        struct entity_traits<sensor_type> {
+            static constexpr std::string_view platform{ "sensor" };
+            static constexpr const auto& fields = SENSOR_FIELDS;
+        };
+
+        template<>
+        struct entity_traits<switch_type> {
+            static constexpr std::string_view platform{ "switch" };
+            static constexpr const auto& fields = SWITCH_FIELDS;
+        };
+
+        template<>
+        struct entity_traits<vacuum_type> {
+            static constexpr std::string_view platform{ "vacuum" };
+            static constexpr const auto& fields = VACUUM_FIELDS;
+        };
+
+        static_assert(unique_keys(DEVICE_FIELDS), "Duplicate key.");
+        static_assert(unique_keys(ORIGIN_FIELDS), "Duplicate key.");
+
+        template<typename T>
+        void add_entity(rapidjson::Value& obj,
+            const T& entity,
+            payload_mode mode,
+            allocator_type& allocator)
+        {
+            static_assert(
+                unique_keys(entity_traits<T>::fields), "Duplicate key.");
+
+            add_fields<entity_traits<T>::fields>(
+                obj, entity, mode == payload_mode::minimal, allocator);
         }
-        if (device.position_closed.has_value())
+
+        template<typename T>
+        rapidjson::Document serialize_entity(const T& entity, payload_mode mode)
         {
-            d.AddMember("pos_clsd",
-                Value().SetInt(device.position_closed.value()),
-                d.GetAllocator());
+            rapidjson::Document d;
+            d.SetObject();
+            add_entity(d, entity, mode, d.GetAllocator());
+            return d;
         }
-        if (device.position_open.has_value())
+
+        void add_component(rapidjson::Value& obj,
+            const component_type& component,
+            payload_mode mode,
+            allocator_type& allocator)
         {
-            d.AddMember("pos_open",
-                Value().SetInt(device.position_open.value()),
-                d.GetAllocator());
+            rapidjson::Value v(rapidjson::kObjectType);
+
+            std::visit(
+                [&](const auto* entity) {
+                    using traits =
+                        entity_traits<std::decay_t<decltype(*entity)>>;
+
+                    add_string(v, "p", traits::platform, allocator);
+                    add_entity(v, *entity, mode, allocator);
+                },
+                component.entity);
+
+            obj.AddMember(
+                make_ref(component.object_id), std::move(v), allocator);
         }
-        if (device.qos.has_value())
-        {
-            d.AddMember("qos",
-                Value().SetInt(device.qos.value()),
-                d.GetAllocator());
-        }
-        if (device.tilt_closed_value.has_value())
-        {
-            d.AddMember("tilt_clsd_val",
-                Value().SetInt(device.tilt_closed_value.value()),
-                d.GetAllocator());
-        }
-        if (device.tilt_max.has_value())
-        {
-            d.AddMember("tilt_max",
-                Value().SetInt(device.tilt_max.value()),
-                d.GetAllocator());
-        }
-        if (device.tilt_min.has_value())
-        {
-            d.AddMember("tilt_min",
-                Value().SetInt(device.tilt_min.value()),
-                d.GetAllocator());
-        }
-        if (device.tilt_opened_value.has_value())
-        {
-            d.AddMember("tilt_opnd_val",
-                Value().SetInt(device.tilt_opened_value.value()),
-                d.GetAllocator());
-        }
-        if (device.availability_mode.has_value())
-        {
-            d.AddMember("avty_mode",
-                Value().SetString(
-                    StringRef(device.availability_mode.value().data(),
-                        device.availability_mode.value().size())),
-                d.GetAllocator());
-        }
-        if (device.availability_topic.has_value())
-        {
-            d.AddMember("avty_t",
-                Value().SetString(
-                    StringRef(device.availability_topic.value().data(),
-                        device.availability_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.command_topic.has_value())
-        {
-            d.AddMember("cmd_t",
-                Value().SetString(StringRef(device.command_topic.value().data(),
-                    device.command_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.device_class.has_value())
-        {
-            d.AddMember("dev_cla",
-                Value().SetString(StringRef(device.device_class.value().data(),
-                    device.device_class.value().size())),
-                d.GetAllocator());
-        }
-        if (device.entity_category.has_value())
-        {
-            d.AddMember("entity_category",
-                Value().SetString(
-                    StringRef(device.entity_category.value().data(),
-                        device.entity_category.value().size())),
-                d.GetAllocator());
-        }
-        if (device.icon.has_value())
-        {
-            d.AddMember("ic",
-                Value().SetString(StringRef(device.icon.value().data(),
-                    device.icon.value().size())),
-                d.GetAllocator());
-        }
-        if (device.json_attributes_template.has_value())
-        {
-            d.AddMember("json_attr_tpl",
-                Value().SetString(
-                    StringRef(device.json_attributes_template.value().data(),
-                        device.json_attributes_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.json_attributes_topic.has_value())
-        {
-            d.AddMember("json_attr_t",
-                Value().SetString(
-                    StringRef(device.json_attributes_topic.value().data(),
-                        device.json_attributes_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.name.has_value())
-        {
-            d.AddMember("name",
-                Value().SetString(StringRef(device.name.value().data(),
-                    device.name.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_available.has_value())
-        {
-            d.AddMember("pl_avail",
-                Value().SetString(
-                    StringRef(device.payload_available.value().data(),
-                        device.payload_available.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_close.has_value())
-        {
-            d.AddMember("pl_cls",
-                Value().SetString(StringRef(device.payload_close.value().data(),
-                    device.payload_close.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_not_available.has_value())
-        {
-            d.AddMember("pl_not_avail",
-                Value().SetString(
-                    StringRef(device.payload_not_available.value().data(),
-                        device.payload_not_available.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_open.has_value())
-        {
-            d.AddMember("pl_open",
-                Value().SetString(StringRef(device.payload_open.value().data(),
-                    device.payload_open.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_stop.has_value())
-        {
-            d.AddMember("pl_stop",
-                Value().SetString(StringRef(device.payload_stop.value().data(),
-                    device.payload_stop.value().size())),
-                d.GetAllocator());
-        }
-        if (device.position_template.has_value())
-        {
-            d.AddMember("pos_tpl",
-                Value().SetString(
-                    StringRef(device.position_template.value().data(),
-                        device.position_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.position_topic.has_value())
-        {
-            d.AddMember("pos_t",
-                Value().SetString(
-                    StringRef(device.position_topic.value().data(),
-                        device.position_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.set_position_template.has_value())
-        {
-            d.AddMember("set_pos_tpl",
-                Value().SetString(
-                    StringRef(device.set_position_template.value().data(),
-                        device.set_position_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.set_position_topic.has_value())
-        {
-            d.AddMember("set_pos_t",
-                Value().SetString(
-                    StringRef(device.set_position_topic.value().data(),
-                        device.set_position_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.state_closed.has_value())
-        {
-            d.AddMember("stat_clsd",
-                Value().SetString(StringRef(device.state_closed.value().data(),
-                    device.state_closed.value().size())),
-                d.GetAllocator());
-        }
-        if (device.state_closing.has_value())
-        {
-            d.AddMember("stat_closing",
-                Value().SetString(StringRef(device.state_closing.value().data(),
-                    device.state_closing.value().size())),
-                d.GetAllocator());
-        }
-        if (device.state_open.has_value())
-        {
-            d.AddMember("stat_open",
-                Value().SetString(StringRef(device.state_open.value().data(),
-                    device.state_open.value().size())),
-                d.GetAllocator());
-        }
-        if (device.state_opening.has_value())
-        {
-            d.AddMember("stat_opening",
-                Value().SetString(StringRef(device.state_opening.value().data(),
-                    device.state_opening.value().size())),
-                d.GetAllocator());
-        }
-        if (device.state_stopped.has_value())
-        {
-            d.AddMember("stat_stopped",
-                Value().SetString(StringRef(device.state_stopped.value().data(),
-                    device.state_stopped.value().size())),
-                d.GetAllocator());
-        }
-        if (device.state_topic.has_value())
-        {
-            d.AddMember("stat_t",
-                Value().SetString(StringRef(device.state_topic.value().data(),
-                    device.state_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.tilt_command_template.has_value())
-        {
-            d.AddMember("tilt_cmd_tpl",
-                Value().SetString(
-                    StringRef(device.tilt_command_template.value().data(),
-                        device.tilt_command_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.tilt_command_topic.has_value())
-        {
-            d.AddMember("tilt_cmd_t",
-                Value().SetString(
-                    StringRef(device.tilt_command_topic.value().data(),
-                        device.tilt_command_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.tilt_status_template.has_value())
-        {
-            d.AddMember("tilt_status_tpl",
-                Value().SetString(
-                    StringRef(device.tilt_status_template.value().data(),
-                        device.tilt_status_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.tilt_status_topic.has_value())
-        {
-            d.AddMember("tilt_status_t",
-                Value().SetString(
-                    StringRef(device.tilt_status_topic.value().data(),
-                        device.tilt_status_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.unique_id.has_value())
-        {
-            d.AddMember("uniq_id",
-                Value().SetString(StringRef(device.unique_id.value().data(),
-                    device.unique_id.value().size())),
-                d.GetAllocator());
-        }
-        if (device.value_template.has_value())
-        {
-            d.AddMember("val_tpl",
-                Value().SetString(
-                    StringRef(device.value_template.value().data(),
-                        device.value_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.availability.has_value())
-        {
-            Value a;
-            a.SetArray();
-            for (const auto& str : device.availability.value())
-            {
-                a.PushBack(Value().SetString(StringRef(str.data(), str.size())),
-                    d.GetAllocator());
-            }
-            d.AddMember("avty", std::move(a), d.GetAllocator());
-        }
-        return d;
+    } // namespace
+
+    rapidjson::Document serialize(
+        const alarm_control_panel_type& device, payload_mode mode) noexcept
+    {
+        return serialize_entity(device, mode);
     }
 
-    rapidjson::Document serialize(const device_tracker_type& device) noexcept
+    rapidjson::Document serialize(
+        const binary_sensor_type& device, payload_mode mode) noexcept
     {
-        using namespace rapidjson;
-        Document d;
-        d.SetObject();
-        Value a;
-        a.SetArray();
-        for (const auto& str : device.devices)
-        {
-            a.PushBack(Value().SetString(StringRef(str.data(), str.size())),
-                d.GetAllocator());
-        }
-        d.AddMember("devices", std::move(a), d.GetAllocator());
-        if (device.qos.has_value())
-        {
-            d.AddMember("qos",
-                Value().SetInt(device.qos.value()),
-                d.GetAllocator());
-        }
-        if (device.payload_home.has_value())
-        {
-            d.AddMember("pl_home",
-                Value().SetString(StringRef(device.payload_home.value().data(),
-                    device.payload_home.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_not_home.has_value())
-        {
-            d.AddMember("pl_not_home",
-                Value().SetString(
-                    StringRef(device.payload_not_home.value().data(),
-                        device.payload_not_home.value().size())),
-                d.GetAllocator());
-        }
-        if (device.source_type.has_value())
-        {
-            d.AddMember("src_type",
-                Value().SetString(StringRef(device.source_type.value().data(),
-                    device.source_type.value().size())),
-                d.GetAllocator());
-        }
-        return d;
+        return serialize_entity(device, mode);
     }
 
-    rapidjson::Document serialize(const device_trigger_type& device) noexcept
+    rapidjson::Document serialize(
+        const camera_type& device, payload_mode mode) noexcept
     {
-        using namespace rapidjson;
-        Document d;
-        d.SetObject();
+        return serialize_entity(device, mode);
+    }
 
-        serialize_device_type(device.device, d);
-
-        d.AddMember("atype",
-            Value().SetString(StringRef(device.automation_type.data(),
-                device.automation_type.size())),
-            d.GetAllocator());
-        d.AddMember("stype",
-            Value().SetString(
-                StringRef(device.subtype.data(), device.subtype.size())),
-            d.GetAllocator());
-        d.AddMember("t",
-            Value().SetString(
-                StringRef(device.topic.data(), device.topic.size())),
-            d.GetAllocator());
-        d.AddMember("type",
-            Value().SetString(
-                StringRef(device.type.data(), device.type.size())),
-            d.GetAllocator());
-        if (device.qos.has_value())
-        {
-            d.AddMember("qos",
-                Value().SetInt(device.qos.value()),
-                d.GetAllocator());
-        }
-        if (device.payload.has_value())
-        {
-            d.AddMember("pl",
-                Value().SetString(StringRef(device.payload.value().data(),
-                    device.payload.value().size())),
-                d.GetAllocator());
-        }
-        return d;
+    rapidjson::Document serialize(
+        const cover_type& device, payload_mode mode) noexcept
+    {
+        return serialize_entity(device, mode);
     }
 
-    rapidjson::Document serialize(const fan_type& device) noexcept
+    rapidjson::Document serialize(
+        const device_tracker_type& device, payload_mode mode) noexcept
     {
-        using namespace rapidjson;
-        Document d;
-        d.SetObject();
-        d.AddMember("cmd_t",
-            Value().SetString(StringRef(device.command_topic.data(),
-                device.command_topic.size())),
-            d.GetAllocator());
-        if (device.enabled_by_default.has_value())
-        {
-            d.AddMember("enabled_by_default",
-                Value().SetBool(device.enabled_by_default.value()),
-                d.GetAllocator());
-        }
-        if (device.optimistic.has_value())
-        {
-            d.AddMember("opt",
-                Value().SetBool(device.optimistic.value()),
-                d.GetAllocator());
-        }
-        if (device.retain.has_value())
-        {
-            d.AddMember("ret",
-                Value().SetBool(device.retain.value()),
-                d.GetAllocator());
-        }
-        if (device.device.has_value())
-        {
-            serialize_device_type(device.device.value(), d);
-        }
-        if (device.qos.has_value())
-        {
-            d.AddMember("qos",
-                Value().SetInt(device.qos.value()),
-                d.GetAllocator());
-        }
-        if (device.speed_range_max.has_value())
-        {
-            d.AddMember("spd_rng_max",
-                Value().SetInt(device.speed_range_max.value()),
-                d.GetAllocator());
-        }
-        if (device.speed_range_min.has_value())
-        {
-            d.AddMember("spd_rng_min",
-                Value().SetInt(device.speed_range_min.value()),
-                d.GetAllocator());
-        }
-        if (device.availability_mode.has_value())
-        {
-            d.AddMember("avty_mode",
-                Value().SetString(
-                    StringRef(device.availability_mode.value().data(),
-                        device.availability_mode.value().size())),
-                d.GetAllocator());
-        }
-        if (device.availability_topic.has_value())
-        {
-            d.AddMember("avty_t",
-                Value().SetString(
-                    StringRef(device.availability_topic.value().data(),
-                        device.availability_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.command_template.has_value())
-        {
-            d.AddMember("cmd_tpl",
-                Value().SetString(
-                    StringRef(device.command_template.value().data(),
-                        device.command_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.entity_category.has_value())
-        {
-            d.AddMember("entity_category",
-                Value().SetString(
-                    StringRef(device.entity_category.value().data(),
-                        device.entity_category.value().size())),
-                d.GetAllocator());
-        }
-        if (device.icon.has_value())
-        {
-            d.AddMember("ic",
-                Value().SetString(StringRef(device.icon.value().data(),
-                    device.icon.value().size())),
-                d.GetAllocator());
-        }
-        if (device.json_attributes_template.has_value())
-        {
-            d.AddMember("json_attr_tpl",
-                Value().SetString(
-                    StringRef(device.json_attributes_template.value().data(),
-                        device.json_attributes_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.json_attributes_topic.has_value())
-        {
-            d.AddMember("json_attr_t",
-                Value().SetString(
-                    StringRef(device.json_attributes_topic.value().data(),
-                        device.json_attributes_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.name.has_value())
-        {
-            d.AddMember("name",
-                Value().SetString(StringRef(device.name.value().data(),
-                    device.name.value().size())),
-                d.GetAllocator());
-        }
-        if (device.oscillation_command_template.has_value())
-        {
-            d.AddMember("osc_cmd_tpl",
-                Value().SetString(StringRef(
-                    device.oscillation_command_template.value().data(),
-                    device.oscillation_command_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.oscillation_command_topic.has_value())
-        {
-            d.AddMember("osc_cmd_t",
-                Value().SetString(
-                    StringRef(device.oscillation_command_topic.value().data(),
-                        device.oscillation_command_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.oscillation_state_topic.has_value())
-        {
-            d.AddMember("osc_stat_t",
-                Value().SetString(
-                    StringRef(device.oscillation_state_topic.value().data(),
-                        device.oscillation_state_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.oscillation_value_template.has_value())
-        {
-            d.AddMember("osc_val_tpl",
-                Value().SetString(
-                    StringRef(device.oscillation_value_template.value().data(),
-                        device.oscillation_value_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_available.has_value())
-        {
-            d.AddMember("pl_avail",
-                Value().SetString(
-                    StringRef(device.payload_available.value().data(),
-                        device.payload_available.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_not_available.has_value())
-        {
-            d.AddMember("pl_not_avail",
-                Value().SetString(
-                    StringRef(device.payload_not_available.value().data(),
-                        device.payload_not_available.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_off.has_value())
-        {
-            d.AddMember("pl_off",
-                Value().SetString(StringRef(device.payload_off.value().data(),
-                    device.payload_off.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_on.has_value())
-        {
-            d.AddMember("pl_on",
-                Value().SetString(StringRef(device.payload_on.value().data(),
-                    device.payload_on.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_oscillation_off.has_value())
-        {
-            d.AddMember("pl_osc_off",
-                Value().SetString(
-                    StringRef(device.payload_oscillation_off.value().data(),
-                        device.payload_oscillation_off.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_oscillation_on.has_value())
-        {
-            d.AddMember("pl_osc_on",
-                Value().SetString(
-                    StringRef(device.payload_oscillation_on.value().data(),
-                        device.payload_oscillation_on.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_reset_percentage.has_value())
-        {
-            d.AddMember("pl_rst_pct",
-                Value().SetString(
-                    StringRef(device.payload_reset_percentage.value().data(),
-                        device.payload_reset_percentage.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_reset_preset_mode.has_value())
-        {
-            d.AddMember("pl_rst_pr_mode",
-                Value().SetString(
-                    StringRef(device.payload_reset_preset_mode.value().data(),
-                        device.payload_reset_preset_mode.value().size())),
-                d.GetAllocator());
-        }
-        if (device.percentage_command_template.has_value())
-        {
-            d.AddMember("pct_cmd_tpl",
-                Value().SetString(
-                    StringRef(device.percentage_command_template.value().data(),
-                        device.percentage_command_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.percentage_command_topic.has_value())
-        {
-            d.AddMember("pct_cmd_t",
-                Value().SetString(
-                    StringRef(device.percentage_command_topic.value().data(),
-                        device.percentage_command_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.percentage_state_topic.has_value())
-        {
-            d.AddMember("pct_stat_t",
-                Value().SetString(
-                    StringRef(device.percentage_state_topic.value().data(),
-                        device.percentage_state_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.percentage_value_template.has_value())
-        {
-            d.AddMember("pct_val_tpl",
-                Value().SetString(
-                    StringRef(device.percentage_value_template.value().data(),
-                        device.percentage_value_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.preset_mode_command_template.has_value())
-        {
-            d.AddMember("pr_mode_cmd_tpl",
-                Value().SetString(StringRef(
-                    device.preset_mode_command_template.value().data(),
-                    device.preset_mode_command_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.preset_mode_command_topic.has_value())
-        {
-            d.AddMember("pr_mode_cmd_t",
-                Value().SetString(
-                    StringRef(device.preset_mode_command_topic.value().data(),
-                        device.preset_mode_command_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.preset_mode_state_topic.has_value())
-        {
-            d.AddMember("pr_mode_stat_t",
-                Value().SetString(
-                    StringRef(device.preset_mode_state_topic.value().data(),
-                        device.preset_mode_state_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.preset_mode_value_template.has_value())
-        {
-            d.AddMember("pr_mode_val_tpl",
-                Value().SetString(
-                    StringRef(device.preset_mode_value_template.value().data(),
-                        device.preset_mode_value_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.state_topic.has_value())
-        {
-            d.AddMember("stat_t",
-                Value().SetString(StringRef(device.state_topic.value().data(),
-                    device.state_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.state_value_template.has_value())
-        {
-            d.AddMember("stat_val_tpl",
-                Value().SetString(
-                    StringRef(device.state_value_template.value().data(),
-                        device.state_value_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.unique_id.has_value())
-        {
-            d.AddMember("uniq_id",
-                Value().SetString(StringRef(device.unique_id.value().data(),
-                    device.unique_id.value().size())),
-                d.GetAllocator());
-        }
-        if (device.availability.has_value())
-        {
-            Value a;
-            a.SetArray();
-            for (const auto& str : device.availability.value())
-            {
-                a.PushBack(Value().SetString(StringRef(str.data(), str.size())),
-                    d.GetAllocator());
-            }
-            d.AddMember("avty", std::move(a), d.GetAllocator());
-        }
-        if (device.preset_modes.has_value())
-        {
-            Value a;
-            a.SetArray();
-            for (const auto& str : device.preset_modes.value())
-            {
-                a.PushBack(Value().SetString(StringRef(str.data(), str.size())),
-                    d.GetAllocator());
-            }
-            d.AddMember("pr_modes", std::move(a), d.GetAllocator());
-        }
-        return d;
+        return serialize_entity(device, mode);
     }
 
-    rapidjson::Document serialize(const humidifier_type& device) noexcept
+    rapidjson::Document serialize(
+        const device_trigger_type& device, payload_mode mode) noexcept
+    {
+        return serialize_entity(device, mode);
+    }
+
+    rapidjson::Document serialize(
+        const fan_type& device, payload_mode mode) noexcept
+    {
+        return serialize_entity(device, mode);
+    }
+
+    rapidjson::Document serialize(
+        const humidifier_type& device, payload_mode mode) noexcept
+    {
+        return serialize_entity(device, mode);
+    }
+
+    rapidjson::Document serialize(
+        const light_type& device, payload_mode mode) noexcept
+    {
+        return serialize_entity(device, mode);
+    }
+
+    rapidjson::Document serialize(
+        const lock_type& device, payload_mode mode) noexcept
+    {
+        return serialize_entity(device, mode);
+    }
+
+    rapidjson::Document serialize(
+        const number_type& device, payload_mode mode) noexcept
+    {
+        return serialize_entity(device, mode);
+    }
+
+    rapidjson::Document serialize(
+        const scene_type& device, payload_mode mode) noexcept
+    {
+        return serialize_entity(device, mode);
+    }
+
+    rapidjson::Document serialize(
+        const select_type& device, payload_mode mode) noexcept
+    {
+        return serialize_entity(device, mode);
+    }
+
+    rapidjson::Document serialize(
+        const sensor_type& device, payload_mode mode) noexcept
+    {
+        return serialize_entity(device, mode);
+    }
+
+    rapidjson::Document serialize(
+        const switch_type& device, payload_mode mode) noexcept
+    {
+        return serialize_entity(device, mode);
+    }
+
+    rapidjson::Document serialize(
+        const vacuum_type& device, payload_mode mode) noexcept
+    {
+        return serialize_entity(device, mode);
+    }
+
+    rapidjson::Document serialize(
+        const device_discovery_type& discovery, payload_mode mode) noexcept
     {
-        using namespace rapidjson;
-        Document d;
+        rapidjson::Document d;
         d.SetObject();
-        d.AddMember("cmd_t",
-            Value().SetString(StringRef(device.command_topic.data(),
-                device.command_topic.size())),
-            d.GetAllocator());
-        d.AddMember("hum_cmd_t",
-            Value().SetString(
-                StringRef(device.target_humidity_command_topic.data(),
-                    device.target_humidity_command_topic.size())),
-            d.GetAllocator());
-        if (device.enabled_by_default.has_value())
-        {
-            d.AddMember("enabled_by_default",
-                Value().SetBool(device.enabled_by_default.value()),
-                d.GetAllocator());
-        }
-        if (device.optimistic.has_value())
-        {
-            d.AddMember("opt",
-                Value().SetBool(device.optimistic.value()),
-                d.GetAllocator());
-        }
-        if (device.retain.has_value())
-        {
-            d.AddMember("ret",
-                Value().SetBool(device.retain.value()),
-                d.GetAllocator());
-        }
-        if (device.device.has_value())
-        {
-            serialize_device_type(device.device.value(), d);
-        }
-        if (device.max_humidity.has_value())
-        {
-            d.AddMember("max_hum",
-                Value().SetInt(device.max_humidity.value()),
-                d.GetAllocator());
-        }
-        if (device.min_humidity.has_value())
-        {
-            d.AddMember("min_hum",
-                Value().SetInt(device.min_humidity.value()),
-                d.GetAllocator());
-        }
-        if (device.qos.has_value())
+
+        auto& allocator = d.GetAllocator();
+
+        add_device(d, "dev", discovery.device, allocator);
+
+        rapidjson::Value origin(rapidjson::kObjectType);
+        add_fields<ORIGIN_FIELDS>(origin, discovery.origin, false, allocator);
+        d.AddMember("o", std::move(origin), allocator);
+
+        rapidjson::Value components(rapidjson::kObjectType);
+        for (const component_type& component : discovery.components)
         {
-            d.AddMember("qos",
-                Value().SetInt(device.qos.value()),
-                d.GetAllocator());
+            add_component(components, component, mode, allocator);
         }
-        if (device.availability_mode.has_value())
+        d.AddMember("cmps", std::move(components), allocator);
+
+        constexpr default_value qos_default =
+            DEFAULTS[find_default("qos", field_kind::optional_int)];
+
+        if (discovery.qos.has_value() &&
+            !(mode == payload_mode::minimal &&
+                is_default(qos_default, discovery.qos.value())))
         {
-            d.AddMember("avty_mode",
-                Value().SetString(
-                    StringRef(device.availability_mode.value().data(),
-                        device.availability_mode.value().size())),
-                d.GetAllocator());
+            add_int(d, "qos", discovery.qos.value(), allocator);
         }
-        if (device.availability_topic.has_value())
+
+        if (discovery.state_topic.has_value())
         {
-            d.AddMember("avty_t",
-                Value().SetString(
-                    StringRef(device.availability_topic.value().data(),
-                        device.availability_topic.value().size())),
-                d.GetAllocator());
+            add_string(d, "stat_t", discovery.state_topic.value(), allocator);
         }
-        if (device.command_template.has_value())
-        {
-            d.AddMember("cmd_tpl",
-                Value().SetString(
-                    StringRef(device.command_template.value().data(),
-                        device.command_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.device_class.has_value())
-        {
-            d.AddMember("dev_cla",
-                Value().SetString(StringRef(device.device_class.value().data(),
-                    device.device_class.value().size())),
-                d.GetAllocator());
-        }
-        if (device.entity_category.has_value())
-        {
-            d.AddMember("entity_category",
-                Value().SetString(
-                    StringRef(device.entity_category.value().data(),
-                        device.entity_category.value().size())),
-                d.GetAllocator());
-        }
-        if (device.icon.has_value())
-        {
-            d.AddMember("ic",
-                Value().SetString(StringRef(device.icon.value().data(),
-                    device.icon.value().size())),
-                d.GetAllocator());
-        }
-        if (device.json_attributes_template.has_value())
-        {
-            d.AddMember("json_attr_tpl",
-                Value().SetString(
-                    StringRef(device.json_attributes_template.value().data(),
-                        device.json_attributes_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.json_attributes_topic.has_value())
-        {
-            d.AddMember("json_attr_t",
-                Value().SetString(
-                    StringRef(device.json_attributes_topic.value().data(),
-                        device.json_attributes_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.mode_command_template.has_value())
-        {
-            d.AddMember("mode_cmd_tpl",
-                Value().SetString(
-                    StringRef(device.mode_command_template.value().data(),
-                        device.mode_command_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.mode_command_topic.has_value())
-        {
-            d.AddMember("mode_cmd_t",
-                Value().SetString(
-                    StringRef(device.mode_command_topic.value().data(),
-                        device.mode_command_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.mode_state_template.has_value())
-        {
-            d.AddMember("mode_stat_tpl",
-                Value().SetString(
-                    StringRef(device.mode_state_template.value().data(),
-                        device.mode_state_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.mode_state_topic.has_value())
-        {
-            d.AddMember("mode_stat_t",
-                Value().SetString(
-                    StringRef(device.mode_state_topic.value().data(),
-                        device.mode_state_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.name.has_value())
-        {
-            d.AddMember("name",
-                Value().SetString(StringRef(device.name.value().data(),
-                    device.name.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_available.has_value())
-        {
-            d.AddMember("pl_avail",
-                Value().SetString(
-                    StringRef(device.payload_available.value().data(),
-                        device.payload_available.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_not_available.has_value())
-        {
-            d.AddMember("pl_not_avail",
-                Value().SetString(
-                    StringRef(device.payload_not_available.value().data(),
-                        device.payload_not_available.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_off.has_value())
-        {
-            d.AddMember("pl_off",
-                Value().SetString(StringRef(device.payload_off.value().data(),
-                    device.payload_off.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_on.has_value())
-        {
-            d.AddMember("pl_on",
-                Value().SetString(StringRef(device.payload_on.value().data(),
-                    device.payload_on.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_reset_humidity.has_value())
-        {
-            d.AddMember("pl_rst_hum",
-                Value().SetString(
-                    StringRef(device.payload_reset_humidity.value().data(),
-                        device.payload_reset_humidity.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_reset_mode.has_value())
-        {
-            d.AddMember("pl_rst_mode",
-                Value().SetString(
-                    StringRef(device.payload_reset_mode.value().data(),
-                        device.payload_reset_mode.value().size())),
-                d.GetAllocator());
-        }
-        if (device.state_topic.has_value())
-        {
-            d.AddMember("stat_t",
-                Value().SetString(StringRef(device.state_topic.value().data(),
-                    device.state_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.state_value_template.has_value())
-        {
-            d.AddMember("stat_val_tpl",
-                Value().SetString(
-                    StringRef(device.state_value_template.value().data(),
-                        device.state_value_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.target_humidity_command_template.has_value())
-        {
-            d.AddMember("hum_cmd_tpl",
-                Value().SetString(StringRef(
-                    device.target_humidity_command_template.value().data(),
-                    device.target_humidity_command_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.target_humidity_state_template.has_value())
-        {
-            d.AddMember("hum_stat_tpl",
-                Value().SetString(StringRef(
-                    device.target_humidity_state_template.value().data(),
-                    device.target_humidity_state_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.target_humidity_state_topic.has_value())
-        {
-            d.AddMember("hum_stat_t",
-                Value().SetString(
-                    StringRef(device.target_humidity_state_topic.value().data(),
-                        device.target_humidity_state_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.unique_id.has_value())
-        {
-            d.AddMember("uniq_id",
-                Value().SetString(StringRef(device.unique_id.value().data(),
-                    device.unique_id.value().size())),
-                d.GetAllocator());
-        }
-        if (device.availability.has_value())
-        {
-            Value a;
-            a.SetArray();
-            for (const auto& str : device.availability.value())
-            {
-                a.PushBack(Value().SetString(StringRef(str.data(), str.size())),
-                    d.GetAllocator());
-            }
-            d.AddMember("avty", std::move(a), d.GetAllocator());
-        }
-        if (device.modes.has_value())
-        {
-            Value a;
-            a.SetArray();
-            for (const auto& str : device.modes.value())
-            {
-                a.PushBack(Value().SetString(StringRef(str.data(), str.size())),
-                    d.GetAllocator());
-            }
-            d.AddMember("modes", std::move(a), d.GetAllocator());
-        }
-        return d;
-    }
-
-    rapidjson::Document serialize(const light_type& device) noexcept
-    {
-        using namespace rapidjson;
-        Document d;
-        d.SetObject();
-        d.AddMember("cmd_t",
-            Value().SetString(StringRef(device.command_topic.data(),
-                device.command_topic.size())),
-            d.GetAllocator());
-        if (device.enabled_by_default.has_value())
-        {
-            d.AddMember("enabled_by_default",
-                Value().SetBool(device.enabled_by_default.value()),
-                d.GetAllocator());
-        }
-        if (device.optimistic.has_value())
-        {
-            d.AddMember("opt",
-                Value().SetBool(device.optimistic.value()),
-                d.GetAllocator());
-        }
-        if (device.retain.has_value())
-        {
-            d.AddMember("ret",
-                Value().SetBool(device.retain.value()),
-                d.GetAllocator());
-        }
-        if (device.device.has_value())
-        {
-            serialize_device_type(device.device.value(), d);
-        }
-        if (device.brightness_scale.has_value())
-        {
-            d.AddMember("bri_scl",
-                Value().SetInt(device.brightness_scale.value()),
-                d.GetAllocator());
-        }
-        if (device.max_mireds.has_value())
-        {
-            d.AddMember("max_mirs",
-                Value().SetInt(device.max_mireds.value()),
-                d.GetAllocator());
-        }
-        if (device.min_mireds.has_value())
-        {
-            d.AddMember("min_mirs",
-                Value().SetInt(device.min_mireds.value()),
-                d.GetAllocator());
-        }
-        if (device.qos.has_value())
-        {
-            d.AddMember("qos",
-                Value().SetInt(device.qos.value()),
-                d.GetAllocator());
-        }
-        if (device.white_scale.has_value())
-        {
-            d.AddMember("white_scale",
-                Value().SetInt(device.white_scale.value()),
-                d.GetAllocator());
-        }
-        if (device.availability_mode.has_value())
-        {
-            d.AddMember("avty_mode",
-                Value().SetString(
-                    StringRef(device.availability_mode.value().data(),
-                        device.availability_mode.value().size())),
-                d.GetAllocator());
-        }
-        if (device.availability_topic.has_value())
-        {
-            d.AddMember("avty_t",
-                Value().SetString(
-                    StringRef(device.availability_topic.value().data(),
-                        device.availability_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.brightness_command_topic.has_value())
-        {
-            d.AddMember("bri_cmd_t",
-                Value().SetString(
-                    StringRef(device.brightness_command_topic.value().data(),
-                        device.brightness_command_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.brightness_state_topic.has_value())
-        {
-            d.AddMember("bri_stat_t",
-                Value().SetString(
-                    StringRef(device.brightness_state_topic.value().data(),
-                        device.brightness_state_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.brightness_value_template.has_value())
-        {
-            d.AddMember("bri_val_tpl",
-                Value().SetString(
-                    StringRef(device.brightness_value_template.value().data(),
-                        device.brightness_value_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.color_mode_state_topic.has_value())
-        {
-            d.AddMember("color_mode_state_topic",
-                Value().SetString(
-                    StringRef(device.color_mode_state_topic.value().data(),
-                        device.color_mode_state_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.color_mode_value_template.has_value())
-        {
-            d.AddMember("color_mode_value_template",
-                Value().SetString(
-                    StringRef(device.color_mode_value_template.value().data(),
-                        device.color_mode_value_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.color_temp_command_template.has_value())
-        {
-            d.AddMember("clr_temp_cmd_tpl",
-                Value().SetString(
-                    StringRef(device.color_temp_command_template.value().data(),
-                        device.color_temp_command_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.color_temp_command_topic.has_value())
-        {
-            d.AddMember("clr_temp_cmd_t",
-                Value().SetString(
-                    StringRef(device.color_temp_command_topic.value().data(),
-                        device.color_temp_command_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.color_temp_state_topic.has_value())
-        {
-            d.AddMember("clr_temp_stat_t",
-                Value().SetString(
-                    StringRef(device.color_temp_state_topic.value().data(),
-                        device.color_temp_state_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.color_temp_value_template.has_value())
-        {
-            d.AddMember("clr_temp_val_tpl",
-                Value().SetString(
-                    StringRef(device.color_temp_value_template.value().data(),
-                        device.color_temp_value_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.effect_command_topic.has_value())
-        {
-            d.AddMember("fx_cmd_t",
-                Value().SetString(
-                    StringRef(device.effect_command_topic.value().data(),
-                        device.effect_command_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.effect_state_topic.has_value())
-        {
-            d.AddMember("fx_stat_t",
-                Value().SetString(
-                    StringRef(device.effect_state_topic.value().data(),
-                        device.effect_state_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.effect_value_template.has_value())
-        {
-            d.AddMember("fx_val_tpl",
-                Value().SetString(
-                    StringRef(device.effect_value_template.value().data(),
-                        device.effect_value_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.entity_category.has_value())
-        {
-            d.AddMember("entity_category",
-                Value().SetString(
-                    StringRef(device.entity_category.value().data(),
-                        device.entity_category.value().size())),
-                d.GetAllocator());
-        }
-        if (device.hs_command_topic.has_value())
-        {
-            d.AddMember("hs_cmd_t",
-                Value().SetString(
-                    StringRef(device.hs_command_topic.value().data(),
-                        device.hs_command_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.hs_state_topic.has_value())
-        {
-            d.AddMember("hs_stat_t",
-                Value().SetString(
-                    StringRef(device.hs_state_topic.value().data(),
-                        device.hs_state_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.hs_value_template.has_value())
-        {
-            d.AddMember("hs_val_tpl",
-                Value().SetString(
-                    StringRef(device.hs_value_template.value().data(),
-                        device.hs_value_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.icon.has_value())
-        {
-            d.AddMember("ic",
-                Value().SetString(StringRef(device.icon.value().data(),
-                    device.icon.value().size())),
-                d.GetAllocator());
-        }
-        if (device.json_attributes_template.has_value())
-        {
-            d.AddMember("json_attr_tpl",
-                Value().SetString(
-                    StringRef(device.json_attributes_template.value().data(),
-                        device.json_attributes_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.json_attributes_topic.has_value())
-        {
-            d.AddMember("json_attr_t",
-                Value().SetString(
-                    StringRef(device.json_attributes_topic.value().data(),
-                        device.json_attributes_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.name.has_value())
-        {
-            d.AddMember("name",
-                Value().SetString(StringRef(device.name.value().data(),
-                    device.name.value().size())),
-                d.GetAllocator());
-        }
-        if (device.on_command_type.has_value())
-        {
-            d.AddMember("on_cmd_type",
-                Value().SetString(
-                    StringRef(device.on_command_type.value().data(),
-                        device.on_command_type.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_available.has_value())
-        {
-            d.AddMember("pl_avail",
-                Value().SetString(
-                    StringRef(device.payload_available.value().data(),
-                        device.payload_available.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_not_available.has_value())
-        {
-            d.AddMember("pl_not_avail",
-                Value().SetString(
-                    StringRef(device.payload_not_available.value().data(),
-                        device.payload_not_available.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_off.has_value())
-        {
-            d.AddMember("pl_off",
-                Value().SetString(StringRef(device.payload_off.value().data(),
-                    device.payload_off.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_on.has_value())
-        {
-            d.AddMember("pl_on",
-                Value().SetString(StringRef(device.payload_on.value().data(),
-                    device.payload_on.value().size())),
-                d.GetAllocator());
-        }
-        if (device.rgb_command_template.has_value())
-        {
-            d.AddMember("rgb_cmd_tpl",
-                Value().SetString(
-                    StringRef(device.rgb_command_template.value().data(),
-                        device.rgb_command_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.rgb_command_topic.has_value())
-        {
-            d.AddMember("rgb_cmd_t",
-                Value().SetString(
-                    StringRef(device.rgb_command_topic.value().data(),
-                        device.rgb_command_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.rgb_state_topic.has_value())
-        {
-            d.AddMember("rgb_stat_t",
-                Value().SetString(
-                    StringRef(device.rgb_state_topic.value().data(),
-                        device.rgb_state_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.rgb_value_template.has_value())
-        {
-            d.AddMember("rgb_val_tpl",
-                Value().SetString(
-                    StringRef(device.rgb_value_template.value().data(),
-                        device.rgb_value_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.schema.has_value())
-        {
-            d.AddMember("schema",
-                Value().SetString(StringRef(device.schema.value().data(),
-                    device.schema.value().size())),
-                d.GetAllocator());
-        }
-        if (device.state_topic.has_value())
-        {
-            d.AddMember("stat_t",
-                Value().SetString(StringRef(device.state_topic.value().data(),
-                    device.state_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.state_value_template.has_value())
-        {
-            d.AddMember("stat_val_tpl",
-                Value().SetString(
-                    StringRef(device.state_value_template.value().data(),
-                        device.state_value_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.unique_id.has_value())
-        {
-            d.AddMember("uniq_id",
-                Value().SetString(StringRef(device.unique_id.value().data(),
-                    device.unique_id.value().size())),
-                d.GetAllocator());
-        }
-        if (device.white_command_topic.has_value())
-        {
-            d.AddMember("white_command_topic",
-                Value().SetString(
-                    StringRef(device.white_command_topic.value().data(),
-                        device.white_command_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.xy_command_topic.has_value())
-        {
-            d.AddMember("xy_cmd_t",
-                Value().SetString(
-                    StringRef(device.xy_command_topic.value().data(),
-                        device.xy_command_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.xy_state_topic.has_value())
-        {
-            d.AddMember("xy_stat_t",
-                Value().SetString(
-                    StringRef(device.xy_state_topic.value().data(),
-                        device.xy_state_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.xy_value_template.has_value())
-        {
-            d.AddMember("xy_val_tpl",
-                Value().SetString(
-                    StringRef(device.xy_value_template.value().data(),
-                        device.xy_value_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.availability.has_value())
-        {
-            Value a;
-            a.SetArray();
-            for (const auto& str : device.availability.value())
-            {
-                a.PushBack(Value().SetString(StringRef(str.data(), str.size())),
-                    d.GetAllocator());
-            }
-            d.AddMember("avty", std::move(a), d.GetAllocator());
-        }
-        if (device.effect_list.has_value())
-        {
-            Value a;
-            a.SetArray();
-            for (const auto& str : device.effect_list.value())
-            {
-                a.PushBack(Value().SetString(StringRef(str.data(), str.size())),
-                    d.GetAllocator());
-            }
-            d.AddMember("fx_list", std::move(a), d.GetAllocator());
-        }
-        return d;
-    }
-
-    rapidjson::Document serialize(const lock_type& device) noexcept
-    {
-        using namespace rapidjson;
-        Document d;
-        d.SetObject();
-        d.AddMember("cmd_t",
-            Value().SetString(StringRef(device.command_topic.data(),
-                device.command_topic.size())),
-            d.GetAllocator());
-        if (device.enabled_by_default.has_value())
-        {
-            d.AddMember("enabled_by_default",
-                Value().SetBool(device.enabled_by_default.value()),
-                d.GetAllocator());
-        }
-        if (device.optimistic.has_value())
-        {
-            d.AddMember("opt",
-                Value().SetBool(device.optimistic.value()),
-                d.GetAllocator());
-        }
-        if (device.retain.has_value())
-        {
-            d.AddMember("ret",
-                Value().SetBool(device.retain.value()),
-                d.GetAllocator());
-        }
-        if (device.device.has_value())
-        {
-            serialize_device_type(device.device.value(), d);
-        }
-        if (device.qos.has_value())
-        {
-            d.AddMember("qos",
-                Value().SetInt(device.qos.value()),
-                d.GetAllocator());
-        }
-        if (device.availability_mode.has_value())
-        {
-            d.AddMember("avty_mode",
-                Value().SetString(
-                    StringRef(device.availability_mode.value().data(),
-                        device.availability_mode.value().size())),
-                d.GetAllocator());
-        }
-        if (device.availability_topic.has_value())
-        {
-            d.AddMember("avty_t",
-                Value().SetString(
-                    StringRef(device.availability_topic.value().data(),
-                        device.availability_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.entity_category.has_value())
-        {
-            d.AddMember("entity_category",
-                Value().SetString(
-                    StringRef(device.entity_category.value().data(),
-                        device.entity_category.value().size())),
-                d.GetAllocator());
-        }
-        if (device.icon.has_value())
-        {
-            d.AddMember("ic",
-                Value().SetString(StringRef(device.icon.value().data(),
-                    device.icon.value().size())),
-                d.GetAllocator());
-        }
-        if (device.json_attributes_template.has_value())
-        {
-            d.AddMember("json_attr_tpl",
-                Value().SetString(
-                    StringRef(device.json_attributes_template.value().data(),
-                        device.json_attributes_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.json_attributes_topic.has_value())
-        {
-            d.AddMember("json_attr_t",
-                Value().SetString(
-                    StringRef(device.json_attributes_topic.value().data(),
-                        device.json_attributes_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.name.has_value())
-        {
-            d.AddMember("name",
-                Value().SetString(StringRef(device.name.value().data(),
-                    device.name.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_available.has_value())
-        {
-            d.AddMember("pl_avail",
-                Value().SetString(
-                    StringRef(device.payload_available.value().data(),
-                        device.payload_available.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_lock.has_value())
-        {
-            d.AddMember("pl_lock",
-                Value().SetString(StringRef(device.payload_lock.value().data(),
-                    device.payload_lock.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_not_available.has_value())
-        {
-            d.AddMember("pl_not_avail",
-                Value().SetString(
-                    StringRef(device.payload_not_available.value().data(),
-                        device.payload_not_available.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_unlock.has_value())
-        {
-            d.AddMember("pl_unlk",
-                Value().SetString(
-                    StringRef(device.payload_unlock.value().data(),
-                        device.payload_unlock.value().size())),
-                d.GetAllocator());
-        }
-        if (device.state_locked.has_value())
-        {
-            d.AddMember("stat_locked",
-                Value().SetString(StringRef(device.state_locked.value().data(),
-                    device.state_locked.value().size())),
-                d.GetAllocator());
-        }
-        if (device.state_topic.has_value())
-        {
-            d.AddMember("stat_t",
-                Value().SetString(StringRef(device.state_topic.value().data(),
-                    device.state_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.state_unlocked.has_value())
-        {
-            d.AddMember("stat_unlocked",
-                Value().SetString(
-                    StringRef(device.state_unlocked.value().data(),
-                        device.state_unlocked.value().size())),
-                d.GetAllocator());
-        }
-        if (device.unique_id.has_value())
-        {
-            d.AddMember("uniq_id",
-                Value().SetString(StringRef(device.unique_id.value().data(),
-                    device.unique_id.value().size())),
-                d.GetAllocator());
-        }
-        if (device.value_template.has_value())
-        {
-            d.AddMember("val_tpl",
-                Value().SetString(
-                    StringRef(device.value_template.value().data(),
-                        device.value_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.availability.has_value())
-        {
-            Value a;
-            a.SetArray();
-            for (const auto& str : device.availability.value())
-            {
-                a.PushBack(Value().SetString(StringRef(str.data(), str.size())),
-                    d.GetAllocator());
-            }
-            d.AddMember("avty", std::move(a), d.GetAllocator());
-        }
-        return d;
-    }
-
-    rapidjson::Document serialize(const number_type& device) noexcept
-    {
-        using namespace rapidjson;
-        Document d;
-        d.SetObject();
-        if (device.enabled_by_default.has_value())
-        {
-            d.AddMember("enabled_by_default",
-                Value().SetBool(device.enabled_by_default.value()),
-                d.GetAllocator());
-        }
-        if (device.optimistic.has_value())
-        {
-            d.AddMember("opt",
-                Value().SetBool(device.optimistic.value()),
-                d.GetAllocator());
-        }
-        if (device.retain.has_value())
-        {
-            d.AddMember("ret",
-                Value().SetBool(device.retain.value()),
-                d.GetAllocator());
-        }
-        if (device.device.has_value())
-        {
-            serialize_device_type(device.device.value(), d);
-        }
-        if (device.max.has_value())
-        {
-            d.AddMember("max",
-                Value().SetDouble(device.max.value()),
-                d.GetAllocator());
-        }
-        if (device.min.has_value())
-        {
-            d.AddMember("min",
-                Value().SetDouble(device.min.value()),
-                d.GetAllocator());
-        }
-        if (device.step.has_value())
-        {
-            d.AddMember("step",
-                Value().SetDouble(device.step.value()),
-                d.GetAllocator());
-        }
-        if (device.qos.has_value())
-        {
-            d.AddMember("qos",
-                Value().SetInt(device.qos.value()),
-                d.GetAllocator());
-        }
-        if (device.availability_mode.has_value())
-        {
-            d.AddMember("avty_mode",
-                Value().SetString(
-                    StringRef(device.availability_mode.value().data(),
-                        device.availability_mode.value().size())),
-                d.GetAllocator());
-        }
-        if (device.availability_topic.has_value())
-        {
-            d.AddMember("avty_t",
-                Value().SetString(
-                    StringRef(device.availability_topic.value().data(),
-                        device.availability_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.command_topic.has_value())
-        {
-            d.AddMember("cmd_t",
-                Value().SetString(StringRef(device.command_topic.value().data(),
-                    device.command_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.entity_category.has_value())
-        {
-            d.AddMember("entity_category",
-                Value().SetString(
-                    StringRef(device.entity_category.value().data(),
-                        device.entity_category.value().size())),
-                d.GetAllocator());
-        }
-        if (device.icon.has_value())
-        {
-            d.AddMember("ic",
-                Value().SetString(StringRef(device.icon.value().data(),
-                    device.icon.value().size())),
-                d.GetAllocator());
-        }
-        if (device.json_attributes_template.has_value())
-        {
-            d.AddMember("json_attr_tpl",
-                Value().SetString(
-                    StringRef(device.json_attributes_template.value().data(),
-                        device.json_attributes_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.json_attributes_topic.has_value())
-        {
-            d.AddMember("json_attr_t",
-                Value().SetString(
-                    StringRef(device.json_attributes_topic.value().data(),
-                        device.json_attributes_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.name.has_value())
-        {
-            d.AddMember("name",
-                Value().SetString(StringRef(device.name.value().data(),
-                    device.name.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_reset.has_value())
-        {
-            d.AddMember("payload_reset",
-                Value().SetString(StringRef(device.payload_reset.value().data(),
-                    device.payload_reset.value().size())),
-                d.GetAllocator());
-        }
-        if (device.state_topic.has_value())
-        {
-            d.AddMember("stat_t",
-                Value().SetString(StringRef(device.state_topic.value().data(),
-                    device.state_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.unique_id.has_value())
-        {
-            d.AddMember("uniq_id",
-                Value().SetString(StringRef(device.unique_id.value().data(),
-                    device.unique_id.value().size())),
-                d.GetAllocator());
-        }
-        if (device.unit_of_measurement.has_value())
-        {
-            d.AddMember("unit_of_meas",
-                Value().SetString(
-                    StringRef(device.unit_of_measurement.value().data(),
-                        device.unit_of_measurement.value().size())),
-                d.GetAllocator());
-        }
-        if (device.value_template.has_value())
-        {
-            d.AddMember("val_tpl",
-                Value().SetString(
-                    StringRef(device.value_template.value().data(),
-                        device.value_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.availability.has_value())
-        {
-            Value a;
-            a.SetArray();
-            for (const auto& str : device.availability.value())
-            {
-                a.PushBack(Value().SetString(StringRef(str.data(), str.size())),
-                    d.GetAllocator());
-            }
-            d.AddMember("avty", std::move(a), d.GetAllocator());
-        }
-        return d;
-    }
-
-    rapidjson::Document serialize(const scene_type& device) noexcept
-    {
-        using namespace rapidjson;
-        Document d;
-        d.SetObject();
-        if (device.enabled_by_default.has_value())
-        {
-            d.AddMember("enabled_by_default",
-                Value().SetBool(device.enabled_by_default.value()),
-                d.GetAllocator());
-        }
-        if (device.retain.has_value())
-        {
-            d.AddMember("ret",
-                Value().SetBool(device.retain.value()),
-                d.GetAllocator());
-        }
-        if (device.qos.has_value())
-        {
-            d.AddMember("qos",
-                Value().SetInt(device.qos.value()),
-                d.GetAllocator());
-        }
-        if (device.availability_mode.has_value())
-        {
-            d.AddMember("avty_mode",
-                Value().SetString(
-                    StringRef(device.availability_mode.value().data(),
-                        device.availability_mode.value().size())),
-                d.GetAllocator());
-        }
-        if (device.availability_topic.has_value())
-        {
-            d.AddMember("avty_t",
-                Value().SetString(
-                    StringRef(device.availability_topic.value().data(),
-                        device.availability_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.command_topic.has_value())
-        {
-            d.AddMember("cmd_t",
-                Value().SetString(StringRef(device.command_topic.value().data(),
-                    device.command_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.entity_category.has_value())
-        {
-            d.AddMember("entity_category",
-                Value().SetString(
-                    StringRef(device.entity_category.value().data(),
-                        device.entity_category.value().size())),
-                d.GetAllocator());
-        }
-        if (device.icon.has_value())
-        {
-            d.AddMember("ic",
-                Value().SetString(StringRef(device.icon.value().data(),
-                    device.icon.value().size())),
-                d.GetAllocator());
-        }
-        if (device.name.has_value())
-        {
-            d.AddMember("name",
-                Value().SetString(StringRef(device.name.value().data(),
-                    device.name.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_available.has_value())
-        {
-            d.AddMember("pl_avail",
-                Value().SetString(
-                    StringRef(device.payload_available.value().data(),
-                        device.payload_available.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_not_available.has_value())
-        {
-            d.AddMember("pl_not_avail",
-                Value().SetString(
-                    StringRef(device.payload_not_available.value().data(),
-                        device.payload_not_available.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_on.has_value())
-        {
-            d.AddMember("pl_on",
-                Value().SetString(StringRef(device.payload_on.value().data(),
-                    device.payload_on.value().size())),
-                d.GetAllocator());
-        }
-        if (device.unique_id.has_value())
-        {
-            d.AddMember("uniq_id",
-                Value().SetString(StringRef(device.unique_id.value().data(),
-                    device.unique_id.value().size())),
-                d.GetAllocator());
-        }
-        if (device.availability.has_value())
-        {
-            Value a;
-            a.SetArray();
-            for (const auto& str : device.availability.value())
-            {
-                a.PushBack(Value().SetString(StringRef(str.data(), str.size())),
-                    d.GetAllocator());
-            }
-            d.AddMember("avty", std::move(a), d.GetAllocator());
-        }
-        return d;
-    }
-
-    rapidjson::Document serialize(const select_type& device) noexcept
-    {
-        using namespace rapidjson;
-        Document d;
-        d.SetObject();
-        d.AddMember("cmd_t",
-            Value().SetString(StringRef(device.command_topic.data(),
-                device.command_topic.size())),
-            d.GetAllocator());
-        Value a;
-        a.SetArray();
-        for (const auto& str : device.options)
-        {
-            a.PushBack(Value().SetString(StringRef(str.data(), str.size())),
-                d.GetAllocator());
-        }
-        d.AddMember("options", std::move(a), d.GetAllocator());
-        if (device.enabled_by_default.has_value())
-        {
-            d.AddMember("enabled_by_default",
-                Value().SetBool(device.enabled_by_default.value()),
-                d.GetAllocator());
-        }
-        if (device.optimistic.has_value())
-        {
-            d.AddMember("opt",
-                Value().SetBool(device.optimistic.value()),
-                d.GetAllocator());
-        }
-        if (device.retain.has_value())
-        {
-            d.AddMember("ret",
-                Value().SetBool(device.retain.value()),
-                d.GetAllocator());
-        }
-        if (device.device.has_value())
-        {
-            serialize_device_type(device.device.value(), d);
-        }
-        if (device.qos.has_value())
-        {
-            d.AddMember("qos",
-                Value().SetInt(device.qos.value()),
-                d.GetAllocator());
-        }
-        if (device.availability_mode.has_value())
-        {
-            d.AddMember("avty_mode",
-                Value().SetString(
-                    StringRef(device.availability_mode.value().data(),
-                        device.availability_mode.value().size())),
-                d.GetAllocator());
-        }
-        if (device.availability_topic.has_value())
-        {
-            d.AddMember("avty_t",
-                Value().SetString(
-                    StringRef(device.availability_topic.value().data(),
-                        device.availability_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.entity_category.has_value())
-        {
-            d.AddMember("entity_category",
-                Value().SetString(
-                    StringRef(device.entity_category.value().data(),
-                        device.entity_category.value().size())),
-                d.GetAllocator());
-        }
-        if (device.icon.has_value())
-        {
-            d.AddMember("ic",
-                Value().SetString(StringRef(device.icon.value().data(),
-                    device.icon.value().size())),
-                d.GetAllocator());
-        }
-        if (device.json_attributes_template.has_value())
-        {
-            d.AddMember("json_attr_tpl",
-                Value().SetString(
-                    StringRef(device.json_attributes_template.value().data(),
-                        device.json_attributes_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.json_attributes_topic.has_value())
-        {
-            d.AddMember("json_attr_t",
-                Value().SetString(
-                    StringRef(device.json_attributes_topic.value().data(),
-                        device.json_attributes_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.name.has_value())
-        {
-            d.AddMember("name",
-                Value().SetString(StringRef(device.name.value().data(),
-                    device.name.value().size())),
-                d.GetAllocator());
-        }
-        if (device.state_topic.has_value())
-        {
-            d.AddMember("stat_t",
-                Value().SetString(StringRef(device.state_topic.value().data(),
-                    device.state_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.unique_id.has_value())
-        {
-            d.AddMember("uniq_id",
-                Value().SetString(StringRef(device.unique_id.value().data(),
-                    device.unique_id.value().size())),
-                d.GetAllocator());
-        }
-        if (device.value_template.has_value())
-        {
-            d.AddMember("val_tpl",
-                Value().SetString(
-                    StringRef(device.value_template.value().data(),
-                        device.value_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.availability.has_value())
-        {
-            Value a;
-            a.SetArray();
-            for (const auto& str : device.availability.value())
-            {
-                a.PushBack(Value().SetString(StringRef(str.data(), str.size())),
-                    d.GetAllocator());
-            }
-            d.AddMember("avty", std::move(a), d.GetAllocator());
-        }
-        return d;
-    }
-
-    rapidjson::Document serialize(const sensor_type& device) noexcept
-    {
-        using namespace rapidjson;
-        Document d;
-        d.SetObject();
-        d.AddMember("stat_t",
-            Value().SetString(StringRef(device.state_topic.data(),
-                device.state_topic.size())),
-            d.GetAllocator());
-        if (device.enabled_by_default.has_value())
-        {
-            d.AddMember("enabled_by_default",
-                Value().SetBool(device.enabled_by_default.value()),
-                d.GetAllocator());
-        }
-        if (device.force_update.has_value())
-        {
-            d.AddMember("frc_upd",
-                Value().SetBool(device.force_update.value()),
-                d.GetAllocator());
-        }
-        if (device.device.has_value())
-        {
-            serialize_device_type(device.device.value(), d);
-        }
-        if (device.expire_after.has_value())
-        {
-            d.AddMember("exp_aft",
-                Value().SetInt(device.expire_after.value()),
-                d.GetAllocator());
-        }
-        if (device.qos.has_value())
-        {
-            d.AddMember("qos",
-                Value().SetInt(device.qos.value()),
-                d.GetAllocator());
-        }
-        if (device.availability_mode.has_value())
-        {
-            d.AddMember("avty_mode",
-                Value().SetString(
-                    StringRef(device.availability_mode.value().data(),
-                        device.availability_mode.value().size())),
-                d.GetAllocator());
-        }
-        if (device.availability_topic.has_value())
-        {
-            d.AddMember("avty_t",
-                Value().SetString(
-                    StringRef(device.availability_topic.value().data(),
-                        device.availability_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.device_class.has_value())
-        {
-            d.AddMember("dev_cla",
-                Value().SetString(StringRef(device.device_class.value().data(),
-                    device.device_class.value().size())),
-                d.GetAllocator());
-        }
-        if (device.entity_category.has_value())
-        {
-            d.AddMember("entity_category",
-                Value().SetString(
-                    StringRef(device.entity_category.value().data(),
-                        device.entity_category.value().size())),
-                d.GetAllocator());
-        }
-        if (device.icon.has_value())
-        {
-            d.AddMember("ic",
-                Value().SetString(StringRef(device.icon.value().data(),
-                    device.icon.value().size())),
-                d.GetAllocator());
-        }
-        if (device.json_attributes_template.has_value())
-        {
-            d.AddMember("json_attr_tpl",
-                Value().SetString(
-                    StringRef(device.json_attributes_template.value().data(),
-                        device.json_attributes_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.json_attributes_topic.has_value())
-        {
-            d.AddMember("json_attr_t",
-                Value().SetString(
-                    StringRef(device.json_attributes_topic.value().data(),
-                        device.json_attributes_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.last_reset_value_template.has_value())
-        {
-            d.AddMember("last_reset_value_template",
-                Value().SetString(
-                    StringRef(device.last_reset_value_template.value().data(),
-                        device.last_reset_value_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.name.has_value())
-        {
-            d.AddMember("name",
-                Value().SetString(StringRef(device.name.value().data(),
-                    device.name.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_available.has_value())
-        {
-            d.AddMember("pl_avail",
-                Value().SetString(
-                    StringRef(device.payload_available.value().data(),
-                        device.payload_available.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_not_available.has_value())
-        {
-            d.AddMember("pl_not_avail",
-                Value().SetString(
-                    StringRef(device.payload_not_available.value().data(),
-                        device.payload_not_available.value().size())),
-                d.GetAllocator());
-        }
-        if (device.state_class.has_value())
-        {
-            d.AddMember("stat_cla",
-                Value().SetString(StringRef(device.state_class.value().data(),
-                    device.state_class.value().size())),
-                d.GetAllocator());
-        }
-        if (device.unique_id.has_value())
-        {
-            d.AddMember("uniq_id",
-                Value().SetString(StringRef(device.unique_id.value().data(),
-                    device.unique_id.value().size())),
-                d.GetAllocator());
-        }
-        if (device.unit_of_measurement.has_value())
-        {
-            d.AddMember("unit_of_meas",
-                Value().SetString(
-                    StringRef(device.unit_of_measurement.value().data(),
-                        device.unit_of_measurement.value().size())),
-                d.GetAllocator());
-        }
-        if (device.value_template.has_value())
-        {
-            d.AddMember("val_tpl",
-                Value().SetString(
-                    StringRef(device.value_template.value().data(),
-                        device.value_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.availability.has_value())
-        {
-            Value a;
-            a.SetArray();
-            for (const auto& str : device.availability.value())
-            {
-                a.PushBack(Value().SetString(StringRef(str.data(), str.size())),
-                    d.GetAllocator());
-            }
-            d.AddMember("avty", std::move(a), d.GetAllocator());
-        }
-        return d;
-    }
-
-    rapidjson::Document serialize(const switch_type& device) noexcept
-    {
-        using namespace rapidjson;
-        Document d;
-        d.SetObject();
-        if (device.enabled_by_default.has_value())
-        {
-            d.AddMember("enabled_by_default",
-                Value().SetBool(device.enabled_by_default.value()),
-                d.GetAllocator());
-        }
-        if (device.optimistic.has_value())
-        {
-            d.AddMember("opt",
-                Value().SetBool(device.optimistic.value()),
-                d.GetAllocator());
-        }
-        if (device.retain.has_value())
-        {
-            d.AddMember("ret",
-                Value().SetBool(device.retain.value()),
-                d.GetAllocator());
-        }
-        if (device.device.has_value())
-        {
-            serialize_device_type(device.device.value(), d);
-        }
-        if (device.qos.has_value())
-        {
-            d.AddMember("qos",
-                Value().SetInt(device.qos.value()),
-                d.GetAllocator());
-        }
-        if (device.availability_mode.has_value())
-        {
-            d.AddMember("avty_mode",
-                Value().SetString(
-                    StringRef(device.availability_mode.value().data(),
-                        device.availability_mode.value().size())),
-                d.GetAllocator());
-        }
-        if (device.availability_topic.has_value())
-        {
-            d.AddMember("avty_t",
-                Value().SetString(
-                    StringRef(device.availability_topic.value().data(),
-                        device.availability_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.command_topic.has_value())
-        {
-            d.AddMember("cmd_t",
-                Value().SetString(StringRef(device.command_topic.value().data(),
-                    device.command_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.entity_category.has_value())
-        {
-            d.AddMember("entity_category",
-                Value().SetString(
-                    StringRef(device.entity_category.value().data(),
-                        device.entity_category.value().size())),
-                d.GetAllocator());
-        }
-        if (device.icon.has_value())
-        {
-            d.AddMember("ic",
-                Value().SetString(StringRef(device.icon.value().data(),
-                    device.icon.value().size())),
-                d.GetAllocator());
-        }
-        if (device.json_attributes_template.has_value())
-        {
-            d.AddMember("json_attr_tpl",
-                Value().SetString(
-                    StringRef(device.json_attributes_template.value().data(),
-                        device.json_attributes_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.json_attributes_topic.has_value())
-        {
-            d.AddMember("json_attr_t",
-                Value().SetString(
-                    StringRef(device.json_attributes_topic.value().data(),
-                        device.json_attributes_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.name.has_value())
-        {
-            d.AddMember("name",
-                Value().SetString(StringRef(device.name.value().data(),
-                    device.name.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_available.has_value())
-        {
-            d.AddMember("pl_avail",
-                Value().SetString(
-                    StringRef(device.payload_available.value().data(),
-                        device.payload_available.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_not_available.has_value())
-        {
-            d.AddMember("pl_not_avail",
-                Value().SetString(
-                    StringRef(device.payload_not_available.value().data(),
-                        device.payload_not_available.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_off.has_value())
-        {
-            d.AddMember("pl_off",
-                Value().SetString(StringRef(device.payload_off.value().data(),
-                    device.payload_off.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_on.has_value())
-        {
-            d.AddMember("pl_on",
-                Value().SetString(StringRef(device.payload_on.value().data(),
-                    device.payload_on.value().size())),
-                d.GetAllocator());
-        }
-        if (device.state_off.has_value())
-        {
-            d.AddMember("stat_off",
-                Value().SetString(StringRef(device.state_off.value().data(),
-                    device.state_off.value().size())),
-                d.GetAllocator());
-        }
-        if (device.state_on.has_value())
-        {
-            d.AddMember("stat_on",
-                Value().SetString(StringRef(device.state_on.value().data(),
-                    device.state_on.value().size())),
-                d.GetAllocator());
-        }
-        if (device.state_topic.has_value())
-        {
-            d.AddMember("stat_t",
-                Value().SetString(StringRef(device.state_topic.value().data(),
-                    device.state_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.unique_id.has_value())
-        {
-            d.AddMember("uniq_id",
-                Value().SetString(StringRef(device.unique_id.value().data(),
-                    device.unique_id.value().size())),
-                d.GetAllocator());
-        }
-        if (device.value_template.has_value())
-        {
-            d.AddMember("val_tpl",
-                Value().SetString(
-                    StringRef(device.value_template.value().data(),
-                        device.value_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.availability.has_value())
-        {
-            Value a;
-            a.SetArray();
-            for (const auto& str : device.availability.value())
-            {
-                a.PushBack(Value().SetString(StringRef(str.data(), str.size())),
-                    d.GetAllocator());
-            }
-            d.AddMember("avty", std::move(a), d.GetAllocator());
-        }
-        return d;
-    }
 
-    rapidjson::Document serialize(const vacuum_type& device) noexcept
-    {
-        using namespace rapidjson;
-        Document d;
-        d.SetObject();
-        if (device.enabled_by_default.has_value())
-        {
-            d.AddMember("enabled_by_default",
-                Value().SetBool(device.enabled_by_default.value()),
-                d.GetAllocator());
-        }
-        if (device.retain.has_value())
-        {
-            d.AddMember("ret",
-                Value().SetBool(device.retain.value()),
-                d.GetAllocator());
-        }
-        if (device.qos.has_value())
-        {
-            d.AddMember("qos",
-                Value().SetInt(device.qos.value()),
-                d.GetAllocator());
-        }
-        if (device.availability_mode.has_value())
-        {
-            d.AddMember("avty_mode",
-                Value().SetString(
-                    StringRef(device.availability_mode.value().data(),
-                        device.availability_mode.value().size())),
-                d.GetAllocator());
-        }
-        if (device.availability_topic.has_value())
-        {
-            d.AddMember("avty_t",
-                Value().SetString(
-                    StringRef(device.availability_topic.value().data(),
-                        device.availability_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.battery_level_template.has_value())
-        {
-            d.AddMember("bat_lev_tpl",
-                Value().SetString(
-                    StringRef(device.battery_level_template.value().data(),
-                        device.battery_level_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.battery_level_topic.has_value())
-        {
-            d.AddMember("bat_lev_t",
-                Value().SetString(
-                    StringRef(device.battery_level_topic.value().data(),
-                        device.battery_level_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.charging_template.has_value())
-        {
-            d.AddMember("chrg_tpl",
-                Value().SetString(
-                    StringRef(device.charging_template.value().data(),
-                        device.charging_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.charging_topic.has_value())
-        {
-            d.AddMember("chrg_t",
-                Value().SetString(
-                    StringRef(device.charging_topic.value().data(),
-                        device.charging_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.cleaning_template.has_value())
-        {
-            d.AddMember("cln_tpl",
-                Value().SetString(
-                    StringRef(device.cleaning_template.value().data(),
-                        device.cleaning_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.cleaning_topic.has_value())
-        {
-            d.AddMember("cln_t",
-                Value().SetString(
-                    StringRef(device.cleaning_topic.value().data(),
-                        device.cleaning_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.command_topic.has_value())
-        {
-            d.AddMember("cmd_t",
-                Value().SetString(StringRef(device.command_topic.value().data(),
-                    device.command_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.docked_template.has_value())
-        {
-            d.AddMember("dock_tpl",
-                Value().SetString(
-                    StringRef(device.docked_template.value().data(),
-                        device.docked_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.docked_topic.has_value())
-        {
-            d.AddMember("dock_t",
-                Value().SetString(StringRef(device.docked_topic.value().data(),
-                    device.docked_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.entity_category.has_value())
-        {
-            d.AddMember("entity_category",
-                Value().SetString(
-                    StringRef(device.entity_category.value().data(),
-                        device.entity_category.value().size())),
-                d.GetAllocator());
-        }
-        if (device.error_template.has_value())
-        {
-            d.AddMember("err_tpl",
-                Value().SetString(
-                    StringRef(device.error_template.value().data(),
-                        device.error_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.error_topic.has_value())
-        {
-            d.AddMember("err_t",
-                Value().SetString(StringRef(device.error_topic.value().data(),
-                    device.error_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.fan_speed_template.has_value())
-        {
-            d.AddMember("fanspd_tpl",
-                Value().SetString(
-                    StringRef(device.fan_speed_template.value().data(),
-                        device.fan_speed_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.fan_speed_topic.has_value())
-        {
-            d.AddMember("fanspd_t",
-                Value().SetString(
-                    StringRef(device.fan_speed_topic.value().data(),
-                        device.fan_speed_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.icon.has_value())
-        {
-            d.AddMember("ic",
-                Value().SetString(StringRef(device.icon.value().data(),
-                    device.icon.value().size())),
-                d.GetAllocator());
-        }
-        if (device.json_attributes_template.has_value())
-        {
-            d.AddMember("json_attr_tpl",
-                Value().SetString(
-                    StringRef(device.json_attributes_template.value().data(),
-                        device.json_attributes_template.value().size())),
-                d.GetAllocator());
-        }
-        if (device.json_attributes_topic.has_value())
-        {
-            d.AddMember("json_attr_t",
-                Value().SetString(
-                    StringRef(device.json_attributes_topic.value().data(),
-                        device.json_attributes_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.name.has_value())
-        {
-            d.AddMember("name",
-                Value().SetString(StringRef(device.name.value().data(),
-                    device.name.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_available.has_value())
-        {
-            d.AddMember("pl_avail",
-                Value().SetString(
-                    StringRef(device.payload_available.value().data(),
-                        device.payload_available.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_clean_spot.has_value())
-        {
-            d.AddMember("pl_cln_sp",
-                Value().SetString(
-                    StringRef(device.payload_clean_spot.value().data(),
-                        device.payload_clean_spot.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_locate.has_value())
-        {
-            d.AddMember("pl_loc",
-                Value().SetString(
-                    StringRef(device.payload_locate.value().data(),
-                        device.payload_locate.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_not_available.has_value())
-        {
-            d.AddMember("pl_not_avail",
-                Value().SetString(
-                    StringRef(device.payload_not_available.value().data(),
-                        device.payload_not_available.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_return_to_base.has_value())
-        {
-            d.AddMember("pl_ret",
-                Value().SetString(
-                    StringRef(device.payload_return_to_base.value().data(),
-                        device.payload_return_to_base.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_start_pause.has_value())
-        {
-            d.AddMember("pl_stpa",
-                Value().SetString(
-                    StringRef(device.payload_start_pause.value().data(),
-                        device.payload_start_pause.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_stop.has_value())
-        {
-            d.AddMember("pl_stop",
-                Value().SetString(StringRef(device.payload_stop.value().data(),
-                    device.payload_stop.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_turn_off.has_value())
-        {
-            d.AddMember("pl_toff",
-                Value().SetString(
-                    StringRef(device.payload_turn_off.value().data(),
-                        device.payload_turn_off.value().size())),
-                d.GetAllocator());
-        }
-        if (device.payload_turn_on.has_value())
-        {
-            d.AddMember("pl_ton",
-                Value().SetString(
-                    StringRef(device.payload_turn_on.value().data(),
-                        device.payload_turn_on.value().size())),
-                d.GetAllocator());
-        }
-        if (device.schema.has_value())
-        {
-            d.AddMember("schema",
-                Value().SetString(StringRef(device.schema.value().data(),
-                    device.schema.value().size())),
-                d.GetAllocator());
-        }
-        if (device.send_command_topic.has_value())
-        {
-            d.AddMember("send_cmd_t",
-                Value().SetString(
-                    StringRef(device.send_command_topic.value().data(),
-                        device.send_command_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.set_fan_speed_topic.has_value())
-        {
-            d.AddMember("set_fan_spd_t",
-                Value().SetString(
-                    StringRef(device.set_fan_speed_topic.value().data(),
-                        device.set_fan_speed_topic.value().size())),
-                d.GetAllocator());
-        }
-        if (device.unique_id.has_value())
-        {
-            d.AddMember("uniq_id",
-                Value().SetString(StringRef(device.unique_id.value().data(),
-                    device.unique_id.value().size())),
-                d.GetAllocator());
-        }
-        if (device.availability.has_value())
-        {
-            Value a;
-            a.SetArray();
-            for (const auto& str : device.availability.value())
-            {
-                a.PushBack(Value().SetString(StringRef(str.data(), str.size())),
-                    d.GetAllocator());
-            }
-            d.AddMember("avty", std::move(a), d.GetAllocator());
-        }
-        if (device.fan_speed_list.has_value())
-        {
-            Value a;
-            a.SetArray();
-            for (const auto& str : device.fan_speed_list.value())
-            {
-                a.PushBack(Value().SetString(StringRef(str.data(), str.size())),
-                    d.GetAllocator());
-            }
-            d.AddMember("fanspd_lst", std::move(a), d.GetAllocator());
-        }
-        if (device.supported_features.has_value())
-        {
-            Value a;
-            a.SetArray();
-            for (const auto& str : device.supported_features.value())
-            {
-                a.PushBack(Value().SetString(StringRef(str.data(), str.size())),
-                    d.GetAllocator());
-            }
-            d.AddMember("sup_feat", std::move(a), d.GetAllocator());
-        }
         return d;
     }
 } // namespace b2h::hass
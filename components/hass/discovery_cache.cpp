@@ -0,0 +1,415 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "hass/discovery_cache.hpp"
+
+#include <algorithm>
+
+#ifdef B2H_HASS_DISCOVERY_NVS
+#include <cstring>
+
+#include "esp_ota_ops.h"
+#include "nvs.h"
+#endif
+
+namespace b2h::hass
+{
+#ifdef B2H_HASS_DISCOVERY_NVS
+    namespace
+    {
+        constexpr const char* NVS_NAMESPACE = "b2h_discovery";
+        constexpr const char* NVS_IMAGE_KEY = "image";
+
+        // Longest model name checked against the stored one.
+        constexpr std::size_t NVS_MODEL_SIZE = 32;
+
+        // NVS keys are limited to 15 characters: 12 for the MAC and 2 for the
+        // entity index, or 'm' for the model the payloads were rendered for.
+        using nvs_key_t = std::array<char, 16>;
+
+        nvs_key_t make_nvs_key(
+            const utils::mac& mac, std::uint8_t index) noexcept
+        {
+            static constexpr std::string_view hex{ "0123456789abcdef" };
+
+            nvs_key_t result{};
+            const auto id = mac.to_id();
+            auto out      = std::copy(id.begin(), id.end(), result.begin());
+            *out++        = hex[index >> 4];
+            *out++        = hex[index & 0xF];
+            *out          = '\0';
+            return result;
+        }
+
+        nvs_key_t make_nvs_model_key(const utils::mac& mac) noexcept
+        {
+            nvs_key_t result{};
+            const auto id = mac.to_id();
+            auto out      = std::copy(id.begin(), id.end(), result.begin());
+            *out++        = 'm';
+            *out          = '\0';
+            return result;
+        }
+
+        /**
+         * @brief Check that the payloads stored for the MAC were rendered for
+         * the model. A MAC reassigned to a different model must not load the
+         * payloads of the previous one.
+         *
+         */
+        bool nvs_model_matches(
+            nvs_handle_t handle, const discovery_cache::key& k) noexcept
+        {
+            const auto model_key = make_nvs_model_key(k.mac);
+            std::array<char, NVS_MODEL_SIZE> stored{};
+            std::size_t size = stored.size();
+
+            return ::nvs_get_str(handle, model_key.data(), stored.data(),
+                       &size) == ESP_OK &&
+                   std::string_view{ stored.data() } == k.model;
+        }
+
+        /**
+         * @brief Erase the payloads stored for the MAC and record the model
+         * the next ones are rendered for.
+         *
+         */
+        void nvs_assign_model(
+            nvs_handle_t handle, const discovery_cache::key& k) noexcept
+        {
+            for (std::size_t index = 0; index < discovery_cache::MAX_ENTRIES;
+                 ++index)
+            {
+                const auto nvs_key =
+                    make_nvs_key(k.mac, static_cast<std::uint8_t>(index));
+                ::nvs_erase_key(handle, nvs_key.data());
+            }
+
+            const auto model_key = make_nvs_model_key(k.mac);
+            std::array<char, NVS_MODEL_SIZE> model{};
+            const std::size_t size = std::min(k.model.size(), model.size() - 1);
+            std::copy_n(k.model.begin(), size, model.begin());
+
+            ::nvs_set_str(handle, model_key.data(), model.data());
+        }
+
+        /**
+         * @brief Open the cache namespace once. Payloads stored by a different
+         * firmware image are dropped, the image is identified by the SHA-256
+         * of its ELF file.
+         *
+         * @return nvs_handle_t 0 if NVS is unavailable.
+         */
+        nvs_handle_t storage() noexcept
+        {
+            static const nvs_handle_t handle = []() -> nvs_handle_t {
+                nvs_handle_t result = 0;
+
+                if (::nvs_open(NVS_NAMESPACE, NVS_READWRITE, &result) != ESP_OK)
+                {
+                    return 0;
+                }
+
+                std::array<char, 65> current{};
+                std::array<char, 65> stored{};
+                std::size_t size = stored.size();
+
+                ::esp_ota_get_app_elf_sha256(current.data(), current.size());
+
+                if (::nvs_get_str(result, NVS_IMAGE_KEY, stored.data(), &size) !=
+                        ESP_OK ||
+                    std::strcmp(current.data(), stored.data()) != 0)
+                {
+                    ::nvs_erase_all(result);
+                    ::nvs_set_str(result, NVS_IMAGE_KEY, current.data());
+                    ::nvs_commit(result);
+                }
+
+                return result;
+            }();
+
+            return handle;
+        }
+    } // namespace
+#endif
+
+    discovery_cache::discovery_cache() noexcept :
+        m_mutex{},
+        m_devices{},
+        m_arena{},
+        m_used{ 0 },
+        m_free{},
+        m_free_count{ 0 },
+        m_generation{ 0 }
+    {
+    }
+
+    discovery_cache& discovery_cache::instance() noexcept
+    {
+        static discovery_cache cache;
+        return cache;
+    }
+
+    std::optional<discovery_cache::entry> discovery_cache::find(
+        const key& k) noexcept
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+
+        if (const slot* s = find_slot(k); s && s->cached)
+        {
+            return entry{
+                std::string_view{ m_arena.data() + s->offset, s->size },
+                s->published,
+            };
+        }
+
+        if (auto payload = load(k); payload.has_value())
+        {
+            return entry{ payload.value(), false };
+        }
+
+        return std::nullopt;
+    }
+
+    std::optional<std::string_view> discovery_cache::insert(
+        const key& k, std::string_view payload) noexcept
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+
+        auto result = store(k, payload);
+
+#ifdef B2H_HASS_DISCOVERY_NVS
+        if (result.has_value())
+        {
+            if (const nvs_handle_t handle = storage(); handle != 0)
+            {
+                if (!nvs_model_matches(handle, k))
+                {
+                    nvs_assign_model(handle, k);
+                }
+
+                const auto nvs_key = make_nvs_key(k.mac, k.index);
+                ::nvs_set_blob(handle,
+                    nvs_key.data(),
+                    payload.data(),
+                    payload.size());
+                ::nvs_commit(handle);
+            }
+        }
+#endif
+
+        return result;
+    }
+
+    void discovery_cache::mark_published(const key& k) noexcept
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+
+        if (slot* s = find_slot(k); s && s->cached)
+        {
+            s->published = true;
+        }
+    }
+
+    void discovery_cache::mark_unpublished() noexcept
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+
+        m_devices.for_each([](const utils::mac&, device_entry& device) {
+            for (auto& s : device.slots)
+            {
+                s.published = false;
+            }
+        });
+
+        ++m_generation;
+    }
+
+    std::uint32_t discovery_cache::generation() const noexcept
+    {
+        return m_generation;
+    }
+
+    void discovery_cache::clear() noexcept
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+
+        m_devices.clear();
+        m_used       = 0;
+        m_free_count = 0;
+    }
+
+    std::size_t discovery_cache::arena_used() const noexcept
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        return m_used;
+    }
+
+    discovery_cache::slot* discovery_cache::find_slot(const key& k) noexcept
+    {
+        if (k.index >= MAX_ENTRIES)
+        {
+            return nullptr;
+        }
+
+        device_entry* device = m_devices.find(k.mac);
+
+        if (!device || device->model != k.model)
+        {
+            return nullptr;
+        }
+
+        return &device->slots[k.index];
+    }
+
+    void discovery_cache::release(const device_entry& device) noexcept
+    {
+        for (const auto& s : device.slots)
+        {
+            if (!s.cached || s.size == 0 || m_free_count == m_free.size())
+            {
+                continue;
+            }
+
+            m_free[m_free_count++] = block{ s.offset, s.size };
+        }
+    }
+
+    std::optional<std::size_t> discovery_cache::allocate(
+        std::size_t size) noexcept
+    {
+        const auto begin = m_free.begin();
+        const auto end   = begin + m_free_count;
+
+        if (auto iter = std::find_if(begin,
+                end,
+                [size](const block& b) { return b.size >= size; });
+            iter != end)
+        {
+            const std::size_t offset = iter->offset;
+            iter->offset = static_cast<std::uint16_t>(iter->offset + size);
+            iter->size   = static_cast<std::uint16_t>(iter->size - size);
+
+            if (iter->size == 0)
+            {
+                *iter = m_free[--m_free_count];
+            }
+
+            return offset;
+        }
+
+        if (size > ARENA_SIZE - m_used)
+        {
+            return std::nullopt;
+        }
+
+        const std::size_t offset = m_used;
+        m_used += size;
+        return offset;
+    }
+
+    std::optional<std::string_view> discovery_cache::store(
+        const key& k, std::string_view payload) noexcept
+    {
+        if (k.index >= MAX_ENTRIES)
+        {
+            return std::nullopt;
+        }
+
+        device_entry* device = m_devices.find(k.mac);
+
+        if (device && device->model != k.model)
+        {
+            // The MAC now belongs to a different model, the payloads of the
+            // previous one are never looked up again.
+            release(*device);
+            device->model = k.model;
+            device->slots = {};
+        }
+
+        if (!device)
+        {
+            device = m_devices.insert_or_assign(k.mac,
+                device_entry{ k.model, {} });
+
+            if (!device)
+            {
+                return std::nullopt;
+            }
+        }
+
+        const auto offset = allocate(payload.size());
+
+        if (!offset)
+        {
+            return std::nullopt;
+        }
+
+        char* const dst = m_arena.data() + offset.value();
+
+        if (payload.data() != dst)
+        {
+            std::copy(payload.begin(), payload.end(), dst);
+        }
+
+        slot& s     = device->slots[k.index];
+        s.offset    = static_cast<std::uint16_t>(offset.value());
+        s.size      = static_cast<std::uint16_t>(payload.size());
+        s.cached    = true;
+        s.published = false;
+
+        return std::string_view{ dst, payload.size() };
+    }
+
+    std::optional<std::string_view> discovery_cache::load(
+        [[maybe_unused]] const key& k) noexcept
+    {
+#ifdef B2H_HASS_DISCOVERY_NVS
+        const nvs_handle_t handle = storage();
+
+        if (handle == 0 || k.index >= MAX_ENTRIES ||
+            !nvs_model_matches(handle, k))
+        {
+            return std::nullopt;
+        }
+
+        const auto nvs_key = make_nvs_key(k.mac, k.index);
+        std::size_t size   = 0;
+
+        if (::nvs_get_blob(handle, nvs_key.data(), nullptr, &size) != ESP_OK ||
+            size > ARENA_SIZE - m_used)
+        {
+            return std::nullopt;
+        }
+
+        // Read straight into the arena, the bytes are claimed by store().
+        char* const dst = m_arena.data() + m_used;
+
+        if (::nvs_get_blob(handle, nvs_key.data(), dst, &size) != ESP_OK)
+        {
+            return std::nullopt;
+        }
+
+        return store(k, std::string_view{ dst, size });
+#else
+        return std::nullopt;
+#endif
+    }
+} // namespace b2h::hass
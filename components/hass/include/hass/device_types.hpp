@@ -24,6 +24,9 @@
 #include "device_type.hpp"
 #include "rapidjson/document.h"
 
+#include <cstdint>
+#include <variant>
+
 namespace b2h::hass
 {
     // Autogenerated from
@@ -510,37 +513,114 @@ namespace b2h::hass
         std::optional<tcb::span<std::string_view>> supported_features;
     };
 
-    rapidjson::Document serialize(
-        const alarm_control_panel_type& device) noexcept;
+    // https://www.home-assistant.io/integrations/mqtt/#device-discovery-payload
+    struct origin_type {
+        std::string_view name;
+        std::optional<std::string_view> sw_version;
+        std::optional<std::string_view> support_url;
+    };
+
+    /**
+     * @brief Entity of a device discovery payload. Serialized under its
+     * object id in "cmps", with the platform ("p") derived from the type.
+     *
+     */
+    struct component_type {
+        using entity_variant_t = std::variant<const alarm_control_panel_type*,
+            const binary_sensor_type*,
+            const camera_type*,
+            const cover_type*,
+            const device_tracker_type*,
+            const device_trigger_type*,
+            const fan_type*,
+            const humidifier_type*,
+            const light_type*,
+            const lock_type*,
+            const number_type*,
+            const scene_type*,
+            const select_type*,
+            const sensor_type*,
+            const switch_type*,
+            const vacuum_type*>;
+
+        std::string_view object_id;
+        entity_variant_t entity;
+    };
+
+    /**
+     * @brief Payload serialization mode. Minimal payloads leave out optional
+     * members set to the value Home Assistant assumes when the key is missing.
+     *
+     */
+    enum class payload_mode : std::uint8_t
+    {
+        full,
+        minimal,
+    };
+
+    /**
+     * @brief All entities of a device announced with a single retained message
+     * on homeassistant/device/<object_id>/config. The shared device block is
+     * emitted once, entities should leave their own device unset.
+     *
+     */
+    struct device_discovery_type {
+        device_type device;
+        origin_type origin;
+        tcb::span<const component_type> components;
+        std::optional<int> qos;
+        std::optional<std::string_view> state_topic;
+    };
+
+    rapidjson::Document serialize(const alarm_control_panel_type& device,
+        payload_mode mode = payload_mode::full) noexcept;
+
+    rapidjson::Document serialize(const binary_sensor_type& device,
+        payload_mode mode = payload_mode::full) noexcept;
 
-    rapidjson::Document serialize(const binary_sensor_type& device) noexcept;
+    rapidjson::Document serialize(const camera_type& device,
+        payload_mode mode = payload_mode::full) noexcept;
 
-    rapidjson::Document serialize(const camera_type& device) noexcept;
+    rapidjson::Document serialize(const cover_type& device,
+        payload_mode mode = payload_mode::full) noexcept;
 
-    rapidjson::Document serialize(const cover_type& device) noexcept;
+    rapidjson::Document serialize(const device_tracker_type& device,
+        payload_mode mode = payload_mode::full) noexcept;
 
-    rapidjson::Document serialize(const device_tracker_type& device) noexcept;
+    rapidjson::Document serialize(const device_trigger_type& device,
+        payload_mode mode = payload_mode::full) noexcept;
 
-    rapidjson::Document serialize(const device_trigger_type& device) noexcept;
+    rapidjson::Document serialize(const fan_type& device,
+        payload_mode mode = payload_mode::full) noexcept;
 
-    rapidjson::Document serialize(const fan_type& device) noexcept;
+    rapidjson::Document serialize(const humidifier_type& device,
+        payload_mode mode = payload_mode::full) noexcept;
 
-    rapidjson::Document serialize(const humidifier_type& device) noexcept;
+    rapidjson::Document serialize(const light_type& device,
+        payload_mode mode = payload_mode::full) noexcept;
 
-    rapidjson::Document serialize(const light_type& device) noexcept;
+    rapidjson::Document serialize(const lock_type& device,
+        payload_mode mode = payload_mode::full) noexcept;
 
-    rapidjson::Document serialize(const lock_type& device) noexcept;
+    rapidjson::Document serialize(const number_type& device,
+        payload_mode mode = payload_mode::full) noexcept;
 
-    rapidjson::Document serialize(const number_type& device) noexcept;
+    rapidjson::Document serialize(const scene_type& device,
+        payload_mode mode = payload_mode::full) noexcept;
 
-    rapidjson::Document serialize(const scene_type& device) noexcept;
+    rapidjson::Document serialize(const select_type& device,
+        payload_mode mode = payload_mode::full) noexcept;
 
-    rapidjson::Document serialize(const select_type& device) noexcept;
+    rapidjson::Document serialize(const sensor_type& device,
+        payload_mode mode = payload_mode::full) noexcept;
 
-    rapidjson::Document serialize(const sensor_type& device) noexcept;
+    rapidjson::Document serialize(const switch_type& device,
+        payload_mode mode = payload_mode::full) noexcept;
 
-    rapidjson::Document serialize(const switch_type& device) noexcept;
+    rapidjson::Document serialize(const vacuum_type& device,
+        payload_mode mode = payload_mode::full) noexcept;
 
-    rapidjson::Document serialize(const vacuum_type& device) noexcept;
+    rapidjson::Document serialize(const device_discovery_type& discovery,
+        payload_mode mode = payload_mode::full) noexcept;
 } // namespace b2h::hass
 #endif
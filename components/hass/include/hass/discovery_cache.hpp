@@ -0,0 +1,268 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef B2H_HASS_DISCOVERY_CACHE_HPP
+#define B2H_HASS_DISCOVERY_CACHE_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+#include "utils/mac.hpp"
+#include "utils/mac_map.hpp"
+
+#if __has_include("sdkconfig.h")
+#include "sdkconfig.h"
+#endif
+
+#if defined(CONFIG_B2H_HASS_DISCOVERY_NVS) && \
+    !defined(B2H_HASS_DISCOVERY_NVS)
+#define B2H_HASS_DISCOVERY_NVS
+#endif
+
+// One per advertised device the application listens to, plus the GATT
+// devices.
+#ifndef B2H_HASS_DISCOVERY_MAX_DEVICES
+#ifdef CONFIG_B2H_HASS_DISCOVERY_MAX_DEVICES
+#define B2H_HASS_DISCOVERY_MAX_DEVICES CONFIG_B2H_HASS_DISCOVERY_MAX_DEVICES
+#else
+#define B2H_HASS_DISCOVERY_MAX_DEVICES 16
+#endif
+#endif
+
+// Arena share of a device, a LYWSD03MMC renders about 1.8 KiB.
+#ifndef B2H_HASS_DISCOVERY_DEVICE_ARENA_SIZE
+#ifdef CONFIG_B2H_HASS_DISCOVERY_DEVICE_ARENA_SIZE
+#define B2H_HASS_DISCOVERY_DEVICE_ARENA_SIZE \
+    CONFIG_B2H_HASS_DISCOVERY_DEVICE_ARENA_SIZE
+#else
+#define B2H_HASS_DISCOVERY_DEVICE_ARENA_SIZE 2048
+#endif
+#endif
+
+#ifndef B2H_HASS_DISCOVERY_MAX_ENTRIES
+#define B2H_HASS_DISCOVERY_MAX_ENTRIES 12
+#endif
+
+namespace b2h::hass
+{
+    // Home Assistant announces itself here, retained discovery payloads are
+    // published again when it comes online.
+    inline constexpr const char* STATUS_TOPIC{ "homeassistant/status" };
+    inline constexpr std::string_view STATUS_ONLINE{ "online" };
+
+    /**
+     * @brief Serialized discovery payloads, rendered once per (device model,
+     * MAC, entity index) and kept in a fixed size arena. Payloads returned by
+     * the cache stay valid until clear() is called, or until their MAC is
+     * cached for a different model: the space of the previous model's
+     * payloads is then reused.
+     *
+     * With CONFIG_B2H_HASS_DISCOVERY_NVS, payloads are also stored in the
+     * "b2h_discovery" NVS namespace and survive a reboot. The namespace is
+     * erased whenever the firmware image changes, and the payloads of a MAC
+     * when it is used with a different model.
+     *
+     */
+    class discovery_cache
+    {
+    public:
+        static constexpr std::size_t MAX_DEVICES =
+            B2H_HASS_DISCOVERY_MAX_DEVICES;
+        static constexpr std::size_t ARENA_SIZE =
+            MAX_DEVICES * B2H_HASS_DISCOVERY_DEVICE_ARENA_SIZE;
+        static constexpr std::size_t MAX_ENTRIES =
+            B2H_HASS_DISCOVERY_MAX_ENTRIES;
+
+        static_assert(ARENA_SIZE <= UINT16_MAX,
+            "Arena offsets are stored on 16 bits.");
+
+        struct key {
+            std::string_view model;
+            utils::mac mac;
+            std::uint8_t index;
+        };
+
+        struct entry {
+            std::string_view payload;
+            bool published;
+        };
+
+        discovery_cache() noexcept;
+
+        discovery_cache(const discovery_cache&) = delete;
+        discovery_cache(discovery_cache&&)      = delete;
+
+        discovery_cache& operator=(const discovery_cache&) = delete;
+        discovery_cache& operator=(discovery_cache&&) = delete;
+
+        ~discovery_cache() = default;
+
+        /**
+         * @brief Cache shared by all devices.
+         *
+         * @return discovery_cache&
+         */
+        static discovery_cache& instance() noexcept;
+
+        /**
+         * @brief Find cached payload.
+         *
+         * @param k
+         * @return std::optional<entry> std::nullopt if not cached.
+         */
+        std::optional<entry> find(const key& k) noexcept;
+
+        /**
+         * @brief Copy payload into the arena.
+         *
+         * @param k
+         * @param payload
+         * @return std::optional<std::string_view> Cached copy of the payload,
+         * std::nullopt if the arena or the device table is full.
+         */
+        std::optional<std::string_view> insert(
+            const key& k, std::string_view payload) noexcept;
+
+        /**
+         * @brief Find cached payload, render and cache it on a miss.
+         *
+         * @tparam RenderT Callable returning a string-like payload.
+         * @param k
+         * @param render
+         * @param storage Holds a copy of the rendered payload if it did not fit
+         * in the cache.
+         * @return entry
+         */
+        template<typename RenderT, typename StringT>
+        entry find_or_render(const key& k, RenderT&& render, StringT& storage)
+        {
+            if (auto cached = find(k); cached.has_value())
+            {
+                return cached.value();
+            }
+
+            auto&& rendered = render();
+            const std::string_view payload{ rendered };
+
+            if (auto cached = insert(k, payload); cached.has_value())
+            {
+                return { cached.value(), false };
+            }
+
+            storage = std::forward<decltype(rendered)>(rendered);
+            return { std::string_view{ storage }, false };
+        }
+
+        /**
+         * @brief Remember that the broker acknowledged a retained copy of the
+         * payload.
+         *
+         * @param k
+         */
+        void mark_published(const key& k) noexcept;
+
+        /**
+         * @brief Forget all acknowledgements, next lookups report payloads as
+         * unpublished, and advance the generation. Call when the broker may
+         * have lost retained messages.
+         *
+         */
+        void mark_unpublished() noexcept;
+
+        /**
+         * @brief Number of mark_unpublished() calls so far. Devices compare
+         * it with the one they configured at to publish discovery again.
+         *
+         * @return std::uint32_t
+         */
+        std::uint32_t generation() const noexcept;
+
+        /**
+         * @brief Drop all payloads, invalidates previously returned views.
+         *
+         */
+        void clear() noexcept;
+
+        std::size_t arena_used() const noexcept;
+
+    private:
+        struct slot {
+            std::uint16_t offset = 0;
+            std::uint16_t size   = 0;
+            bool cached          = false;
+            bool published       = false;
+        };
+
+        struct device_entry {
+            std::string_view model;
+            std::array<slot, MAX_ENTRIES> slots;
+        };
+
+        /**
+         * @brief Arena range freed by a model change.
+         *
+         */
+        struct block {
+            std::uint16_t offset = 0;
+            std::uint16_t size   = 0;
+        };
+
+        mutable std::mutex m_mutex;
+        utils::mac_map<device_entry, MAX_DEVICES> m_devices;
+        std::array<char, ARENA_SIZE> m_arena;
+        std::size_t m_used;
+        std::array<block, MAX_ENTRIES> m_free;
+        std::size_t m_free_count;
+        std::atomic<std::uint32_t> m_generation;
+
+        slot* find_slot(const key& k) noexcept;
+
+        /**
+         * @brief Free the arena ranges of the device's payloads.
+         *
+         * Ranges past the free list capacity stay unused until clear().
+         *
+         * @param device
+         */
+        void release(const device_entry& device) noexcept;
+
+        /**
+         * @brief Take a freed range that fits size bytes, the arena tail
+         * otherwise.
+         *
+         * @param size
+         * @return std::optional<std::size_t> Offset in the arena,
+         * std::nullopt if the arena is full.
+         */
+        std::optional<std::size_t> allocate(std::size_t size) noexcept;
+
+        std::optional<std::string_view> store(
+            const key& k, std::string_view payload) noexcept;
+        std::optional<std::string_view> load(const key& k) noexcept;
+    };
+} // namespace b2h::hass
+
+#endif
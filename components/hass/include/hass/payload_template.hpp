@@ -0,0 +1,133 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef B2H_HASS_PAYLOAD_TEMPLATE_HPP
+#define B2H_HASS_PAYLOAD_TEMPLATE_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "tcb/span.hpp"
+
+namespace b2h::hass
+{
+    /**
+     * @brief Serialized payload split into literal text and placeholder slots.
+     *
+     * A template is compiled once from a payload serialized with slot()
+     * markers in place of the per-device values, rendering it afterwards is
+     * a handful of copies into the output buffer. Slot values are copied
+     * verbatim and must not require JSON escaping (MAC addresses, ids and
+     * topics built from them are fine).
+     *
+     */
+    class payload_template
+    {
+    public:
+        static constexpr std::size_t MAX_SLOTS = 4;
+
+        /**
+         * @brief Placeholder of the slot. DEL (0x7F) is not escaped by the
+         * JSON writer and never appears in Home Assistant payloads.
+         *
+         * @param index Slot index, smaller than MAX_SLOTS.
+         * @return constexpr std::string_view
+         */
+        static constexpr std::string_view slot(std::size_t index) noexcept
+        {
+            return std::string_view{ SLOT_MARKERS.data() + index * 2, 2 };
+        }
+
+        payload_template() = default;
+
+        /**
+         * @brief Compile template from a payload containing slot() markers.
+         *
+         * @param rendered
+         */
+        explicit payload_template(std::string_view rendered);
+
+        /**
+         * @brief Size of the payload rendered with given slot values.
+         *
+         * @param values
+         * @return std::size_t
+         */
+        std::size_t size(
+            tcb::span<const std::string_view> values) const noexcept;
+
+        /**
+         * @brief Render payload into a caller provided buffer.
+         *
+         * @param out
+         * @param values Slot values, indexed as in slot().
+         * @return std::optional<std::string_view> Rendered payload,
+         * std::nullopt if it does not fit into the buffer or a slot value is
+         * missing.
+         */
+        std::optional<std::string_view> render_to(tcb::span<char> out,
+            tcb::span<const std::string_view> values) const noexcept;
+
+        /**
+         * @brief Render payload into a string, allocates once.
+         *
+         * @param values
+         * @return std::string
+         */
+        std::string render(tcb::span<const std::string_view> values) const;
+
+        std::string render(
+            std::initializer_list<std::string_view> values) const
+        {
+            return render(tcb::span<const std::string_view>{ values.begin(),
+                values.size() });
+        }
+
+    private:
+        static constexpr char SLOT_MARKER = '\x7f';
+
+        static constexpr std::array<char, MAX_SLOTS * 2> SLOT_MARKERS{
+            SLOT_MARKER,
+            '0',
+            SLOT_MARKER,
+            '1',
+            SLOT_MARKER,
+            '2',
+            SLOT_MARKER,
+            '3',
+        };
+
+        struct hole {
+            std::uint16_t offset;
+            std::uint8_t slot;
+        };
+
+        std::string m_text;
+        std::vector<hole> m_holes;
+    };
+} // namespace b2h::hass
+
+#endif
@@ -0,0 +1,127 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "hass/payload_template.hpp"
+
+#include <cassert>
+#include <cstring>
+
+namespace b2h::hass
+{
+    payload_template::payload_template(std::string_view rendered)
+    {
+        m_text.reserve(rendered.size());
+
+        for (std::size_t pos = 0; pos < rendered.size();)
+        {
+            const std::size_t marker = rendered.find(SLOT_MARKER, pos);
+
+            if (marker == std::string_view::npos)
+            {
+                m_text.append(rendered.substr(pos));
+                break;
+            }
+
+            assert(marker + 1 < rendered.size());
+
+            const auto slot =
+                static_cast<std::uint8_t>(rendered[marker + 1] - '0');
+            assert(slot < MAX_SLOTS);
+
+            m_text.append(rendered.substr(pos, marker - pos));
+            m_holes.push_back({
+                static_cast<std::uint16_t>(m_text.size()),
+                slot,
+            });
+
+            pos = marker + 2;
+        }
+    }
+
+    std::size_t payload_template::size(
+        tcb::span<const std::string_view> values) const noexcept
+    {
+        std::size_t result = m_text.size();
+
+        for (const hole& h : m_holes)
+        {
+            if (h.slot < values.size())
+            {
+                result += values[h.slot].size();
+            }
+        }
+
+        return result;
+    }
+
+    std::optional<std::string_view> payload_template::render_to(
+        tcb::span<char> out,
+        tcb::span<const std::string_view> values) const noexcept
+    {
+        char* dst            = out.data();
+        char* const last     = out.data() + out.size();
+        std::size_t consumed = 0;
+
+        const auto append = [&](const char* src, std::size_t count) {
+            if (static_cast<std::size_t>(last - dst) < count)
+            {
+                return false;
+            }
+
+            std::memcpy(dst, src, count);
+            dst += count;
+            return true;
+        };
+
+        for (const hole& h : m_holes)
+        {
+            if (h.slot >= values.size() ||
+                !append(m_text.data() + consumed, h.offset - consumed) ||
+                !append(values[h.slot].data(), values[h.slot].size()))
+            {
+                return std::nullopt;
+            }
+
+            consumed = h.offset;
+        }
+
+        if (!append(m_text.data() + consumed, m_text.size() - consumed))
+        {
+            return std::nullopt;
+        }
+
+        return std::string_view{ out.data(),
+            static_cast<std::size_t>(dst - out.data()) };
+    }
+
+    std::string payload_template::render(
+        tcb::span<const std::string_view> values) const
+    {
+        std::string result(size(values), '\0');
+
+        if (!render_to(tcb::span<char>{ result.data(), result.size() },
+                values))
+        {
+            result.clear();
+        }
+
+        return result;
+    }
+} // namespace b2h::hass
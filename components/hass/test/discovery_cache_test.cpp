@@ -0,0 +1,130 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "catch2/catch.hpp"
+
+#include <string>
+
+#include "hass/discovery_cache.hpp"
+
+using namespace b2h;
+using namespace b2h::utils::literals;
+
+TEST_CASE("Discovery cache renders payload once.", "[hass]")
+{
+    hass::discovery_cache cache;
+    const hass::discovery_cache::key key{ "LYWSD03MMC",
+        "A4:C1:38:01:02:03"_mac,
+        0 };
+
+    int renders = 0;
+    std::string storage;
+
+    const auto render = [&] {
+        ++renders;
+        return std::string{ "{\"name\":\"Temperature\"}" };
+    };
+
+    const auto first = cache.find_or_render(key, render, storage);
+    REQUIRE(first.payload == "{\"name\":\"Temperature\"}");
+    REQUIRE_FALSE(first.published);
+
+    const auto second = cache.find_or_render(key, render, storage);
+    REQUIRE(second.payload == first.payload);
+    REQUIRE(second.payload.data() == first.payload.data());
+    REQUIRE(renders == 1);
+    REQUIRE(cache.arena_used() == first.payload.size());
+}
+
+TEST_CASE("Discovery cache keys by model, MAC and index.", "[hass]")
+{
+    hass::discovery_cache cache;
+    const auto mac = "A4:C1:38:01:02:03"_mac;
+
+    REQUIRE(cache.insert({ "LYWSD03MMC", mac, 0 }, "temperature"));
+    REQUIRE(cache.insert({ "LYWSD03MMC", mac, 1 }, "humidity"));
+
+    REQUIRE(cache.find({ "LYWSD03MMC", mac, 0 })->payload == "temperature");
+    REQUIRE(cache.find({ "LYWSD03MMC", mac, 1 })->payload == "humidity");
+    REQUIRE_FALSE(cache.find({ "LYWSD03MMC", mac, 2 }));
+    REQUIRE_FALSE(cache.find({ "MiKettle", mac, 0 }));
+    REQUIRE_FALSE(cache.find({ "LYWSD03MMC", "A4:C1:38:01:02:04"_mac, 0 }));
+    REQUIRE_FALSE(cache.insert(
+        { "LYWSD03MMC", mac, hass::discovery_cache::MAX_ENTRIES }, "x"));
+}
+
+TEST_CASE("Discovery cache reuses the arena of a replaced model.", "[hass]")
+{
+    hass::discovery_cache cache;
+    const auto mac = "A4:C1:38:01:02:03"_mac;
+
+    REQUIRE(cache.insert({ "LYWSD03MMC", mac, 0 }, "temperature"));
+    REQUIRE(cache.insert({ "LYWSD03MMC", mac, 1 }, "humidity"));
+    const std::size_t used = cache.arena_used();
+
+    REQUIRE(cache.insert({ "MiKettle", mac, 0 }, "kettle"));
+    REQUIRE(cache.insert({ "MiKettle", mac, 1 }, "mode"));
+    REQUIRE(cache.find({ "MiKettle", mac, 0 })->payload == "kettle");
+    REQUIRE(cache.find({ "MiKettle", mac, 1 })->payload == "mode");
+    REQUIRE_FALSE(cache.find({ "LYWSD03MMC", mac, 0 }));
+    REQUIRE(cache.arena_used() == used);
+}
+
+TEST_CASE("Discovery cache tracks published payloads.", "[hass]")
+{
+    hass::discovery_cache cache;
+    const hass::discovery_cache::key key{ "MiKettle",
+        "A4:C1:38:01:02:03"_mac,
+        3 };
+
+    cache.mark_published(key);
+    REQUIRE_FALSE(cache.find(key));
+
+    REQUIRE(cache.insert(key, "payload"));
+    cache.mark_published(key);
+    REQUIRE(cache.find(key)->published);
+
+    const std::uint32_t generation = cache.generation();
+    cache.mark_unpublished();
+    REQUIRE_FALSE(cache.find(key)->published);
+    REQUIRE(cache.generation() == generation + 1);
+
+    cache.clear();
+    REQUIRE_FALSE(cache.find(key));
+    REQUIRE(cache.arena_used() == 0);
+}
+
+TEST_CASE("Discovery cache falls back to rendered payload when full.", "[hass]")
+{
+    hass::discovery_cache cache;
+    const hass::discovery_cache::key key{ "LYWSD03MMC",
+        "A4:C1:38:01:02:03"_mac,
+        0 };
+
+    const std::string large(hass::discovery_cache::ARENA_SIZE + 1, 'x');
+    std::string storage;
+
+    const auto result =
+        cache.find_or_render(key, [&] { return large; }, storage);
+
+    REQUIRE(result.payload == large);
+    REQUIRE(result.payload.data() == storage.data());
+    REQUIRE_FALSE(cache.find(key));
+}
@@ -57,3 +57,107 @@ TEST_CASE("Conversion to JSON with optional.", "[hass]")
     auto result      = serialize(dev);
     REQUIRE(dump(result) == "{\"stat_t\":\"example/topic\",\"frc_upd\":true}");
 }
+
+TEST_CASE("Conversion to JSON with device and lists.", "[hass]")
+{
+    using namespace b2h::hass;
+    std::string_view identifiers[]{ "id0", "id1" };
+    std::pair<std::string_view, std::string_view> connections[]{ { "mac",
+        "A4:C1:38:00:00:00" } };
+    device_type device;
+    device.name        = "Thermometer";
+    device.connections = connections;
+    device.identifiers = identifiers;
+
+    sensor_type dev;
+    dev.state_topic = "example/topic";
+    dev.device      = device;
+    dev.qos         = 1;
+    auto result     = serialize(dev);
+    REQUIRE(dump(result) ==
+            "{\"stat_t\":\"example/topic\",\"dev\":{\"name\":\"Thermometer\","
+            "\"cns\":[[\"mac\",\"A4:C1:38:00:00:00\"]],\"ids\":[\"id0\","
+            "\"id1\"]},\"qos\":1}");
+}
+
+TEST_CASE("Conversion of device discovery to JSON.", "[hass]")
+{
+    using namespace b2h::hass;
+
+    std::pair<std::string_view, std::string_view> connections[]{ { "mac",
+        "A4:C1:38:00:00:00" } };
+
+    sensor_type temperature;
+    temperature.unique_id   = "temperature";
+    temperature.state_topic = "example/temperature";
+
+    switch_type power;
+    power.unique_id     = "power";
+    power.command_topic = "example/power/cmd";
+
+    const component_type components[]{
+        { "temperature", &temperature },
+        { "power", &power },
+    };
+
+    device_discovery_type discovery;
+    discovery.device.name        = "Device";
+    discovery.device.connections = connections;
+    discovery.origin.name        = "ble2hass";
+    discovery.components         = components;
+    discovery.qos                = 1;
+
+    auto result = serialize(discovery);
+    REQUIRE(dump(result) ==
+            "{\"dev\":{\"name\":\"Device\",\"cns\":[[\"mac\","
+            "\"A4:C1:38:00:00:00\"]]},\"o\":{\"name\":\"ble2hass\"},"
+            "\"cmps\":{\"temperature\":{\"p\":\"sensor\","
+            "\"stat_t\":\"example/temperature\",\"uniq_id\":\"temperature\"},"
+            "\"power\":{\"p\":\"switch\",\"cmd_t\":\"example/power/cmd\","
+            "\"uniq_id\":\"power\"}},\"qos\":1}");
+}
+
+TEST_CASE("Minimal payload leaves out defaults.", "[hass]")
+{
+    using namespace b2h::hass;
+
+    sensor_type sensor;
+    sensor.state_topic        = "example/topic";
+    sensor.name               = "Sensor";
+    sensor.qos                = 0;
+    sensor.enabled_by_default = true;
+    sensor.force_update       = false;
+    sensor.payload_available  = "online";
+
+    REQUIRE(dump(serialize(sensor, payload_mode::minimal)) ==
+            "{\"stat_t\":\"example/topic\",\"name\":\"Sensor\"}");
+    REQUIRE(dump(serialize(sensor)) ==
+            "{\"stat_t\":\"example/topic\",\"enabled_by_default\":true,"
+            "\"frc_upd\":false,\"qos\":0,\"name\":\"Sensor\","
+            "\"pl_avail\":\"online\"}");
+
+    number_type number;
+    number.command_topic = "example/cmd";
+    number.min           = 1.0;
+    number.max           = 95.5;
+    number.qos           = 1;
+    number.retain        = false;
+
+    REQUIRE(dump(serialize(number, payload_mode::minimal)) ==
+            "{\"max\":95.5,\"qos\":1,\"cmd_t\":\"example/cmd\"}");
+}
+
+TEST_CASE("Device via_device key.", "[hass]")
+{
+    using namespace b2h::hass;
+
+    sensor_type sensor;
+    sensor.state_topic        = "example/topic";
+    sensor.device             = device_type{};
+    sensor.device->name       = "Sensor";
+    sensor.device->via_device = "Gateway";
+
+    REQUIRE(dump(serialize(sensor)) ==
+            "{\"stat_t\":\"example/topic\",\"dev\":{\"name\":\"Sensor\","
+            "\"via_device\":\"Gateway\"}}");
+}
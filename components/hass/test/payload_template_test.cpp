@@ -0,0 +1,122 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "catch2/catch.hpp"
+
+#include <array>
+#include <string>
+
+#include "fmt/format.h"
+
+#include "rapidjson/document.h"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+
+#include "hass/device_types.hpp"
+#include "hass/payload_template.hpp"
+
+namespace rjs = rapidjson;
+
+namespace
+{
+    using connection_t = std::pair<std::string_view, std::string_view>;
+
+    constexpr std::size_t ID_SLOT  = 0;
+    constexpr std::size_t MAC_SLOT = 1;
+
+    std::string dump(const rjs::Document& document)
+    {
+        rjs::StringBuffer buffer;
+        rjs::Writer<rjs::StringBuffer> writer(buffer);
+        document.Accept(writer);
+        return std::string{ buffer.GetString(), buffer.GetSize() };
+    }
+
+    // Mirrors the LYWSD03MMC temperature sensor config.
+    std::string make_sensor_payload(std::string_view id, std::string_view mac)
+    {
+        using namespace std::literals;
+
+        const std::string unique_id =
+            fmt::format("lywsd03mmc_{}_temperature", id);
+        const std::string state_topic =
+            fmt::format("homeassistant/sensor/{}/state", unique_id);
+        std::array<connection_t, 1> conn{ { { "mac"sv, mac } } };
+
+        b2h::hass::device_type device;
+        device.name         = "Mi Temperature & Humidity Monitor 2"sv;
+        device.model        = "LYWSD03MMC"sv;
+        device.manufacturer = "Xiaomi"sv;
+        device.connections  = tcb::make_span(conn);
+
+        b2h::hass::sensor_type sens;
+        sens.device              = device;
+        sens.state_topic         = state_topic;
+        sens.name                = "LYWSD03MMC Temperature"sv;
+        sens.device_class        = "temperature"sv;
+        sens.unit_of_measurement = "°C"sv;
+        sens.qos                 = 0;
+        sens.unique_id           = unique_id;
+        sens.value_template =
+            "{{ ((value_json | float(0)) * 0.01) | round(2) }}"sv;
+
+        return dump(b2h::hass::serialize(sens));
+    }
+} // namespace
+
+TEST_CASE("Payload template renders serialized payload.", "[hass]")
+{
+    using namespace b2h::hass;
+
+    const payload_template tmpl{ make_sensor_payload(
+        payload_template::slot(ID_SLOT),
+        payload_template::slot(MAC_SLOT)) };
+
+    const std::array<std::string_view, 2> values{ "a4c1380d53a1",
+        "A4:C1:38:0D:53:A1" };
+
+    const std::string expected = make_sensor_payload(values[0], values[1]);
+
+    REQUIRE(tmpl.size(values) == expected.size());
+    REQUIRE(tmpl.render(values) == expected);
+
+    std::array<char, 512> buffer{};
+    const auto rendered = tmpl.render_to(buffer, values);
+    REQUIRE(rendered.has_value());
+    REQUIRE(rendered.value() == expected);
+}
+
+TEST_CASE("Payload template rejects small buffer and missing slot.", "[hass]")
+{
+    using namespace b2h::hass;
+
+    const payload_template tmpl{ "{\"uniq_id\":\"id_\x7f"
+                                 "0\",\"mac\":\"\x7f"
+                                 "1\"}" };
+
+    const std::array<std::string_view, 2> values{ "0011", "00:11" };
+    REQUIRE(tmpl.render(values) == "{\"uniq_id\":\"id_0011\",\"mac\":\"00:11\"}");
+
+    std::array<char, 16> small{};
+    REQUIRE_FALSE(tmpl.render_to(small, values));
+
+    const std::array<std::string_view, 1> missing{ "0011" };
+    REQUIRE_FALSE(tmpl.render_to(small, missing));
+}
@@ -0,0 +1,295 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "benchmark/benchmark.h"
+
+#include <chrono>
+#include <list>
+#include <string>
+#include <vector>
+
+#include "event/event.hpp"
+#include "mqtt/client.hpp"
+#include "mqtt/session.hpp"
+#include "mqtt_client.h"
+
+// Load generator running mqtt::client channels against the in-process
+// broker stand-in, one channel per simulated device.
+
+namespace
+{
+    using namespace b2h;
+
+    using clock_type = std::chrono::steady_clock;
+
+    static constexpr std::size_t TOPICS_PER_DEVICE{ 3 };
+
+    struct load_stats {
+        std::size_t completed = 0;
+        std::size_t failed    = 0;
+        std::size_t no_mem    = 0; // Rejected by a full publish pipeline.
+        clock_type::duration latency{};
+    };
+
+    class device_load final
+    {
+    public:
+        device_load(event::context& ctx, mqtt::session& session,
+            std::size_t id, load_stats& stats) :
+            m_context{ ctx },
+            m_client{ ctx, session },
+            m_topics{},
+            m_stats{ stats },
+            m_count{ 0 }
+        {
+            for (std::size_t i = 0; i < TOPICS_PER_DEVICE; ++i)
+            {
+                m_topics.push_back("b2h/device" + std::to_string(id) +
+                                   "/sensor" + std::to_string(i) + "/state");
+            }
+        }
+
+        /**
+         * @brief Publish a reading every period until the deadline.
+         *
+         */
+        void run_at(clock_type::duration period, clock_type::time_point end)
+        {
+            if (clock_type::now() >= end)
+            {
+                return;
+            }
+
+            publish(m_topics[m_count % m_topics.size()]);
+
+            ++m_context.active_events();
+            m_context.shedule_after(period,
+                [this,
+                    period,
+                    end,
+                    &active_events = m_context.active_events()]() {
+                    --active_events;
+                    run_at(period, end);
+                });
+        }
+
+        /**
+         * @brief Keep window publishes outstanding until total are done.
+         *
+         */
+        void run_closed(std::size_t window, std::size_t total)
+        {
+            for (std::size_t i = 0; i < window; ++i)
+            {
+                m_topics.push_back(
+                    m_topics.front() + "/" + std::to_string(i));
+            }
+
+            for (std::size_t i = 0; i < window; ++i)
+            {
+                next(m_topics[TOPICS_PER_DEVICE + i], total);
+            }
+        }
+
+    private:
+        event::context& m_context;
+        mqtt::client m_client;
+        std::vector<std::string> m_topics;
+        load_stats& m_stats;
+        std::size_t m_count;
+
+        template<typename FuncT = void (*)(bool)>
+        void publish(const std::string& topic, FuncT&& then = [](bool) {})
+        {
+            const auto sent = clock_type::now();
+
+            m_client.async_publish(topic,
+                std::to_string(m_count++),
+                1,
+                false,
+                [this, sent, then](auto result) {
+                    if (result.has_value())
+                    {
+                        ++m_stats.completed;
+                        m_stats.latency += clock_type::now() - sent;
+                    }
+                    else if (result.error() == ESP_ERR_NO_MEM)
+                    {
+                        ++m_stats.no_mem;
+                        --m_count;
+                    }
+                    else
+                    {
+                        ++m_stats.failed;
+                    }
+
+                    then(!result.has_value() &&
+                         result.error() == ESP_ERR_NO_MEM);
+                });
+        }
+
+        void next(const std::string& topic, std::size_t total)
+        {
+            using namespace std::chrono_literals;
+
+            if (m_count >= total)
+            {
+                return;
+            }
+
+            publish(topic, [this, &topic, total](bool rejected) {
+                if (!rejected)
+                {
+                    next(topic, total);
+                    return;
+                }
+
+                // Back off until the pipeline has room again.
+                ++m_context.active_events();
+                m_context.shedule_after(1ms,
+                    [this,
+                        &topic,
+                        total,
+                        &active_events = m_context.active_events()]() {
+                        --active_events;
+                        next(topic, total);
+                    });
+            });
+        }
+    };
+
+    template<typename StartT>
+    load_stats run_load(std::size_t devices, StartT&& start)
+    {
+        event::context context;
+        mqtt::session session{ context };
+        std::list<device_load> loads;
+        load_stats stats;
+
+        session.config(mqtt::config{ "mqtt://standin:1883" });
+
+        for (std::size_t i = 0; i < devices; ++i)
+        {
+            loads.emplace_back(context, session, i, stats);
+        }
+
+        session.async_connect([&](auto) {
+            for (auto& load : loads)
+            {
+                start(load);
+            }
+        });
+
+        context.run();
+        return stats;
+    }
+
+    void report(benchmark::State& state, const load_stats& stats)
+    {
+        using namespace std::chrono;
+
+        state.counters["published"] = benchmark::Counter(
+            static_cast<double>(stats.completed),
+            benchmark::Counter::kIsRate);
+        state.counters["latency_ms"] = stats.completed == 0
+            ? 0.0
+            : duration<double, std::milli>(stats.latency).count() /
+                  static_cast<double>(stats.completed);
+        state.counters["no_mem"] = static_cast<double>(stats.no_mem);
+        state.counters["failed"] = static_cast<double>(stats.failed);
+        state.counters["rejected"] =
+            static_cast<double>(broker_stats.rejected.load());
+        state.counters["lost"] =
+            static_cast<double>(broker_stats.lost.load());
+    }
+} // namespace
+
+// N devices publishing at M Hz for half a second over a 5 ms link, with a
+// packet loss given in per mille.
+static void client_load(benchmark::State& state)
+{
+    using namespace std::chrono_literals;
+
+    const auto devices = static_cast<std::size_t>(state.range(0));
+    const auto period  = clock_type::duration{ 1s } / state.range(1);
+
+    broker_config = standin_config{};
+    broker_config.latency   = 5ms;
+    broker_config.ack_delay = 1ms;
+    broker_config.loss      = static_cast<double>(state.range(2)) / 1000.0;
+    broker_stats.reset();
+
+    load_stats stats;
+
+    for (auto _ : state)
+    {
+        const auto end = clock_type::now() + 500ms;
+
+        stats = run_load(devices,
+            [period, end](device_load& load) { load.run_at(period, end); });
+    }
+
+    report(state, stats);
+}
+BENCHMARK(client_load)
+    ->ArgNames({ "devices", "hz", "loss" })
+    ->Args({ 1, 10, 0 })
+    ->Args({ 10, 10, 0 })
+    ->Args({ 10, 100, 0 })
+    ->Args({ 50, 100, 0 })
+    ->Args({ 10, 100, 10 })
+    ->Iterations(1)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+// Devices publishing as fast as acknowledgements allow, with a given
+// number of publishes outstanding. Windows beyond MAX_INFLIGHT hit the
+// pipeline backpressure.
+static void client_saturate(benchmark::State& state)
+{
+    using namespace std::chrono_literals;
+
+    const auto devices = static_cast<std::size_t>(state.range(0));
+    const auto window  = static_cast<std::size_t>(state.range(1));
+
+    broker_config = standin_config{};
+    broker_config.latency = 1ms;
+    broker_stats.reset();
+
+    load_stats stats;
+
+    for (auto _ : state)
+    {
+        stats = run_load(devices,
+            [window](device_load& load) { load.run_closed(window, 256); });
+    }
+
+    report(state, stats);
+}
+BENCHMARK(client_saturate)
+    ->ArgNames({ "devices", "window" })
+    ->Args({ 1, 1 })
+    ->Args({ 1, 4 })
+    ->Args({ 1, 8 })
+    ->Args({ 1, 16 })
+    ->Args({ 10, 8 })
+    ->Iterations(1)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,106 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "benchmark/benchmark.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mqtt/router.hpp"
+
+// 100 devices with 10 command topics each, plus one wildcard filter per
+// device, e.g. "b2h/device042/entity7/set" and "b2h/device042/+/get".
+static constexpr std::size_t DEVICES{ 100 };
+static constexpr std::size_t ENTITIES{ 10 };
+
+static std::vector<std::string> make_topics()
+{
+    std::vector<std::string> topics;
+    topics.reserve(DEVICES * ENTITIES);
+
+    for (std::size_t device = 0; device < DEVICES; ++device)
+    {
+        for (std::size_t entity = 0; entity < ENTITIES; ++entity)
+        {
+            topics.push_back("b2h/device" + std::to_string(device) +
+                             "/entity" + std::to_string(entity) + "/set");
+        }
+    }
+
+    return topics;
+}
+
+static void router_match(benchmark::State& state)
+{
+    const auto topics = make_topics();
+    b2h::mqtt::router<std::size_t> router;
+
+    for (std::size_t i = 0; i < topics.size(); ++i)
+    {
+        router[topics[i]] = i;
+    }
+
+    for (std::size_t device = 0; device < DEVICES; ++device)
+    {
+        router["b2h/device" + std::to_string(device) + "/+/get"] = 0;
+    }
+
+    std::size_t index   = 0;
+    std::size_t matched = 0;
+
+    for (auto _ : state)
+    {
+        router.match(topics[index],
+            [&matched](std::size_t value) { matched += value; });
+        index = (index + 1) % topics.size();
+    }
+
+    benchmark::DoNotOptimize(matched);
+}
+BENCHMARK(router_match);
+
+// Previous approach: every inbound message compared against each
+// subscribed topic in turn.
+static void linear_match(benchmark::State& state)
+{
+    const auto topics = make_topics();
+
+    std::size_t index   = 0;
+    std::size_t matched = 0;
+
+    for (auto _ : state)
+    {
+        const std::string_view topic = topics[index];
+
+        for (std::size_t i = 0; i < topics.size(); ++i)
+        {
+            if (topics[i] == topic)
+            {
+                matched += i;
+            }
+        }
+
+        index = (index + 1) % topics.size();
+    }
+
+    benchmark::DoNotOptimize(matched);
+}
+BENCHMARK(linear_match);
@@ -0,0 +1,386 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef STANDIN_MQTT_CLIENT_H
+#define STANDIN_MQTT_CLIENT_H
+
+#include "esp_err.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// In-process broker standing in for esp-mqtt and a remote broker, for
+// benchmarks on the host. Publishes are acknowledged and subscribed topics
+// are echoed back from a separate thread playing the MQTT task, after the
+// configured network delays.
+
+struct standin_config {
+    std::chrono::microseconds latency{ 0 };   // One way, client to broker.
+    std::chrono::microseconds ack_delay{ 0 }; // Broker processing time.
+    double loss{ 0.0 }; // Probability of losing a packet.
+    std::chrono::microseconds retransmit{ 100000 }; // Resend of lost QoS > 0.
+    std::size_t outbox_size{ 64 }; // Unacknowledged messages, enqueueing
+                                   // more fails.
+};
+
+struct standin_stats {
+    std::atomic<std::size_t> published{ 0 };
+    std::atomic<std::size_t> acknowledged{ 0 };
+    std::atomic<std::size_t> lost{ 0 };
+    std::atomic<std::size_t> rejected{ 0 };
+    std::atomic<std::size_t> delivered{ 0 };
+
+    void reset() noexcept
+    {
+        published    = 0;
+        acknowledged = 0;
+        lost         = 0;
+        rejected     = 0;
+        delivered    = 0;
+    }
+};
+
+// Applied to clients created afterwards.
+inline standin_config broker_config;
+
+inline standin_stats broker_stats;
+
+enum esp_mqtt_event_id_t : int
+{
+    ESP_EVENT_ANY_ID = -1,
+    MQTT_EVENT_BEFORE_CONNECT,
+    MQTT_EVENT_CONNECTED,
+    MQTT_EVENT_DISCONNECTED,
+    MQTT_EVENT_SUBSCRIBED,
+    MQTT_EVENT_UNSUBSCRIBED,
+    MQTT_EVENT_PUBLISHED,
+    MQTT_EVENT_DATA,
+    MQTT_EVENT_ERROR,
+};
+
+struct esp_mqtt_client_config_t {
+    const char* uri;
+    const char* username;
+    const char* password;
+    const char* client_id;
+    int disable_clean_session;
+};
+
+using esp_event_base_t = const char*;
+
+using esp_event_handler_t = void (*)(void* event_handler_arg,
+    esp_event_base_t event_base, std::int32_t event_id, void* event_data);
+
+struct esp_mqtt_event_t {
+    esp_mqtt_event_id_t event_id;
+    const char* data;
+    const char* topic;
+    std::size_t topic_len;
+    std::size_t data_len;
+    int total_data_len;
+    int current_data_offset;
+    int msg_id;
+};
+
+using esp_mqtt_event_handle_t = esp_mqtt_event_t*;
+
+struct esp_mqtt_client {
+    using clock_type = std::chrono::steady_clock;
+
+    standin_config settings{ broker_config };
+    esp_event_handler_t event_handler{ nullptr };
+    void* event_handler_arg{ nullptr };
+    std::vector<esp_mqtt_event_id_t> events;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::multimap<clock_type::time_point, std::function<void()>> timers;
+    std::vector<std::string> subscriptions;
+    std::minstd_rand random{ 1 };
+    int next_msg_id{ 1 };
+    std::size_t outbox{ 0 };
+    bool running{ true };
+    std::thread task{ [this]() { run(); } };
+
+    ~esp_mqtt_client()
+    {
+        {
+            std::lock_guard<std::mutex> lock{ mutex };
+            running = false;
+        }
+        cv.notify_one();
+        task.join();
+    }
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lock{ mutex };
+
+        while (running)
+        {
+            if (timers.empty())
+            {
+                cv.wait(lock);
+                continue;
+            }
+
+            if (timers.cbegin()->first > clock_type::now())
+            {
+                cv.wait_until(lock, timers.cbegin()->first);
+                continue;
+            }
+
+            auto func = std::move(timers.begin()->second);
+            timers.erase(timers.begin());
+
+            lock.unlock();
+            func();
+            lock.lock();
+        }
+    }
+
+    // mutex must be held.
+    void after(clock_type::duration delay, std::function<void()> func)
+    {
+        timers.emplace(clock_type::now() + delay, std::move(func));
+        cv.notify_one();
+    }
+
+    // mutex must be held.
+    bool lose() noexcept
+    {
+        return settings.loss > 0.0 &&
+               std::bernoulli_distribution{ settings.loss }(random);
+    }
+
+    void dispatch(esp_mqtt_event_id_t event_id, int msg_id = 0,
+        const std::string& topic = {}, const std::string& data = {})
+    {
+        if (std::find_if(events.cbegin(), events.cend(), [event_id](auto val) {
+                return val == ESP_EVENT_ANY_ID || val == event_id;
+            }) == events.cend())
+        {
+            return;
+        }
+
+        esp_mqtt_event_t event{};
+        event.event_id       = event_id;
+        event.msg_id         = msg_id;
+        event.topic          = topic.data();
+        event.topic_len      = topic.size();
+        event.data           = data.data();
+        event.data_len       = data.size();
+        event.total_data_len = static_cast<int>(data.size());
+        event_handler(event_handler_arg, nullptr, event_id, &event);
+    }
+
+    // Round trip of a request, acknowledged with event_id. mutex must be
+    // held.
+    void request(esp_mqtt_event_id_t event_id, int msg_id,
+        std::function<void()> on_broker = {})
+    {
+        after(2 * settings.latency + settings.ack_delay,
+            [this, event_id, msg_id, on_broker]() {
+                if (on_broker)
+                {
+                    on_broker();
+                }
+                dispatch(event_id, msg_id);
+            });
+    }
+
+    // Handle a packet reaching the broker, mutex must be held.
+    void send(int msg_id, std::string topic, std::string data, int qos)
+    {
+        if (lose())
+        {
+            ++broker_stats.lost;
+
+            if (qos > 0)
+            {
+                after(settings.retransmit,
+                    [this, msg_id, topic, data, qos]() {
+                        std::lock_guard<std::mutex> lock{ mutex };
+                        send(msg_id, topic, data, qos);
+                    });
+            }
+            return;
+        }
+
+        if (std::find(subscriptions.cbegin(), subscriptions.cend(), topic) !=
+            subscriptions.cend())
+        {
+            after(settings.ack_delay + settings.latency,
+                [this, topic, data]() {
+                    ++broker_stats.delivered;
+                    dispatch(MQTT_EVENT_DATA, 0, topic, data);
+                });
+        }
+
+        if (qos == 0)
+        {
+            ++broker_stats.acknowledged;
+            return;
+        }
+
+        after(settings.ack_delay + settings.latency, [this, msg_id]() {
+            {
+                std::lock_guard<std::mutex> lock{ mutex };
+                --outbox;
+            }
+            ++broker_stats.acknowledged;
+            dispatch(MQTT_EVENT_PUBLISHED, msg_id);
+        });
+    }
+};
+
+using esp_mqtt_client_handle_t = esp_mqtt_client*;
+
+inline esp_err_t esp_mqtt_set_config(esp_mqtt_client_handle_t client,
+    const esp_mqtt_client_config_t* config) noexcept
+{
+    return ESP_OK;
+}
+
+inline esp_err_t esp_mqtt_client_start(esp_mqtt_client_handle_t client) noexcept
+{
+    std::lock_guard<std::mutex> lock{ client->mutex };
+    client->request(MQTT_EVENT_CONNECTED, 0);
+    return ESP_OK;
+}
+
+inline esp_err_t esp_mqtt_client_stop(esp_mqtt_client_handle_t client) noexcept
+{
+    std::lock_guard<std::mutex> lock{ client->mutex };
+    client->after({},
+        [client]() { client->dispatch(MQTT_EVENT_DISCONNECTED); });
+    return ESP_OK;
+}
+
+inline esp_err_t esp_mqtt_client_register_event(esp_mqtt_client_handle_t client,
+    esp_mqtt_event_id_t event, esp_event_handler_t event_handler,
+    void* event_handler_arg) noexcept
+{
+    std::lock_guard<std::mutex> lock{ client->mutex };
+    client->events.push_back(event);
+    client->event_handler     = event_handler;
+    client->event_handler_arg = event_handler_arg;
+    return ESP_OK;
+}
+
+inline int esp_mqtt_client_enqueue(esp_mqtt_client_handle_t client,
+    const char* topic, const char* data, int len, int qos, int retain,
+    bool store) noexcept
+{
+    std::lock_guard<std::mutex> lock{ client->mutex };
+
+    if (qos > 0 && client->outbox == client->settings.outbox_size)
+    {
+        ++broker_stats.rejected;
+        return -1;
+    }
+
+    ++broker_stats.published;
+
+    const int msg_id = qos > 0 ? client->next_msg_id++ : 0;
+
+    if (qos > 0)
+    {
+        ++client->outbox;
+    }
+
+    // Reaches the broker one network latency later.
+    client->after(client->settings.latency,
+        [client,
+            msg_id,
+            topic = std::string{ topic },
+            data  = std::string(data, len),
+            qos]() {
+            std::lock_guard<std::mutex> lock{ client->mutex };
+            client->send(msg_id, topic, data, qos);
+        });
+
+    return msg_id;
+}
+
+inline int esp_mqtt_client_publish(esp_mqtt_client_handle_t client,
+    const char* topic, const char* data, int len, int qos, int retain) noexcept
+{
+    return esp_mqtt_client_enqueue(client, topic, data, len, qos, retain, true);
+}
+
+inline int esp_mqtt_client_subscribe(
+    esp_mqtt_client_handle_t client, const char* topic, int qos) noexcept
+{
+    std::lock_guard<std::mutex> lock{ client->mutex };
+
+    const int msg_id = client->next_msg_id++;
+    client->request(MQTT_EVENT_SUBSCRIBED,
+        msg_id,
+        [client, topic{ std::string{ topic } }]() {
+            std::lock_guard<std::mutex> lock{ client->mutex };
+            client->subscriptions.push_back(topic);
+        });
+    return msg_id;
+}
+
+inline int esp_mqtt_client_unsubscribe(
+    esp_mqtt_client_handle_t client, const char* topic) noexcept
+{
+    std::lock_guard<std::mutex> lock{ client->mutex };
+
+    const int msg_id = client->next_msg_id++;
+    client->request(MQTT_EVENT_UNSUBSCRIBED,
+        msg_id,
+        [client, topic{ std::string{ topic } }]() {
+            std::lock_guard<std::mutex> lock{ client->mutex };
+            auto& subscriptions = client->subscriptions;
+            subscriptions.erase(std::remove(subscriptions.begin(),
+                                    subscriptions.end(),
+                                    topic),
+                subscriptions.end());
+        });
+    return msg_id;
+}
+
+inline esp_mqtt_client_handle_t esp_mqtt_client_init(
+    const esp_mqtt_client_config_t*)
+{
+    return new esp_mqtt_client{};
+}
+
+inline esp_err_t esp_mqtt_client_destroy(
+    esp_mqtt_client_handle_t client) noexcept
+{
+    delete client;
+    return ESP_OK;
+}
+
+#endif
@@ -0,0 +1,204 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Feasibility estimate for MQTT 5 topic aliases, the session does not use
+// them. The tree builds against the IDF 4.x esp-mqtt API, which has no MQTT 5
+// client, so the numbers size the gain of porting to IDF 5.
+
+#include "benchmark/benchmark.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+// Outgoing aliases of one connection, the least recently published topic
+// gives its alias up once all of them are in use.
+class alias_model
+{
+public:
+    struct alias {
+        bool assigned; // Published under an alias.
+        bool bound;    // The broker knows the alias, the topic is left out.
+    };
+
+    explicit alias_model(std::size_t limit) :
+        m_entries{},
+        m_limit{ limit },
+        m_clock{ 0 }
+    {
+        m_entries.reserve(limit);
+    }
+
+    alias assign(const std::string& topic)
+    {
+        if (m_limit == 0)
+        {
+            return { false, false };
+        }
+
+        ++m_clock;
+
+        if (auto iter = std::find_if(m_entries.begin(),
+                m_entries.end(),
+                [&topic](const entry& candidate) {
+                    return candidate.topic == topic;
+                });
+            iter != m_entries.end())
+        {
+            iter->last_use = m_clock;
+            return { true, true };
+        }
+
+        if (m_entries.size() < m_limit)
+        {
+            m_entries.push_back(entry{ topic, m_clock });
+            return { true, false };
+        }
+
+        auto lru = std::min_element(m_entries.begin(),
+            m_entries.end(),
+            [](const entry& lhs, const entry& rhs) {
+                return lhs.last_use < rhs.last_use;
+            });
+
+        lru->topic    = topic;
+        lru->last_use = m_clock;
+        return { true, false };
+    }
+
+private:
+    struct entry {
+        std::string topic;
+        std::uint64_t last_use;
+    };
+
+    std::vector<entry> m_entries;
+    std::size_t m_limit;
+    std::uint64_t m_clock;
+};
+
+// State topics of a LYWSD03MMC fleet, three per device.
+static std::vector<std::string> make_topics(std::size_t devices)
+{
+    static constexpr const char* SENSORS[]{
+        "temperature",
+        "humidity",
+        "battery",
+    };
+
+    std::vector<std::string> topics;
+    topics.reserve(devices * 3);
+
+    for (std::size_t device = 0; device < devices; ++device)
+    {
+        char id[13];
+        std::snprintf(id,
+            sizeof(id),
+            "a4c138%06x",
+            static_cast<unsigned>(device & 0xFFFFFF));
+
+        for (const char* sensor : SENSORS)
+        {
+            topics.push_back(std::string{ "homeassistant/sensor/lywsd03mmc_" } +
+                             id + "_" + sensor + "/state");
+        }
+    }
+
+    return topics;
+}
+
+static std::size_t varint_size(std::size_t value)
+{
+    std::size_t size = 1;
+
+    while (value >= 128)
+    {
+        value /= 128;
+        ++size;
+    }
+
+    return size;
+}
+
+// PUBLISH packet size on the wire, QoS 0.
+static std::size_t publish_size(std::size_t topic_size,
+    std::size_t payload_size, bool v5, bool alias)
+{
+    std::size_t remaining = 2 + topic_size + payload_size;
+
+    if (v5)
+    {
+        const std::size_t properties = alias ? 3 : 0; // Topic Alias, u16.
+        remaining += varint_size(properties) + properties;
+    }
+
+    return 1 + varint_size(remaining) + remaining;
+}
+
+// Readings arrive from random sensors of the fleet, with 2 to 4 byte
+// payloads. Reports the bytes sent per publish over MQTT 3.1.1 and over
+// MQTT 5 with topic aliases. Args: devices, alias limit.
+static void topic_alias_bytes(benchmark::State& state)
+{
+    const auto topics = make_topics(static_cast<std::size_t>(state.range(0)));
+    alias_model aliases{ static_cast<std::size_t>(state.range(1)) };
+
+    std::minstd_rand rng{ 42 };
+    std::uniform_int_distribution<std::size_t> pick{ 0, topics.size() - 1 };
+    std::uniform_int_distribution<std::size_t> payload{ 2, 4 };
+
+    std::uint64_t publishes  = 0;
+    std::uint64_t bytes_v311 = 0;
+    std::uint64_t bytes_v5   = 0;
+    std::uint64_t bound      = 0;
+
+    for (auto _ : state)
+    {
+        const std::string& topic      = topics[pick(rng)];
+        const std::size_t payload_size = payload(rng);
+
+        const auto alias = aliases.assign(topic);
+        benchmark::DoNotOptimize(alias);
+
+        bytes_v311 += publish_size(topic.size(), payload_size, false, false);
+        bytes_v5 += publish_size(alias.bound ? 0 : topic.size(),
+            payload_size,
+            true,
+            alias.assigned);
+        bound += alias.bound ? 1 : 0;
+        ++publishes;
+    }
+
+    const auto per_publish = [publishes](std::uint64_t value) {
+        return static_cast<double>(value) / static_cast<double>(publishes);
+    };
+
+    state.counters["bytes_v311"] = per_publish(bytes_v311);
+    state.counters["bytes_v5"]   = per_publish(bytes_v5);
+    state.counters["saved"] =
+        1.0 - static_cast<double>(bytes_v5) / static_cast<double>(bytes_v311);
+    state.counters["alias_hits"] = per_publish(bound);
+}
+BENCHMARK(topic_alias_bytes)
+    ->ArgNames({ "devices", "aliases" })
+    ->ArgsProduct({ { 1, 3, 10, 30 }, { 10, 64 } });
@@ -20,147 +20,407 @@
 
 #include "mqtt/client.hpp"
 
+#include <algorithm>
+#include <memory>
+
 namespace b2h::mqtt
 {
-    std::uint8_t client::id = 0;
-
-    client::client(event::context& ctx) noexcept :
-        id_buff{},
+    client::client(event::context& ctx, session& owner) noexcept :
+        m_session{ owner },
         m_dispatcher{ ctx },
         m_receiver{ m_dispatcher.make_receiver() },
-        m_handle{ nullptr, &::esp_mqtt_client_destroy },
-        m_buffer{}
+        m_mutex{},
+        m_inflight{},
+        m_batch{},
+        m_outbound{},
+        m_self{ std::make_shared<client*>(this) }
     {
     }
 
-    tl::expected<void, esp_err_t> client::config(
-        const mqtt::config& cfg) noexcept
+    client::~client()
     {
-        log::debug(COMPONENT, "Got MQTT config. URI: {}", cfg.uri);
+        m_session.detach(*this);
 
-        esp_mqtt_client_config_t config{};
-        config.uri = cfg.uri.c_str();
+        // Handlers of unacknowledged publishes are never called, release
+        // their hold on the context.
+        for (const auto& entry : m_inflight)
+        {
+            if (entry.handler)
+            {
+                --m_dispatcher.context().active_events();
+            }
+        }
+    }
 
-        if (!cfg.username.empty())
+    void client::request(const char* topic, int qos) noexcept
+    {
+        using namespace b2h::events::mqtt;
+
+        const int msg_id = m_session.subscribe(*this, topic, qos);
+
+        if (msg_id == -1)
         {
-            config.username = cfg.username.c_str();
+            m_dispatcher.async_dispatch<subscribe>(
+                tl::make_unexpected(ESP_FAIL));
+            return;
         }
 
-        if (!cfg.password.empty())
+        if (msg_id == 0)
         {
-            config.password = cfg.password.c_str();
+            m_dispatcher.async_dispatch<subscribe>({});
+            return;
         }
 
-        fmt::format_to(id_buff.begin(), "{0:2x}", id);
-        ++id;
+        m_session.track(this, msg_id);
+    }
+
+    void client::request(tcb::span<const subscription> topics) noexcept
+    {
+        {
+            std::lock_guard<std::mutex> lock{ m_mutex };
 
-        config.client_id = id_buff.data();
-        config.disable_clean_session =
-            static_cast<int>(cfg.disable_clean_session);
+            m_batch.msg_ids.assign(topics.size(), -1);
+            m_batch.results.assign(topics.size(), ESP_FAIL);
 
-        log::debug(COMPONENT, "Client ID set to: {}.", id_buff.data());
+            // One extra count is held until every request is sent, early
+            // acknowledgements must not complete the batch.
+            m_batch.remaining = topics.size() + 1;
+        }
 
-        if (m_handle =
-                handle_ptr{
-                    ::esp_mqtt_client_init(&config),
-                    &::esp_mqtt_client_destroy,
-                };
-            !m_handle)
+        for (std::size_t i = 0; i < topics.size(); ++i)
         {
-            log::error(COMPONENT,
-                "Failed to initialize MQTT client, error code: {0} [{1}]",
-                ESP_FAIL,
-                ::esp_err_to_name(ESP_FAIL));
-            return tl::make_unexpected(ESP_FAIL);
+            const int msg_id =
+                m_session.subscribe(*this, topics[i].topic, topics[i].qos);
+
+            if (msg_id > 0)
+            {
+                {
+                    std::lock_guard<std::mutex> lock{ m_mutex };
+                    m_batch.msg_ids[i] = msg_id;
+                }
+
+                m_session.track(this, msg_id);
+                continue;
+            }
+
+            if (msg_id == -1)
+            {
+                log::warning(COMPONENT,
+                    "Failed to subscribe to topic: {}",
+                    topics[i].topic);
+            }
+
+            answer(i, msg_id == 0 ? ESP_OK : ESP_FAIL);
         }
 
-        return {};
+        answer(topics.size(), ESP_OK);
     }
 
-    void client::mqtt_event_callback(void* handler_args, esp_event_base_t base,
-        int32_t event_id, void* event) noexcept
+    void client::answer(std::size_t index, esp_err_t result) noexcept
     {
         using namespace b2h::events::mqtt;
 
-        esp_mqtt_event_handle_t event_data =
-            reinterpret_cast<esp_mqtt_event_handle_t>(event);
-        client* client_ptr = static_cast<client*>(handler_args);
+        std::vector<esp_err_t> results;
 
-        switch (event_data->event_id)
-        {
-        case MQTT_EVENT_DATA:
         {
-            log::debug(COMPONENT, "Event: MQTT_EVENT_DATA");
-            log::verbose(COMPONENT,
-                "topic: {}, data: {}",
-                std::string_view{ event_data->topic,
-                    static_cast<std::size_t>(event_data->topic_len) },
-                std::string_view{ event_data->data,
-                    static_cast<std::size_t>(event_data->data_len) });
+            std::lock_guard<std::mutex> lock{ m_mutex };
 
-            client_ptr->m_buffer.resize(
-                event_data->topic_len + event_data->data_len);
+            if (index < m_batch.results.size())
+            {
+                m_batch.msg_ids[index] = -1;
+                m_batch.results[index] = result;
+            }
 
+            if (--m_batch.remaining != 0)
             {
-                auto iter = std::copy(event_data->topic,
-                    event_data->topic + event_data->topic_len,
-                    client_ptr->m_buffer.begin());
+                return;
+            }
+
+            results = std::move(m_batch.results);
+            m_batch.msg_ids.clear();
+        }
+
+        m_dispatcher.async_dispatch<subscribe_batch>(std::move(results));
+    }
 
-                std::copy(event_data->data,
-                    event_data->data + event_data->data_len,
-                    iter);
+    void client::subscribed(int msg_id) noexcept
+    {
+        using namespace b2h::events::mqtt;
+
+        std::size_t index = 0;
+        bool batched      = false;
+
+        {
+            std::lock_guard<std::mutex> lock{ m_mutex };
+
+            auto iter = std::find(m_batch.msg_ids.cbegin(),
+                m_batch.msg_ids.cend(),
+                msg_id);
+
+            batched = iter != m_batch.msg_ids.cend();
+            index   = std::distance(m_batch.msg_ids.cbegin(), iter);
+        }
+
+        if (!batched)
+        {
+            m_dispatcher.async_dispatch<subscribe>({});
+            return;
+        }
+
+        answer(index, ESP_OK);
+    }
+
+    std::size_t client::reserve(publish_handler_type&& handler) noexcept
+    {
+        std::size_t slot = MAX_INFLIGHT;
+
+        {
+            std::lock_guard<std::mutex> lock{ m_mutex };
+
+            auto iter = std::find_if(m_inflight.begin(),
+                m_inflight.end(),
+                [](const inflight& entry) { return !entry.handler; });
+
+            if (iter != m_inflight.end())
+            {
+                iter->msg_id  = -1;
+                iter->handler = std::move(handler);
+                slot          = std::distance(m_inflight.begin(), iter);
             }
+        }
 
-            client_ptr->m_dispatcher.async_dispatch<data>(data_args{
-                std::string_view{
-                    client_ptr->m_buffer.data(),
-                    static_cast<std::size_t>(event_data->topic_len),
-                },
-                std::string_view{
-                    client_ptr->m_buffer.data() + event_data->topic_len,
-                    static_cast<std::size_t>(event_data->data_len),
-                },
+        ++m_dispatcher.context().active_events();
+
+        if (slot == MAX_INFLIGHT)
+        {
+            log::warning(COMPONENT, "Too many publishes in flight.");
+
+            auto& context = m_dispatcher.context();
+            context.shedule([&active_events = context.active_events(),
+                                handler{ std::move(handler) }]() {
+                --active_events;
+                handler(tl::make_unexpected(ESP_ERR_NO_MEM));
             });
+        }
+
+        return slot;
+    }
+
+    void client::min_interval(
+        std::string_view topic, std::chrono::milliseconds interval) noexcept
+    {
+        auto iter = std::find_if(m_outbound.begin(),
+            m_outbound.end(),
+            [topic](const outbound& entry) { return entry.topic == topic; });
+
+        if (iter == m_outbound.end())
+        {
+            iter = m_outbound.insert(m_outbound.end(), outbound{});
+            iter->topic = topic;
+        }
+
+        iter->interval = interval;
+    }
+
+    void client::publish(const char* topic, std::string_view data, int qos,
+        bool retain, publish_handler_type&& handler) noexcept
+    {
+        auto iter = std::find_if(m_outbound.begin(),
+            m_outbound.end(),
+            [topic](const outbound& entry) { return entry.topic == topic; });
 
-            break;
+        if (iter == m_outbound.end())
+        {
+            send(*m_outbound.insert(m_outbound.end(), outbound{ topic }),
+                data,
+                qos,
+                retain,
+                std::move(handler));
+            return;
         }
-        case MQTT_EVENT_PUBLISHED:
+
+        const auto now = clock_type::now();
+
+        if (!iter->busy && now >= iter->next)
         {
-            log::debug(COMPONENT, "Event: MQTT_EVENT_PUBLISHED");
-            client_ptr->m_dispatcher.async_dispatch<publish>({});
-            break;
+            send(*iter, data, qos, retain, std::move(handler));
+            return;
         }
-        case MQTT_EVENT_SUBSCRIBED:
+
+        if (iter->held)
         {
-            log::debug(COMPONENT, "Event: MQTT_EVENT_SUBSCRIBED");
-            client_ptr->m_dispatcher.async_dispatch<subscribe>({});
-            break;
+            B2H_LOG_VERBOSE(COMPONENT, "Coalesced publish on: {}", topic);
+            post(std::move(iter->handler), {});
         }
-        case MQTT_EVENT_UNSUBSCRIBED:
+
+        iter->held    = true;
+        iter->data    = data;
+        iter->qos     = qos;
+        iter->retain  = retain;
+        iter->handler = std::move(handler);
+
+        if (!iter->busy)
         {
-            log::debug(COMPONENT, "Event: MQTT_EVENT_UNSUBSCRIBED");
-            client_ptr->m_dispatcher.async_dispatch<unsubscribe>({});
-            break;
+            arm(*iter, iter->next - now);
         }
-        case MQTT_EVENT_CONNECTED:
+    }
+
+    void client::send(outbound& entry, std::string_view data, int qos,
+        bool retain, publish_handler_type&& handler) noexcept
+    {
+        entry.busy = true;
+        entry.next = clock_type::now() + entry.interval;
+
+        transmit(entry.topic.c_str(),
+            data,
+            qos,
+            retain,
+            [this, &entry, handler{ std::move(handler) }](
+                events::mqtt::publish::expected_type result) {
+                settle(entry);
+                handler(std::move(result));
+            });
+    }
+
+    void client::settle(outbound& entry) noexcept
+    {
+        entry.busy = false;
+
+        if (entry.held)
         {
-            log::debug(COMPONENT, "Event: MQTT_EVENT_CONNECTED");
-            client_ptr->m_dispatcher.async_dispatch<connect>({});
-            // client_ptr->m_dispatcher.async_dispatch<connected>({});
-            break;
+            const auto now = clock_type::now();
+
+            if (now < entry.next)
+            {
+                arm(entry, entry.next - now);
+                return;
+            }
+
+            // The pipeline copies the data before send returns.
+            entry.held = false;
+            send(entry,
+                entry.data,
+                entry.qos,
+                entry.retain,
+                std::move(entry.handler));
+            return;
         }
-        case MQTT_EVENT_DISCONNECTED:
+
+        if (entry.interval == std::chrono::milliseconds::zero())
         {
-            log::debug(COMPONENT, "Event: MQTT_EVENT_DISCONNECTED");
-            client_ptr->m_dispatcher.async_dispatch<disconnect>({});
-            // client_ptr->m_dispatcher.async_dispatch<disconnected>({});
-            break;
+            m_outbound.remove_if(
+                [&entry](const outbound& other) { return &other == &entry; });
         }
-        default:
+    }
+
+    void client::arm(outbound& entry, clock_type::duration delay) noexcept
+    {
+        entry.busy = true;
+
+        auto& context = m_dispatcher.context();
+        ++context.active_events();
+        context.shedule_after(delay,
+            [&active_events = context.active_events(),
+                self  = std::weak_ptr<client*>{ m_self },
+                entry = &entry]() {
+                --active_events;
+
+                if (const auto owner = self.lock())
+                {
+                    (*owner)->settle(*entry);
+                }
+            });
+    }
+
+    void client::transmit(const char* topic, std::string_view data, int qos,
+        bool retain, publish_handler_type&& handler) noexcept
+    {
+        const std::size_t slot = reserve(std::move(handler));
+
+        if (slot == MAX_INFLIGHT)
         {
-            log::debug(COMPONENT, "Other event: {0}.", event_data->event_id);
-            break;
+            return;
         }
+
+        const int msg_id = m_session.publish(topic, data, qos, retain);
+
+        if (msg_id == -1)
+        {
+            complete(slot, tl::make_unexpected(ESP_FAIL));
+            return;
+        }
+
+        if (msg_id == 0)
+        {
+            // QoS 0 or spooled, no acknowledgement follows.
+            complete(slot, {});
+            return;
+        }
+
+        bind(slot, msg_id);
+        m_session.track(this, msg_id);
+    }
+
+    void client::post(publish_handler_type&& handler,
+        events::mqtt::publish::expected_type&& result) noexcept
+    {
+        auto& context = m_dispatcher.context();
+        ++context.active_events();
+        context.shedule([&active_events = context.active_events(),
+                            handler{ std::move(handler) },
+                            result{ std::move(result) }]() {
+            --active_events;
+            handler(std::move(result));
+        });
+    }
+
+    void client::bind(std::size_t slot, int msg_id) noexcept
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        m_inflight[slot].msg_id = msg_id;
+    }
+
+    void client::complete(std::size_t slot,
+        events::mqtt::publish::expected_type&& result) noexcept
+    {
+        publish_handler_type handler;
+
+        {
+            std::lock_guard<std::mutex> lock{ m_mutex };
+            handler                 = std::move(m_inflight[slot].handler);
+            m_inflight[slot].handler = nullptr;
+        }
+
+        auto& context = m_dispatcher.context();
+        context.shedule([&active_events = context.active_events(),
+                            handler{ std::move(handler) },
+                            result{ std::move(result) }]() {
+            --active_events;
+            handler(std::move(result));
+        });
+    }
+
+    void client::acknowledge(int msg_id) noexcept
+    {
+        std::size_t slot = MAX_INFLIGHT;
+
+        {
+            std::lock_guard<std::mutex> lock{ m_mutex };
+
+            auto iter = std::find_if(m_inflight.cbegin(),
+                m_inflight.cend(),
+                [msg_id](const inflight& entry) {
+                    return entry.handler && entry.msg_id == msg_id;
+                });
+
+            if (iter == m_inflight.cend())
+            {
+                return;
+            }
+
+            slot = std::distance(m_inflight.cbegin(), iter);
         }
+
+        complete(slot, {});
     }
 } // namespace b2h::mqtt
@@ -0,0 +1,179 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "mqtt/inbound.hpp"
+
+#include <algorithm>
+#include <utility>
+
+#include "utils/logger.hpp"
+
+namespace b2h::mqtt
+{
+    static constexpr log::component COMPONENT{ "mqtt::inbound" };
+
+    message_ref::message_ref(const message_ref& other) noexcept :
+        m_slot{ other.m_slot }
+    {
+        if (m_slot)
+        {
+            m_slot->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    message_ref::message_ref(message_ref&& other) noexcept :
+        m_slot{ other.m_slot }
+    {
+        other.m_slot = nullptr;
+    }
+
+    message_ref::~message_ref()
+    {
+        if (m_slot)
+        {
+            m_slot->refs.fetch_sub(1, std::memory_order_acq_rel);
+        }
+    }
+
+    message_ref& message_ref::operator=(const message_ref& other) noexcept
+    {
+        message_ref copy{ other };
+        std::swap(m_slot, copy.m_slot);
+        return *this;
+    }
+
+    message_ref& message_ref::operator=(message_ref&& other) noexcept
+    {
+        message_ref moved{ std::move(other) };
+        std::swap(m_slot, moved.m_slot);
+        return *this;
+    }
+
+    std::string_view message_ref::topic() const noexcept
+    {
+        return m_slot ? std::string_view{ m_slot->buffer.data(),
+                            m_slot->topic_len }
+                      : std::string_view{};
+    }
+
+    std::string_view message_ref::data() const noexcept
+    {
+        return m_slot ? std::string_view{ m_slot->buffer.data() +
+                                              m_slot->topic_len,
+                            m_slot->size - m_slot->topic_len }
+                      : std::string_view{};
+    }
+
+    inbound_ring::inbound_ring() noexcept :
+        m_slots{},
+        m_next{ 0 },
+        m_assembling{ nullptr }
+    {
+    }
+
+    message_ref inbound_ring::append(std::string_view topic,
+        std::string_view data,
+        std::size_t offset,
+        std::size_t total) noexcept
+    {
+        if (offset == 0)
+        {
+            if (m_assembling)
+            {
+                log::warning(COMPONENT, "Incomplete message dropped.");
+                drop();
+            }
+
+            if (topic.size() + total > INBOUND_SLOT_SIZE)
+            {
+                log::warning(COMPONENT,
+                    "Message on {} is too large ({} B), dropped.",
+                    topic,
+                    total);
+                return {};
+            }
+
+            if (m_assembling = acquire(); !m_assembling)
+            {
+                log::warning(COMPONENT,
+                    "No free inbound slot, message on {} dropped.",
+                    topic);
+                return {};
+            }
+
+            std::copy(topic.cbegin(),
+                topic.cend(),
+                m_assembling->buffer.begin());
+            m_assembling->topic_len = topic.size();
+            m_assembling->size      = topic.size();
+        }
+        else if (!m_assembling)
+        {
+            // Remaining fragment of a dropped message.
+            return {};
+        }
+
+        if (offset != m_assembling->size - m_assembling->topic_len ||
+            offset + data.size() > total)
+        {
+            log::warning(COMPONENT, "Unexpected fragment, message dropped.");
+            drop();
+            return {};
+        }
+
+        std::copy(data.cbegin(),
+            data.cend(),
+            m_assembling->buffer.begin() + m_assembling->size);
+        m_assembling->size += data.size();
+
+        if (offset + data.size() < total)
+        {
+            return {};
+        }
+
+        // The reference held while assembling passes to the caller.
+        return message_ref{ std::exchange(m_assembling, nullptr) };
+    }
+
+    inbound_ring::slot* inbound_ring::acquire() noexcept
+    {
+        for (std::size_t i = 0; i < m_slots.size(); ++i)
+        {
+            slot& candidate = m_slots[(m_next + i) % m_slots.size()];
+
+            // Only the producer takes a reference to a free slot, nobody
+            // can race this one.
+            if (candidate.refs.load(std::memory_order_acquire) == 0)
+            {
+                candidate.refs.store(1, std::memory_order_relaxed);
+                m_next = (m_next + i + 1) % m_slots.size();
+                return &candidate;
+            }
+        }
+
+        return nullptr;
+    }
+
+    void inbound_ring::drop() noexcept
+    {
+        m_assembling->refs.store(0, std::memory_order_release);
+        m_assembling = nullptr;
+    }
+} // namespace b2h::mqtt
@@ -21,65 +21,76 @@
 #ifndef B2H_MQTT_CLIENT_HPP
 #define B2H_MQTT_CLIENT_HPP
 
+#include <array>
+#include <chrono>
+#include <functional>
+#include <list>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include "esp_err.h"
 #include "mqtt_client.h"
 
+#if __has_include("sdkconfig.h")
+#include "sdkconfig.h"
+#endif
+
+#include "tcb/span.hpp"
 #include "tl/expected.hpp"
 
 #include "event/event.hpp"
+#include "mqtt/session.hpp"
 #include "utils/logger.hpp"
 
+// Publishes a channel may have awaiting their broker acknowledgement. Further
+// publishes fail with ESP_ERR_NO_MEM until one of them completes.
+#ifndef B2H_MQTT_MAX_INFLIGHT
+#ifdef CONFIG_B2H_MQTT_MAX_INFLIGHT
+#define B2H_MQTT_MAX_INFLIGHT CONFIG_B2H_MQTT_MAX_INFLIGHT
+#else
+#define B2H_MQTT_MAX_INFLIGHT 8
+#endif
+#endif
+
 namespace b2h
 {
-    namespace events::mqtt
+    namespace mqtt
     {
-        struct data_args {
-            std::string_view topic;
-            std::string_view data;
-        };
-
-        struct data : public event::basic_event<data_args, esp_err_t> {
-        };
-
-        struct subscribe : public event::basic_event<void, esp_err_t> {
-        };
-
-        struct unsubscribe : public event::basic_event<void, esp_err_t> {
-        };
-
-        struct publish : public event::basic_event<void, esp_err_t> {
-        };
+        static constexpr log::component COMPONENT{ "mqtt::client" };
 
-        struct connect : public event::basic_event<void, esp_err_t> {
-        };
-
-        struct disconnect : public event::basic_event<void, esp_err_t> {
-        };
+        inline constexpr std::size_t MAX_INFLIGHT{ B2H_MQTT_MAX_INFLIGHT };
 
-    } // namespace events::mqtt
-
-    namespace mqtt
-    {
-        struct config {
-            std::string uri;
-            std::string username;
-            std::string password;
-            bool disable_clean_session;
+        struct subscription {
+            const char* topic;
+            int qos;
         };
 
-        static constexpr std::string_view COMPONENT = "mqtt::client";
-
+        /**
+         * @brief Per-device channel of a shared mqtt::session.
+         *
+         * Publishes, subscriptions and inbound data of the channel are
+         * delivered to its own handlers only. The channel holds no network
+         * resources, the connection is owned by the session.
+         *
+         * Up to MAX_INFLIGHT publishes may be outstanding at once, each
+         * handler is completed individually when the broker acknowledges
+         * its msg_id.
+         *
+         * Only one publish per topic is outstanding. Values published to a
+         * busy topic are coalesced, the latest one is sent when the topic
+         * frees up and the handlers of superseded values complete
+         * successfully. Publishing is expected on the context thread.
+         *
+         */
         class client final
         {
         public:
             client() = delete;
 
-            explicit client(event::context& ctx) noexcept;
+            client(event::context& ctx, session& owner) noexcept;
 
             client(const client&) = delete;
 
@@ -89,98 +100,25 @@ namespace b2h
 
             client& operator=(client&& other) = delete;
 
-            ~client() = default;
+            ~client();
 
             auto& receiver() noexcept
             {
                 return m_receiver;
             }
 
-            tl::expected<void, esp_err_t> config(const config& cfg) noexcept;
-
-            template<typename HandlerT>
-            void async_connect(HandlerT&& handler) noexcept
-            {
-                using namespace b2h::events::mqtt;
-
-                assert(static_cast<bool>(m_handle));
-
-                log::debug(COMPONENT, "Attempting to connect.");
-
-                m_receiver.async_receive<connect>(
-                    std::forward<HandlerT>(handler));
-
-                esp_err_t result = ESP_OK;
-
-                if (result = ::esp_mqtt_client_register_event(m_handle.get(),
-                        static_cast<esp_mqtt_event_id_t>(ESP_EVENT_ANY_ID),
-                        &mqtt_event_callback,
-                        static_cast<void*>(this));
-                    result != ESP_OK)
-                {
-                    log::error(COMPONENT,
-                        "Failed to register events, error code: {0} [{1}]",
-                        result,
-                        ::esp_err_to_name(result));
-                    m_dispatcher.async_dispatch<connect>(
-                        tl::make_unexpected(result));
-                    return;
-                }
-
-                if (result = ::esp_mqtt_client_start(m_handle.get());
-                    result != ESP_OK)
-                {
-                    log::error(COMPONENT,
-                        "Failed to start, error code: {0} [{1}]",
-                        result,
-                        ::esp_err_to_name(result));
-                    m_dispatcher.async_dispatch<connect>(
-                        tl::make_unexpected(result));
-                    return;
-                }
-
-                log::info(COMPONENT, "Successfully started MQTT client.");
-            }
-
-            template<typename HandlerT>
-            void async_disconnect(HandlerT&& handler) noexcept
-            {
-                using namespace b2h::events::mqtt;
-
-                assert(static_cast<bool>(m_handle));
-
-                log::debug(COMPONENT, "Attempting to disconnect.");
-
-                m_receiver.async_receive<disconnect>(
-                    std::forward<HandlerT>(handler));
-
-                if (::esp_mqtt_client_stop(m_handle.get()) != ESP_OK)
-                {
-                    m_dispatcher.async_dispatch<events::mqtt::disconnect>(
-                        tl::make_unexpected(ESP_FAIL));
-                }
-            }
-
             template<typename HandlerT>
             void async_subscribe(
                 const char* topic, int qos, HandlerT&& handler) noexcept
             {
                 using namespace b2h::events::mqtt;
 
-                assert(static_cast<bool>(m_handle));
-
                 log::debug(COMPONENT, "Subscribing to topic.");
                 log::verbose(COMPONENT, "topic: {}", topic);
 
                 m_receiver.async_receive<subscribe>(
                     std::forward<HandlerT>(handler));
-
-                if (::esp_mqtt_client_subscribe(m_handle.get(), topic, qos) ==
-                    -1)
-                {
-                    m_dispatcher.async_dispatch<subscribe>(
-                        tl::make_unexpected(ESP_FAIL));
-                }
+                request(topic, qos);
             }
 
             template<typename HandlerT>
@@ -207,25 +145,44 @@ namespace b2h
                     std::forward<HandlerT>(handler));
             }
 
+            /**
+             * @brief Subscribe to several topics at once.
+             *
+             * The requests are sent back to back without waiting for each
+             * acknowledgement. The handler is called once, with a result
+             * per topic in the order given.
+             *
+             * @param topics Topics to subscribe to, must stay valid until
+             * the call returns.
+             * @param handler Called with std::vector<esp_err_t>.
+             */
+            template<typename HandlerT>
+            void async_subscribe(tcb::span<const subscription> topics,
+                HandlerT&& handler) noexcept
+            {
+                using namespace b2h::events::mqtt;
+
+                log::debug(COMPONENT,
+                    "Subscribing to {} topics.",
+                    topics.size());
+
+                m_receiver.async_receive<subscribe_batch>(
+                    std::forward<HandlerT>(handler));
+                request(topics);
+            }
+
             template<typename HandlerT>
             void async_unsubscribe(
                 const char* topic, HandlerT&& handler) noexcept
             {
                 using namespace b2h::events::mqtt;
 
-                assert(static_cast<bool>(m_handle));
-
                 log::debug(COMPONENT, "Unsubscribing from topic.");
                 log::verbose(COMPONENT, "topic: {}", topic);
 
                 m_receiver.async_receive<unsubscribe>(
                     std::forward<HandlerT>(handler));
-
-                if (::esp_mqtt_client_unsubscribe(m_handle.get(), topic) == -1)
-                {
-                    m_dispatcher.async_dispatch<unsubscribe>(
-                        tl::make_unexpected(ESP_FAIL));
-                }
+                m_session.unsubscribe(*this, topic);
             }
 
             template<typename HandlerT>
@@ -242,31 +199,23 @@ namespace b2h
             {
                 using namespace b2h::events::mqtt;
 
-                assert(static_cast<bool>(m_handle));
-
-                log::debug(COMPONENT, "Publishing MQTT data.");
-                log::verbose(COMPONENT, "topic: {}; data: {}", topic, data);
-
-                m_receiver.async_receive<publish>(
-                    std::forward<HandlerT>(handler));
-
-                if (::esp_mqtt_client_enqueue(m_handle.get(),
-                        topic,
-                        data.data(),
-                        data.size(),
-                        qos,
-                        static_cast<int>(retain),
-                        true) == -1)
-                {
-                    m_dispatcher.async_dispatch<publish>(
-                        tl::make_unexpected(ESP_FAIL));
-                    return;
-                }
-
-                if (qos == 0)
-                {
-                    m_dispatcher.async_dispatch<publish>({});
-                }
+                B2H_LOG_EVERY_N(log::log_level::debug,
+                    COMPONENT,
+                    16,
+                    "Publishing MQTT data.");
+                B2H_LOG_RATE_LIMITED(log::log_level::verbose,
+                    COMPONENT,
+                    5,
+                    10,
+                    "topic: {}; data: {}",
+                    topic,
+                    data);
+
+                publish(topic,
+                    data,
+                    qos,
+                    retain,
+                    publish_handler_type{ std::forward<HandlerT>(handler) });
             }
 
             template<typename HandlerT>
@@ -280,48 +229,149 @@ namespace b2h
                     std::forward<HandlerT>(handler));
             }
 
+            /**
+             * @brief Publish to the topic at most once per interval.
+             *
+             * Values published within the interval are coalesced, the
+             * latest one is sent once the interval elapses.
+             *
+             * @param topic Topic name.
+             * @param interval Minimum interval, zero removes the limit.
+             */
+            void min_interval(std::string_view topic,
+                std::chrono::milliseconds interval) noexcept;
+
             template<typename HandlerT>
             void async_receive(HandlerT&& handler) noexcept
             {
                 using namespace b2h::events::mqtt;
 
-                log::debug(COMPONENT, "Waiting for data.");
+                B2H_LOG_DEBUG(COMPONENT, "Waiting for data.");
                 m_receiver.async_receive<data>(std::forward<HandlerT>(handler));
             }
 
         private:
+            friend class session;
+
             // clang-format off
             using dispatcher_type = event::dispatcher<
-                b2h::events::mqtt::connect,
                 b2h::events::mqtt::data,
-                b2h::events::mqtt::disconnect,
-                b2h::events::mqtt::publish,
                 b2h::events::mqtt::subscribe,
+                b2h::events::mqtt::subscribe_batch,
                 b2h::events::mqtt::unsubscribe
             >;
 
             using receiver_type = typename dispatcher_type::receiver_type;
 
-            using handle_ptr = std::unique_ptr<
-                esp_mqtt_client, 
-                decltype(&::esp_mqtt_client_destroy)
+            using publish_handler_type = std::function<
+                void(b2h::events::mqtt::publish::expected_type)
             >;
             // clang-format on
 
-            static std::uint8_t id;
-
-            std::array<char, 3> id_buff;
+            /**
+             * @brief Publish awaiting completion. Free when handler is empty.
+             *
+             */
+            struct inflight {
+                int msg_id;
+                publish_handler_type handler;
+            };
+
+            /**
+             * @brief Subscriptions requested together, answered at once.
+             *
+             */
+            struct batch {
+                std::vector<int> msg_ids; // -1 once answered.
+                std::vector<esp_err_t> results;
+                std::size_t remaining;
+            };
+
+            using clock_type = std::chrono::steady_clock;
+
+            /**
+             * @brief Coalescing state of a topic, kept while the topic is
+             * busy or has a minimum interval.
+             *
+             */
+            struct outbound {
+                std::string topic{};
+                std::chrono::milliseconds interval{ 0 };
+                clock_type::time_point next{}; // Earliest time to send again.
+                bool busy{ false };            // Publish or timer pending.
+                bool held{ false };            // Value below awaits sending.
+                std::string data{};
+                int qos{ 0 };
+                bool retain{ false };
+                publish_handler_type handler{};
+            };
+
+            session& m_session;
 
             dispatcher_type m_dispatcher;
             receiver_type m_receiver;
 
-            handle_ptr m_handle;
+            std::mutex m_mutex;
+            std::array<inflight, MAX_INFLIGHT> m_inflight;
+            batch m_batch;
+
+            // Accessed on the context thread only, entries are referenced
+            // by pending completions and must not move.
+            std::list<outbound> m_outbound;
+
+            // Expires with the channel, checked by pending timers.
+            std::shared_ptr<client*> m_self;
+
+            void request(const char* topic, int qos) noexcept;
+
+            void request(tcb::span<const subscription> topics) noexcept;
+
+            /**
+             * @brief Record the result of a batched subscription, the
+             * batch handler is called after the last one.
+             *
+             * @param index Position in the batch, out of range only counts
+             * down.
+             * @param result Result of the subscription.
+             */
+            void answer(std::size_t index, esp_err_t result) noexcept;
+
+            void subscribed(int msg_id) noexcept;
+
+            void publish(const char* topic, std::string_view data, int qos,
+                bool retain, publish_handler_type&& handler) noexcept;
+
+            void send(outbound& entry, std::string_view data, int qos,
+                bool retain, publish_handler_type&& handler) noexcept;
+
+            /**
+             * @brief Mark the topic free and send its held value, if any.
+             *
+             */
+            void settle(outbound& entry) noexcept;
+
+            void arm(outbound& entry, clock_type::duration delay) noexcept;
+
+            void transmit(const char* topic, std::string_view data, int qos,
+                bool retain, publish_handler_type&& handler) noexcept;
+
+            void post(publish_handler_type&& handler,
+                b2h::events::mqtt::publish::expected_type&& result) noexcept;
+
+            /**
+             * @brief Store the handler in a free slot.
+             *
+             * @return Slot index or MAX_INFLIGHT if all slots are taken, the
+             * handler is then completed with ESP_ERR_NO_MEM.
+             */
+            std::size_t reserve(publish_handler_type&& handler) noexcept;
+
+            void bind(std::size_t slot, int msg_id) noexcept;
 
-            std::string m_buffer;
+            void complete(std::size_t slot,
+                b2h::events::mqtt::publish::expected_type&& result) noexcept;
 
-            static void mqtt_event_callback(void* handler_args,
-                esp_event_base_t base, std::int32_t event_id,
-                void* event) noexcept;
+            void acknowledge(int msg_id) noexcept;
         };
 
     } // namespace mqtt
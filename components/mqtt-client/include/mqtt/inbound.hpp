@@ -0,0 +1,152 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef B2H_MQTT_INBOUND_HPP
+#define B2H_MQTT_INBOUND_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Messages that may be held by handlers at once. A message arriving while
+// all slots are held is dropped.
+#ifndef B2H_MQTT_INBOUND_SLOTS
+#define B2H_MQTT_INBOUND_SLOTS 4
+#endif
+
+// Capacity of a single slot, topic and payload together. Larger messages
+// are dropped.
+#ifndef B2H_MQTT_INBOUND_SLOT_SIZE
+#define B2H_MQTT_INBOUND_SLOT_SIZE 256
+#endif
+
+namespace b2h::mqtt
+{
+    inline constexpr std::size_t INBOUND_SLOTS{ B2H_MQTT_INBOUND_SLOTS };
+
+    inline constexpr std::size_t INBOUND_SLOT_SIZE{
+        B2H_MQTT_INBOUND_SLOT_SIZE
+    };
+
+    class inbound_ring;
+
+    /**
+     * @brief Shared reference to a message stored in an inbound_ring slot.
+     *
+     * The slot is reused only after every reference to it is destroyed, so
+     * views returned by topic() and data() stay valid as long as the
+     * reference lives.
+     *
+     */
+    class message_ref final
+    {
+    public:
+        message_ref() noexcept : m_slot{ nullptr }
+        {
+        }
+
+        message_ref(const message_ref& other) noexcept;
+
+        message_ref(message_ref&& other) noexcept;
+
+        ~message_ref();
+
+        message_ref& operator=(const message_ref& other) noexcept;
+
+        message_ref& operator=(message_ref&& other) noexcept;
+
+        explicit operator bool() const noexcept
+        {
+            return m_slot != nullptr;
+        }
+
+        std::string_view topic() const noexcept;
+
+        std::string_view data() const noexcept;
+
+    private:
+        friend class inbound_ring;
+
+        struct slot {
+            std::atomic<std::uint8_t> refs;
+            std::size_t topic_len;
+            std::size_t size;
+            std::array<char, INBOUND_SLOT_SIZE> buffer;
+        };
+
+        explicit message_ref(slot* owned) noexcept : m_slot{ owned }
+        {
+        }
+
+        slot* m_slot;
+    };
+
+    /**
+     * @brief Fixed ring of inbound message slots.
+     *
+     * Reassembles messages esp-mqtt delivers in fragments directly into a
+     * slot and hands the complete message out as a message_ref. Messages
+     * are written by a single producer, the MQTT task. References may be
+     * released from any thread.
+     *
+     */
+    class inbound_ring final
+    {
+    public:
+        inbound_ring() noexcept;
+
+        inbound_ring(const inbound_ring&) = delete;
+        inbound_ring(inbound_ring&&)      = delete;
+        ~inbound_ring()                   = default;
+
+        inbound_ring& operator=(const inbound_ring&) = delete;
+        inbound_ring& operator=(inbound_ring&&) = delete;
+
+        /**
+         * @brief Append a fragment of an inbound message.
+         *
+         * @param topic Topic name, given with the first fragment only.
+         * @param data Fragment of the payload.
+         * @param offset Offset of the fragment within the payload.
+         * @param total Length of the whole payload.
+         * @return Reference to the message once its last fragment is
+         * appended, empty reference otherwise or if the message is dropped.
+         */
+        message_ref append(std::string_view topic,
+            std::string_view data,
+            std::size_t offset,
+            std::size_t total) noexcept;
+
+    private:
+        using slot = message_ref::slot;
+
+        std::array<slot, INBOUND_SLOTS> m_slots;
+        std::size_t m_next;
+        slot* m_assembling;
+
+        slot* acquire() noexcept;
+
+        void drop() noexcept;
+    };
+} // namespace b2h::mqtt
+
+#endif
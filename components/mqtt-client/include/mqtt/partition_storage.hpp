@@ -0,0 +1,62 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef B2H_MQTT_PARTITION_STORAGE_HPP
+#define B2H_MQTT_PARTITION_STORAGE_HPP
+
+#include "esp_partition.h"
+
+#include "mqtt/spool.hpp"
+
+namespace b2h::mqtt
+{
+    /**
+     * @brief Spool storage backed by a data partition.
+     *
+     */
+    class partition_storage final : public spool_storage
+    {
+    public:
+        /**
+         * @brief Construct a new partition storage object.
+         *
+         * @param partition Partition to use, nullptr leaves the storage
+         * empty and the spool fails to mount.
+         */
+        explicit partition_storage(const esp_partition_t* partition) noexcept;
+
+        std::size_t size() const noexcept override;
+
+        std::size_t sector_size() const noexcept override;
+
+        esp_err_t read(std::size_t offset,
+            tcb::span<std::uint8_t> dst) noexcept override;
+
+        esp_err_t write(std::size_t offset,
+            tcb::span<const std::uint8_t> src) noexcept override;
+
+        esp_err_t erase(std::size_t sector) noexcept override;
+
+    private:
+        const esp_partition_t* m_partition;
+    };
+} // namespace b2h::mqtt
+
+#endif
@@ -0,0 +1,378 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef B2H_MQTT_ROUTER_HPP
+#define B2H_MQTT_ROUTER_HPP
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace b2h::mqtt
+{
+    /**
+     * @brief Topic filter trie mapping MQTT subscriptions to values.
+     *
+     * Each filter level is a trie node, '+' and '#' levels are kept apart
+     * from the named children, which are sorted for binary search. Matching
+     * a topic visits at most three branches per level, so its cost depends
+     * on the topic length, not on the number of registered filters.
+     *
+     * @tparam T Value stored per filter, e.g. a handler.
+     */
+    template<typename T>
+    class router
+    {
+    public:
+        using value_type = T;
+
+        router() : m_root{}, m_size{ 0 }
+        {
+        }
+
+        router(const router&) = delete;
+        router(router&&)      = default;
+        ~router()             = default;
+
+        router& operator=(const router&) = delete;
+        router& operator=(router&&) = default;
+
+        /**
+         * @brief Get the value of the filter, default constructing it if the
+         * filter is not registered yet.
+         *
+         * @param filter Topic filter, possibly with '+' and '#' wildcards.
+         * @return Reference to the value.
+         */
+        value_type& operator[](std::string_view filter)
+        {
+            node* current = &m_root;
+
+            for_each_level(filter, [&current](std::string_view level) {
+                current = &current->child(level);
+            });
+
+            if (!current->value)
+            {
+                current->value.emplace();
+                ++m_size;
+            }
+
+            return *current->value;
+        }
+
+        /**
+         * @brief Find the value of exactly this filter, wildcards are not
+         * expanded.
+         *
+         * @param filter Topic filter.
+         * @return Pointer to the value or nullptr if not registered.
+         */
+        value_type* find(std::string_view filter) noexcept
+        {
+            node* current = &m_root;
+
+            for_each_level(filter, [&current](std::string_view level) {
+                current = current ? current->find(level) : nullptr;
+            });
+
+            return current && current->value ? &*current->value : nullptr;
+        }
+
+        /**
+         * @brief Remove the filter, pruning the nodes left unused.
+         *
+         * @param filter Topic filter.
+         * @return true if the filter was registered.
+         */
+        bool erase(std::string_view filter) noexcept
+        {
+            if (!erase(m_root, filter, 0))
+            {
+                return false;
+            }
+
+            --m_size;
+            return true;
+        }
+
+        /**
+         * @brief Call visitor with the value of every filter matching the
+         * topic.
+         *
+         * @param topic Topic name of a received message.
+         * @param visitor Callable taking const value_type&.
+         */
+        template<typename VisitorT>
+        void match(std::string_view topic, VisitorT&& visitor) const
+        {
+            // Wildcards at the first level do not match topics starting
+            // with '$', reserved for broker internal topics.
+            const bool system = !topic.empty() && topic.front() == '$';
+
+            match(m_root, topic, 0, system, visitor);
+        }
+
+        /**
+         * @brief Call visitor with every registered filter and its value.
+         *
+         * @param visitor Callable taking (std::string_view, value_type&).
+         */
+        template<typename VisitorT>
+        void for_each(VisitorT&& visitor)
+        {
+            std::string filter;
+            for_each(m_root, filter, visitor);
+        }
+
+        std::size_t size() const noexcept
+        {
+            return m_size;
+        }
+
+        bool empty() const noexcept
+        {
+            return m_size == 0;
+        }
+
+    private:
+        struct node {
+            std::string level;
+            std::vector<std::unique_ptr<node>> children;
+            std::unique_ptr<node> single;
+            std::unique_ptr<node> multi;
+            std::optional<value_type> value;
+
+            bool unused() const noexcept
+            {
+                return !value && children.empty() && !single && !multi;
+            }
+
+            auto lower_bound(std::string_view name) const noexcept
+            {
+                return std::lower_bound(children.begin(),
+                    children.end(),
+                    name,
+                    [](const std::unique_ptr<node>& entry,
+                        std::string_view name) { return entry->level < name; });
+            }
+
+            node* find(std::string_view name) noexcept
+            {
+                if (name == "+")
+                {
+                    return single.get();
+                }
+
+                if (name == "#")
+                {
+                    return multi.get();
+                }
+
+                auto iter = lower_bound(name);
+                return iter != children.end() && (*iter)->level == name
+                           ? iter->get()
+                           : nullptr;
+            }
+
+            node& child(std::string_view name)
+            {
+                if (name == "+" || name == "#")
+                {
+                    auto& wildcard = name == "+" ? single : multi;
+
+                    if (!wildcard)
+                    {
+                        wildcard        = std::make_unique<node>();
+                        wildcard->level = name;
+                    }
+
+                    return *wildcard;
+                }
+
+                auto iter = lower_bound(name);
+
+                if (iter == children.end() || (*iter)->level != name)
+                {
+                    iter = children.insert(iter, std::make_unique<node>());
+                    (*iter)->level = name;
+                }
+
+                return **iter;
+            }
+
+            void remove(std::string_view name) noexcept
+            {
+                if (name == "+" || name == "#")
+                {
+                    (name == "+" ? single : multi).reset();
+                    return;
+                }
+
+                if (auto iter = lower_bound(name);
+                    iter != children.end() && (*iter)->level == name)
+                {
+                    children.erase(iter);
+                }
+            }
+        };
+
+        node m_root;
+        std::size_t m_size;
+
+        static constexpr std::size_t next_level(std::size_t end) noexcept
+        {
+            return end == std::string_view::npos ? end : end + 1;
+        }
+
+        static constexpr std::string_view level_at(
+            std::string_view topic, std::size_t begin, std::size_t end) noexcept
+        {
+            return topic.substr(begin,
+                end == std::string_view::npos ? end : end - begin);
+        }
+
+        template<typename FunctionT>
+        static void for_each_level(std::string_view topic, FunctionT&& function)
+        {
+            std::size_t begin = 0;
+
+            while (true)
+            {
+                const std::size_t end = topic.find('/', begin);
+
+                if (end == std::string_view::npos)
+                {
+                    function(topic.substr(begin));
+                    return;
+                }
+
+                function(topic.substr(begin, end - begin));
+                begin = end + 1;
+            }
+        }
+
+        static bool erase(
+            node& current, std::string_view filter, std::size_t begin) noexcept
+        {
+            if (begin == std::string_view::npos)
+            {
+                if (!current.value)
+                {
+                    return false;
+                }
+
+                current.value.reset();
+                return true;
+            }
+
+            const std::size_t end        = filter.find('/', begin);
+            const std::string_view level = level_at(filter, begin, end);
+            node* next                   = current.find(level);
+
+            if (!next || !erase(*next, filter, next_level(end)))
+            {
+                return false;
+            }
+
+            if (next->unused())
+            {
+                current.remove(level);
+            }
+
+            return true;
+        }
+
+        template<typename VisitorT>
+        static void match(const node& current, std::string_view topic,
+            std::size_t begin, bool system, VisitorT& visitor)
+        {
+            if (current.multi && current.multi->value && !system)
+            {
+                visitor(*current.multi->value);
+            }
+
+            if (begin == std::string_view::npos)
+            {
+                if (current.value)
+                {
+                    visitor(*current.value);
+                }
+                return;
+            }
+
+            const std::size_t end        = topic.find('/', begin);
+            const std::size_t next       = next_level(end);
+            const std::string_view level = level_at(topic, begin, end);
+
+            if (auto iter = current.lower_bound(level);
+                iter != current.children.end() && (*iter)->level == level)
+            {
+                match(**iter, topic, next, false, visitor);
+            }
+
+            if (current.single && !system)
+            {
+                match(*current.single, topic, next, false, visitor);
+            }
+        }
+
+        template<typename VisitorT>
+        static void for_each(node& current, std::string& filter,
+            VisitorT& visitor)
+        {
+            const auto visit_child = [&filter, &visitor](node& child) {
+                const std::size_t size = filter.size();
+
+                filter.append(child.level);
+
+                if (child.value)
+                {
+                    visitor(std::string_view{ filter }, *child.value);
+                }
+
+                filter.push_back('/');
+                for_each(child, filter, visitor);
+                filter.resize(size);
+            };
+
+            for (auto& child : current.children)
+            {
+                visit_child(*child);
+            }
+
+            if (current.single)
+            {
+                visit_child(*current.single);
+            }
+
+            if (current.multi)
+            {
+                visit_child(*current.multi);
+            }
+        }
+    };
+} // namespace b2h::mqtt
+
+#endif
@@ -0,0 +1,329 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef B2H_MQTT_SESSION_HPP
+#define B2H_MQTT_SESSION_HPP
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "esp_err.h"
+#include "mqtt_client.h"
+
+#include "tl/expected.hpp"
+
+#include "event/event.hpp"
+#include "mqtt/inbound.hpp"
+#include "mqtt/router.hpp"
+#include "mqtt/spool.hpp"
+#include "utils/logger.hpp"
+
+namespace b2h
+{
+    namespace events::mqtt
+    {
+        struct data_args {
+            std::string_view topic;
+            std::string_view data;
+            b2h::mqtt::message_ref message; // Keeps topic and data valid.
+        };
+
+        struct data : public event::basic_event<data_args, esp_err_t> {
+        };
+
+        struct subscribe : public event::basic_event<void, esp_err_t> {
+        };
+
+        struct subscribe_batch
+            : public event::basic_event<std::vector<esp_err_t>, esp_err_t> {
+        };
+
+        struct unsubscribe : public event::basic_event<void, esp_err_t> {
+        };
+
+        struct publish : public event::basic_event<void, esp_err_t> {
+        };
+
+        struct connect : public event::basic_event<void, esp_err_t> {
+        };
+
+        struct disconnect : public event::basic_event<void, esp_err_t> {
+        };
+
+    } // namespace events::mqtt
+
+    namespace mqtt
+    {
+        struct config {
+            std::string uri;
+            std::string username;
+            std::string password;
+            bool disable_clean_session;
+            std::string client_id; // Empty selects the ESP-IDF default,
+                                   // derived from the chip MAC.
+        };
+
+        class client;
+
+        /**
+         * @brief Single connection to the MQTT broker, shared by all the
+         * devices.
+         *
+         * Devices talk to the broker through mqtt::client channels attached
+         * to the session. The session routes acknowledgements back to the
+         * channel that issued the request and inbound data to every channel
+         * subscribed to a matching topic filter. Broker subscriptions are
+         * reference counted, a filter is unsubscribed when the last channel
+         * using it lets go.
+         *
+         * Channels may subscribe and publish before the broker is reachable.
+         * Filters are subscribed once the session connects, and again after
+         * the broker starts a clean session. Retained publishes wait in the
+         * spool.
+         *
+         */
+        class session final
+        {
+        public:
+            session() = delete;
+
+            explicit session(event::context& ctx) noexcept;
+
+            session(const session&) = delete;
+
+            session(session&& other) = delete;
+
+            session& operator=(const session&) = delete;
+
+            session& operator=(session&& other) = delete;
+
+            ~session() = default;
+
+            tl::expected<void, esp_err_t> config(const config& cfg) noexcept;
+
+            /**
+             * @brief Start the MQTT task. It connects in the background and
+             * reconnects on its own, connect and disconnect events follow.
+             *
+             * @return Error if the task could not be started.
+             */
+            tl::expected<void, esp_err_t> start() noexcept;
+
+            /**
+             * @brief Call hook from the MQTT task on every connection, before
+             * the connect event is dispatched. Set it before start().
+             *
+             * @param hook Called with whether the broker resumed the previous
+             * session, e.g. to republish retained messages it lost otherwise.
+             */
+            void on_connected(std::function<void(bool)> hook) noexcept;
+
+            /**
+             * @brief Keep retained publishes in the spool while the broker
+             * is unreachable. They are drained in batches of
+             * SPOOL_DRAIN_BATCH once the connection is back.
+             *
+             * @param offline Mounted spool, must outlive the session.
+             */
+            void attach_spool(spool& offline) noexcept;
+
+            template<typename HandlerT>
+            void async_connect(HandlerT&& handler) noexcept
+            {
+                using namespace b2h::events::mqtt;
+
+                m_receiver.async_receive<connect>(
+                    std::forward<HandlerT>(handler));
+
+                if (auto result = start(); !result)
+                {
+                    m_dispatcher.async_dispatch<connect>(
+                        tl::make_unexpected(result.error()));
+                }
+            }
+
+            template<typename HandlerT>
+            void async_disconnect(HandlerT&& handler) noexcept
+            {
+                using namespace b2h::events::mqtt;
+
+                assert(static_cast<bool>(m_handle));
+
+                log::debug(COMPONENT, "Attempting to disconnect.");
+
+                m_receiver.async_receive<disconnect>(
+                    std::forward<HandlerT>(handler));
+
+                if (::esp_mqtt_client_stop(m_handle.get()) != ESP_OK)
+                {
+                    m_dispatcher.async_dispatch<disconnect>(
+                        tl::make_unexpected(ESP_FAIL));
+                }
+            }
+
+        private:
+            friend class client;
+
+            // clang-format off
+            using dispatcher_type = event::dispatcher<
+                b2h::events::mqtt::connect,
+                b2h::events::mqtt::disconnect
+            >;
+
+            using receiver_type = typename dispatcher_type::receiver_type;
+
+            using handle_ptr = std::unique_ptr<
+                esp_mqtt_client, 
+                decltype(&::esp_mqtt_client_destroy)
+            >;
+            // clang-format on
+
+            /**
+             * @brief Request awaiting its acknowledgement from the broker.
+             * Owner is null when the channel is gone, the acknowledgement is
+             * then dropped.
+             *
+             */
+            struct pending {
+                int msg_id;
+                client* owner;
+            };
+
+            /**
+             * @brief Acknowledgement that arrived before its request was
+             * tracked.
+             *
+             */
+            struct unclaimed {
+                int msg_id;
+                esp_mqtt_event_id_t event_id;
+            };
+
+            /**
+             * @brief Channels using a topic filter and the state of its
+             * broker subscription.
+             *
+             */
+            struct route {
+                std::vector<client*> owners;
+                int qos;
+                bool subscribed; // Sent to the broker on this connection.
+            };
+
+            static constexpr log::component COMPONENT{ "mqtt::session" };
+
+            static constexpr std::size_t MAX_UNCLAIMED{ 8 };
+
+            dispatcher_type m_dispatcher;
+            receiver_type m_receiver;
+
+            std::mutex m_mutex;
+            router<route> m_routes;
+            std::vector<pending> m_pending;
+            std::vector<unclaimed> m_unclaimed;
+            inbound_ring m_inbound;
+
+            spool* m_spool;
+            std::function<void(bool)> m_on_connected;
+            std::atomic<bool> m_connected;
+            bool m_draining; // Accessed on the context thread only.
+
+            // Destroyed first, stopping the MQTT task using the members above.
+            handle_ptr m_handle;
+
+            void detach(client& owner) noexcept;
+
+            /**
+             * @brief Enqueue the message in esp-mqtt.
+             *
+             * @return Message id, 0 for QoS 0 and spooled messages or -1 on
+             * failure.
+             */
+            int publish(const char* topic, std::string_view data, int qos,
+                bool retain) noexcept;
+
+            /**
+             * @brief Add the channel to the filter and subscribe at the
+             * broker if it is the first one. The caller tracks the request.
+             *
+             * @return Message id, 0 if the filter was already subscribed or
+             * waits for the connection, -1 on failure.
+             */
+            int subscribe(client& owner, const char* topic, int qos) noexcept;
+
+            void unsubscribe(client& owner, const char* topic) noexcept;
+
+            /**
+             * @brief Start draining the spool on the context thread, unless
+             * it is draining already.
+             *
+             */
+            void resume() noexcept;
+
+            /**
+             * @brief Mark the session connected and subscribe, on the
+             * context thread, to the filters the broker does not know.
+             *
+             * @param session_present Broker kept the previous session, and
+             * with it the filters subscribed then.
+             */
+            void restore(bool session_present) noexcept;
+
+            /**
+             * @brief Publish a batch of spooled messages and schedule the
+             * next one, until the spool is empty or the connection drops.
+             *
+             */
+            void drain() noexcept;
+
+            /**
+             * @brief Remove the channel from the filter.
+             *
+             * @return true if no channel uses the filter anymore, so it can
+             * be unsubscribed at the broker.
+             */
+            bool release(client& owner, std::string_view topic) noexcept;
+
+            void track(client* owner, int msg_id) noexcept;
+
+            void acknowledge(
+                esp_mqtt_event_id_t event_id, int msg_id) noexcept;
+
+            static void complete(client& owner, esp_mqtt_event_id_t event_id,
+                int msg_id) noexcept;
+
+            void receive(std::string_view topic, std::string_view data,
+                std::size_t offset, std::size_t total) noexcept;
+
+            static void mqtt_event_callback(void* handler_args,
+                esp_event_base_t base, std::int32_t event_id,
+                void* event) noexcept;
+        };
+
+    } // namespace mqtt
+} // namespace b2h
+
+#endif
@@ -0,0 +1,224 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef B2H_MQTT_SPOOL_HPP
+#define B2H_MQTT_SPOOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "esp_err.h"
+
+#include "tcb/span.hpp"
+#include "tl/expected.hpp"
+
+#if __has_include("sdkconfig.h")
+#include "sdkconfig.h"
+#endif
+
+// Spooled messages published at once when the connection comes back.
+#ifndef B2H_MQTT_SPOOL_DRAIN_BATCH
+#ifdef CONFIG_B2H_MQTT_SPOOL_DRAIN_BATCH
+#define B2H_MQTT_SPOOL_DRAIN_BATCH CONFIG_B2H_MQTT_SPOOL_DRAIN_BATCH
+#else
+#define B2H_MQTT_SPOOL_DRAIN_BATCH 8
+#endif
+#endif
+
+// Delay between two drained batches, in milliseconds.
+#ifndef B2H_MQTT_SPOOL_DRAIN_INTERVAL_MS
+#ifdef CONFIG_B2H_MQTT_SPOOL_DRAIN_INTERVAL_MS
+#define B2H_MQTT_SPOOL_DRAIN_INTERVAL_MS CONFIG_B2H_MQTT_SPOOL_DRAIN_INTERVAL_MS
+#else
+#define B2H_MQTT_SPOOL_DRAIN_INTERVAL_MS 250
+#endif
+#endif
+
+namespace b2h::mqtt
+{
+    inline constexpr std::size_t SPOOL_DRAIN_BATCH{
+        B2H_MQTT_SPOOL_DRAIN_BATCH
+    };
+
+    inline constexpr std::uint32_t SPOOL_DRAIN_INTERVAL_MS{
+        B2H_MQTT_SPOOL_DRAIN_INTERVAL_MS
+    };
+
+    /**
+     * @brief NOR flash region holding the spool.
+     *
+     * Erased bytes read as 0xFF, writes may only clear bits.
+     *
+     */
+    class spool_storage
+    {
+    public:
+        virtual ~spool_storage() = default;
+
+        virtual std::size_t size() const noexcept = 0;
+
+        virtual std::size_t sector_size() const noexcept = 0;
+
+        virtual esp_err_t read(
+            std::size_t offset, tcb::span<std::uint8_t> dst) noexcept = 0;
+
+        virtual esp_err_t write(std::size_t offset,
+            tcb::span<const std::uint8_t> src) noexcept = 0;
+
+        virtual esp_err_t erase(std::size_t sector) noexcept = 0;
+    };
+
+    /**
+     * @brief Message kept in the spool.
+     *
+     */
+    struct spooled {
+        std::string topic;
+        std::string data;
+        int qos;
+        bool retain;
+    };
+
+    /**
+     * @brief Append-only log of publishes that could not reach the broker.
+     *
+     * Records are appended to the sectors of the storage in turn, so erases
+     * spread evenly over the region. Publishing to a topic supersedes its
+     * previous record, only the latest value of a topic is drained. When the
+     * log wraps onto a sector still holding pending records, they are
+     * dropped.
+     *
+     * Record states are changed in place by clearing bits, a record whose
+     * write was interrupted is skipped on mount. Not thread safe, used on
+     * the context thread.
+     *
+     */
+    class spool final
+    {
+    public:
+        spool() = delete;
+
+        explicit spool(spool_storage& storage) noexcept;
+
+        spool(const spool&) = delete;
+        spool(spool&&)      = delete;
+        ~spool()            = default;
+
+        spool& operator=(const spool&) = delete;
+        spool& operator=(spool&&) = delete;
+
+        /**
+         * @brief Recover pending records, formats the storage if it holds
+         * no spool.
+         *
+         * @return ESP_ERR_INVALID_SIZE if the storage has fewer than two
+         * sectors.
+         */
+        tl::expected<void, esp_err_t> mount() noexcept;
+
+        /**
+         * @brief Store the message, superseding the pending one of the
+         * topic.
+         *
+         * @return ESP_ERR_INVALID_SIZE if the message does not fit in a
+         * sector.
+         */
+        tl::expected<void, esp_err_t> append(std::string_view topic,
+            std::string_view data, int qos, bool retain) noexcept;
+
+        /**
+         * @brief Drop the pending message of the topic.
+         *
+         * @return true if the topic had a pending message.
+         */
+        bool discard(std::string_view topic) noexcept;
+
+        /**
+         * @brief Oldest pending message.
+         *
+         * @return std::nullopt if the spool is empty or unreadable.
+         */
+        std::optional<spooled> front() noexcept;
+
+        /**
+         * @brief Drop the oldest pending message, once it is published.
+         *
+         */
+        void pop() noexcept;
+
+        std::size_t size() const noexcept
+        {
+            return m_pending.size();
+        }
+
+        bool empty() const noexcept
+        {
+            return m_pending.empty();
+        }
+
+    private:
+        struct sector_header {
+            std::uint32_t magic;
+            std::uint32_t seq;
+        };
+
+        struct record_header {
+            std::uint8_t state;
+            std::uint8_t flags;
+            std::uint8_t topic_len;
+            std::uint8_t reserved;
+            std::uint16_t data_len;
+            std::uint16_t reserved2;
+        };
+
+        struct pending {
+            std::string topic;
+            std::size_t offset;
+        };
+
+        spool_storage& m_storage;
+        std::size_t m_sectors;
+        std::size_t m_head;   // Sector being appended to.
+        std::size_t m_offset; // Append offset within the head sector.
+        std::uint32_t m_seq;  // Sequence number of the head sector.
+        std::deque<pending> m_pending; // Oldest first.
+
+        tl::expected<void, esp_err_t> format() noexcept;
+
+        tl::expected<void, esp_err_t> open(
+            std::size_t sector, std::uint32_t seq) noexcept;
+
+        /**
+         * @brief Collect the pending records of the sector.
+         *
+         * @return Offset past the last record, or the sector size if the
+         * sector cannot be appended to anymore.
+         */
+        std::size_t scan(std::size_t sector) noexcept;
+
+        void retire(std::size_t offset) noexcept;
+    };
+} // namespace b2h::mqtt
+
+#endif
@@ -0,0 +1,65 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "mqtt/partition_storage.hpp"
+
+namespace b2h::mqtt
+{
+    partition_storage::partition_storage(
+        const esp_partition_t* partition) noexcept :
+        m_partition{ partition }
+    {
+    }
+
+    std::size_t partition_storage::size() const noexcept
+    {
+        return m_partition ? m_partition->size : 0;
+    }
+
+    std::size_t partition_storage::sector_size() const noexcept
+    {
+        return SPI_FLASH_SEC_SIZE;
+    }
+
+    esp_err_t partition_storage::read(
+        std::size_t offset, tcb::span<std::uint8_t> dst) noexcept
+    {
+        return ::esp_partition_read(m_partition,
+            offset,
+            dst.data(),
+            dst.size());
+    }
+
+    esp_err_t partition_storage::write(
+        std::size_t offset, tcb::span<const std::uint8_t> src) noexcept
+    {
+        return ::esp_partition_write(m_partition,
+            offset,
+            src.data(),
+            src.size());
+    }
+
+    esp_err_t partition_storage::erase(std::size_t sector) noexcept
+    {
+        return ::esp_partition_erase_range(m_partition,
+            sector * SPI_FLASH_SEC_SIZE,
+            SPI_FLASH_SEC_SIZE);
+    }
+} // namespace b2h::mqtt
@@ -0,0 +1,632 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "mqtt/session.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+#include "mqtt/client.hpp"
+
+namespace b2h::mqtt
+{
+    session::session(event::context& ctx) noexcept :
+        m_dispatcher{ ctx },
+        m_receiver{ m_dispatcher.make_receiver() },
+        m_mutex{},
+        m_routes{},
+        m_pending{},
+        m_unclaimed{},
+        m_inbound{},
+        m_spool{ nullptr },
+        m_on_connected{},
+        m_connected{ false },
+        m_draining{ false },
+        m_handle{ nullptr, &::esp_mqtt_client_destroy }
+    {
+    }
+
+    tl::expected<void, esp_err_t> session::config(
+        const mqtt::config& cfg) noexcept
+    {
+        log::debug(COMPONENT, "Got MQTT config. URI: {}", cfg.uri);
+
+        esp_mqtt_client_config_t config{};
+        config.uri = cfg.uri.c_str();
+
+        if (!cfg.username.empty())
+        {
+            config.username = cfg.username.c_str();
+        }
+
+        if (!cfg.password.empty())
+        {
+            config.password = cfg.password.c_str();
+        }
+
+        if (!cfg.client_id.empty())
+        {
+            config.client_id = cfg.client_id.c_str();
+            log::debug(COMPONENT, "Client ID set to: {}.", cfg.client_id);
+        }
+
+        config.disable_clean_session =
+            static_cast<int>(cfg.disable_clean_session);
+
+        if (m_handle =
+                handle_ptr{
+                    ::esp_mqtt_client_init(&config),
+                    &::esp_mqtt_client_destroy,
+                };
+            !m_handle)
+        {
+            log::error(COMPONENT,
+                "Failed to initialize MQTT client, error code: {0} [{1}]",
+                ESP_FAIL,
+                ::esp_err_to_name(ESP_FAIL));
+            return tl::make_unexpected(ESP_FAIL);
+        }
+
+        if (const esp_err_t result =
+                ::esp_mqtt_client_register_event(m_handle.get(),
+                    static_cast<esp_mqtt_event_id_t>(ESP_EVENT_ANY_ID),
+                    &mqtt_event_callback,
+                    static_cast<void*>(this));
+            result != ESP_OK)
+        {
+            log::error(COMPONENT,
+                "Failed to register events, error code: {0} [{1}]",
+                result,
+                ::esp_err_to_name(result));
+            m_handle.reset();
+            return tl::make_unexpected(result);
+        }
+
+        return {};
+    }
+
+    tl::expected<void, esp_err_t> session::start() noexcept
+    {
+        assert(static_cast<bool>(m_handle));
+
+        log::debug(COMPONENT, "Attempting to connect.");
+
+        if (const esp_err_t result = ::esp_mqtt_client_start(m_handle.get());
+            result != ESP_OK)
+        {
+            log::error(COMPONENT,
+                "Failed to start, error code: {0} [{1}]",
+                result,
+                ::esp_err_to_name(result));
+            return tl::make_unexpected(result);
+        }
+
+        log::info(COMPONENT, "Successfully started MQTT client.");
+        return {};
+    }
+
+    void session::on_connected(std::function<void(bool)> hook) noexcept
+    {
+        m_on_connected = std::move(hook);
+    }
+
+    void session::attach_spool(spool& offline) noexcept
+    {
+        m_spool = &offline;
+    }
+
+    void session::detach(client& owner) noexcept
+    {
+        std::vector<std::string> released;
+
+        {
+            std::lock_guard<std::mutex> lock{ m_mutex };
+
+            for (auto& entry : m_pending)
+            {
+                if (entry.owner == &owner)
+                {
+                    entry.owner = nullptr;
+                }
+            }
+
+            m_routes.for_each([&owner, &released](std::string_view filter,
+                                  route& entry) {
+                auto& owners = entry.owners;
+                owners.erase(std::remove(owners.begin(), owners.end(), &owner),
+                    owners.end());
+
+                if (owners.empty())
+                {
+                    released.emplace_back(filter);
+                }
+            });
+
+            for (const auto& filter : released)
+            {
+                m_routes.erase(filter);
+            }
+        }
+
+        for (const auto& filter : released)
+        {
+            log::debug(COMPONENT, "Releasing topic: {}", filter);
+
+            if (int msg_id = ::esp_mqtt_client_unsubscribe(m_handle.get(),
+                    filter.c_str());
+                msg_id != -1)
+            {
+                track(nullptr, msg_id);
+            }
+        }
+    }
+
+    int session::publish(const char* topic, std::string_view data, int qos,
+        bool retain) noexcept
+    {
+        assert(static_cast<bool>(m_handle));
+
+        if (m_spool && retain)
+        {
+            if (!m_connected)
+            {
+                // Reported as sent, the value reaches the broker once the
+                // spool drains.
+                return m_spool->append(topic, data, qos, retain).has_value()
+                           ? 0
+                           : -1;
+            }
+
+            // The fresh value supersedes one still waiting to drain.
+            m_spool->discard(topic);
+        }
+
+        return ::esp_mqtt_client_enqueue(m_handle.get(),
+            topic,
+            data.data(),
+            data.size(),
+            qos,
+            static_cast<int>(retain),
+            true);
+    }
+
+    int session::subscribe(client& owner, const char* topic, int qos) noexcept
+    {
+        assert(static_cast<bool>(m_handle));
+
+        bool shared = false;
+
+        {
+            std::lock_guard<std::mutex> lock{ m_mutex };
+
+            auto& entry = m_routes[topic];
+            shared      = !entry.owners.empty();
+            entry.owners.push_back(&owner);
+
+            if (!shared)
+            {
+                entry.qos        = qos;
+                entry.subscribed = m_connected;
+            }
+
+            // Either the broker already delivers this filter to the
+            // session, or it is subscribed once the session connects.
+            if (shared || !entry.subscribed)
+            {
+                return 0;
+            }
+        }
+
+        const int msg_id =
+            ::esp_mqtt_client_subscribe(m_handle.get(), topic, qos);
+
+        if (msg_id == -1)
+        {
+            release(owner, topic);
+        }
+
+        return msg_id;
+    }
+
+    void session::unsubscribe(client& owner, const char* topic) noexcept
+    {
+        using namespace b2h::events::mqtt;
+
+        assert(static_cast<bool>(m_handle));
+
+        if (!release(owner, topic))
+        {
+            // Other channels still need the filter, keep it at the broker.
+            owner.m_dispatcher.async_dispatch<events::mqtt::unsubscribe>({});
+            return;
+        }
+
+        if (int msg_id = ::esp_mqtt_client_unsubscribe(m_handle.get(), topic);
+            msg_id != -1)
+        {
+            track(&owner, msg_id);
+            return;
+        }
+
+        owner.m_dispatcher.async_dispatch<events::mqtt::unsubscribe>(
+            tl::make_unexpected(ESP_FAIL));
+    }
+
+    void session::resume() noexcept
+    {
+        if (!m_spool)
+        {
+            return;
+        }
+
+        auto& context = m_dispatcher.context();
+        ++context.active_events();
+        context.shedule(
+            [this, &active_events = context.active_events()]() {
+                --active_events;
+
+                if (!m_draining)
+                {
+                    m_draining = true;
+                    drain();
+                }
+            });
+    }
+
+    void session::restore(bool session_present) noexcept
+    {
+        {
+            // Under the lock, subscribe() either sees the session
+            // connected or leaves the filter to the flush below.
+            std::lock_guard<std::mutex> lock{ m_mutex };
+
+            m_connected = true;
+
+            if (!session_present)
+            {
+                m_routes.for_each([](std::string_view, route& entry) {
+                    entry.subscribed = false;
+                });
+            }
+        }
+
+        auto& context = m_dispatcher.context();
+        ++context.active_events();
+        context.shedule(
+            [this, &active_events = context.active_events()]() {
+                --active_events;
+
+                std::vector<std::pair<std::string, int>> filters;
+
+                {
+                    std::lock_guard<std::mutex> lock{ m_mutex };
+
+                    m_routes.for_each(
+                        [&filters](std::string_view filter, route& entry) {
+                            if (!entry.subscribed)
+                            {
+                                entry.subscribed = true;
+                                filters.emplace_back(filter, entry.qos);
+                            }
+                        });
+                }
+
+                for (const auto& [filter, qos] : filters)
+                {
+                    // The channels were told already, nobody waits for the
+                    // acknowledgement.
+                    if (const int msg_id = ::esp_mqtt_client_subscribe(
+                            m_handle.get(), filter.c_str(), qos);
+                        msg_id != -1)
+                    {
+                        track(nullptr, msg_id);
+                        continue;
+                    }
+
+                    log::warning(COMPONENT,
+                        "Failed to subscribe to {}, retrying on the next "
+                        "connection.",
+                        filter);
+
+                    std::lock_guard<std::mutex> lock{ m_mutex };
+
+                    if (auto* entry = m_routes.find(filter))
+                    {
+                        entry->subscribed = false;
+                    }
+                }
+            });
+    }
+
+    void session::drain() noexcept
+    {
+        std::size_t sent = 0;
+
+        while (m_connected && sent < SPOOL_DRAIN_BATCH && !m_spool->empty())
+        {
+            const auto message = m_spool->front();
+
+            if (!message)
+            {
+                log::warning(COMPONENT, "Skipping unreadable spool record.");
+                m_spool->pop();
+                continue;
+            }
+
+            const int msg_id = ::esp_mqtt_client_enqueue(m_handle.get(),
+                message->topic.c_str(),
+                message->data.data(),
+                message->data.size(),
+                message->qos,
+                static_cast<int>(message->retain),
+                true);
+
+            if (msg_id == -1)
+            {
+                // Outbox full, retried with the next batch.
+                break;
+            }
+
+            if (msg_id > 0)
+            {
+                track(nullptr, msg_id);
+            }
+
+            m_spool->pop();
+            ++sent;
+        }
+
+        if (!m_connected || m_spool->empty())
+        {
+            m_draining = false;
+            return;
+        }
+
+        auto& context = m_dispatcher.context();
+        ++context.active_events();
+        context.shedule_after(
+            std::chrono::milliseconds{ SPOOL_DRAIN_INTERVAL_MS },
+            [this, &active_events = context.active_events()]() {
+                --active_events;
+                drain();
+            });
+    }
+
+    bool session::release(client& owner, std::string_view topic) noexcept
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+
+        auto* entry = m_routes.find(topic);
+
+        if (!entry)
+        {
+            return true;
+        }
+
+        auto& owners = entry->owners;
+
+        if (auto iter = std::find(owners.begin(), owners.end(), &owner);
+            iter != owners.end())
+        {
+            owners.erase(iter);
+        }
+
+        if (!owners.empty())
+        {
+            return false;
+        }
+
+        m_routes.erase(topic);
+        return true;
+    }
+
+    void session::track(client* owner, int msg_id) noexcept
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+
+        // The MQTT task may have handled the acknowledgement already, while
+        // esp-mqtt returned the message id to this thread.
+        if (auto iter = std::find_if(m_unclaimed.cbegin(),
+                m_unclaimed.cend(),
+                [msg_id](const unclaimed& entry) {
+                    return entry.msg_id == msg_id;
+                });
+            iter != m_unclaimed.cend())
+        {
+            const esp_mqtt_event_id_t event_id = iter->event_id;
+            m_unclaimed.erase(iter);
+
+            if (owner)
+            {
+                complete(*owner, event_id, msg_id);
+            }
+            return;
+        }
+
+        m_pending.push_back(pending{ msg_id, owner });
+    }
+
+    void session::acknowledge(
+        esp_mqtt_event_id_t event_id, int msg_id) noexcept
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+
+        if (auto iter = std::find_if(m_pending.cbegin(),
+                m_pending.cend(),
+                [msg_id](const pending& entry) {
+                    return entry.msg_id == msg_id;
+                });
+            iter != m_pending.cend())
+        {
+            client* owner = iter->owner;
+            m_pending.erase(iter);
+
+            if (owner)
+            {
+                complete(*owner, event_id, msg_id);
+            }
+            return;
+        }
+
+        if (m_unclaimed.size() == MAX_UNCLAIMED)
+        {
+            m_unclaimed.erase(m_unclaimed.begin());
+        }
+
+        m_unclaimed.push_back(unclaimed{ msg_id, event_id });
+    }
+
+    void session::complete(
+        client& owner, esp_mqtt_event_id_t event_id, int msg_id) noexcept
+    {
+        using namespace b2h::events::mqtt;
+
+        switch (event_id)
+        {
+        case MQTT_EVENT_PUBLISHED:
+            owner.acknowledge(msg_id);
+            break;
+        case MQTT_EVENT_SUBSCRIBED:
+            owner.subscribed(msg_id);
+            break;
+        case MQTT_EVENT_UNSUBSCRIBED:
+            owner.m_dispatcher.async_dispatch<events::mqtt::unsubscribe>({});
+            break;
+        default:
+            break;
+        }
+    }
+
+    void session::receive(std::string_view topic, std::string_view data,
+        std::size_t offset, std::size_t total) noexcept
+    {
+        using namespace b2h::events::mqtt;
+
+        std::lock_guard<std::mutex> lock{ m_mutex };
+
+        const message_ref message =
+            m_inbound.append(topic, data, offset, total);
+
+        if (!message)
+        {
+            return;
+        }
+
+        // Every channel shares the slot, it is reused once all handlers
+        // have finished.
+        m_routes.match(message.topic(),
+            [&message](const route& entry) {
+                for (client* owner : entry.owners)
+                {
+                    owner->m_dispatcher.async_dispatch<events::mqtt::data>(
+                        data_args{
+                            message.topic(),
+                            message.data(),
+                            message,
+                        });
+                }
+            });
+    }
+
+    void session::mqtt_event_callback(void* handler_args, esp_event_base_t base,
+        int32_t event_id, void* event) noexcept
+    {
+        using namespace b2h::events::mqtt;
+
+        esp_mqtt_event_handle_t event_data =
+            reinterpret_cast<esp_mqtt_event_handle_t>(event);
+        session* session_ptr = static_cast<session*>(handler_args);
+
+        switch (event_data->event_id)
+        {
+        case MQTT_EVENT_DATA:
+        {
+            const std::string_view topic{ event_data->topic,
+                static_cast<std::size_t>(event_data->topic_len) };
+            const std::string_view data{ event_data->data,
+                static_cast<std::size_t>(event_data->data_len) };
+
+            B2H_LOG_DEBUG(COMPONENT, "Event: MQTT_EVENT_DATA");
+            B2H_LOG_VERBOSE(COMPONENT,
+                "topic: {}, data: {}, offset: {}/{}",
+                topic,
+                data,
+                event_data->current_data_offset,
+                event_data->total_data_len);
+
+            session_ptr->receive(topic,
+                data,
+                static_cast<std::size_t>(event_data->current_data_offset),
+                static_cast<std::size_t>(event_data->total_data_len));
+            break;
+        }
+        case MQTT_EVENT_PUBLISHED:
+        {
+            B2H_LOG_EVERY_N(log::log_level::debug,
+                COMPONENT,
+                16,
+                "Event: MQTT_EVENT_PUBLISHED");
+            session_ptr->acknowledge(event_data->event_id, event_data->msg_id);
+            break;
+        }
+        case MQTT_EVENT_SUBSCRIBED:
+        {
+            log::debug(COMPONENT, "Event: MQTT_EVENT_SUBSCRIBED");
+            session_ptr->acknowledge(event_data->event_id, event_data->msg_id);
+            break;
+        }
+        case MQTT_EVENT_UNSUBSCRIBED:
+        {
+            log::debug(COMPONENT, "Event: MQTT_EVENT_UNSUBSCRIBED");
+            session_ptr->acknowledge(event_data->event_id, event_data->msg_id);
+            break;
+        }
+        case MQTT_EVENT_CONNECTED:
+        {
+            log::debug(COMPONENT, "Event: MQTT_EVENT_CONNECTED");
+
+            const bool session_present = event_data->session_present != 0;
+
+            session_ptr->restore(session_present);
+
+            if (session_ptr->m_on_connected)
+            {
+                session_ptr->m_on_connected(session_present);
+            }
+
+            session_ptr->resume();
+            session_ptr->m_dispatcher.async_dispatch<connect>({});
+            break;
+        }
+        case MQTT_EVENT_DISCONNECTED:
+        {
+            log::debug(COMPONENT, "Event: MQTT_EVENT_DISCONNECTED");
+            session_ptr->m_connected = false;
+            session_ptr->m_dispatcher.async_dispatch<disconnect>({});
+            break;
+        }
+        default:
+        {
+            log::debug(COMPONENT, "Other event: {0}.", event_data->event_id);
+            break;
+        }
+        }
+    }
+} // namespace b2h::mqtt
@@ -0,0 +1,391 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "mqtt/spool.hpp"
+
+#include <algorithm>
+#include <utility>
+
+#include "utils/logger.hpp"
+
+namespace b2h::mqtt
+{
+    static constexpr log::component COMPONENT{ "mqtt::spool" };
+
+    namespace
+    {
+        constexpr std::uint32_t SECTOR_MAGIC{ 0x4C4F5053 }; // "SPOL"
+
+        // Bits are only cleared, each state follows the previous one.
+        constexpr std::uint8_t STATE_ERASED{ 0xFF };
+        constexpr std::uint8_t STATE_WRITTEN{ 0xFE };
+        constexpr std::uint8_t STATE_LIVE{ 0xFC };
+        constexpr std::uint8_t STATE_DEAD{ 0xF8 };
+
+        constexpr std::uint8_t FLAG_QOS_MASK{ 0x03 };
+        constexpr std::uint8_t FLAG_RETAIN{ 0x04 };
+
+        constexpr std::size_t align(std::size_t size) noexcept
+        {
+            return (size + 3) & ~std::size_t{ 3 };
+        }
+
+        template<typename T>
+        tcb::span<std::uint8_t> bytes_of(T& value) noexcept
+        {
+            return { reinterpret_cast<std::uint8_t*>(&value), sizeof(T) };
+        }
+
+        template<typename T>
+        tcb::span<const std::uint8_t> bytes_of(const T& value) noexcept
+        {
+            return { reinterpret_cast<const std::uint8_t*>(&value),
+                sizeof(T) };
+        }
+
+        tcb::span<const std::uint8_t> bytes_of(std::string_view str) noexcept
+        {
+            return { reinterpret_cast<const std::uint8_t*>(str.data()),
+                str.size() };
+        }
+    } // namespace
+
+    spool::spool(spool_storage& storage) noexcept :
+        m_storage{ storage },
+        m_sectors{ storage.size() / storage.sector_size() },
+        m_head{ 0 },
+        m_offset{ 0 },
+        m_seq{ 0 },
+        m_pending{}
+    {
+    }
+
+    tl::expected<void, esp_err_t> spool::mount() noexcept
+    {
+        if (m_sectors < 2)
+        {
+            log::error(COMPONENT, "Spool needs at least two sectors.");
+            return tl::make_unexpected(ESP_ERR_INVALID_SIZE);
+        }
+
+        m_pending.clear();
+        m_seq = 0;
+
+        std::optional<std::size_t> oldest;
+        std::optional<std::size_t> newest;
+        std::uint32_t oldest_seq = 0;
+
+        for (std::size_t sector = 0; sector != m_sectors; ++sector)
+        {
+            sector_header header{};
+
+            if (m_storage.read(sector * m_storage.sector_size(),
+                    bytes_of(header)) != ESP_OK ||
+                header.magic != SECTOR_MAGIC)
+            {
+                continue;
+            }
+
+            if (!oldest || header.seq < oldest_seq)
+            {
+                oldest     = sector;
+                oldest_seq = header.seq;
+            }
+
+            if (!newest || header.seq > m_seq)
+            {
+                newest = sector;
+                m_seq  = header.seq;
+            }
+        }
+
+        if (!newest)
+        {
+            log::info(COMPONENT, "Formatting spool.");
+            return format();
+        }
+
+        // Sectors are opened in turn, so the ring from the oldest sector to
+        // the newest one is in append order.
+        for (std::size_t sector = *oldest;; sector = (sector + 1) % m_sectors)
+        {
+            m_head   = sector;
+            m_offset = scan(sector);
+
+            if (sector == *newest)
+            {
+                break;
+            }
+        }
+
+        log::info(COMPONENT, "Recovered {} spooled messages.", size());
+        return {};
+    }
+
+    tl::expected<void, esp_err_t> spool::append(std::string_view topic,
+        std::string_view data, int qos, bool retain) noexcept
+    {
+        const std::size_t sector_size = m_storage.sector_size();
+        const std::size_t size =
+            align(sizeof(record_header) + topic.size() + data.size());
+
+        if (topic.size() > UINT8_MAX || data.size() > UINT16_MAX ||
+            size > sector_size - sizeof(sector_header))
+        {
+            log::warning(COMPONENT, "Message too large to spool.");
+            return tl::make_unexpected(ESP_ERR_INVALID_SIZE);
+        }
+
+        if (m_offset + size > sector_size)
+        {
+            if (auto result = open((m_head + 1) % m_sectors, m_seq + 1);
+                !result.has_value())
+            {
+                return result;
+            }
+        }
+
+        const std::size_t offset = m_head * sector_size + m_offset;
+
+        record_header header{
+            STATE_WRITTEN,
+            static_cast<std::uint8_t>((qos & FLAG_QOS_MASK) |
+                                      (retain ? FLAG_RETAIN : 0)),
+            static_cast<std::uint8_t>(topic.size()),
+            0xFF,
+            static_cast<std::uint16_t>(data.size()),
+            0xFFFF,
+        };
+
+        // Whatever gets written, the space is used up.
+        m_offset += size;
+
+        if (esp_err_t result = m_storage.write(offset, bytes_of(header));
+            result != ESP_OK)
+        {
+            return tl::make_unexpected(result);
+        }
+
+        if (esp_err_t result = m_storage.write(
+                offset + sizeof(record_header), bytes_of(topic));
+            result != ESP_OK)
+        {
+            return tl::make_unexpected(result);
+        }
+
+        if (esp_err_t result = m_storage.write(
+                offset + sizeof(record_header) + topic.size(),
+                bytes_of(data));
+            result != ESP_OK)
+        {
+            return tl::make_unexpected(result);
+        }
+
+        if (esp_err_t result = m_storage.write(offset, bytes_of(STATE_LIVE));
+            result != ESP_OK)
+        {
+            return tl::make_unexpected(result);
+        }
+
+        // The previous value is retired only once the new one is complete.
+        discard(topic);
+        m_pending.push_back(pending{ std::string{ topic }, offset });
+
+        return {};
+    }
+
+    bool spool::discard(std::string_view topic) noexcept
+    {
+        auto iter = std::find_if(m_pending.begin(),
+            m_pending.end(),
+            [topic](const pending& entry) { return entry.topic == topic; });
+
+        if (iter == m_pending.end())
+        {
+            return false;
+        }
+
+        retire(iter->offset);
+        m_pending.erase(iter);
+        return true;
+    }
+
+    std::optional<spooled> spool::front() noexcept
+    {
+        if (m_pending.empty())
+        {
+            return std::nullopt;
+        }
+
+        const pending& entry = m_pending.front();
+        record_header header{};
+
+        if (m_storage.read(entry.offset, bytes_of(header)) != ESP_OK)
+        {
+            return std::nullopt;
+        }
+
+        spooled result{
+            entry.topic,
+            std::string(header.data_len, '\0'),
+            header.flags & FLAG_QOS_MASK,
+            (header.flags & FLAG_RETAIN) != 0,
+        };
+
+        if (m_storage.read(
+                entry.offset + sizeof(record_header) + header.topic_len,
+                { reinterpret_cast<std::uint8_t*>(result.data.data()),
+                    result.data.size() }) != ESP_OK)
+        {
+            return std::nullopt;
+        }
+
+        return result;
+    }
+
+    void spool::pop() noexcept
+    {
+        if (m_pending.empty())
+        {
+            return;
+        }
+
+        retire(m_pending.front().offset);
+        m_pending.pop_front();
+    }
+
+    tl::expected<void, esp_err_t> spool::format() noexcept
+    {
+        m_pending.clear();
+        return open(0, 1);
+    }
+
+    tl::expected<void, esp_err_t> spool::open(
+        std::size_t sector, std::uint32_t seq) noexcept
+    {
+        const std::size_t sector_size = m_storage.sector_size();
+        const std::size_t begin       = sector * sector_size;
+
+        const auto first = std::remove_if(m_pending.begin(),
+            m_pending.end(),
+            [begin, sector_size](const pending& entry) {
+                return entry.offset - begin < sector_size;
+            });
+
+        if (first != m_pending.end())
+        {
+            log::warning(COMPONENT,
+                "Spool full, dropping {} messages.",
+                std::distance(first, m_pending.end()));
+            m_pending.erase(first, m_pending.end());
+        }
+
+        if (esp_err_t result = m_storage.erase(sector); result != ESP_OK)
+        {
+            return tl::make_unexpected(result);
+        }
+
+        const sector_header header{ SECTOR_MAGIC, seq };
+
+        m_head   = sector;
+        m_offset = sector_size;
+        m_seq    = seq;
+
+        if (esp_err_t result = m_storage.write(begin, bytes_of(header));
+            result != ESP_OK)
+        {
+            return tl::make_unexpected(result);
+        }
+
+        m_offset = sizeof(sector_header);
+        return {};
+    }
+
+    std::size_t spool::scan(std::size_t sector) noexcept
+    {
+        const std::size_t sector_size = m_storage.sector_size();
+        const std::size_t begin       = sector * sector_size;
+        std::size_t offset            = sizeof(sector_header);
+
+        if (sector_header header{};
+            m_storage.read(begin, bytes_of(header)) != ESP_OK ||
+            header.magic != SECTOR_MAGIC)
+        {
+            return sector_size;
+        }
+
+        while (offset + sizeof(record_header) <= sector_size)
+        {
+            record_header header{};
+
+            if (m_storage.read(begin + offset, bytes_of(header)) != ESP_OK)
+            {
+                return sector_size;
+            }
+
+            const auto raw = bytes_of(std::as_const(header));
+
+            if (std::all_of(raw.begin(), raw.end(), [](std::uint8_t byte) {
+                    return byte == STATE_ERASED;
+                }))
+            {
+                return offset;
+            }
+
+            const std::size_t size = align(
+                sizeof(record_header) + header.topic_len + header.data_len);
+
+            if (header.state == STATE_ERASED || offset + size > sector_size)
+            {
+                // Interrupted while writing the header, nothing past it can
+                // be trusted.
+                return sector_size;
+            }
+
+            if (header.state == STATE_LIVE)
+            {
+                std::string topic(header.topic_len, '\0');
+
+                if (m_storage.read(begin + offset + sizeof(record_header),
+                        { reinterpret_cast<std::uint8_t*>(topic.data()),
+                            topic.size() }) != ESP_OK)
+                {
+                    return sector_size;
+                }
+
+                discard(topic);
+                m_pending.push_back(
+                    pending{ std::move(topic), begin + offset });
+            }
+
+            offset += size;
+        }
+
+        return sector_size;
+    }
+
+    void spool::retire(std::size_t offset) noexcept
+    {
+        if (m_storage.write(offset, bytes_of(STATE_DEAD)) != ESP_OK)
+        {
+            log::warning(COMPONENT, "Failed to retire spooled message.");
+        }
+    }
+} // namespace b2h::mqtt
@@ -20,26 +20,32 @@
 
 #include "catch2/catch.hpp"
 
+#include <array>
+#include <chrono>
 #include <future>
+#include <string>
+#include <vector>
 
 #include "tl/expected.hpp"
 
 #include "event/event.hpp"
 #include "mqtt/client.hpp"
 
-static constexpr auto TEST_TOPIC = "test/1234";
+static constexpr auto TEST_TOPIC  = "test/1234";
+static constexpr auto OTHER_TOPIC = "other/1234";
 
 TEST_CASE("Initialize client.", "[mqtt]")
 {
     using namespace b2h;
 
     event::context context;
-    mqtt::client client{ context };
+    mqtt::session session{ context };
+    mqtt::client client{ context, session };
 
     context.run();
 }
 
-TEST_CASE("Set client config.", "[mqtt]")
+TEST_CASE("Set session config.", "[mqtt]")
 {
     using namespace b2h;
 
@@ -49,9 +55,9 @@ TEST_CASE("Set client config.", "[mqtt]")
         {},
         {},
     };
-    mqtt::client client{ context };
+    mqtt::session session{ context };
 
-    client.config(config);
+    REQUIRE(session.config(config).has_value());
     context.run();
 }
 
@@ -61,12 +67,12 @@ TEST_CASE("Connect to broker.", "[mqtt]")
 
     event::context context;
     mqtt::config config{ "mqtt://test:1883" };
-    mqtt::client client{ context };
+    mqtt::session session{ context };
     bool connect_handled = false;
 
-    client.config(config);
+    session.config(config);
 
-    client.async_connect([&](events::mqtt::connect::expected_type result) {
+    session.async_connect([&](events::mqtt::connect::expected_type result) {
         connect_handled = true;
         REQUIRE(result.has_value());
     });
@@ -81,11 +87,12 @@ TEST_CASE("Subscribe to topic.", "[mqtt]")
 
     event::context context;
     mqtt::config config{ "mqtt://test:1883" };
-    mqtt::client client{ context };
+    mqtt::session session{ context };
+    mqtt::client client{ context, session };
     bool subscribe_handled = false;
 
-    client.config(config);
-    client.async_connect([&](auto) {
+    session.config(config);
+    session.async_connect([&](auto) {
         client.async_subscribe(TEST_TOPIC,
             [&](events::mqtt::subscribe::expected_type result) {
                 subscribe_handled = true;
@@ -103,11 +110,12 @@ TEST_CASE("Unsubscribe from topic.", "[mqtt]")
 
     event::context context;
     mqtt::config config{ "mqtt://test:1883" };
-    mqtt::client client{ context };
+    mqtt::session session{ context };
+    mqtt::client client{ context, session };
     bool unsubscribe_handled = false;
 
-    client.config(config);
-    client.async_connect([&](auto) {
+    session.config(config);
+    session.async_connect([&](auto) {
         client.async_subscribe(TEST_TOPIC, [&](auto) {
             client.async_unsubscribe(TEST_TOPIC,
                 [&](events::mqtt::unsubscribe::expected_type result) {
@@ -127,13 +135,16 @@ TEST_CASE("Publish to topic.", "[mqtt]")
 
     event::context context;
     mqtt::config config{ "mqtt://test:1883" };
-    mqtt::client client{ context };
+    mqtt::session session{ context };
+    mqtt::client client{ context, session };
     bool publish_handled = false;
 
-    client.config(config);
-    client.async_connect([&](auto) {
+    session.config(config);
+    session.async_connect([&](auto) {
         client.async_publish(TEST_TOPIC,
             TEST_DATA,
+            1,
+            false,
             [&](events::mqtt::publish::expected_type result) {
                 publish_handled = true;
                 REQUIRE(result.has_value());
@@ -144,18 +155,125 @@ TEST_CASE("Publish to topic.", "[mqtt]")
     REQUIRE(publish_handled);
 }
 
+TEST_CASE("Pipeline publishes.", "[mqtt]")
+{
+    using namespace b2h;
+
+    event::context context;
+    mqtt::config config{ "mqtt://test:1883" };
+    mqtt::session session{ context };
+    mqtt::client client{ context, session };
+    std::array<std::size_t, mqtt::MAX_INFLIGHT> publish_handled{};
+
+    test_published.clear();
+
+    session.config(config);
+    session.async_connect([&](auto) {
+        // Fill the pipeline without waiting for any acknowledgement, a
+        // topic each so that nothing is coalesced.
+        for (std::size_t i = 0; i < publish_handled.size(); ++i)
+        {
+            client.async_publish(TEST_TOPIC + std::to_string(i),
+                TEST_DATA,
+                1,
+                false,
+                [&, i](events::mqtt::publish::expected_type result) {
+                    REQUIRE(result.has_value());
+                    ++publish_handled[i];
+                });
+        }
+    });
+
+    context.run();
+    REQUIRE(test_published.size() == mqtt::MAX_INFLIGHT);
+    for (auto handled : publish_handled)
+    {
+        REQUIRE(handled == 1);
+    }
+}
+
+TEST_CASE("Coalesce publishes to a busy topic.", "[mqtt]")
+{
+    using namespace b2h;
+
+    event::context context;
+    mqtt::config config{ "mqtt://test:1883" };
+    mqtt::session session{ context };
+    mqtt::client client{ context, session };
+    std::size_t publish_handled = 0;
+
+    test_published.clear();
+
+    session.config(config);
+    session.async_connect([&](auto) {
+        for (const char* value : { "1", "2", "3", "4" })
+        {
+            client.async_publish(TEST_TOPIC,
+                value,
+                1,
+                true,
+                [&](events::mqtt::publish::expected_type result) {
+                    REQUIRE(result.has_value());
+                    ++publish_handled;
+                });
+        }
+    });
+
+    context.run();
+    REQUIRE(publish_handled == 4);
+    REQUIRE(test_published == std::vector<std::string>{ "1", "4" });
+}
+
+TEST_CASE("Limit publish rate per topic.", "[mqtt]")
+{
+    using namespace b2h;
+    using namespace std::chrono_literals;
+
+    event::context context;
+    mqtt::config config{ "mqtt://test:1883" };
+    mqtt::session session{ context };
+    mqtt::client client{ context, session };
+    std::vector<std::string> completed;
+    auto start = std::chrono::steady_clock::now();
+
+    test_published.clear();
+    client.min_interval(TEST_TOPIC, 50ms);
+
+    session.config(config);
+    session.async_connect([&](auto) {
+        start = std::chrono::steady_clock::now();
+
+        for (const char* value : { "1", "2", "3" })
+        {
+            client.async_publish(TEST_TOPIC,
+                value,
+                0,
+                true,
+                [&, value](events::mqtt::publish::expected_type result) {
+                    REQUIRE(result.has_value());
+                    completed.emplace_back(value);
+                });
+        }
+    });
+
+    context.run();
+    REQUIRE(std::chrono::steady_clock::now() - start >= 50ms);
+    REQUIRE(test_published == std::vector<std::string>{ "1", "3" });
+    REQUIRE(completed == std::vector<std::string>{ "1", "2", "3" });
+}
+
 TEST_CASE("Disconnect from broker.", "[mqtt]")
 {
     using namespace b2h;
 
     event::context context;
     mqtt::config config{ "mqtt://test:1883" };
-    mqtt::client client{ context };
+    mqtt::session session{ context };
     bool disconnect_handled = false;
 
-    client.config(config);
-    client.async_connect([&](auto) {
-        client.async_disconnect(
+    session.config(config);
+    session.async_connect([&](auto) {
+        session.async_disconnect(
             [&](events::mqtt::disconnect::expected_type result) {
                 disconnect_handled = true;
                 REQUIRE(result.has_value());
@@ -172,11 +290,12 @@ TEST_CASE("Receive data from broker.", "[mqtt]")
 
     event::context context;
     mqtt::config config{ "mqtt://test:1883" };
-    mqtt::client client{ context };
+    mqtt::session session{ context };
+    mqtt::client client{ context, session };
     bool receive_handled = false;
 
-    client.config(config);
-    client.async_connect([&](auto) {
+    session.config(config);
+    session.async_connect([&](auto) {
         client.async_receive([&](auto result) {
             receive_handled = true;
             REQUIRE(result.has_value());
@@ -189,3 +308,128 @@ TEST_CASE("Receive data from broker.", "[mqtt]")
     context.run();
     REQUIRE(receive_handled);
 }
+
+TEST_CASE("Subscribe before connecting.", "[mqtt]")
+{
+    using namespace b2h;
+
+    event::context context;
+    mqtt::config config{ "mqtt://test:1883" };
+    mqtt::session session{ context };
+    mqtt::client client{ context, session };
+    bool subscribe_handled = false;
+    bool receive_handled   = false;
+
+    session.config(config);
+    client.async_receive([&](auto result) {
+        receive_handled = true;
+        REQUIRE(result.has_value());
+        REQUIRE(result.value().topic == TEST_TOPIC);
+    });
+    client.async_subscribe(TEST_TOPIC,
+        [&](events::mqtt::subscribe::expected_type result) {
+            subscribe_handled = true;
+            REQUIRE(result.has_value());
+            REQUIRE(session.start().has_value());
+        });
+
+    context.run();
+    REQUIRE(subscribe_handled);
+    REQUIRE(receive_handled);
+}
+
+TEST_CASE("Route data to subscribed channels only.", "[mqtt]")
+{
+    using namespace b2h;
+
+    event::context context;
+    mqtt::config config{ "mqtt://test:1883" };
+    mqtt::session session{ context };
+    mqtt::client first{ context, session };
+    mqtt::client second{ context, session };
+    bool first_handled  = false;
+    bool second_handled = false;
+
+    session.config(config);
+    session.async_connect([&](auto) {
+        first.async_receive([&](auto result) {
+            first_handled = true;
+            REQUIRE(result.has_value());
+            REQUIRE(result.value().topic == TEST_TOPIC);
+        });
+        second.async_receive([&](auto result) {
+            second_handled = true;
+            REQUIRE(result.has_value());
+            REQUIRE(result.value().topic == OTHER_TOPIC);
+        });
+        first.async_subscribe(TEST_TOPIC, [&](auto) {
+            second.async_subscribe(OTHER_TOPIC, [&](auto) {});
+        });
+    });
+
+    context.run();
+    REQUIRE(first_handled);
+    REQUIRE(second_handled);
+}
+
+TEST_CASE("Subscribe to several topics at once.", "[mqtt]")
+{
+    using namespace b2h;
+
+    event::context context;
+    mqtt::config config{ "mqtt://test:1883" };
+    mqtt::session session{ context };
+    mqtt::client first{ context, session };
+    mqtt::client second{ context, session };
+    bool subscribe_handled = false;
+
+    const std::array<mqtt::subscription, 2> topics{ {
+        { TEST_TOPIC, 1 },
+        { OTHER_TOPIC, 1 },
+    } };
+
+    session.config(config);
+    session.async_connect([&](auto) {
+        // The first topic is already subscribed by another channel.
+        second.async_subscribe(TEST_TOPIC, [&](auto) {
+            first.async_subscribe(topics,
+                [&](events::mqtt::subscribe_batch::expected_type result) {
+                    subscribe_handled = true;
+                    REQUIRE(result.has_value());
+                    REQUIRE(result.value() ==
+                            std::vector<esp_err_t>{ ESP_OK, ESP_OK });
+                });
+        });
+    });
+
+    context.run();
+    REQUIRE(subscribe_handled);
+}
+
+TEST_CASE("Keep filter shared by another channel.", "[mqtt]")
+{
+    using namespace b2h;
+
+    event::context context;
+    mqtt::config config{ "mqtt://test:1883" };
+    mqtt::session session{ context };
+    mqtt::client first{ context, session };
+    mqtt::client second{ context, session };
+    bool unsubscribe_handled = false;
+
+    session.config(config);
+    session.async_connect([&](auto) {
+        first.async_subscribe(TEST_TOPIC, [&](auto) {
+            second.async_subscribe(TEST_TOPIC, [&](auto result) {
+                REQUIRE(result.has_value());
+                first.async_unsubscribe(TEST_TOPIC, [&](auto result) {
+                    unsubscribe_handled = true;
+                    REQUIRE(result.has_value());
+                });
+            });
+        });
+    });
+
+    context.run();
+    REQUIRE(unsubscribe_handled);
+}
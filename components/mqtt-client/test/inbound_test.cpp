@@ -0,0 +1,138 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "catch2/catch.hpp"
+
+#include <string>
+#include <vector>
+
+#include "mqtt/inbound.hpp"
+
+TEST_CASE("Reassemble fragmented messages.", "[mqtt]")
+{
+    b2h::mqtt::inbound_ring ring;
+
+    SECTION("Single fragment.")
+    {
+        const auto message = ring.append("a/b", "payload", 0, 7);
+
+        REQUIRE(message);
+        REQUIRE(message.topic() == "a/b");
+        REQUIRE(message.data() == "payload");
+    }
+
+    SECTION("Multiple fragments.")
+    {
+        REQUIRE(!ring.append("a/b", "pay", 0, 7));
+        REQUIRE(!ring.append({}, "lo", 3, 7));
+
+        const auto message = ring.append({}, "ad", 5, 7);
+
+        REQUIRE(message);
+        REQUIRE(message.topic() == "a/b");
+        REQUIRE(message.data() == "payload");
+    }
+
+    SECTION("Empty payload.")
+    {
+        const auto message = ring.append("a/b", {}, 0, 0);
+
+        REQUIRE(message);
+        REQUIRE(message.topic() == "a/b");
+        REQUIRE(message.data().empty());
+    }
+}
+
+TEST_CASE("Hold inbound slots until released.", "[mqtt]")
+{
+    using namespace b2h::mqtt;
+
+    inbound_ring ring;
+    std::vector<message_ref> held;
+
+    for (std::size_t i = 0; i < INBOUND_SLOTS; ++i)
+    {
+        const std::string data = std::to_string(i);
+        held.push_back(ring.append("a/b", data, 0, data.size()));
+        REQUIRE(held.back());
+    }
+
+    // Every slot is referenced, nothing may be overwritten.
+    REQUIRE(!ring.append("a/b", "x", 0, 1));
+
+    message_ref copy = held.front();
+    held.erase(held.begin());
+    REQUIRE(!ring.append("a/b", "x", 0, 1));
+
+    copy = message_ref{};
+    const auto message = ring.append("a/c", "x", 0, 1);
+
+    REQUIRE(message);
+    REQUIRE(message.topic() == "a/c");
+
+    for (std::size_t i = 0; i < held.size(); ++i)
+    {
+        REQUIRE(held[i].data() == std::to_string(i + 1));
+    }
+}
+
+TEST_CASE("Drop malformed inbound messages.", "[mqtt]")
+{
+    using namespace b2h::mqtt;
+
+    inbound_ring ring;
+
+    SECTION("Too large for a slot.")
+    {
+        const std::string data(INBOUND_SLOT_SIZE, 'x');
+
+        REQUIRE(!ring.append("a/b", { data.data(), 8 }, 0, data.size()));
+        REQUIRE(!ring.append({}, { data.data() + 8, data.size() - 8 },
+            8,
+            data.size()));
+    }
+
+    SECTION("Fragment out of order.")
+    {
+        REQUIRE(!ring.append("a/b", "pay", 0, 7));
+        REQUIRE(!ring.append({}, "ad", 5, 7));
+        REQUIRE(!ring.append({}, "lo", 3, 7));
+    }
+
+    SECTION("New message before the last fragment.")
+    {
+        REQUIRE(!ring.append("a/b", "pay", 0, 7));
+
+        const auto message = ring.append("a/c", "x", 0, 1);
+
+        REQUIRE(message);
+        REQUIRE(message.topic() == "a/c");
+        REQUIRE(message.data() == "x");
+    }
+
+    // Dropped messages give their slot back.
+    std::vector<message_ref> held;
+
+    for (std::size_t i = 0; i < INBOUND_SLOTS; ++i)
+    {
+        held.push_back(ring.append("a/b", "x", 0, 1));
+        REQUIRE(held.back());
+    }
+}
@@ -18,14 +18,35 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#ifndef MOCK_MQTT_CLIENT_H
+#define MOCK_MQTT_CLIENT_H
+
 #include "esp_err.h"
 
 #include <algorithm>
 #include <cstdint>
 #include <future>
+#include <map>
+#include <string>
+#include <vector>
 
 inline constexpr const char* TEST_DATA = "TEST";
 
+// Received data is split so that every test goes through reassembly.
+inline constexpr std::size_t TEST_FRAGMENT_SIZE = 3;
+
+// Payloads enqueued for publishing, in order.
+inline std::vector<std::string> test_published;
+
+// Topics enqueued for publishing, in order.
+inline std::vector<std::string> test_published_topics;
+
+// Whether the broker resumes the previous session on connect.
+inline bool test_session_present = false;
+
+// Payloads delivered on subscribe instead of TEST_DATA, by topic.
+inline std::map<std::string, std::string> test_retained;
+
 enum esp_mqtt_event_id_t : int
 {
     ESP_EVENT_ANY_ID = -1,
@@ -43,6 +64,8 @@ struct esp_mqtt_client_config_t {
     const char* uri;
     const char* username;
     const char* password;
+    const char* client_id;
+    int disable_clean_session;
 };
 
 using esp_event_base_t = const char*;
@@ -56,6 +79,10 @@ struct esp_mqtt_event_t {
     const char* topic;
     std::size_t topic_len;
     std::size_t data_len;
+    int total_data_len;
+    int current_data_offset;
+    int msg_id;
+    int session_present;
 };
 
 using esp_mqtt_event_handle_t = esp_mqtt_event_t*;
@@ -66,28 +93,48 @@ struct esp_mqtt_client {
     void* event_handler_arg;
     std::vector<esp_mqtt_event_id_t> events;
     std::future<void> dispatch_fut;
+    int next_msg_id = 1;
 
-    void dispatch(esp_mqtt_event_id_t event_id)
+    void dispatch(esp_mqtt_event_id_t event_id, int msg_id = 0)
     {
         esp_mqtt_event_t event;
+        event.session_present = static_cast<int>(test_session_present);
         if (std::find_if(events.cbegin(), events.cend(), [event_id](auto val) {
                 return val == ESP_EVENT_ANY_ID || val == event_id;
             }) != events.cend())
         {
             event.event_id = event_id;
+            event.msg_id   = msg_id;
             event_handler(event_handler_arg, nullptr, event_id, &event);
         }
     }
 
-    void publish(std::string topic, std::string data)
+    // Deliver data in fragments of at most fragment_size bytes, the way
+    // esp-mqtt does for messages larger than its buffer.
+    void publish(std::string topic, std::string data,
+        std::size_t fragment_size = SIZE_MAX)
     {
-        esp_mqtt_event_t event;
-        event.event_id  = MQTT_EVENT_DATA;
-        event.data      = data.data();
-        event.data_len  = data.size();
-        event.topic     = topic.data();
-        event.topic_len = topic.size();
-        event_handler(event_handler_arg, nullptr, event.event_id, &event);
+        std::size_t offset = 0;
+
+        do
+        {
+            const std::size_t size =
+                std::min(fragment_size, data.size() - offset);
+
+            esp_mqtt_event_t event;
+            event.event_id            = MQTT_EVENT_DATA;
+            event.data                = data.data() + offset;
+            event.data_len            = size;
+            event.topic               = offset == 0 ? topic.data() : nullptr;
+            event.topic_len           = offset == 0 ? topic.size() : 0;
+            event.total_data_len      = static_cast<int>(data.size());
+            event.current_data_offset = static_cast<int>(offset);
+            event.msg_id              = 0;
+            event.session_present     = 0;
+            event_handler(event_handler_arg, nullptr, event.event_id, &event);
+
+            offset += size;
+        } while (offset < data.size());
     }
 };
 
@@ -126,34 +173,60 @@ inline esp_err_t esp_mqtt_client_register_event(esp_mqtt_client_handle_t client,
 inline int esp_mqtt_client_publish(esp_mqtt_client_handle_t client,
     const char* topic, const char* data, int len, int qos, int retain) noexcept
 {
-    client->dispatch_fut = std::async(std::launch::async,
-        [client]() { client->dispatch(MQTT_EVENT_PUBLISHED); });
-    return 23;
+    const int msg_id = client->next_msg_id++;
+    client->dispatch_fut = std::async(std::launch::async, [client, msg_id]() {
+        client->dispatch(MQTT_EVENT_PUBLISHED, msg_id);
+    });
+    return msg_id;
+}
+
+inline int esp_mqtt_client_enqueue(esp_mqtt_client_handle_t client,
+    const char* topic, const char* data, int len, int qos, int retain,
+    bool store) noexcept
+{
+    test_published.emplace_back(data, len);
+    test_published_topics.emplace_back(topic);
+
+    if (qos == 0)
+    {
+        return 0;
+    }
+
+    return esp_mqtt_client_publish(client, topic, data, len, qos, retain);
 }
 
 inline int esp_mqtt_client_subscribe(
     esp_mqtt_client_handle_t client, const char* topic, int qos) noexcept
 {
-    client->dispatch_fut =
-        std::async(std::launch::async, [client, topic{ std::string(topic) }]() {
-            client->dispatch(MQTT_EVENT_SUBSCRIBED);
-            client->publish(std::move(topic), TEST_DATA);
+    const int msg_id = client->next_msg_id++;
+    client->dispatch_fut = std::async(std::launch::async,
+        [client, msg_id, topic{ std::string(topic) }]() {
+            client->dispatch(MQTT_EVENT_SUBSCRIBED, msg_id);
+
+            const auto retained = test_retained.find(topic);
+            client->publish(std::move(topic),
+                retained != test_retained.end() ? retained->second : TEST_DATA,
+                TEST_FRAGMENT_SIZE);
         });
-    return 23;
+    return msg_id;
 }
 
 inline int esp_mqtt_client_unsubscribe(
     esp_mqtt_client_handle_t client, const char* topic) noexcept
 {
-    client->dispatch_fut = std::async(std::launch::async,
-        [client]() { client->dispatch(MQTT_EVENT_UNSUBSCRIBED); });
-    return 23;
+    const int msg_id = client->next_msg_id++;
+    client->dispatch_fut = std::async(std::launch::async, [client, msg_id]() {
+        client->dispatch(MQTT_EVENT_UNSUBSCRIBED, msg_id);
+    });
+    return msg_id;
 }
 
 inline esp_mqtt_client_handle_t esp_mqtt_client_init(
-    const esp_mqtt_client_config_t*)
+    const esp_mqtt_client_config_t* config)
 {
-    return new esp_mqtt_client{};
+    auto* client   = new esp_mqtt_client{};
+    client->config = *config;
+    return client;
 }
 
 inline esp_err_t esp_mqtt_client_destroy(
@@ -162,3 +235,5 @@ inline esp_err_t esp_mqtt_client_destroy(
     delete client;
     return ESP_OK;
 }
+
+#endif
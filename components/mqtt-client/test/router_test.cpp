@@ -0,0 +1,217 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "catch2/catch.hpp"
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mqtt/router.hpp"
+
+namespace
+{
+    // Reference matcher the router is checked against.
+    bool topic_matches(std::string_view filter, std::string_view topic)
+    {
+        std::size_t f = 0;
+        std::size_t t = 0;
+
+        while (f < filter.size())
+        {
+            if (filter[f] == '#')
+            {
+                return true;
+            }
+
+            if (filter[f] == '+')
+            {
+                t = std::min(topic.find('/', t), topic.size());
+                ++f;
+                continue;
+            }
+
+            if (t == topic.size() || filter[f] != topic[t])
+            {
+                // "a/#" also matches its parent level "a".
+                return t == topic.size() && filter.substr(f) == "/#";
+            }
+
+            ++f;
+            ++t;
+        }
+
+        return t == topic.size();
+    }
+
+    std::vector<int> matches(b2h::mqtt::router<int>& router, const char* topic)
+    {
+        std::vector<int> result;
+        router.match(topic, [&result](int value) { result.push_back(value); });
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+} // namespace
+
+TEST_CASE("Route exact topics.", "[mqtt]")
+{
+    b2h::mqtt::router<int> router;
+
+    router["a/b"]  = 1;
+    router["a/c"]  = 2;
+    router["a/b/"] = 3;
+
+    REQUIRE(router.size() == 3);
+    REQUIRE(matches(router, "a/b") == std::vector<int>{ 1 });
+    REQUIRE(matches(router, "a/c") == std::vector<int>{ 2 });
+    REQUIRE(matches(router, "a/b/") == std::vector<int>{ 3 });
+    REQUIRE(matches(router, "a").empty());
+    REQUIRE(matches(router, "a/b/c").empty());
+}
+
+TEST_CASE("Route wildcard filters.", "[mqtt]")
+{
+    b2h::mqtt::router<int> router;
+
+    router["a/+/c"] = 1;
+    router["a/#"]   = 2;
+    router["#"]     = 3;
+    router["+/b/c"] = 4;
+
+    REQUIRE(matches(router, "a/b/c") == std::vector<int>{ 1, 2, 3, 4 });
+    REQUIRE(matches(router, "a") == std::vector<int>{ 2, 3 });
+    REQUIRE(matches(router, "x/b/c") == std::vector<int>{ 3, 4 });
+    REQUIRE(matches(router, "$SYS/b/c").empty());
+}
+
+TEST_CASE("Erase filters from router.", "[mqtt]")
+{
+    b2h::mqtt::router<int> router;
+
+    router["a/b/c"] = 1;
+    router["a/b"]   = 2;
+
+    REQUIRE(router.erase("a/b/c"));
+    REQUIRE_FALSE(router.erase("a/b/c"));
+    REQUIRE_FALSE(router.erase("a"));
+    REQUIRE(router.find("a/b/c") == nullptr);
+    REQUIRE(*router.find("a/b") == 2);
+    REQUIRE(matches(router, "a/b") == std::vector<int>{ 2 });
+
+    REQUIRE(router.erase("a/b"));
+    REQUIRE(router.empty());
+
+    std::vector<std::string> filters;
+    router.for_each([&filters](std::string_view filter, int) {
+        filters.emplace_back(filter);
+    });
+    REQUIRE(filters.empty());
+}
+
+TEST_CASE("List router filters.", "[mqtt]")
+{
+    b2h::mqtt::router<int> router;
+
+    router["a/+/#"] = 1;
+    router["b"]     = 2;
+    router["a/b"]   = 3;
+
+    std::vector<std::string> filters;
+    router.for_each([&filters](std::string_view filter, int) {
+        filters.emplace_back(filter);
+    });
+
+    std::sort(filters.begin(), filters.end());
+    REQUIRE(filters == std::vector<std::string>{ "a/+/#", "a/b", "b" });
+}
+
+TEST_CASE("Match topic filters.", "[mqtt]")
+{
+    REQUIRE(topic_matches("a/b", "a/b"));
+    REQUIRE(topic_matches("a/+/c", "a/b/c"));
+    REQUIRE(topic_matches("a/#", "a/b/c"));
+    REQUIRE(topic_matches("a/#", "a"));
+    REQUIRE(topic_matches("#", "a/b"));
+    REQUIRE(topic_matches("+/b", "/b"));
+    REQUIRE_FALSE(topic_matches("a/b", "a/b/c"));
+    REQUIRE_FALSE(topic_matches("a/+", "a/b/c"));
+    REQUIRE_FALSE(topic_matches("a/+/c", "a/b/d"));
+    REQUIRE_FALSE(topic_matches("a/b/#", "a/c"));
+}
+
+TEST_CASE("Router agrees with topic_matches.", "[mqtt]")
+{
+    static constexpr std::array<const char*, 4> LEVELS{ "a", "b", "", "+" };
+
+    std::mt19937 gen{ 1234 };
+    std::uniform_int_distribution<std::size_t> level_dist{ 0,
+        LEVELS.size() - 1 };
+    std::uniform_int_distribution<std::size_t> depth_dist{ 1, 4 };
+
+    const auto make_name = [&](bool filter) {
+        std::string name;
+        const std::size_t depth = depth_dist(gen);
+
+        for (std::size_t i = 0; i < depth; ++i)
+        {
+            name += i == 0 ? "" : "/";
+            name += LEVELS[level_dist(gen) % (filter ? 4 : 3)];
+        }
+
+        if (filter && depth_dist(gen) == 1)
+        {
+            name += "/#";
+        }
+
+        return name;
+    };
+
+    std::vector<std::string> filters;
+    b2h::mqtt::router<int> router;
+
+    for (int i = 0; i < 32; ++i)
+    {
+        filters.push_back(make_name(true));
+        router[filters.back()] = 0;
+    }
+
+    for (int i = 0; i < 256; ++i)
+    {
+        const std::string topic = make_name(false);
+        std::size_t expected    = 0;
+        std::size_t routed      = 0;
+
+        std::sort(filters.begin(), filters.end());
+        for (auto iter = filters.cbegin(); iter != filters.cend(); ++iter)
+        {
+            if ((iter == filters.cbegin() || *iter != *std::prev(iter)) &&
+                topic_matches(*iter, topic))
+            {
+                ++expected;
+            }
+        }
+
+        router.match(topic, [&routed](int) { ++routed; });
+        REQUIRE(routed == expected);
+    }
+}
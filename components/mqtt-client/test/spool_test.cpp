@@ -0,0 +1,276 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "catch2/catch.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "event/event.hpp"
+#include "mqtt/client.hpp"
+#include "mqtt/spool.hpp"
+
+namespace
+{
+    // NOR flash in RAM, writes fail once the budget is spent.
+    class ram_storage final : public b2h::mqtt::spool_storage
+    {
+    public:
+        ram_storage(std::size_t sectors, std::size_t sector_size) :
+            m_sector_size{ sector_size },
+            m_data(sectors * sector_size, 0xFF),
+            m_budget{ SIZE_MAX }
+        {
+        }
+
+        std::size_t size() const noexcept override
+        {
+            return m_data.size();
+        }
+
+        std::size_t sector_size() const noexcept override
+        {
+            return m_sector_size;
+        }
+
+        esp_err_t read(std::size_t offset,
+            tcb::span<std::uint8_t> dst) noexcept override
+        {
+            std::copy_n(m_data.begin() + offset, dst.size(), dst.begin());
+            return ESP_OK;
+        }
+
+        esp_err_t write(std::size_t offset,
+            tcb::span<const std::uint8_t> src) noexcept override
+        {
+            if (m_budget == 0)
+            {
+                return ESP_FAIL;
+            }
+
+            --m_budget;
+
+            for (std::size_t i = 0; i < src.size(); ++i)
+            {
+                m_data[offset + i] &= src[i];
+            }
+            return ESP_OK;
+        }
+
+        esp_err_t erase(std::size_t sector) noexcept override
+        {
+            std::fill_n(m_data.begin() + sector * m_sector_size,
+                m_sector_size,
+                0xFF);
+            return ESP_OK;
+        }
+
+        void budget(std::size_t writes) noexcept
+        {
+            m_budget = writes;
+        }
+
+    private:
+        std::size_t m_sector_size;
+        std::vector<std::uint8_t> m_data;
+        std::size_t m_budget;
+    };
+} // namespace
+
+TEST_CASE("Spool messages in order.", "[mqtt]")
+{
+    ram_storage storage{ 2, 256 };
+    b2h::mqtt::spool spool{ storage };
+
+    REQUIRE(spool.mount().has_value());
+    REQUIRE(spool.empty());
+
+    REQUIRE(spool.append("a/b", "1", 1, true).has_value());
+    REQUIRE(spool.append("a/c", "2", 0, false).has_value());
+    REQUIRE(spool.size() == 2);
+
+    auto message = spool.front();
+    REQUIRE(message.has_value());
+    REQUIRE(message->topic == "a/b");
+    REQUIRE(message->data == "1");
+    REQUIRE(message->qos == 1);
+    REQUIRE(message->retain);
+
+    spool.pop();
+    message = spool.front();
+    REQUIRE(message.has_value());
+    REQUIRE(message->topic == "a/c");
+    REQUIRE(message->data == "2");
+    REQUIRE(message->qos == 0);
+    REQUIRE(!message->retain);
+
+    spool.pop();
+    REQUIRE(spool.empty());
+    REQUIRE(!spool.front().has_value());
+}
+
+TEST_CASE("Keep the latest spooled value per topic.", "[mqtt]")
+{
+    ram_storage storage{ 2, 256 };
+    b2h::mqtt::spool spool{ storage };
+
+    REQUIRE(spool.mount().has_value());
+    REQUIRE(spool.append("a/b", "1", 1, true).has_value());
+    REQUIRE(spool.append("a/c", "2", 1, true).has_value());
+    REQUIRE(spool.append("a/b", "3", 1, true).has_value());
+    REQUIRE(spool.size() == 2);
+
+    REQUIRE(spool.front()->topic == "a/c");
+    spool.pop();
+    REQUIRE(spool.front()->data == "3");
+
+    REQUIRE(spool.discard("a/b"));
+    REQUIRE(!spool.discard("a/b"));
+    REQUIRE(spool.empty());
+}
+
+TEST_CASE("Recover spooled messages on mount.", "[mqtt]")
+{
+    ram_storage storage{ 4, 64 };
+
+    {
+        b2h::mqtt::spool spool{ storage };
+
+        REQUIRE(spool.mount().has_value());
+
+        // Spans several sectors.
+        for (int i = 0; i < 8; ++i)
+        {
+            REQUIRE(spool.append("t/" + std::to_string(i % 4),
+                                     std::to_string(i),
+                                     1,
+                                     true)
+                        .has_value());
+        }
+
+        spool.pop();
+    }
+
+    b2h::mqtt::spool spool{ storage };
+
+    REQUIRE(spool.mount().has_value());
+    REQUIRE(spool.size() == 3);
+
+    for (int i = 5; i < 8; ++i)
+    {
+        const auto message = spool.front();
+        REQUIRE(message.has_value());
+        REQUIRE(message->topic == "t/" + std::to_string(i % 4));
+        REQUIRE(message->data == std::to_string(i));
+        spool.pop();
+    }
+
+    REQUIRE(spool.append("t/0", "8", 1, true).has_value());
+    REQUIRE(spool.front()->data == "8");
+}
+
+TEST_CASE("Drop the oldest messages when the spool wraps.", "[mqtt]")
+{
+    ram_storage storage{ 2, 64 };
+    b2h::mqtt::spool spool{ storage };
+
+    REQUIRE(spool.mount().has_value());
+
+    // A 16 byte record each, three fit in a sector.
+    for (int i = 0; i < 7; ++i)
+    {
+        REQUIRE(spool.append("t/" + std::to_string(i), "abcd", 1, true)
+                    .has_value());
+    }
+
+    REQUIRE(spool.size() == 4);
+    REQUIRE(spool.front()->topic == "t/3");
+
+    REQUIRE(!spool.append("t", std::string(64, 'x'), 1, true).has_value());
+}
+
+TEST_CASE("Skip interrupted spool records.", "[mqtt]")
+{
+    ram_storage storage{ 2, 256 };
+
+    {
+        b2h::mqtt::spool spool{ storage };
+
+        REQUIRE(spool.mount().has_value());
+        REQUIRE(spool.append("a/b", "1", 1, true).has_value());
+
+        // Power lost before the record is committed.
+        storage.budget(3);
+        REQUIRE(!spool.append("a/c", "2", 1, true).has_value());
+        storage.budget(SIZE_MAX);
+    }
+
+    b2h::mqtt::spool spool{ storage };
+
+    REQUIRE(spool.mount().has_value());
+    REQUIRE(spool.size() == 1);
+    REQUIRE(spool.front()->topic == "a/b");
+
+    REQUIRE(spool.append("a/c", "3", 1, true).has_value());
+    REQUIRE(spool.size() == 2);
+
+    b2h::mqtt::spool remounted{ storage };
+
+    REQUIRE(remounted.mount().has_value());
+    REQUIRE(remounted.size() == 2);
+}
+
+TEST_CASE("Drain retained publishes spooled while disconnected.", "[mqtt]")
+{
+    using namespace b2h;
+
+    ram_storage storage{ 2, 256 };
+    mqtt::spool spool{ storage };
+    event::context context;
+    mqtt::config config{ "mqtt://test:1883" };
+    mqtt::session session{ context };
+    mqtt::client client{ context, session };
+    bool publish_handled = false;
+
+    REQUIRE(spool.mount().has_value());
+
+    test_published.clear();
+    session.config(config);
+    session.attach_spool(spool);
+
+    client.async_publish("a/b", "1", 1, true, [&](auto result) {
+        REQUIRE(result.has_value());
+        client.async_publish("a/b", "2", 1, true, [&](auto result) {
+            publish_handled = true;
+            REQUIRE(result.has_value());
+            REQUIRE(test_published.empty());
+            REQUIRE(spool.size() == 1);
+
+            session.async_connect([&](auto) {});
+        });
+    });
+
+    context.run();
+    REQUIRE(publish_handled);
+    REQUIRE(spool.empty());
+    REQUIRE(test_published == std::vector<std::string>{ "2" });
+}
@@ -0,0 +1,142 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "benchmark/benchmark.h"
+
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+
+#include "fmt/format.h"
+
+#include "utils/mac.hpp"
+#include "utils/mac_map.hpp"
+
+namespace
+{
+    constexpr std::string_view INPUT{ "a4:c1:38:0d:53:a1" };
+} // namespace
+
+static void mac_make_mac(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        auto mac = b2h::utils::make_mac(INPUT);
+        benchmark::DoNotOptimize(mac);
+    }
+}
+BENCHMARK(mac_make_mac);
+
+// Parsing as done before make_mac, for comparison.
+static void mac_from_chars(benchmark::State& state)
+{
+    using b2h::utils::mac;
+
+    for (auto _ : state)
+    {
+        std::array<std::uint8_t, mac::MAC_SIZE> result{};
+        const char* first = INPUT.data();
+
+        for (std::size_t i = 0; i < mac::MAC_SIZE; ++i)
+        {
+            std::uint16_t buf = 0;
+            const auto res = std::from_chars(first, first + 2, buf, 16);
+            first          = res.ptr + 1;
+            result[mac::MAC_SIZE - 1 - i] = static_cast<std::uint8_t>(buf);
+        }
+
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(mac_from_chars);
+
+static void mac_to_id(benchmark::State& state)
+{
+    const auto mac = b2h::utils::make_mac(INPUT).value();
+
+    for (auto _ : state)
+    {
+        auto id = mac.to_id();
+        benchmark::DoNotOptimize(id);
+    }
+}
+BENCHMARK(mac_to_id);
+
+// Formatting as done before mac::to_id, for comparison.
+static void mac_fmt_format(benchmark::State& state)
+{
+    const auto mac = b2h::utils::make_mac(INPUT).value();
+
+    for (auto _ : state)
+    {
+        const auto bytes = mac.as_bytes();
+        auto str = fmt::format("{:02x}:{:02x}:{:02x}:{:02x}:{:02x}:{:02x}",
+            bytes[5],
+            bytes[4],
+            bytes[3],
+            bytes[2],
+            bytes[1],
+            bytes[0]);
+        benchmark::DoNotOptimize(str);
+    }
+}
+BENCHMARK(mac_fmt_format);
+
+static void mac_hash(benchmark::State& state)
+{
+    const auto mac = b2h::utils::make_mac(INPUT).value();
+
+    for (auto _ : state)
+    {
+        auto hash = std::hash<b2h::utils::mac>{}(mac);
+        benchmark::DoNotOptimize(hash);
+    }
+}
+BENCHMARK(mac_hash);
+
+// Lookup in a map filled to 12 of 16 slots.
+static void mac_map_find(benchmark::State& state)
+{
+    b2h::utils::mac_map<int, 16> map;
+    std::array<std::uint8_t, b2h::utils::mac::MAC_SIZE> bytes{ 0xa1,
+        0x53,
+        0x0d,
+        0x38,
+        0xc1,
+        0xa4 };
+
+    for (std::uint8_t i = 0; i < 12; ++i)
+    {
+        bytes[0] = i;
+        map.insert_or_assign(b2h::utils::mac{ bytes }, i);
+    }
+
+    bytes[0] = 7;
+    const b2h::utils::mac key{ bytes };
+
+    for (auto _ : state)
+    {
+        auto* value = map.find(key);
+        benchmark::DoNotOptimize(value);
+    }
+}
+BENCHMARK(mac_map_find);
@@ -21,11 +21,24 @@
 #ifndef B2H_UTILS_JSON_HPP
 #define B2H_UTILS_JSON_HPP
 
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
 #include <fstream>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <stdexcept>
 #include <string>
 #include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "rapidjson/document.h"
+#include "rapidjson/memorystream.h"
+#include "rapidjson/reader.h"
 
 namespace b2h::utils::json
 {
@@ -111,6 +124,464 @@ namespace b2h::utils::json
                 };
         }
     } // namespace pred
+
+    /**
+     * @brief Exception thrown when JSON cannot be bound to a described
+     * structure. Message contains the path of the offending field and offset
+     * of the input at which the error was detected.
+     *
+     */
+    class bind_error : public std::runtime_error
+    {
+    public:
+        bind_error(std::string_view message, std::size_t offset);
+
+        /**
+         * @brief Returns the input offset at which the error was detected.
+         *
+         * @return std::size_t
+         */
+        std::size_t offset() const noexcept;
+
+    private:
+        std::size_t m_offset;
+    };
+
+    /**
+     * @brief Compile-time description of a single structure member bound to a
+     * JSON object key.
+     *
+     * @tparam T Structure type
+     * @tparam MemberT Member type
+     */
+    template<typename T, typename MemberT>
+    struct field_descriptor {
+        using object_type = T;
+        using member_type = MemberT;
+
+        std::string_view key;
+        MemberT T::*member;
+        bool required;
+    };
+
+    /**
+     * @brief Describe a required field.
+     *
+     * @param key
+     * @param member
+     * @return constexpr field_descriptor<T, MemberT>
+     */
+    template<typename T, typename MemberT>
+    inline constexpr field_descriptor<T, MemberT> field(
+        std::string_view key, MemberT T::*member) noexcept
+    {
+        return { key, member, true };
+    }
+
+    /**
+     * @brief Describe an optional field. Member keeps its default value when
+     * the key is absent.
+     *
+     * @param key
+     * @param member
+     * @return constexpr field_descriptor<T, MemberT>
+     */
+    template<typename T, typename MemberT>
+    inline constexpr field_descriptor<T, MemberT> optional_field(
+        std::string_view key, MemberT T::*member) noexcept
+    {
+        return { key, member, false };
+    }
+
+    /**
+     * @brief Create a field table. Structures become bindable by returning it
+     * from a static constexpr json_fields() member function.
+     *
+     * @param fields
+     * @return constexpr auto
+     */
+    template<typename... FieldsT>
+    inline constexpr auto fields(FieldsT... fields) noexcept
+    {
+        return std::make_tuple(fields...);
+    }
+
+    namespace impl
+    {
+        enum class token : std::uint8_t
+        {
+            null,
+            boolean,
+            integer,
+            floating,
+            string,
+            key,
+            object_begin,
+            object_end,
+            array_begin,
+            array_end,
+            end,
+        };
+
+        /**
+         * @brief Pull-style tokenizer on top of the rapidjson SAX reader.
+         * Every next() call consumes exactly one token, no DOM is built.
+         *
+         */
+        class pull_reader
+        {
+        public:
+            pull_reader(std::string_view input, std::string_view source);
+
+            pull_reader(const pull_reader&) = delete;
+
+            pull_reader& operator=(const pull_reader&) = delete;
+
+            token next();
+
+            token current() const noexcept
+            {
+                return m_token;
+            }
+
+            bool boolean() const noexcept
+            {
+                return m_bool;
+            }
+
+            std::int64_t integer() const noexcept
+            {
+                return m_integer;
+            }
+
+            double floating() const noexcept
+            {
+                return m_token == token::integer
+                           ? static_cast<double>(m_integer)
+                           : m_floating;
+            }
+
+            std::string& string() noexcept
+            {
+                return m_string;
+            }
+
+            void skip();
+
+            void push_path(std::string_view key);
+
+            void push_path(std::size_t index);
+
+            void pop_path() noexcept;
+
+            [[noreturn]] void fail_type(std::string_view expected) const;
+
+            [[noreturn]] void fail_missing(std::string_view key) const;
+
+            // rapidjson handler interface
+
+            bool Null();
+            bool Bool(bool value);
+            bool Int(int value);
+            bool Uint(unsigned value);
+            bool Int64(std::int64_t value);
+            bool Uint64(std::uint64_t value);
+            bool Double(double value);
+            bool RawNumber(const char* str, rapidjson::SizeType length, bool);
+            bool String(const char* str, rapidjson::SizeType length, bool);
+            bool StartObject();
+            bool Key(const char* str, rapidjson::SizeType length, bool);
+            bool EndObject(rapidjson::SizeType);
+            bool StartArray();
+            bool EndArray(rapidjson::SizeType);
+
+        private:
+            rapidjson::MemoryStream m_stream;
+            rapidjson::Reader m_reader;
+            std::string_view m_source;
+
+            token m_token;
+            bool m_bool;
+            std::int64_t m_integer;
+            double m_floating;
+            std::string m_string;
+
+            std::string m_path;
+            std::vector<std::size_t> m_path_marks;
+
+            std::size_t offset() const noexcept;
+        };
+
+        template<typename T, typename = void>
+        struct has_json_fields : std::false_type {
+        };
+
+        template<typename T>
+        struct has_json_fields<T, std::void_t<decltype(T::json_fields())>> :
+            std::true_type {
+        };
+
+        template<typename T>
+        struct is_optional : std::false_type {
+        };
+
+        template<typename T>
+        struct is_optional<std::optional<T>> : std::true_type {
+        };
+
+        template<typename T>
+        struct is_vector : std::false_type {
+        };
+
+        template<typename T, typename AllocT>
+        struct is_vector<std::vector<T, AllocT>> : std::true_type {
+        };
+
+        template<typename T>
+        inline constexpr bool dependent_false_v = false;
+
+        template<typename FieldsT, std::size_t... Is>
+        constexpr bool has_unique_keys(
+            const FieldsT& fields, std::index_sequence<Is...>) noexcept
+        {
+            if constexpr (sizeof...(Is) < 2)
+            {
+                return true;
+            }
+            else
+            {
+                const std::string_view keys[]{ std::get<Is>(fields).key... };
+
+                for (std::size_t i = 0; i < sizeof...(Is); ++i)
+                {
+                    for (std::size_t j = i + 1; j < sizeof...(Is); ++j)
+                    {
+                        if (keys[i] == keys[j])
+                        {
+                            return false;
+                        }
+                    }
+                }
+
+                return true;
+            }
+        }
+
+        template<typename FieldsT, std::size_t... Is>
+        constexpr std::size_t find_field(const FieldsT& fields,
+            std::string_view key, std::index_sequence<Is...>) noexcept
+        {
+            std::size_t index = sizeof...(Is);
+            ((std::get<Is>(fields).key == key ? (index = Is, true) : false) ||
+                ...);
+            return index;
+        }
+
+        template<typename T>
+        void read_value(pull_reader& reader, T& out);
+
+        template<typename T, typename FieldsT, std::size_t... Is>
+        void read_field(pull_reader& reader, T& out, const FieldsT& fields,
+            std::size_t index, std::index_sequence<Is...>)
+        {
+            ((index == Is
+                     ? (read_value(reader, out.*(std::get<Is>(fields).member)),
+                           true)
+                     : false) ||
+                ...);
+        }
+
+        template<typename T>
+        void read_object(pull_reader& reader, T& out)
+        {
+            constexpr auto fields = T::json_fields();
+            constexpr std::size_t field_count =
+                std::tuple_size_v<std::remove_const_t<decltype(fields)>>;
+            constexpr auto indices = std::make_index_sequence<field_count>{};
+
+            static_assert(has_unique_keys(fields, indices),
+                "JSON field keys must be unique.");
+
+            std::bitset<field_count> seen;
+
+            if (reader.current() != token::object_begin)
+            {
+                reader.fail_type("an object");
+            }
+
+            while (reader.next() == token::key)
+            {
+                const std::size_t index =
+                    find_field(fields, reader.string(), indices);
+
+                reader.push_path(reader.string());
+                reader.next();
+
+                if (index == field_count)
+                {
+                    reader.skip(); // Unknown keys are ignored.
+                }
+                else
+                {
+                    read_field(reader, out, fields, index, indices);
+                    seen.set(index);
+                }
+
+                reader.pop_path();
+            }
+
+            std::apply(
+                [&](const auto&... field) {
+                    std::size_t index = 0;
+                    ((field.required && !seen.test(index)
+                             ? reader.fail_missing(field.key)
+                             : void(),
+                         ++index),
+                        ...);
+                },
+                fields);
+        }
+
+        template<typename T>
+        void read_value(pull_reader& reader, T& out)
+        {
+            if constexpr (std::is_same_v<T, std::string>)
+            {
+                if (reader.current() != token::string)
+                {
+                    reader.fail_type("a string");
+                }
+
+                out.assign(reader.string());
+            }
+            else if constexpr (std::is_same_v<T, bool>)
+            {
+                if (reader.current() != token::boolean)
+                {
+                    reader.fail_type("a boolean");
+                }
+
+                out = reader.boolean();
+            }
+            else if constexpr (std::is_integral_v<T>)
+            {
+                using limits = std::numeric_limits<T>;
+
+                if (reader.current() != token::integer ||
+                    (std::is_unsigned_v<T> && reader.integer() < 0) ||
+                    (reader.integer() >= 0 &&
+                        static_cast<std::uint64_t>(reader.integer()) >
+                            static_cast<std::uint64_t>(limits::max())) ||
+                    (std::is_signed_v<T> &&
+                        reader.integer() <
+                            static_cast<std::int64_t>(limits::min())))
+                {
+                    reader.fail_type("an integer in the range of the field");
+                }
+
+                out = static_cast<T>(reader.integer());
+            }
+            else if constexpr (std::is_floating_point_v<T>)
+            {
+                if (reader.current() != token::integer &&
+                    reader.current() != token::floating)
+                {
+                    reader.fail_type("a number");
+                }
+
+                out = static_cast<T>(reader.floating());
+            }
+            else if constexpr (is_optional<T>::value)
+            {
+                if (reader.current() == token::null)
+                {
+                    out.reset();
+                    return;
+                }
+
+                typename T::value_type value{};
+                read_value(reader, value);
+                out = std::move(value);
+            }
+            else if constexpr (is_vector<T>::value)
+            {
+                if (reader.current() != token::array_begin)
+                {
+                    reader.fail_type("an array");
+                }
+
+                out.clear();
+
+                while (reader.next() != token::array_end)
+                {
+                    reader.push_path(out.size());
+                    read_value(reader, out.emplace_back());
+                    reader.pop_path();
+                }
+            }
+            else if constexpr (has_json_fields<T>::value)
+            {
+                read_object(reader, out);
+            }
+            else
+            {
+                static_assert(dependent_false_v<T>,
+                    "Type cannot be bound to JSON. Supported types are "
+                    "std::string, bool, arithmetic types, std::optional, "
+                    "std::vector and structures with json_fields().");
+            }
+        }
+    } // namespace impl
+
+    /**
+     * @brief Bind JSON text to a structure described with json_fields().
+     * Parsing is done in a single pass, without building a document.
+     *
+     * @param input
+     * @param source Name of the input used in error messages.
+     * @return T
+     * @throws bind_error on syntax error, type mismatch or missing field.
+     */
+    template<typename T>
+    T bind(std::string_view input, std::string_view source = "JSON")
+    {
+        T result{};
+        impl::pull_reader reader{ input, source };
+
+        reader.next();
+        impl::read_value(reader, result);
+
+        if (reader.next() != impl::token::end)
+        {
+            reader.fail_type("a single value");
+        }
+
+        return result;
+    }
+
+    /**
+     * @brief Bind JSON file to a structure described with json_fields().
+     *
+     * @param path
+     * @return T
+     * @throws bind_error if the file cannot be read or bound.
+     */
+    template<typename T>
+    T bind_file(const char* path)
+    {
+        std::ifstream ifs(path, std::ios::binary);
+
+        if (!ifs)
+        {
+            throw bind_error{ std::string{ "Failed to open " } + path + ".",
+                0 };
+        }
+
+        const std::string content{ std::istreambuf_iterator<char>{ ifs },
+            std::istreambuf_iterator<char>{} };
+
+        return bind<T>(content, path);
+    }
 } // namespace b2h::utils::json
 
 #endif
\ No newline at end of file
@@ -21,13 +21,57 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
 #include "fmt/color.h"
 #include "fmt/format.h"
+#include "tcb/span.hpp"
+
+#if __has_include("sdkconfig.h")
+#include "sdkconfig.h"
+#endif
 
 #ifndef B2H_LOG_LEVEL
 #define B2H_LOG_LEVEL none
 #endif
 
+// Enable CONFIG_B2H_LOG_DEFERRED (or define B2H_LOG_DEFERRED) to move
+// formatting and output off the calling thread. Call sites then only copy
+// their arguments into a lock-free queue and log::drain() formats them later.
+// Format and component strings must have static storage duration in this mode.
+
+#if defined(CONFIG_B2H_LOG_DEFERRED) && !defined(B2H_LOG_DEFERRED)
+#define B2H_LOG_DEFERRED
+#endif
+
+#ifndef B2H_LOG_DEFERRED_SLOTS
+#ifdef CONFIG_B2H_LOG_DEFERRED_SLOTS
+#define B2H_LOG_DEFERRED_SLOTS CONFIG_B2H_LOG_DEFERRED_SLOTS
+#else
+#define B2H_LOG_DEFERRED_SLOTS 32
+#endif
+#endif
+
+#ifndef B2H_LOG_DEFERRED_PAYLOAD
+#ifdef CONFIG_B2H_LOG_DEFERRED_PAYLOAD
+#define B2H_LOG_DEFERRED_PAYLOAD CONFIG_B2H_LOG_DEFERRED_PAYLOAD
+#else
+#define B2H_LOG_DEFERRED_PAYLOAD 64
+#endif
+#endif
+
 namespace b2h::log
 {
     enum class log_level : std::uint8_t
@@ -49,8 +93,872 @@ namespace b2h::log
 
     inline constexpr auto GLOBAL_LOG_LEVEL = log_level::B2H_LOG_LEVEL;
 
+    /**
+     * @brief Check if messages at given level are compiled in. Levels above
+     * B2H_LOG_LEVEL are removed at compile time regardless of runtime
+     * configuration.
+     *
+     * @param level
+     * @return true
+     * @return false
+     */
+    inline constexpr bool compiled_in(log_level level) noexcept
+    {
+        return level != log_level::none &&
+               static_cast<std::uint8_t>(level) <=
+                   static_cast<std::uint8_t>(GLOBAL_LOG_LEVEL);
+    }
+
+    /**
+     * @brief Name of a logging component with precomputed identifier used for
+     * the runtime level lookup.
+     *
+     */
+    class component
+    {
+    public:
+        constexpr component(std::string_view name) noexcept :
+            m_name{ name },
+            m_id{ make_id(name) }
+        {
+        }
+
+        template<std::size_t N>
+        constexpr component(const char (&name)[N]) noexcept :
+            component{ std::string_view{ name, N - 1 } }
+        {
+        }
+
+        constexpr std::string_view name() const noexcept
+        {
+            return m_name;
+        }
+
+        constexpr std::uint32_t id() const noexcept
+        {
+            return m_id;
+        }
+
+        /**
+         * @brief FNV-1a hash of the name. Zero is reserved for empty slots of
+         * the level table.
+         *
+         * @param name
+         * @return constexpr std::uint32_t
+         */
+        static constexpr std::uint32_t make_id(std::string_view name) noexcept
+        {
+            std::uint32_t hash = 2166136261u;
+
+            for (const char c : name)
+            {
+                hash ^= static_cast<std::uint8_t>(c);
+                hash *= 16777619u;
+            }
+
+            return hash != 0 ? hash : 1;
+        }
+
+    private:
+        std::string_view m_name;
+        std::uint32_t m_id;
+    };
+
+    namespace impl
+    {
+        /**
+         * @brief Fixed capacity open addressing map of runtime level
+         * overrides keyed by component id. Lookups are lock-free, when no
+         * override is set the lookup is a single atomic load.
+         *
+         */
+        class level_table
+        {
+        public:
+            static constexpr std::size_t CAPACITY = 32;
+
+            constexpr level_table() noexcept :
+                m_ids{},
+                m_levels{},
+                m_default{ static_cast<std::uint8_t>(GLOBAL_LOG_LEVEL) },
+                m_overrides{ 0 }
+            {
+            }
+
+            level_table(const level_table&) = delete;
+
+            level_table& operator=(const level_table&) = delete;
+
+            log_level get(std::uint32_t id) const noexcept
+            {
+                const auto fallback = static_cast<log_level>(
+                    m_default.load(std::memory_order_relaxed));
+
+                if (m_overrides.load(std::memory_order_relaxed) == 0)
+                {
+                    return fallback;
+                }
+
+                for (std::size_t i = 0, index = id & (CAPACITY - 1);
+                     i < CAPACITY;
+                     ++i, index = (index + 1) & (CAPACITY - 1))
+                {
+                    const std::uint32_t key =
+                        m_ids[index].load(std::memory_order_acquire);
+
+                    if (key == id)
+                    {
+                        const std::uint8_t stored =
+                            m_levels[index].load(std::memory_order_relaxed);
+                        return stored == 0
+                                   ? fallback
+                                   : static_cast<log_level>(stored - 1);
+                    }
+
+                    if (key == 0)
+                    {
+                        break;
+                    }
+                }
+
+                return fallback;
+            }
+
+            bool set(std::uint32_t id, std::optional<log_level> level) noexcept
+            {
+                // Level is stored incremented by one, zero means no override.
+                const std::uint8_t stored =
+                    level ? static_cast<std::uint8_t>(*level) + 1 : 0;
+
+                for (std::size_t i = 0, index = id & (CAPACITY - 1);
+                     i < CAPACITY;
+                     ++i, index = (index + 1) & (CAPACITY - 1))
+                {
+                    std::uint32_t key =
+                        m_ids[index].load(std::memory_order_acquire);
+
+                    if (key == 0 && stored != 0 &&
+                        m_ids[index].compare_exchange_strong(key,
+                            id,
+                            std::memory_order_acq_rel))
+                    {
+                        m_levels[index].store(
+                            stored, std::memory_order_relaxed);
+                        m_overrides.fetch_add(1, std::memory_order_release);
+                        return true;
+                    }
+
+                    if (key == id)
+                    {
+                        m_levels[index].store(
+                            stored, std::memory_order_relaxed);
+                        return true;
+                    }
+
+                    if (key == 0)
+                    {
+                        return stored == 0;
+                    }
+                }
+
+                return false;
+            }
+
+            void set_default(log_level level) noexcept
+            {
+                m_default.store(static_cast<std::uint8_t>(level),
+                    std::memory_order_relaxed);
+            }
+
+        private:
+            std::array<std::atomic<std::uint32_t>, CAPACITY> m_ids;
+            std::array<std::atomic<std::uint8_t>, CAPACITY> m_levels;
+            std::atomic<std::uint8_t> m_default;
+            std::atomic<std::size_t> m_overrides;
+        };
+
+        inline level_table g_levels{};
+    } // namespace impl
+
+    /**
+     * @brief Set runtime level of a component. Levels above B2H_LOG_LEVEL
+     * stay disabled.
+     *
+     * @param comp
+     * @param level
+     * @return true Level set.
+     * @return false Override table is full.
+     */
+    inline bool set_level(const component& comp, log_level level) noexcept
+    {
+        return impl::g_levels.set(comp.id(), level);
+    }
+
+    /**
+     * @brief Remove runtime level override of a component, it will use the
+     * default level again.
+     *
+     * @param comp
+     */
+    inline void reset_level(const component& comp) noexcept
+    {
+        impl::g_levels.set(comp.id(), std::nullopt);
+    }
+
+    /**
+     * @brief Set runtime level of components without an override.
+     *
+     * @param level
+     */
+    inline void set_default_level(log_level level) noexcept
+    {
+        impl::g_levels.set_default(level);
+    }
+
+    /**
+     * @brief Get current runtime level of a component.
+     *
+     * @param comp
+     * @return log_level
+     */
+    inline log_level level(const component& comp) noexcept
+    {
+        return impl::g_levels.get(comp.id());
+    }
+
+    /**
+     * @brief Check if message at given level would be printed for a
+     * component.
+     *
+     * @param level
+     * @param comp
+     * @return true
+     * @return false
+     */
+    inline bool enabled(log_level msg_level, const component& comp) noexcept
+    {
+        return compiled_in(msg_level) &&
+               static_cast<std::uint8_t>(msg_level) <=
+                   static_cast<std::uint8_t>(level(comp));
+    }
+
+    /**
+     * @brief Parse level name, e.g. "debug".
+     *
+     * @param name
+     * @return std::optional<log_level>
+     */
+    std::optional<log_level> parse_level(std::string_view name) noexcept;
+
+#ifdef B2H_LOG_DEFERRED
+    inline constexpr bool DEFERRED_LOGGING = true;
+#else
+    inline constexpr bool DEFERRED_LOGGING = false;
+#endif
+
+    /**
+     * @brief Format and print all deferred records. No-op when deferred
+     * logging is disabled.
+     *
+     * @return std::size_t Number of records printed.
+     */
+    std::size_t drain() noexcept;
+
+    namespace impl
+    {
+        using decoder_type = void (*)(const std::uint8_t* payload,
+            std::string_view format,
+            fmt::memory_buffer& out);
+
+        struct record_header {
+            log_level level;
+            std::string_view component;
+            std::string_view format;
+            decoder_type decoder;
+        };
+
+        template<typename T>
+        inline constexpr bool is_string_like_v =
+            std::is_same_v<T, std::string> ||
+            std::is_same_v<T, std::string_view> ||
+            std::is_same_v<T, const char*> || std::is_same_v<T, char*>;
+
+        template<typename T, typename = void>
+        inline constexpr bool is_bytes_v = false;
+
+        /**
+         * @brief Contiguous container of bytes, e.g. std::vector<std::uint8_t>
+         * holding a BLE notification.
+         *
+         */
+        template<typename T>
+        inline constexpr bool is_bytes_v<T,
+            std::void_t<decltype(std::declval<const T&>().data()),
+                decltype(std::declval<const T&>().size())>> =
+            std::is_same_v<std::remove_cv_t<std::remove_pointer_t<decltype(
+                               std::declval<const T&>().data())>>,
+                std::uint8_t>;
+
+        template<typename T>
+        inline constexpr bool is_raw_v = !is_string_like_v<T> &&
+                                         !is_bytes_v<T> &&
+                                         std::is_trivially_copyable_v<T>;
+
+        /**
+         * @brief Type of an argument as stored in the record payload. Byte
+         * containers are stored as their bytes, strings and other types which
+         * are not trivially copyable as text.
+         *
+         */
+        template<typename T>
+        using wire_t = std::conditional_t<is_raw_v<T>,
+            T,
+            std::conditional_t<is_bytes_v<T>,
+                tcb::span<const std::uint8_t>,
+                std::string_view>>;
+
+        /**
+         * @brief String argument read back from a record, marked when it was
+         * shortened to fit the slot.
+         *
+         */
+        struct text {
+            std::string_view value;
+            bool truncated;
+        };
+
+        /**
+         * @brief Byte container argument read back from a record, formatted
+         * in the drain task.
+         *
+         */
+        struct bytes {
+            tcb::span<const std::uint8_t> value;
+            bool truncated;
+        };
+
+        // Set in the encoded size of a shortened string or byte container.
+        inline constexpr std::uint16_t TRUNCATED_FLAG{ 0x8000 };
+
+        template<typename T>
+        inline constexpr bool is_sized_v =
+            std::is_same_v<T, std::string_view> ||
+            std::is_same_v<T, tcb::span<const std::uint8_t>>;
+
+        template<typename T>
+        using decoded_t =
+            std::conditional_t<std::is_same_v<T, std::string_view>,
+                text,
+                std::conditional_t<is_sized_v<T>, bytes, T>>;
+
+        /**
+         * @brief Index of the last argument stored with its size, the one
+         * shortened when a record does not fit its slot.
+         *
+         * @return std::size_t sizeof...(WireT) if there is none.
+         */
+        template<typename... WireT>
+        constexpr std::size_t last_sized_index() noexcept
+        {
+            std::size_t result = sizeof...(WireT);
+            std::size_t index  = 0;
+
+            ((result = is_sized_v<WireT> ? index : result, ++index), ...);
+
+            return result;
+        }
+
+        template<typename T>
+        inline auto to_encodable(const T& arg)
+        {
+            if constexpr (is_raw_v<T>)
+            {
+                return arg;
+            }
+            else if constexpr (is_bytes_v<T>)
+            {
+                // Formatted in the drain task, not in the caller's context.
+                return tcb::span<const std::uint8_t>{ arg.data(), arg.size() };
+            }
+            else if constexpr (is_string_like_v<T>)
+            {
+                if constexpr (std::is_pointer_v<T>)
+                {
+                    return arg ? std::string_view{ arg } : std::string_view{};
+                }
+                else
+                {
+                    return std::string_view{ arg };
+                }
+            }
+            else
+            {
+                return fmt::to_string(arg);
+            }
+        }
+
+        template<typename T>
+        inline std::size_t encoded_size(const T& value) noexcept
+        {
+            if constexpr (is_raw_v<T>)
+            {
+                return sizeof(T);
+            }
+            else
+            {
+                return sizeof(std::uint16_t) + value.size();
+            }
+        }
+
+        template<typename T>
+        inline void truncate(T& value, std::size_t size) noexcept
+        {
+            if constexpr (std::is_same_v<T, std::string>)
+            {
+                value.resize(size);
+            }
+            else
+            {
+                value = T{ value.data(), size };
+            }
+        }
+
+        template<typename T>
+        inline std::uint8_t* encode(
+            std::uint8_t* out, const T& value, bool truncated) noexcept
+        {
+            if constexpr (is_raw_v<T>)
+            {
+                std::memcpy(out, &value, sizeof(T));
+                return out + sizeof(T);
+            }
+            else
+            {
+                const auto size  = static_cast<std::uint16_t>(value.size());
+                const auto field = static_cast<std::uint16_t>(
+                    truncated ? size | TRUNCATED_FLAG : size);
+                std::memcpy(out, &field, sizeof(field));
+                std::memcpy(out + sizeof(field), value.data(), size);
+                return out + sizeof(field) + size;
+            }
+        }
+
+        template<typename T>
+        inline decoded_t<T> decode_one(const std::uint8_t*& in) noexcept
+        {
+            if constexpr (is_sized_v<T>)
+            {
+                std::uint16_t field = 0;
+                std::memcpy(&field, in, sizeof(field));
+                const auto size = static_cast<std::uint16_t>(
+                    field & ~TRUNCATED_FLAG);
+                const auto* data =
+                    reinterpret_cast<const typename T::value_type*>(
+                        in + sizeof(field));
+                in += sizeof(field) + size;
+                return { T{ data, size }, (field & TRUNCATED_FLAG) != 0 };
+            }
+            else
+            {
+                T value;
+                std::memcpy(&value, in, sizeof(T));
+                in += sizeof(T);
+                return value;
+            }
+        }
+
+        template<typename... WireT>
+        void decode([[maybe_unused]] const std::uint8_t* payload,
+            std::string_view format,
+            fmt::memory_buffer& out)
+        {
+            // Braced initialization guarantees left to right evaluation.
+            std::tuple<decoded_t<WireT>...> values{ decode_one<WireT>(
+                payload)... };
+
+            std::apply(
+                [&](auto&... args) {
+                    fmt::vformat_to(std::back_inserter(out),
+                        format,
+                        fmt::make_format_args(args...));
+                },
+                values);
+        }
+
+        /**
+         * @brief Bounded multi-producer queue of log records with fixed size
+         * slots. Based on the Vyukov bounded MPMC queue, producers never
+         * block. A record too large for its slot has its last string or byte
+         * container argument shortened and marked, records which still do
+         * not fit are dropped and counted.
+         *
+         * @tparam SlotCount Number of slots, must be a power of 2.
+         * @tparam PayloadSize Maximum size of encoded arguments in bytes.
+         */
+        template<std::size_t SlotCount, std::size_t PayloadSize>
+        class basic_record_queue
+        {
+            static_assert((SlotCount & (SlotCount - 1)) == 0,
+                "SlotCount must be a power of 2.");
+            static_assert(PayloadSize < TRUNCATED_FLAG,
+                "String sizes must leave the truncation flag free.");
+
+        public:
+            basic_record_queue() noexcept :
+                m_slots{},
+                m_enqueue_pos{ 0 },
+                m_dequeue_pos{ 0 },
+                m_dropped{ 0 }
+            {
+                for (std::size_t i = 0; i < SlotCount; ++i)
+                {
+                    m_slots[i].sequence.store(i, std::memory_order_relaxed);
+                }
+            }
+
+            basic_record_queue(const basic_record_queue&) = delete;
+
+            basic_record_queue& operator=(const basic_record_queue&) = delete;
+
+            /**
+             * @brief Copy arguments into a free slot.
+             *
+             * @param level
+             * @param component
+             * @param format
+             * @param args
+             * @return true Record enqueued, possibly shortened.
+             * @return false Queue full or record too large, record dropped.
+             */
+            template<typename... ArgsT>
+            bool push(log_level level,
+                std::string_view component,
+                std::string_view format,
+                const ArgsT&... args) noexcept
+            {
+                static constexpr std::size_t LAST_SIZED =
+                    last_sized_index<wire_t<ArgsT>...>();
+
+                auto encodables  = std::make_tuple(to_encodable(args)...);
+                std::size_t size = std::apply(
+                    [](const auto&... values) {
+                        return (std::size_t{ 0 } + ... + encoded_size(values));
+                    },
+                    encodables);
+                std::size_t truncated = sizeof...(ArgsT);
+
+                if constexpr (LAST_SIZED < sizeof...(ArgsT))
+                {
+                    auto& value = std::get<LAST_SIZED>(encodables);
+
+                    if (const std::size_t excess =
+                            size > PayloadSize ? size - PayloadSize : 0;
+                        excess != 0 && excess <= value.size())
+                    {
+                        truncate(value, value.size() - excess);
+                        size      = PayloadSize;
+                        truncated = LAST_SIZED;
+                    }
+                }
+
+                slot* target = nullptr;
+
+                if (size > PayloadSize || !(target = acquire()))
+                {
+                    m_dropped.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+
+                target->header = {
+                    level, component, format, &decode<wire_t<ArgsT>...>
+                };
+
+                std::apply(
+                    [out = target->payload.data(), index = std::size_t{ 0 },
+                        truncated](const auto&... values) mutable {
+                        ((out = encode(out, values, index++ == truncated)),
+                            ...);
+                    },
+                    encodables);
+
+                target->sequence.store(
+                    target->position + 1, std::memory_order_release);
+                return true;
+            }
+
+            /**
+             * @brief Take the oldest record and pass it to the callback.
+             *
+             * @param func Callable taking record_header and payload pointer.
+             * @return true Record consumed.
+             * @return false Queue empty.
+             */
+            template<typename FuncT>
+            bool pop(FuncT&& func) noexcept
+            {
+                std::size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+                slot* source    = nullptr;
+
+                for (;;)
+                {
+                    source = &m_slots[pos & (SlotCount - 1)];
+                    const auto diff = static_cast<std::intptr_t>(
+                        source->sequence.load(std::memory_order_acquire) -
+                        (pos + 1));
+
+                    if (diff == 0)
+                    {
+                        if (m_dequeue_pos.compare_exchange_weak(
+                                pos, pos + 1, std::memory_order_relaxed))
+                        {
+                            break;
+                        }
+                    }
+                    else if (diff < 0)
+                    {
+                        return false;
+                    }
+                    else
+                    {
+                        pos = m_dequeue_pos.load(std::memory_order_relaxed);
+                    }
+                }
+
+                func(static_cast<const record_header&>(source->header),
+                    static_cast<const std::uint8_t*>(source->payload.data()));
+                source->sequence.store(
+                    pos + SlotCount, std::memory_order_release);
+                return true;
+            }
+
+            /**
+             * @brief Return number of dropped records since the last call and
+             * reset the counter.
+             *
+             * @return std::size_t
+             */
+            std::size_t take_dropped() noexcept
+            {
+                return m_dropped.exchange(0, std::memory_order_relaxed);
+            }
+
+        private:
+            struct slot {
+                std::atomic<std::size_t> sequence;
+                std::size_t position;
+                record_header header;
+                std::array<std::uint8_t, PayloadSize> payload;
+            };
+
+            std::array<slot, SlotCount> m_slots;
+            std::atomic<std::size_t> m_enqueue_pos;
+            std::atomic<std::size_t> m_dequeue_pos;
+            std::atomic<std::size_t> m_dropped;
+
+            slot* acquire() noexcept
+            {
+                std::size_t pos = m_enqueue_pos.load(std::memory_order_relaxed);
+
+                for (;;)
+                {
+                    slot& candidate = m_slots[pos & (SlotCount - 1)];
+                    const auto diff = static_cast<std::intptr_t>(
+                        candidate.sequence.load(std::memory_order_acquire) -
+                        pos);
+
+                    if (diff == 0)
+                    {
+                        if (m_enqueue_pos.compare_exchange_weak(
+                                pos, pos + 1, std::memory_order_relaxed))
+                        {
+                            candidate.position = pos;
+                            return &candidate;
+                        }
+                    }
+                    else if (diff < 0)
+                    {
+                        return nullptr;
+                    }
+                    else
+                    {
+                        pos = m_enqueue_pos.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+        };
+
+        using record_queue = basic_record_queue<B2H_LOG_DEFERRED_SLOTS,
+            B2H_LOG_DEFERRED_PAYLOAD>;
+
+        /**
+         * @brief Queue used by the logging functions in deferred mode.
+         *
+         * @return record_queue&
+         */
+        record_queue& deferred_queue() noexcept;
+
+        /**
+         * @brief Print a formatted message with level prefix and color.
+         *
+         * @param level
+         * @param component
+         * @param message
+         */
+        void print_line(log_level level,
+            std::string_view component,
+            std::string_view message) noexcept;
+
+        template<typename... ArgsT>
+        inline void write(log_level level,
+            const component& comp,
+            std::string_view format,
+            const ArgsT&... args) noexcept
+        {
+            if constexpr (DEFERRED_LOGGING)
+            {
+                deferred_queue().push(level, comp.name(), format, args...);
+            }
+            else
+            {
+                fmt::memory_buffer message;
+                fmt::vformat_to(std::back_inserter(message),
+                    format,
+                    fmt::make_format_args(args...));
+                print_line(level,
+                    comp.name(),
+                    std::string_view{ message.data(), message.size() });
+            }
+        }
+
+        /**
+         * @brief Token bucket limiting a log site to a number of messages per
+         * second with given burst. Implemented as GCRA, so the whole state is
+         * a single atomic timestamp.
+         *
+         */
+        class rate_limiter
+        {
+        public:
+            constexpr rate_limiter(
+                std::uint32_t per_second, std::uint32_t burst) noexcept :
+                m_interval{ 1'000'000'000 / static_cast<std::int64_t>(
+                                                per_second ? per_second : 1) },
+                m_tolerance{ m_interval *
+                             static_cast<std::int64_t>(burst ? burst - 1 : 0) },
+                m_arrival{ 0 },
+                m_suppressed{ 0 }
+            {
+            }
+
+            rate_limiter(const rate_limiter&) = delete;
+
+            rate_limiter& operator=(const rate_limiter&) = delete;
+
+            /**
+             * @brief Try to take a token.
+             *
+             * @param now_ns Monotonic time in nanoseconds.
+             * @param suppressed Set to number of messages dropped since the
+             * last accepted one.
+             * @return true Message may be logged.
+             * @return false Message should be dropped.
+             */
+            bool try_acquire(
+                std::int64_t now_ns, std::uint32_t& suppressed) noexcept
+            {
+                std::int64_t arrival = m_arrival.load(std::memory_order_relaxed);
+
+                do
+                {
+                    if (now_ns < arrival - m_tolerance)
+                    {
+                        m_suppressed.fetch_add(1, std::memory_order_relaxed);
+                        return false;
+                    }
+                } while (!m_arrival.compare_exchange_weak(arrival,
+                    (arrival > now_ns ? arrival : now_ns) + m_interval,
+                    std::memory_order_relaxed));
+
+                suppressed = m_suppressed.exchange(0, std::memory_order_relaxed);
+                return true;
+            }
+
+            bool try_acquire(std::uint32_t& suppressed) noexcept
+            {
+                return try_acquire(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch())
+                        .count(),
+                    suppressed);
+            }
+
+        private:
+            const std::int64_t m_interval;
+            const std::int64_t m_tolerance;
+            std::atomic<std::int64_t> m_arrival;
+            std::atomic<std::uint32_t> m_suppressed;
+        };
+
+        /**
+         * @brief Let through every n-th message of a log site.
+         *
+         */
+        class sampler
+        {
+        public:
+            constexpr explicit sampler(std::uint32_t every_n) noexcept :
+                m_every_n{ every_n ? every_n : 1 },
+                m_counter{ 0 }
+            {
+            }
+
+            sampler(const sampler&) = delete;
+
+            sampler& operator=(const sampler&) = delete;
+
+            /**
+             * @brief Count a message, first one of each n is accepted.
+             *
+             * @param suppressed Set to number of messages dropped since the
+             * last accepted one.
+             * @return true Message may be logged.
+             * @return false Message should be dropped.
+             */
+            bool try_acquire(std::uint32_t& suppressed) noexcept
+            {
+                const std::uint32_t count =
+                    m_counter.fetch_add(1, std::memory_order_relaxed);
+
+                if (count % m_every_n != 0)
+                {
+                    return false;
+                }
+
+                suppressed = count == 0 ? 0 : m_every_n - 1;
+                return true;
+            }
+
+        private:
+            const std::uint32_t m_every_n;
+            std::atomic<std::uint32_t> m_counter;
+        };
+
+        inline void write_suppressed(log_level level,
+            const component& comp,
+            std::uint32_t suppressed) noexcept
+        {
+            if (suppressed != 0)
+            {
+                write(level,
+                    comp,
+                    "{} similar messages suppressed.",
+                    suppressed);
+            }
+        }
+    } // namespace impl
+
     template<typename... ArgsT>
-    inline void verbose([[maybe_unused]] std::string_view component,
+    inline void verbose([[maybe_unused]] const component& comp,
         [[maybe_unused]] std::string_view format,
         [[maybe_unused]] ArgsT... args) noexcept
     {
@@ -60,14 +968,14 @@ namespace b2h::log
             return;
         }
 
-        fmt::print(fmt::fg(VERBOSE_COLOR),
-            "VERBOSE  | {:<17} | {}\n",
-            component,
-            fmt::format(format, std::forward<ArgsT>(args)...));
+        if (level(comp) >= log_level::verbose)
+        {
+            impl::write(log_level::verbose, comp, format, args...);
+        }
     }
 
     template<typename... ArgsT>
-    inline void debug([[maybe_unused]] std::string_view component,
+    inline void debug([[maybe_unused]] const component& comp,
         [[maybe_unused]] std::string_view format,
         [[maybe_unused]] ArgsT... args) noexcept
     {
@@ -77,13 +985,14 @@ namespace b2h::log
             return;
         }
 
-        fmt::print("DEBUG    | {:<17} | {}\n",
-            component,
-            fmt::format(format, std::forward<ArgsT>(args)...));
+        if (level(comp) >= log_level::debug)
+        {
+            impl::write(log_level::debug, comp, format, args...);
+        }
     }
 
     template<typename... ArgsT>
-    inline void info([[maybe_unused]] std::string_view component,
+    inline void info([[maybe_unused]] const component& comp,
         [[maybe_unused]] std::string_view format,
         [[maybe_unused]] ArgsT... args) noexcept
     {
@@ -93,14 +1002,14 @@ namespace b2h::log
             return;
         }
 
-        fmt::print(fmt::fg(INFO_COLOR),
-            "INFO     | {:<17} | {}\n",
-            component,
-            fmt::format(format, std::forward<ArgsT>(args)...));
+        if (level(comp) >= log_level::info)
+        {
+            impl::write(log_level::info, comp, format, args...);
+        }
     }
 
     template<typename... ArgsT>
-    inline void warning([[maybe_unused]] std::string_view component,
+    inline void warning([[maybe_unused]] const component& comp,
         [[maybe_unused]] std::string_view format,
         [[maybe_unused]] ArgsT... args) noexcept
     {
@@ -110,14 +1019,14 @@ namespace b2h::log
             return;
         }
 
-        fmt::print(fmt::fg(WARNING_COLOR),
-            "WARNING  | {:<17} | {}\n",
-            component,
-            fmt::format(format, std::forward<ArgsT>(args)...));
+        if (level(comp) >= log_level::warning)
+        {
+            impl::write(log_level::warning, comp, format, args...);
+        }
     }
 
     template<typename... ArgsT>
-    inline void error([[maybe_unused]] std::string_view component,
+    inline void error([[maybe_unused]] const component& comp,
         [[maybe_unused]] std::string_view format,
         [[maybe_unused]] ArgsT... args) noexcept
     {
@@ -127,14 +1036,14 @@ namespace b2h::log
             return;
         }
 
-        fmt::print(fmt::fg(ERROR_COLOR),
-            "ERROR    | {:<17} | {}\n",
-            component,
-            fmt::format(format, std::forward<ArgsT>(args)...));
+        if (level(comp) >= log_level::error)
+        {
+            impl::write(log_level::error, comp, format, args...);
+        }
     }
 
     template<typename... ArgsT>
-    inline void critical([[maybe_unused]] std::string_view component,
+    inline void critical([[maybe_unused]] const component& comp,
         [[maybe_unused]] std::string_view format,
         [[maybe_unused]] ArgsT... args) noexcept
     {
@@ -144,11 +1053,141 @@ namespace b2h::log
             return;
         }
 
-        fmt::print(fmt::fg(CRITICAL_COLOR),
-            "CRITICAL | {:<17} | {}\n",
-            component,
-            fmt::format(format, std::forward<ArgsT>(args)...));
+        if (level(comp) >= log_level::critical)
+        {
+            impl::write(log_level::critical, comp, format, args...);
+        }
     }
 } // namespace b2h::log
 
+/**
+ * @brief Print a shortened deferred string argument followed by "...".
+ *
+ */
+template<>
+struct fmt::formatter<b2h::log::impl::text>
+    : fmt::formatter<std::string_view> {
+    template<typename FormatContext>
+    auto format(const b2h::log::impl::text& arg, FormatContext& ctx) const
+    {
+        constexpr std::string_view MARK{ "..." };
+
+        auto out = fmt::formatter<std::string_view>::format(arg.value, ctx);
+
+        if (arg.truncated)
+        {
+            out = std::copy(MARK.begin(), MARK.end(), out);
+        }
+
+        return out;
+    }
+};
+
+/**
+ * @brief Print a deferred byte container the way fmt prints ranges, e.g.
+ * "[1, 2, 3]", with ", ..." before the bracket if it was shortened.
+ *
+ */
+template<>
+struct fmt::formatter<b2h::log::impl::bytes> {
+    constexpr auto parse(fmt::format_parse_context& ctx)
+    {
+        return ctx.begin();
+    }
+
+    template<typename FormatContext>
+    auto format(const b2h::log::impl::bytes& arg, FormatContext& ctx) const
+    {
+        if (arg.truncated)
+        {
+            return fmt::format_to(ctx.out(),
+                "[{}, ...]",
+                fmt::join(arg.value, ", "));
+        }
+
+        return fmt::format_to(ctx.out(), "[{}]", fmt::join(arg.value, ", "));
+    }
+};
+
+/**
+ * @brief Log a message if enabled for the component. Unlike the logging
+ * functions, arguments are not evaluated when the message is filtered out.
+ *
+ */
+#define B2H_LOG(level, comp, ...)                                            \
+    do                                                                       \
+    {                                                                        \
+        if constexpr (::b2h::log::compiled_in(level))                        \
+        {                                                                    \
+            if (::b2h::log::enabled(level, comp))                            \
+            {                                                                \
+                ::b2h::log::impl::write(level, comp, __VA_ARGS__);           \
+            }                                                                \
+        }                                                                    \
+    } while (false)
+
+/**
+ * @brief Log a message at most per_second times a second, allowing bursts of
+ * up to burst messages. Each message logged after a drop is followed by a
+ * line with the number of suppressed messages.
+ *
+ */
+#define B2H_LOG_RATE_LIMITED(level, comp, per_second, burst, ...)            \
+    do                                                                       \
+    {                                                                        \
+        if constexpr (::b2h::log::compiled_in(level))                        \
+        {                                                                    \
+            if (::b2h::log::enabled(level, comp))                            \
+            {                                                                \
+                static ::b2h::log::impl::rate_limiter b2h_limiter_{          \
+                    per_second, burst                                        \
+                };                                                           \
+                if (std::uint32_t b2h_suppressed_ = 0;                       \
+                    b2h_limiter_.try_acquire(b2h_suppressed_))               \
+                {                                                            \
+                    ::b2h::log::impl::write(level, comp, __VA_ARGS__);       \
+                    ::b2h::log::impl::write_suppressed(                      \
+                        level, comp, b2h_suppressed_);                       \
+                }                                                            \
+            }                                                                \
+        }                                                                    \
+    } while (false)
+
+/**
+ * @brief Log first of every n messages. Each logged message is followed by a
+ * line with the number of suppressed messages.
+ *
+ */
+#define B2H_LOG_EVERY_N(level, comp, n, ...)                                 \
+    do                                                                       \
+    {                                                                        \
+        if constexpr (::b2h::log::compiled_in(level))                        \
+        {                                                                    \
+            if (::b2h::log::enabled(level, comp))                            \
+            {                                                                \
+                static ::b2h::log::impl::sampler b2h_sampler_{ n };          \
+                if (std::uint32_t b2h_suppressed_ = 0;                       \
+                    b2h_sampler_.try_acquire(b2h_suppressed_))               \
+                {                                                            \
+                    ::b2h::log::impl::write(level, comp, __VA_ARGS__);       \
+                    ::b2h::log::impl::write_suppressed(                      \
+                        level, comp, b2h_suppressed_);                       \
+                }                                                            \
+            }                                                                \
+        }                                                                    \
+    } while (false)
+
+#define B2H_LOG_VERBOSE(comp, ...) \
+    B2H_LOG(::b2h::log::log_level::verbose, comp, __VA_ARGS__)
+#define B2H_LOG_DEBUG(comp, ...) \
+    B2H_LOG(::b2h::log::log_level::debug, comp, __VA_ARGS__)
+#define B2H_LOG_INFO(comp, ...) \
+    B2H_LOG(::b2h::log::log_level::info, comp, __VA_ARGS__)
+#define B2H_LOG_WARNING(comp, ...) \
+    B2H_LOG(::b2h::log::log_level::warning, comp, __VA_ARGS__)
+#define B2H_LOG_ERROR(comp, ...) \
+    B2H_LOG(::b2h::log::log_level::error, comp, __VA_ARGS__)
+#define B2H_LOG_CRITICAL(comp, ...) \
+    B2H_LOG(::b2h::log::log_level::critical, comp, __VA_ARGS__)
+
 #endif
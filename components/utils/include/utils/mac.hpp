@@ -26,12 +26,14 @@
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <iterator>
 #include <optional>
 #include <stdexcept>
+#include <string>
+#include <string_view>
 #include <type_traits>
 
-#include "fmt/format.h"
 #include "tcb/span.hpp"
 
 namespace impl
@@ -47,6 +49,89 @@ namespace impl
 
     template<typename T>
     inline constexpr bool always_false_v = false;
+
+    inline constexpr std::uint8_t HEX_INVALID{ 0xF0 };
+
+    inline constexpr std::array<char, 16> HEX_DIGITS{ '0',
+        '1',
+        '2',
+        '3',
+        '4',
+        '5',
+        '6',
+        '7',
+        '8',
+        '9',
+        'a',
+        'b',
+        'c',
+        'd',
+        'e',
+        'f' };
+
+    inline constexpr std::array<std::uint8_t, 256> make_hex_values() noexcept
+    {
+        std::array<std::uint8_t, 256> result{};
+
+        for (auto& value : result)
+        {
+            value = HEX_INVALID;
+        }
+
+        for (std::uint8_t i = 0; i < 10; ++i)
+        {
+            result['0' + i] = i;
+        }
+
+        for (std::uint8_t i = 0; i < 6; ++i)
+        {
+            result['a' + i] = 10 + i;
+            result['A' + i] = 10 + i;
+        }
+
+        return result;
+    }
+
+    /**
+     * @brief Maps characters to nibble values, invalid characters have the
+     * HEX_INVALID bits set.
+     *
+     */
+    inline constexpr std::array<std::uint8_t, 256> HEX_VALUES =
+        make_hex_values();
+
+    /**
+     * @brief Multiply and fold the 128-bit product, mixing step of wyhash.
+     *
+     * @param lhs
+     * @param rhs
+     * @return std::uint64_t
+     */
+    inline constexpr std::uint64_t wymix(
+        std::uint64_t lhs, std::uint64_t rhs) noexcept
+    {
+#ifdef __SIZEOF_INT128__
+        const auto product = static_cast<unsigned __int128>(lhs) * rhs;
+        return static_cast<std::uint64_t>(product) ^
+               static_cast<std::uint64_t>(product >> 64);
+#else
+        const std::uint64_t lhs_hi = lhs >> 32;
+        const std::uint64_t lhs_lo = lhs & 0xFFFFFFFF;
+        const std::uint64_t rhs_hi = rhs >> 32;
+        const std::uint64_t rhs_lo = rhs & 0xFFFFFFFF;
+
+        const std::uint64_t hh = lhs_hi * rhs_hi;
+        const std::uint64_t hl = lhs_hi * rhs_lo;
+        const std::uint64_t lh = lhs_lo * rhs_hi;
+        const std::uint64_t ll = lhs_lo * rhs_lo;
+
+        const std::uint64_t mid = (ll >> 32) + (hl & 0xFFFFFFFF) + lh;
+        const std::uint64_t lo  = (mid << 32) | (ll & 0xFFFFFFFF);
+        const std::uint64_t hi  = hh + (hl >> 32) + (mid >> 32);
+
+        return lo ^ hi;
+#endif
+    }
 } // namespace impl
 
 namespace b2h::utils
@@ -56,10 +141,28 @@ namespace b2h::utils
     public:
         static constexpr std::size_t MAC_SIZE{ 6 };
         static constexpr std::size_t MAC_STR_SIZE{ 17 }; // MAC string size
+        static constexpr std::size_t MAC_ID_SIZE{ 12 };  // Without separators
 
-        using buffer_t = std::array<std::uint8_t, MAC_SIZE>;
+        using buffer_t    = std::array<std::uint8_t, MAC_SIZE>;
+        using string_t    = std::array<char, MAC_STR_SIZE>;
+        using id_string_t = std::array<char, MAC_ID_SIZE>;
+
+        constexpr mac() noexcept : m_address{}, m_string{ format(m_address) }
+        {
+        }
+
+        /**
+         * @brief Construct from bytes in NimBLE order, least significant
+         * byte first.
+         *
+         * @param address
+         */
+        constexpr explicit mac(const buffer_t& address) noexcept :
+            m_address{ address },
+            m_string{ format(address) }
+        {
+        }
 
-        mac()           = default;
         mac(const mac&) = default;
         mac(mac&&)      = default;
 
@@ -73,57 +176,216 @@ namespace b2h::utils
             static_assert(impl::is_char_iter_v<OutIt>,
                 "Iterator value type must be char.");
 
-            const auto [out, size] = fmt::format_to_n(first,
-                static_cast<std::size_t>(std::distance(first, last)),
-                "{:02x}:{:02x}:{:02x}:{:02x}:{:02x}:{:02x}",
-                m_address[5],
-                m_address[4],
-                m_address[3],
-                m_address[2],
-                m_address[1],
-                m_address[0]);
-
-            if (size == 0)
+            if (std::distance(first, last) <
+                static_cast<std::ptrdiff_t>(MAC_STR_SIZE))
             {
                 return std::nullopt;
             }
 
-            return std::string_view{ &(*first), size };
+            std::copy(m_string.begin(), m_string.end(), first);
+            return std::string_view{ &(*first), MAC_STR_SIZE };
+        }
+
+        /**
+         * @brief Get cached string form, e.g. "a4:c1:38:0d:53:a1".
+         *
+         * @return constexpr std::string_view
+         */
+        constexpr std::string_view str() const noexcept
+        {
+            return { m_string.data(), m_string.size() };
         }
 
         std::string to_string() const;
 
+        /**
+         * @brief Format without separators, e.g. "a4c1380d53a1".
+         *
+         * @return constexpr id_string_t
+         */
+        constexpr id_string_t to_id() const noexcept
+        {
+            id_string_t result{};
+
+            for (std::size_t i = 0; i < MAC_SIZE; ++i)
+            {
+                const std::uint8_t byte = m_address[MAC_SIZE - 1 - i];
+                result[2 * i]           = impl::HEX_DIGITS[byte >> 4];
+                result[2 * i + 1]       = impl::HEX_DIGITS[byte & 0x0F];
+            }
+
+            return result;
+        }
+
         tcb::span<const std::uint8_t> as_bytes() const noexcept
         {
             return tcb::make_span(m_address);
         }
 
-        friend std::optional<mac> make_mac(const std::string_view str) noexcept;
+        /**
+         * @brief Address as integer, most significant byte is the first one
+         * of the string form.
+         *
+         * @return constexpr std::uint64_t
+         */
+        constexpr std::uint64_t to_u64() const noexcept
+        {
+            std::uint64_t result = 0;
+
+            for (std::size_t i = MAC_SIZE; i-- > 0;)
+            {
+                result = (result << 8) | m_address[i];
+            }
+
+            return result;
+        }
 
-        template<typename InIt>
-        friend std::optional<mac> make_mac(InIt first, InIt last) noexcept;
+        friend constexpr bool operator==(
+            const mac& lhs, const mac& rhs) noexcept
+        {
+            return lhs.to_u64() == rhs.to_u64();
+        }
+
+        friend constexpr bool operator!=(
+            const mac& lhs, const mac& rhs) noexcept
+        {
+            return !(lhs == rhs);
+        }
+
+        friend constexpr bool operator<(const mac& lhs, const mac& rhs) noexcept
+        {
+            return lhs.to_u64() < rhs.to_u64();
+        }
 
     private:
         buffer_t m_address;
+        string_t m_string;
+
+        static constexpr string_t format(const buffer_t& address) noexcept
+        {
+            string_t result{};
+
+            for (std::size_t i = 0; i < MAC_SIZE; ++i)
+            {
+                const std::uint8_t byte = address[MAC_SIZE - 1 - i];
+                result[3 * i]           = impl::HEX_DIGITS[byte >> 4];
+                result[3 * i + 1]       = impl::HEX_DIGITS[byte & 0x0F];
+
+                if (i != MAC_SIZE - 1)
+                {
+                    result[3 * i + 2] = ':';
+                }
+            }
+
+            return result;
+        }
     };
 
-    std::optional<mac> make_mac(const std::string_view str) noexcept;
+    /**
+     * @brief Parse MAC in "xx:xx:xx:xx:xx:xx" form, "-" separators are
+     * accepted as well. Digits are decoded through a lookup table and
+     * validated once at the end.
+     *
+     * @param str
+     * @return std::optional<mac>
+     */
+    inline constexpr std::optional<mac> make_mac(
+        const std::string_view str) noexcept
+    {
+        if (str.size() != mac::MAC_STR_SIZE)
+        {
+            return std::nullopt;
+        }
+
+        const char separator = str[2];
+        mac::buffer_t address{};
+        std::uint8_t invalid = 0;
+
+        for (std::size_t i = 0; i < mac::MAC_SIZE; ++i)
+        {
+            const std::uint8_t hi =
+                impl::HEX_VALUES[static_cast<std::uint8_t>(str[3 * i])];
+            const std::uint8_t lo =
+                impl::HEX_VALUES[static_cast<std::uint8_t>(str[3 * i + 1])];
+
+            invalid |= hi | lo;
+            address[mac::MAC_SIZE - 1 - i] =
+                static_cast<std::uint8_t>((hi << 4) | (lo & 0x0F));
+
+            if (i != mac::MAC_SIZE - 1)
+            {
+                invalid |= static_cast<std::uint8_t>(
+                    (str[3 * i + 2] != separator) << 4);
+            }
+        }
+
+        if ((invalid & impl::HEX_INVALID) != 0 ||
+            (separator != ':' && separator != '-'))
+        {
+            return std::nullopt;
+        }
+
+        return mac{ address };
+    }
 
     template<typename InIt>
     std::optional<mac> make_mac(InIt first, InIt last) noexcept
     {
         static_assert(impl::is_byte_iter_v<InIt>,
             "Required iterator with value_type std::uint8_t.");
-        mac result;
+        mac::buffer_t address;
 
         if (std::distance(first, last) != mac::MAC_SIZE)
         {
             return std::nullopt;
         }
 
-        std::copy(first, last, result.m_address.begin());
-        return result;
+        std::copy(first, last, address.begin());
+        return mac{ address };
     }
+
+    namespace literals
+    {
+        /**
+         * @brief MAC literal, e.g. "a4:c1:38:0d:53:a1"_mac. Invalid literal
+         * fails compilation when used in constant expression.
+         *
+         * @param str
+         * @param size
+         * @return constexpr mac
+         */
+        inline constexpr mac operator""_mac(const char* str, std::size_t size)
+        {
+            const auto result = make_mac(std::string_view{ str, size });
+
+            if (!result)
+            {
+                throw std::invalid_argument{ "Invalid MAC literal." };
+            }
+
+            return *result;
+        }
+    } // namespace literals
 } // namespace b2h::utils
 
+namespace std
+{
+    /**
+     * @brief wyhash style hash of the 48-bit address.
+     *
+     */
+    template<>
+    struct hash<b2h::utils::mac> {
+        constexpr std::size_t operator()(
+            const b2h::utils::mac& address) const noexcept
+        {
+            constexpr std::uint64_t SECRET_0 = 0xa0761d6478bd642full;
+            constexpr std::uint64_t SECRET_1 = 0xe7037ed1a0b428dbull;
+
+            return static_cast<std::size_t>(
+                impl::wymix(address.to_u64() ^ SECRET_0, SECRET_1));
+        }
+    };
+} // namespace std
+
 #endif
@@ -0,0 +1,226 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef B2H_UTILS_MAC_MAP_HPP
+#define B2H_UTILS_MAC_MAP_HPP
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <utility>
+
+#include "utils/mac.hpp"
+
+namespace b2h::utils
+{
+    /**
+     * @brief Fixed capacity open addressing map keyed by MAC address. Uses
+     * linear probing and backward shift deletion, never allocates.
+     *
+     * @tparam T Mapped type
+     * @tparam Capacity Number of slots, must be a power of 2.
+     */
+    template<typename T, std::size_t Capacity>
+    class mac_map
+    {
+        static_assert(Capacity != 0 && (Capacity & (Capacity - 1)) == 0,
+            "Capacity must be a power of 2.");
+
+    public:
+        using key_type    = mac;
+        using mapped_type = T;
+        using size_type   = std::size_t;
+
+        mac_map() noexcept : m_slots{}, m_size{ 0 }
+        {
+        }
+
+        size_type size() const noexcept
+        {
+            return m_size;
+        }
+
+        bool empty() const noexcept
+        {
+            return m_size == 0;
+        }
+
+        static constexpr size_type capacity() noexcept
+        {
+            return Capacity;
+        }
+
+        /**
+         * @brief Find value mapped to the key.
+         *
+         * @param key
+         * @return T* nullptr if not found.
+         */
+        T* find(const mac& key) noexcept
+        {
+            const auto index = find_index(key);
+            return index ? &m_slots[*index]->second : nullptr;
+        }
+
+        const T* find(const mac& key) const noexcept
+        {
+            const auto index = find_index(key);
+            return index ? &m_slots[*index]->second : nullptr;
+        }
+
+        bool contains(const mac& key) const noexcept
+        {
+            return find_index(key).has_value();
+        }
+
+        /**
+         * @brief Insert value or assign to existing one.
+         *
+         * @param key
+         * @param value
+         * @return T* nullptr if the map is full.
+         */
+        template<typename... ArgsT>
+        T* insert_or_assign(const mac& key, ArgsT&&... args)
+        {
+            for (size_type i = 0, index = home(key); i < Capacity;
+                 ++i, index = next(index))
+            {
+                auto& slot = m_slots[index];
+
+                if (!slot)
+                {
+                    slot.emplace(std::piecewise_construct,
+                        std::forward_as_tuple(key),
+                        std::forward_as_tuple(std::forward<ArgsT>(args)...));
+                    ++m_size;
+                    return &slot->second;
+                }
+
+                if (slot->first == key)
+                {
+                    slot->second = T(std::forward<ArgsT>(args)...);
+                    return &slot->second;
+                }
+            }
+
+            return nullptr;
+        }
+
+        /**
+         * @brief Remove key from the map.
+         *
+         * @param key
+         * @return true Key was present.
+         * @return false
+         */
+        bool erase(const mac& key) noexcept
+        {
+            const auto found = find_index(key);
+
+            if (!found)
+            {
+                return false;
+            }
+
+            // Shift following entries of the probe sequence back, so that
+            // lookups never need tombstones.
+            size_type hole = *found;
+            m_slots[hole].reset();
+
+            for (size_type index = next(hole); m_slots[index];
+                 index           = next(index))
+            {
+                const size_type ideal = home(m_slots[index]->first);
+
+                if (((index - ideal) & (Capacity - 1)) >=
+                    ((index - hole) & (Capacity - 1)))
+                {
+                    m_slots[hole] = std::move(m_slots[index]);
+                    m_slots[index].reset();
+                    hole = index;
+                }
+            }
+
+            --m_size;
+            return true;
+        }
+
+        void clear() noexcept
+        {
+            for (auto& slot : m_slots)
+            {
+                slot.reset();
+            }
+
+            m_size = 0;
+        }
+
+        template<typename FuncT>
+        void for_each(FuncT&& func)
+        {
+            for (auto& slot : m_slots)
+            {
+                if (slot)
+                {
+                    func(std::as_const(slot->first), slot->second);
+                }
+            }
+        }
+
+    private:
+        std::array<std::optional<std::pair<mac, T>>, Capacity> m_slots;
+        size_type m_size;
+
+        static size_type home(const mac& key) noexcept
+        {
+            return std::hash<mac>{}(key) & (Capacity - 1);
+        }
+
+        static constexpr size_type next(size_type index) noexcept
+        {
+            return (index + 1) & (Capacity - 1);
+        }
+
+        std::optional<size_type> find_index(const mac& key) const noexcept
+        {
+            for (size_type i = 0, index = home(key); i < Capacity;
+                 ++i, index = next(index))
+            {
+                const auto& slot = m_slots[index];
+
+                if (!slot)
+                {
+                    return std::nullopt;
+                }
+
+                if (slot->first == key)
+                {
+                    return index;
+                }
+            }
+
+            return std::nullopt;
+        }
+    };
+} // namespace b2h::utils
+
+#endif
@@ -20,6 +20,11 @@
 
 #include "utils/json.hpp"
 
+#include <iterator>
+
+#include <fmt/format.h>
+
+#include "rapidjson/error/en.h"
 #include "rapidjson/istreamwrapper.h"
 #include "rapidjson/stringbuffer.h"
 #include "rapidjson/writer.h"
@@ -58,4 +63,235 @@ namespace b2h::utils::json
 
         return file;
     }
+
+    bind_error::bind_error(std::string_view message, std::size_t offset) :
+        std::runtime_error{ std::string{ message } },
+        m_offset{ offset }
+    {
+    }
+
+    std::size_t bind_error::offset() const noexcept
+    {
+        return m_offset;
+    }
+
+    namespace impl
+    {
+        pull_reader::pull_reader(
+            std::string_view input, std::string_view source) :
+            m_stream{ input.data(), input.size() },
+            m_reader{},
+            m_source{ source },
+            m_token{ token::end },
+            m_bool{ false },
+            m_integer{ 0 },
+            m_floating{ 0.0 },
+            m_string{},
+            m_path{},
+            m_path_marks{}
+        {
+            m_reader.IterativeParseInit();
+        }
+
+        token pull_reader::next()
+        {
+            m_token = token::end;
+
+            if (m_reader.IterativeParseComplete())
+            {
+                return m_token;
+            }
+
+            if (!m_reader.IterativeParseNext<rapidjson::kParseDefaultFlags>(
+                    m_stream, *this))
+            {
+                const std::size_t error_offset = m_reader.GetErrorOffset();
+
+                throw bind_error{
+                    fmt::format("{}: {} (offset {}).",
+                        m_source,
+                        rapidjson::GetParseError_En(m_reader.GetParseErrorCode()),
+                        error_offset),
+                    error_offset
+                };
+            }
+
+            return m_token;
+        }
+
+        void pull_reader::skip()
+        {
+            if (m_token != token::object_begin && m_token != token::array_begin)
+            {
+                return;
+            }
+
+            std::size_t depth = 1;
+
+            while (depth != 0)
+            {
+                switch (next())
+                {
+                case token::object_begin:
+                case token::array_begin:
+                    ++depth;
+                    break;
+                case token::object_end:
+                case token::array_end:
+                    --depth;
+                    break;
+                default:
+                    break;
+                }
+            }
+        }
+
+        void pull_reader::push_path(std::string_view key)
+        {
+            m_path_marks.push_back(m_path.size());
+
+            if (!m_path.empty())
+            {
+                m_path += '.';
+            }
+
+            m_path += key;
+        }
+
+        void pull_reader::push_path(std::size_t index)
+        {
+            m_path_marks.push_back(m_path.size());
+            fmt::format_to(std::back_inserter(m_path), "[{}]", index);
+        }
+
+        void pull_reader::pop_path() noexcept
+        {
+            m_path.resize(m_path_marks.back());
+            m_path_marks.pop_back();
+        }
+
+        void pull_reader::fail_type(std::string_view expected) const
+        {
+            throw bind_error{ fmt::format("{}: {}: expected {} (offset {}).",
+                                  m_source,
+                                  m_path.empty() ? "<root>" : m_path,
+                                  expected,
+                                  offset()),
+                offset() };
+        }
+
+        void pull_reader::fail_missing(std::string_view key) const
+        {
+            throw bind_error{
+                fmt::format("{}: {}: missing required field \"{}\" (offset {}).",
+                    m_source,
+                    m_path.empty() ? "<root>" : m_path,
+                    key,
+                    offset()),
+                offset()
+            };
+        }
+
+        std::size_t pull_reader::offset() const noexcept
+        {
+            return m_stream.Tell();
+        }
+
+        bool pull_reader::Null()
+        {
+            m_token = token::null;
+            return true;
+        }
+
+        bool pull_reader::Bool(bool value)
+        {
+            m_token = token::boolean;
+            m_bool  = value;
+            return true;
+        }
+
+        bool pull_reader::Int(int value)
+        {
+            return Int64(value);
+        }
+
+        bool pull_reader::Uint(unsigned value)
+        {
+            return Int64(value);
+        }
+
+        bool pull_reader::Int64(std::int64_t value)
+        {
+            m_token   = token::integer;
+            m_integer = value;
+            return true;
+        }
+
+        bool pull_reader::Uint64(std::uint64_t value)
+        {
+            if (value >
+                static_cast<std::uint64_t>(
+                    std::numeric_limits<std::int64_t>::max()))
+            {
+                return Double(static_cast<double>(value));
+            }
+
+            return Int64(static_cast<std::int64_t>(value));
+        }
+
+        bool pull_reader::Double(double value)
+        {
+            m_token    = token::floating;
+            m_floating = value;
+            return true;
+        }
+
+        bool pull_reader::RawNumber(
+            const char* str, rapidjson::SizeType length, bool)
+        {
+            // Not produced with the default parse flags.
+            m_token = token::string;
+            m_string.assign(str, length);
+            return true;
+        }
+
+        bool pull_reader::String(
+            const char* str, rapidjson::SizeType length, bool)
+        {
+            m_token = token::string;
+            m_string.assign(str, length);
+            return true;
+        }
+
+        bool pull_reader::StartObject()
+        {
+            m_token = token::object_begin;
+            return true;
+        }
+
+        bool pull_reader::Key(const char* str, rapidjson::SizeType length, bool)
+        {
+            m_token = token::key;
+            m_string.assign(str, length);
+            return true;
+        }
+
+        bool pull_reader::EndObject(rapidjson::SizeType)
+        {
+            m_token = token::object_end;
+            return true;
+        }
+
+        bool pull_reader::StartArray()
+        {
+            m_token = token::array_begin;
+            return true;
+        }
+
+        bool pull_reader::EndArray(rapidjson::SizeType)
+        {
+            m_token = token::array_end;
+            return true;
+        }
+    } // namespace impl
 } // namespace b2h::utils::json
\ No newline at end of file
@@ -0,0 +1,136 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "utils/logger.hpp"
+
+namespace b2h::log
+{
+    namespace impl
+    {
+        void print_line(log_level level,
+            std::string_view component,
+            std::string_view message) noexcept
+        {
+            switch (level)
+            {
+            case log_level::verbose:
+                fmt::print(fmt::fg(VERBOSE_COLOR),
+                    "VERBOSE  | {:<17} | {}\n",
+                    component,
+                    message);
+                break;
+            case log_level::debug:
+                fmt::print("DEBUG    | {:<17} | {}\n", component, message);
+                break;
+            case log_level::info:
+                fmt::print(fmt::fg(INFO_COLOR),
+                    "INFO     | {:<17} | {}\n",
+                    component,
+                    message);
+                break;
+            case log_level::warning:
+                fmt::print(fmt::fg(WARNING_COLOR),
+                    "WARNING  | {:<17} | {}\n",
+                    component,
+                    message);
+                break;
+            case log_level::error:
+                fmt::print(fmt::fg(ERROR_COLOR),
+                    "ERROR    | {:<17} | {}\n",
+                    component,
+                    message);
+                break;
+            case log_level::critical:
+                fmt::print(fmt::fg(CRITICAL_COLOR),
+                    "CRITICAL | {:<17} | {}\n",
+                    component,
+                    message);
+                break;
+            default:
+                break;
+            }
+        }
+
+#ifdef B2H_LOG_DEFERRED
+        record_queue& deferred_queue() noexcept
+        {
+            static record_queue queue{};
+            return queue;
+        }
+#endif
+    } // namespace impl
+
+    std::optional<log_level> parse_level(std::string_view name) noexcept
+    {
+        constexpr std::array<std::string_view, 7> LEVEL_NAMES{
+            "none",
+            "critical",
+            "error",
+            "warning",
+            "info",
+            "debug",
+            "verbose",
+        };
+
+        for (std::size_t i = 0; i < LEVEL_NAMES.size(); ++i)
+        {
+            if (LEVEL_NAMES[i] == name)
+            {
+                return static_cast<log_level>(i);
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    std::size_t drain() noexcept
+    {
+#ifdef B2H_LOG_DEFERRED
+        constexpr std::string_view COMPONENT{ "logger" };
+
+        auto& queue         = impl::deferred_queue();
+        std::size_t printed = 0;
+        fmt::memory_buffer message;
+
+        while (queue.pop([&](const impl::record_header& header,
+                             const std::uint8_t* payload) {
+            message.clear();
+            header.decoder(payload, header.format, message);
+            impl::print_line(header.level,
+                header.component,
+                std::string_view{ message.data(), message.size() });
+        }))
+        {
+            ++printed;
+        }
+
+        if (const std::size_t dropped = queue.take_dropped(); dropped != 0)
+        {
+            impl::print_line(log_level::warning,
+                COMPONENT,
+                fmt::format("{} log records dropped.", dropped));
+        }
+
+        return printed;
+#else
+        return 0;
+#endif
+    }
+} // namespace b2h::log
@@ -20,8 +20,48 @@
 
 #include "utils/json.hpp"
 #include "catch2/catch.hpp"
+#include <cstdint>
+#include <optional>
 #include <string>
 #include <string_view>
+#include <vector>
+
+namespace
+{
+    struct bind_device {
+        std::string mac;
+        std::string name;
+        std::uint16_t interval{ 60 };
+
+        static constexpr auto json_fields()
+        {
+            using namespace b2h::utils::json;
+
+            return fields(field("mac", &bind_device::mac),
+                field("name", &bind_device::name),
+                optional_field("interval", &bind_device::interval));
+        }
+    };
+
+    struct bind_config {
+        std::string ssid;
+        std::optional<std::string> password;
+        bool enabled{ false };
+        double ratio{ 0.0 };
+        std::vector<bind_device> devices;
+
+        static constexpr auto json_fields()
+        {
+            using namespace b2h::utils::json;
+
+            return fields(field("ssid", &bind_config::ssid),
+                optional_field("password", &bind_config::password),
+                optional_field("enabled", &bind_config::enabled),
+                optional_field("ratio", &bind_config::ratio),
+                field("devices", &bind_config::devices));
+        }
+    };
+} // namespace
 
 TEST_CASE("Parse and dump.", "[json]")
 {
@@ -93,3 +133,77 @@ TEST_CASE("Check if key exists on non-existing key.", "[json]")
 
     REQUIRE(!has_key(json::parse(input)));
 }
+
+TEST_CASE("Bind described structure.", "[json]")
+{
+    using namespace b2h::utils;
+
+    constexpr std::string_view input{
+        "{\"ssid\":\"home\",\"enabled\":true,\"ratio\":0.5,\"unknown\":"
+        "{\"nested\":[1,{\"a\":2}]},\"devices\":[{\"mac\":\"a4:c1:38:00:00:01\","
+        "\"name\":\"kitchen\"},{\"name\":\"bedroom\",\"mac\":"
+        "\"a4:c1:38:00:00:02\",\"interval\":30}]}"
+    };
+
+    const auto config = json::bind<bind_config>(input);
+
+    REQUIRE(config.ssid == "home");
+    REQUIRE(!config.password.has_value());
+    REQUIRE(config.enabled);
+    REQUIRE(config.ratio == 0.5);
+    REQUIRE(config.devices.size() == 2);
+    REQUIRE(config.devices[0].mac == "a4:c1:38:00:00:01");
+    REQUIRE(config.devices[0].name == "kitchen");
+    REQUIRE(config.devices[0].interval == 60);
+    REQUIRE(config.devices[1].mac == "a4:c1:38:00:00:02");
+    REQUIRE(config.devices[1].name == "bedroom");
+    REQUIRE(config.devices[1].interval == 30);
+}
+
+TEST_CASE("Bind reports path of missing field.", "[json]")
+{
+    using namespace b2h::utils;
+
+    constexpr std::string_view input{
+        "{\"ssid\":\"home\",\"devices\":[{\"mac\":\"a\",\"name\":\"b\"},"
+        "{\"name\":\"c\"}]}"
+    };
+
+    REQUIRE_THROWS_WITH(json::bind<bind_config>(input, "config.json"),
+        Catch::Contains("config.json: devices[1]: missing required field "
+                        "\"mac\""));
+}
+
+TEST_CASE("Bind reports path of mistyped field.", "[json]")
+{
+    using namespace b2h::utils;
+
+    constexpr std::string_view input{
+        "{\"ssid\":\"home\",\"devices\":[{\"mac\":\"a\",\"name\":\"b\","
+        "\"interval\":\"60\"}]}"
+    };
+
+    REQUIRE_THROWS_WITH(json::bind<bind_config>(input),
+        Catch::Contains("devices[0].interval: expected an integer"));
+}
+
+TEST_CASE("Bind rejects out of range integer.", "[json]")
+{
+    using namespace b2h::utils;
+
+    constexpr std::string_view input{
+        "{\"ssid\":\"home\",\"devices\":[{\"mac\":\"a\",\"name\":\"b\","
+        "\"interval\":70000}]}"
+    };
+
+    REQUIRE_THROWS_AS(json::bind<bind_config>(input), json::bind_error);
+}
+
+TEST_CASE("Bind rejects malformed JSON.", "[json]")
+{
+    using namespace b2h::utils;
+
+    constexpr std::string_view input{ "{\"ssid\":\"home\",\"devices\":[" };
+
+    REQUIRE_THROWS_AS(json::bind<bind_config>(input), json::bind_error);
+}
@@ -0,0 +1,286 @@
+// Copyright 2022 Borys Chyliński
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "utils/logger.hpp"
+#include "catch2/catch.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "fmt/ranges.h"
+
+namespace
+{
+    using test_queue = b2h::log::impl::basic_record_queue<4, 32>;
+
+    std::string pop_message(test_queue& queue)
+    {
+        std::string result;
+
+        queue.pop([&](const b2h::log::impl::record_header& header,
+                      const std::uint8_t* payload) {
+            fmt::memory_buffer message;
+            header.decoder(payload, header.format, message);
+            result.assign(message.data(), message.size());
+        });
+
+        return result;
+    }
+} // namespace
+
+TEST_CASE("Deferred record is formatted on pop.", "[logger]")
+{
+    using namespace b2h::log;
+
+    test_queue queue;
+    std::string transient{ "kettle" };
+
+    REQUIRE(queue.push(log_level::debug,
+        "test",
+        "{} {} {:.1f} {}",
+        std::uint16_t{ 42 },
+        transient.c_str(),
+        21.5,
+        true));
+
+    // Strings are copied into the record, source may go away.
+    transient.assign("xxxxxx");
+
+    REQUIRE(pop_message(queue) == "42 kettle 21.5 true");
+    REQUIRE(!queue.pop([](const auto&, const auto*) {}));
+}
+
+TEST_CASE("Deferred byte container is formatted on pop.", "[logger]")
+{
+    using namespace b2h::log;
+
+    test_queue queue;
+    std::vector<std::uint8_t> data{ 0x01, 0x20, 0xff };
+
+    REQUIRE(queue.push(log_level::verbose, "test", "Got data: {}.", data));
+
+    // Bytes are copied into the record, source may go away.
+    const std::string expected = fmt::format("Got data: {}.", data);
+    data.assign(3, 0);
+
+    REQUIRE(pop_message(queue) == expected);
+
+    // 2 bytes of size leave 30 bytes of data in a 32 byte slot.
+    data.assign(40, 7);
+    REQUIRE(queue.push(log_level::verbose, "test", "{}", data));
+    REQUIRE(pop_message(queue) ==
+            fmt::format("[{}, ...]", fmt::join(data.cbegin(),
+                                         data.cbegin() + 30,
+                                         ", ")));
+}
+
+TEST_CASE("Deferred records keep FIFO order.", "[logger]")
+{
+    using namespace b2h::log;
+
+    test_queue queue;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        REQUIRE(queue.push(log_level::info, "test", "{}", i));
+    }
+
+    REQUIRE(pop_message(queue) == "0");
+    REQUIRE(pop_message(queue) == "1");
+    REQUIRE(pop_message(queue) == "2");
+}
+
+TEST_CASE("Deferred records are dropped when queue is full.", "[logger]")
+{
+    using namespace b2h::log;
+
+    test_queue queue;
+
+    for (int i = 0; i < 4; ++i)
+    {
+        REQUIRE(queue.push(log_level::info, "test", "{}", i));
+    }
+
+    REQUIRE(!queue.push(log_level::info, "test", "{}", 4));
+    REQUIRE(pop_message(queue) == "0");
+    REQUIRE(queue.push(log_level::info, "test", "{}", 5));
+    REQUIRE(queue.take_dropped() == 1);
+    REQUIRE(queue.take_dropped() == 0);
+}
+
+TEST_CASE("Oversized deferred string is truncated.", "[logger]")
+{
+    using namespace b2h::log;
+
+    test_queue queue;
+    const std::string topic(8, 't');
+    const std::string data(64, 'x');
+
+    // 2 + 8 bytes for the topic leave 20 of data in a 32 byte slot.
+    REQUIRE(queue.push(log_level::info, "test", "{}: {}", topic, data));
+    REQUIRE(pop_message(queue) ==
+            topic + ": " + std::string(20, 'x') + "...");
+    REQUIRE(queue.take_dropped() == 0);
+}
+
+TEST_CASE("Oversized deferred record is dropped.", "[logger]")
+{
+    using namespace b2h::log;
+
+    test_queue queue;
+    const std::string label(24, 'x');
+
+    // The numbers alone take 40 bytes, no string can make room.
+    REQUIRE(!queue.push(log_level::info,
+        "test",
+        "{} {} {} {} {} {}",
+        std::uint64_t{ 1 },
+        std::uint64_t{ 2 },
+        std::uint64_t{ 3 },
+        std::uint64_t{ 4 },
+        std::uint64_t{ 5 },
+        label));
+    REQUIRE(queue.take_dropped() == 1);
+}
+
+TEST_CASE("Component id is computed at compile time.", "[logger]")
+{
+    using namespace b2h::log;
+
+    static constexpr component first{ "first" };
+    static constexpr component second{ "second" };
+
+    STATIC_REQUIRE(first.id() != 0);
+    STATIC_REQUIRE(first.id() != second.id());
+    STATIC_REQUIRE(first.id() == component::make_id("first"));
+    STATIC_REQUIRE(first.name() == "first");
+}
+
+TEST_CASE("Runtime level overrides fall back to default.", "[logger]")
+{
+    using namespace b2h::log;
+
+    impl::level_table table;
+    constexpr auto kettle = component::make_id("xiaomi::mikettle");
+    constexpr auto sensor = component::make_id("xiaomi::lywsd03mmc");
+
+    table.set_default(log_level::warning);
+    REQUIRE(table.get(kettle) == log_level::warning);
+
+    REQUIRE(table.set(kettle, log_level::verbose));
+    REQUIRE(table.get(kettle) == log_level::verbose);
+    REQUIRE(table.get(sensor) == log_level::warning);
+
+    table.set_default(log_level::error);
+    REQUIRE(table.get(sensor) == log_level::error);
+
+    REQUIRE(table.set(kettle, std::nullopt));
+    REQUIRE(table.get(kettle) == log_level::error);
+}
+
+TEST_CASE("Runtime level table rejects overrides when full.", "[logger]")
+{
+    using namespace b2h::log;
+
+    impl::level_table table;
+
+    for (std::uint32_t id = 1; id <= impl::level_table::CAPACITY; ++id)
+    {
+        REQUIRE(table.set(id, log_level::debug));
+    }
+
+    REQUIRE(!table.set(impl::level_table::CAPACITY + 1, log_level::debug));
+    REQUIRE(table.set(1, log_level::info));
+    REQUIRE(table.get(1) == log_level::info);
+}
+
+TEST_CASE("Parse log level names.", "[logger]")
+{
+    using namespace b2h::log;
+
+    REQUIRE(parse_level("debug") == log_level::debug);
+    REQUIRE(parse_level("none") == log_level::none);
+    REQUIRE(!parse_level("loud").has_value());
+}
+
+TEST_CASE("Filtered log macro does not evaluate arguments.", "[logger]")
+{
+    using namespace b2h::log;
+
+    static constexpr component test_component{ "test" };
+
+    int evaluated = 0;
+    const auto argument = [&evaluated]() { return ++evaluated; };
+
+    set_level(test_component, log_level::none);
+    B2H_LOG_CRITICAL(test_component, "{}", argument());
+    B2H_LOG_VERBOSE(test_component, "{}", argument());
+    reset_level(test_component);
+
+    REQUIRE(evaluated == 0);
+}
+
+TEST_CASE("Rate limiter allows burst and refills.", "[logger]")
+{
+    using namespace b2h::log;
+
+    constexpr std::int64_t SECOND = 1'000'000'000;
+
+    impl::rate_limiter limiter{ 2, 3 };
+    std::uint32_t suppressed = 0;
+    std::int64_t now         = 10 * SECOND;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        REQUIRE(limiter.try_acquire(now, suppressed));
+        REQUIRE(suppressed == 0);
+    }
+
+    REQUIRE(!limiter.try_acquire(now, suppressed));
+    REQUIRE(!limiter.try_acquire(now, suppressed));
+
+    now += SECOND / 2;
+    REQUIRE(limiter.try_acquire(now, suppressed));
+    REQUIRE(suppressed == 2);
+    REQUIRE(!limiter.try_acquire(now, suppressed));
+
+    now += 10 * SECOND;
+    for (int i = 0; i < 3; ++i)
+    {
+        REQUIRE(limiter.try_acquire(now, suppressed));
+    }
+    REQUIRE(!limiter.try_acquire(now, suppressed));
+}
+
+TEST_CASE("Sampler accepts every n-th message.", "[logger]")
+{
+    using namespace b2h::log;
+
+    impl::sampler sampler{ 3 };
+    std::uint32_t suppressed = 0;
+
+    REQUIRE(sampler.try_acquire(suppressed));
+    REQUIRE(suppressed == 0);
+    REQUIRE(!sampler.try_acquire(suppressed));
+    REQUIRE(!sampler.try_acquire(suppressed));
+    REQUIRE(sampler.try_acquire(suppressed));
+    REQUIRE(suppressed == 2);
+}
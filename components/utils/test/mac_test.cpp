@@ -19,13 +19,16 @@
 // SOFTWARE.
 
 #include "utils/mac.hpp"
+#include "utils/mac_map.hpp"
 #include "catch2/catch.hpp"
 #include "tcb/span.hpp"
 #include <array>
 #include <cstdint>
+#include <functional>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <unordered_set>
 #include <vector>
 
 TEST_CASE("Create from std::string.", "[mac]")
@@ -33,7 +36,7 @@ TEST_CASE("Create from std::string.", "[mac]")
     using namespace b2h;
 
     std::string s{ "ab:0d:53:a1:ff:65" };
-    utils::mac m = utils::make_mac(s);
+    utils::mac m = utils::make_mac(s).value();
 
     REQUIRE(m.to_string() == s);
 }
@@ -54,9 +57,114 @@ TEST_CASE("Dump as char buffer.", "[mac]")
 
     std::string_view s{ "ab:0d:53:a1:ff:65" };
     std::array<char, utils::mac::MAC_STR_SIZE> buff;
-    utils::mac m = utils::make_mac(s);
+    utils::mac m = utils::make_mac(s).value();
 
     m.to_charbuf(buff.begin(), buff.end());
 
     REQUIRE(std::string_view(buff.data(), buff.size()) == s);
 }
+
+TEST_CASE("Parse upper case digits and dash separators.", "[mac]")
+{
+    using namespace b2h;
+
+    REQUIRE(utils::make_mac("AB-0D-53-A1-FF-65").value().str() ==
+            "ab:0d:53:a1:ff:65");
+}
+
+TEST_CASE("Reject malformed MAC strings.", "[mac]")
+{
+    using namespace b2h;
+
+    REQUIRE(!utils::make_mac("ab:0d:53:a1:ff:6").has_value());
+    REQUIRE(!utils::make_mac("ab:0d:53:a1:ff:655").has_value());
+    REQUIRE(!utils::make_mac("ab:0d:53:a1:fg:65").has_value());
+    REQUIRE(!utils::make_mac("ab:0d:53-a1:ff:65").has_value());
+    REQUIRE(!utils::make_mac("ab.0d.53.a1.ff.65").has_value());
+    REQUIRE(!utils::make_mac("ab:0d:53:a1:ff: 5").has_value());
+}
+
+TEST_CASE("Parse and format at compile time.", "[mac]")
+{
+    using namespace b2h::utils::literals;
+
+    static constexpr auto m = "a4:c1:38:0d:53:a1"_mac;
+
+    STATIC_REQUIRE(m.str() == "a4:c1:38:0d:53:a1");
+    STATIC_REQUIRE(m.to_u64() == 0xa4c1380d53a1);
+    STATIC_REQUIRE(
+        std::string_view{ m.to_id().data(), m.to_id().size() } ==
+        "a4c1380d53a1");
+    STATIC_REQUIRE(m == "A4:C1:38:0D:53:A1"_mac);
+    STATIC_REQUIRE(m != "a4:c1:38:0d:53:a2"_mac);
+}
+
+TEST_CASE("Invalid MAC literal throws at runtime.", "[mac]")
+{
+    using namespace b2h::utils::literals;
+
+    REQUIRE_THROWS_AS("a4:c1:38:0d:53"_mac, std::invalid_argument);
+}
+
+TEST_CASE("Hash distinguishes addresses.", "[mac]")
+{
+    using namespace b2h;
+
+    std::unordered_set<std::size_t> hashes;
+    std::array<std::uint8_t, utils::mac::MAC_SIZE> bytes{};
+
+    for (std::uint16_t i = 0; i < 1024; ++i)
+    {
+        bytes[0] = static_cast<std::uint8_t>(i);
+        bytes[1] = static_cast<std::uint8_t>(i >> 8);
+        hashes.insert(std::hash<utils::mac>{}(utils::mac{ bytes }));
+    }
+
+    REQUIRE(hashes.size() == 1024);
+}
+
+TEST_CASE("Insert, find and erase in MAC map.", "[mac]")
+{
+    using namespace b2h;
+
+    utils::mac_map<int, 8> map;
+    std::array<std::uint8_t, utils::mac::MAC_SIZE> bytes{};
+
+    for (std::uint8_t i = 0; i < 8; ++i)
+    {
+        bytes[0] = i;
+        REQUIRE(map.insert_or_assign(utils::mac{ bytes }, i) != nullptr);
+    }
+
+    bytes[0] = 8;
+    REQUIRE(map.insert_or_assign(utils::mac{ bytes }, 8) == nullptr);
+    REQUIRE(map.size() == 8);
+
+    for (std::uint8_t i = 0; i < 8; i += 2)
+    {
+        bytes[0] = i;
+        REQUIRE(map.erase(utils::mac{ bytes }));
+    }
+
+    REQUIRE(map.size() == 4);
+
+    for (std::uint8_t i = 0; i < 8; ++i)
+    {
+        bytes[0]        = i;
+        const int* item = map.find(utils::mac{ bytes });
+
+        if (i % 2 == 0)
+        {
+            REQUIRE(item == nullptr);
+        }
+        else
+        {
+            REQUIRE(item != nullptr);
+            REQUIRE(*item == i);
+        }
+    }
+
+    bytes[0] = 1;
+    REQUIRE(*map.insert_or_assign(utils::mac{ bytes }, 10) == 10);
+    REQUIRE(map.size() == 4);
+}
@@ -26,6 +26,7 @@ enum esp_err_t : int
     ESP_FAIL             = -1,
     ESP_OK               = 0,
     ESP_ERR_INVALID_SIZE = 1,
+    ESP_ERR_NO_MEM       = 0x101,
 };
 
 inline const char* esp_err_to_name(esp_err_t err) noexcept
@@ -36,6 +37,8 @@ inline const char* esp_err_to_name(esp_err_t err) noexcept
         return "ESP_FAIL";
     case ESP_OK:
         return "ESP_OK";
+    case ESP_ERR_NO_MEM:
+        return "ESP_ERR_NO_MEM";
     default:
         return "OTHER";
     }
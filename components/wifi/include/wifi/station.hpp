@@ -176,7 +176,7 @@ namespace b2h
             }
 
         private:
-            static constexpr std::string_view COMPONENT{ "wifi::station" };
+            static constexpr log::component COMPONENT{ "wifi::station" };
 
             friend void impl::event_handler(void* arg,
                 esp_event_base_t event_base, int32_t event_id,
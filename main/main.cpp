@@ -23,14 +23,25 @@
 #include "ble/gatt/client.hpp"
 #include "device/base.hpp"
 #include "device/builder.hpp"
+#include "device/discovery.hpp"
+#include "device/options.hpp"
 #include "event/event.hpp"
+#include "hass/discovery_cache.hpp"
 #include "mqtt/client.hpp"
+#include "mqtt/partition_storage.hpp"
+#include "mqtt/session.hpp"
+#include "mqtt/spool.hpp"
 #include "utils/esp_exception.hpp"
 #include "utils/json.hpp"
 #include "utils/logger.hpp"
+#include "utils/mac_map.hpp"
 #include "wifi/station.hpp"
+#include "xiaomi/custom_advertisement.hpp"
+#include "xiaomi/mibeacon.hpp"
 
 #include "esp_event.h"
+#include "esp_partition.h"
+#include "esp_pthread.h"
 #include "esp_spiffs.h"
 #include "nvs_flash.h"
 
@@ -51,6 +62,11 @@ namespace b2h
             m_config{ load_config() },
             m_context{},
             m_station{ m_context },
+            m_spool_storage{ ::esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                ESP_PARTITION_SUBTYPE_ANY,
+                SPOOL_PARTITION_LABEL) },
+            m_spool{ m_spool_storage },
+            m_mqtt_session{ m_context },
             m_exit{ false },
             m_connection_task{}
         {
@@ -66,6 +82,7 @@ namespace b2h
 
         void run()
         {
+            apply_log_levels();
             async_init();
             m_connection_task = std::thread([this]() { connection_task(); });
             m_context.run();
@@ -75,6 +92,36 @@ namespace b2h
         struct device_config {
             std::string mac;
             std::string name;
+            device::options options;
+            std::string mode; // "connect" (default) or "advertisement".
+
+            bool advertised() const noexcept
+            {
+                return mode == "advertisement";
+            }
+
+            static constexpr auto json_fields()
+            {
+                using namespace utils::json;
+
+                return fields(field("mac", &device_config::mac),
+                    field("name", &device_config::name),
+                    optional_field("options", &device_config::options),
+                    optional_field("mode", &device_config::mode));
+            }
+        };
+
+        struct log_level_config {
+            std::string component;
+            std::string level;
+
+            static constexpr auto json_fields()
+            {
+                using namespace utils::json;
+
+                return fields(field("component", &log_level_config::component),
+                    field("level", &log_level_config::level));
+            }
         };
 
         struct app_config {
@@ -84,19 +131,56 @@ namespace b2h
             std::string mqtt_broker_uri;
             std::string mqtt_user;
             std::string mqtt_password;
+            std::string mqtt_client_id;
+
+            std::string scan_mode; // "passive" (default) or "active".
 
             std::vector<device_config> devices;
+            std::vector<log_level_config> log_levels;
+
+            static constexpr auto json_fields()
+            {
+                using namespace utils::json;
+
+                return fields(field("wifi_ssid", &app_config::wifi_ssid),
+                    field("wifi_password", &app_config::wifi_password),
+                    field("mqtt_broker_uri", &app_config::mqtt_broker_uri),
+                    optional_field("mqtt_user", &app_config::mqtt_user),
+                    optional_field("mqtt_password", &app_config::mqtt_password),
+                    optional_field("mqtt_client_id",
+                        &app_config::mqtt_client_id),
+                    optional_field("scan_mode", &app_config::scan_mode),
+                    field("devices", &app_config::devices),
+                    optional_field("log_levels", &app_config::log_levels));
+            }
         };
 
         using device_container =
             std::vector<std::pair<std::reference_wrapper<const device_config>,
                 std::weak_ptr<device::interface>>>;
 
-        static constexpr std::string_view COMPONENT{ "application" };
+        static constexpr std::size_t MAX_ADVERTISED_DEVICES{ 16 };
+
+        static_assert(
+            hass::discovery_cache::MAX_DEVICES >= MAX_ADVERTISED_DEVICES,
+            "Discovery cache too small for the advertised devices.");
+
+        // Devices read from advertisements, they stay for the lifetime of
+        // the application.
+        using advertised_device_map =
+            utils::mac_map<std::shared_ptr<device::interface>,
+                MAX_ADVERTISED_DEVICES>;
+
+        static constexpr log::component COMPONENT{ "application" };
+
+        static constexpr const char* SPOOL_PARTITION_LABEL{ "spool" };
 
         const app_config m_config;
         event::context m_context;
         wifi::station m_station;
+        mqtt::partition_storage m_spool_storage;
+        mqtt::spool m_spool;
+        mqtt::session m_mqtt_session;
 
         std::atomic_bool m_exit;
         std::thread m_connection_task;
@@ -105,97 +189,36 @@ namespace b2h
         {
             constexpr const char* CONFIG_FILE_PATH{ "/spiffs/config.json" };
 
-            constexpr auto get_string_value = [=](const auto& doc,
-                                                  const char* key) {
-                const auto iter = doc.FindMember(key);
-                if (iter == doc.MemberEnd())
-                {
-                    throw std::runtime_error{ fmt::format(
-                        "Field \"{}\" not found in {}.",
-                        key,
-                        CONFIG_FILE_PATH) };
-                }
-
-                if (!iter->value.IsString())
-                {
-                    throw std::runtime_error{
-                        fmt::format("Field \"{}\" must be a string.", key)
-                    };
-                }
-
-                return std::string{
-                    iter->value.GetString(),
-                    iter->value.GetStringLength(),
-                };
-            };
+            return utils::json::bind_file<app_config>(CONFIG_FILE_PATH);
+        }
 
-            constexpr auto get_optional_string_value = [=](const auto& doc,
-                                                           const char* key) {
-                const auto iter = doc.FindMember(key);
-                if (iter == doc.MemberEnd())
-                {
-                    return std::string{};
-                }
+        void apply_log_levels() const noexcept
+        {
+            for (const auto& entry : m_config.log_levels)
+            {
+                const auto level = log::parse_level(entry.level);
 
-                if (!iter->value.IsString())
+                if (!level)
                 {
-                    throw std::runtime_error{ fmt::format(
-                        "Optional field \"{}\" must be a string.",
-                        key) };
+                    log::warning(COMPONENT,
+                        "Unknown log level \"{}\" for component \"{}\".",
+                        entry.level,
+                        entry.component);
+                    continue;
                 }
 
-                return std::string{ iter->value.GetString() };
-            };
-
-            constexpr auto get_array_value = [=](const auto& doc,
-                                                 const char* key) {
-                const auto iter = doc.FindMember(key);
-                if (iter == doc.MemberEnd())
+                if (entry.component == "*")
                 {
-                    throw std::runtime_error{ fmt::format(
-                        "Field \"{}\" not found in {}.",
-                        key,
-                        CONFIG_FILE_PATH) };
+                    log::set_default_level(*level);
                 }
-
-                if (!iter->value.IsArray())
+                else if (!log::set_level(
+                             log::component{ entry.component }, *level))
                 {
-                    throw std::runtime_error{
-                        fmt::format("Field \"{}\" must be an array.", key)
-                    };
+                    log::warning(COMPONENT,
+                        "Too many log level overrides, \"{}\" ignored.",
+                        entry.component);
                 }
-
-                return iter->value.GetArray();
-            };
-
-            app_config config;
-            const auto json_config = utils::json::parse_file(CONFIG_FILE_PATH);
-
-            if (!json_config.IsObject())
-            {
-                throw std::runtime_error("Invalid \"config.json\".");
-            }
-
-            config.wifi_ssid = get_string_value(json_config, "wifi_ssid");
-            config.wifi_password =
-                get_string_value(json_config, "wifi_password");
-            config.mqtt_broker_uri =
-                get_string_value(json_config, "mqtt_broker_uri");
-
-            config.mqtt_user =
-                get_optional_string_value(json_config, "mqtt_user");
-            config.mqtt_password =
-                get_optional_string_value(json_config, "mqtt_password");
-
-            for (const auto& elem : get_array_value(json_config, "devices"))
-            {
-                config.devices.push_back({
-                    get_string_value(elem, "mac"),
-                    get_string_value(elem, "name"),
-                });
             }
-
-            return config;
         }
 
         void async_init() noexcept
@@ -306,6 +329,61 @@ namespace b2h
             });
         }
 
+        static void async_ble_advertisement(
+            ble::gap::central& gap_central,
+            advertised_device_map& advertised) noexcept
+        {
+            gap_central.async_advertisement([&](auto&& data) mutable {
+                if (!data.has_value())
+                {
+                    log::error(COMPONENT,
+                        "Error receiving the advertisement. Error code: {}",
+                        data.error());
+                    return;
+                }
+
+                if (auto* device = advertised.find(data.value().address))
+                {
+                    (*device)->on_advertisement(data.value().service_uuid,
+                        data.value().service_data);
+                }
+
+                async_ble_advertisement(gap_central, advertised);
+            });
+        }
+
+        void start_scan(ble::gap::central& gap_central,
+            advertised_device_map& advertised) const noexcept
+        {
+            ble::gap::scan_mode mode = ble::gap::scan_mode::passive;
+
+            if (m_config.scan_mode == "active")
+            {
+                mode = ble::gap::scan_mode::active;
+            }
+            else if (!m_config.scan_mode.empty() &&
+                     m_config.scan_mode != "passive")
+            {
+                log::warning(COMPONENT,
+                    "Unknown scan mode \"{}\", scanning passively.",
+                    m_config.scan_mode);
+            }
+
+            async_ble_advertisement(gap_central, advertised);
+
+            // Service data of advertised readings: the custom LYWSD03MMC
+            // firmware and Xiaomi MiBeacon.
+            const int rc = gap_central.start_scan(mode,
+                { device::xiaomi::CUSTOM_ADV_SERVICE_UUID,
+                    device::xiaomi::mibeacon::SERVICE_UUID });
+
+            if (rc != 0)
+            {
+                log::error(COMPONENT,
+                    "Scanning failed, advertised devices are not read.");
+            }
+        }
+
         void connection_task() noexcept
         {
             using namespace std::literals;
@@ -341,15 +419,107 @@ namespace b2h
                 return;
             }
 
+            // All the devices share a single broker connection.
+            const mqtt::config mqtt_config{
+                m_config.mqtt_broker_uri,
+                m_config.mqtt_user,
+                m_config.mqtt_password,
+                true,
+                m_config.mqtt_client_id,
+            };
+
+            if (!m_mqtt_session.config(mqtt_config).has_value())
+            {
+                log::critical(COMPONENT, "MQTT session configuration failed.");
+                return;
+            }
+
+            device::discovery_watch discovery_watch{
+                m_context,
+                m_mqtt_session,
+            };
+
+            // State readings taken while the broker is unreachable are kept
+            // in flash and published once it is back.
+            if (m_spool.mount().has_value())
+            {
+                m_mqtt_session.attach_spool(m_spool);
+            }
+            else
+            {
+                log::warning(COMPONENT,
+                    "Offline spool unavailable, publishes fail while "
+                    "disconnected.");
+            }
+
+            // The devices do not wait for the broker. Their subscriptions
+            // are sent and the spool drained once it connects.
+            bool mqtt_started = m_mqtt_session.start().has_value();
+
             ble::gap::central gap_central{ m_context };
 
             async_ble_notify_rx(gap_central, device_refs);
             async_ble_on_disconnect(gap_central, device_refs);
 
+            advertised_device_map advertised;
+
+            for (const auto& cfg : m_config.devices)
+            {
+                if (!cfg.advertised())
+                {
+                    continue;
+                }
+
+                const auto mac = utils::make_mac(cfg.mac);
+                if (!mac)
+                {
+                    log::error(COMPONENT, "Invalid MAC \"{}\".", cfg.mac);
+                    continue;
+                }
+
+                device::builder builder{};
+                auto device_shared = builder.context(m_context)
+                                         .mqtt_client(m_mqtt_session)
+                                         .gatt_client(*mac)
+                                         .build(cfg.name, cfg.options);
+
+                if (!device_shared ||
+                    !advertised.insert_or_assign(*mac, device_shared))
+                {
+                    log::error(COMPONENT,
+                        "Cannot read device \"{}\" [MAC: \"{}\"] from "
+                        "advertisements.",
+                        cfg.name,
+                        cfg.mac);
+                    continue;
+                }
+
+                log::info(COMPONENT,
+                    "Listening to device: \"{}\" [MAC: \"{}\"].",
+                    cfg.name,
+                    cfg.mac);
+            }
+
+            if (!advertised.empty())
+            {
+                start_scan(gap_central, advertised);
+            }
+
             while (!m_exit)
             {
+                if (!mqtt_started)
+                {
+                    log::info(COMPONENT, "Retrying MQTT client start.");
+                    mqtt_started = m_mqtt_session.start().has_value();
+                }
+
                 for (auto& [device_config, device_ptr] : devices)
                 {
+                    if (device_config.get().advertised())
+                    {
+                        continue;
+                    }
+
                     if (!device_ptr.expired())
                     {
                         log::debug(COMPONENT,
@@ -369,23 +539,19 @@ namespace b2h
                         device::builder builder{};
                         auto device_shared =
                             builder.context(m_context)
-                                .mqtt_client({
-                                    m_config.mqtt_broker_uri,
-                                    m_config.mqtt_user,
-                                    m_config.mqtt_password,
-                                    true,
-                                })
+                                .mqtt_client(m_mqtt_session)
                                 .gatt_client(gap_central,
                                     utils::make_mac(device_config.get().mac)
                                         .value())
-                                .build(device_config.get().name);
+                                .build(device_config.get().name,
+                                    device_config.get().options);
 
                         device_ptr =
                             device_refs.emplace_back(std::move(device_shared));
                     }
                     catch (const std::exception& err)
                     {
-                        log::error(COMPONENT, err.what());
+                        log::error(COMPONENT, "{}", err.what());
                     }
                 }
 
@@ -395,6 +561,51 @@ namespace b2h
             }
         }
     };
+
+#ifdef B2H_LOG_DEFERRED
+    /**
+     * @brief Low priority thread formatting deferred log records, so that
+     * logging does not delay the BLE host and MQTT tasks.
+     *
+     */
+    class log_task
+    {
+    public:
+        log_task() : m_exit{ false }, m_thread{}
+        {
+            using namespace std::literals;
+
+            esp_pthread_cfg_t config = esp_pthread_get_default_config();
+            config.prio              = 1;
+            config.thread_name       = "log_task";
+            esp_pthread_set_cfg(&config);
+
+            m_thread = std::thread([this]() {
+                while (!m_exit)
+                {
+                    if (log::drain() == 0)
+                    {
+                        std::this_thread::sleep_for(20ms);
+                    }
+                }
+            });
+
+            config = esp_pthread_get_default_config();
+            esp_pthread_set_cfg(&config);
+        }
+
+        ~log_task()
+        {
+            m_exit = true;
+            m_thread.join();
+            log::drain();
+        }
+
+    private:
+        std::atomic_bool m_exit;
+        std::thread m_thread;
+    };
+#endif
 } // namespace b2h
 
 extern "C" void app_main(void) noexcept
@@ -402,7 +613,7 @@ extern "C" void app_main(void) noexcept
     using namespace b2h;
     using namespace std::literals;
 
-    constexpr std::string_view COMPONENT{ "app_main" };
+    constexpr log::component COMPONENT{ "app_main" };
     constexpr esp_vfs_spiffs_conf_t fs_config{
         "/spiffs", // base path
         "storage", // partition label
@@ -439,23 +650,29 @@ extern "C" void app_main(void) noexcept
         goto spiffs_deinit;
     }
 
-    try
     {
-        application app;
+#ifdef B2H_LOG_DEFERRED
+        log_task logging{};
+#endif
 
-        log::info(COMPONENT, "Starting event context.");
-        app.run();
-    }
-    catch (const std::exception& err)
-    {
-        log::error(COMPONENT, "Exception caught: {}", err.what());
-    }
-    catch (...)
-    {
-        log::critical(COMPONENT, "Unknown exception caught.");
-    }
+        try
+        {
+            application app;
 
-    log::warning(COMPONENT, "Application exited, cleaning up resources.");
+            log::info(COMPONENT, "Starting event context.");
+            app.run();
+        }
+        catch (const std::exception& err)
+        {
+            log::error(COMPONENT, "Exception caught: {}", err.what());
+        }
+        catch (...)
+        {
+            log::critical(COMPONENT, "Unknown exception caught.");
+        }
+
+        log::warning(COMPONENT, "Application exited, cleaning up resources.");
+    }
 
     esp_event_loop_delete_default();
 spiffs_deinit: